@@ -0,0 +1,127 @@
+/*! Compare the bin look-up and the filling speed of the variable-width histograms with and without
+VariableBinLookup. Binnings and values are modelled after the typical mass distribution (falling spectrum with bins
+that widen at high mass) and the MVA score distribution (score peaking at the edges with fine bins near 1).
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <random>
+#include <TAxis.h>
+#include "AnalysisTools/Core/include/BinLookup.h"
+#include "AnalysisTools/Core/include/SmartHistogram.h"
+#include "AnalysisTools/Run/include/program_main.h"
+
+struct Arguments {
+    OPT_ARG(unsigned, n_values, 10000000);
+    OPT_ARG(unsigned, n_runs, 5);
+    OPT_ARG(unsigned, seed, 12345);
+};
+
+class Benchmark_BinLookup {
+public:
+    using clock = std::chrono::steady_clock;
+    using Hist = root_ext::SmartHistogram<TH1D>;
+
+    Benchmark_BinLookup(const Arguments& _args) : args(_args), gen(args.seed())
+    {
+        if(!args.n_runs() || !args.n_values())
+            throw analysis::exception("Number of runs and number of values should be positive.");
+        TH1::AddDirectory(false);
+    }
+
+    void Run()
+    {
+        std::cout << std::left << std::setw(10) << "Binning" << std::right << std::setw(8) << "n_bins"
+                  << std::setw(16) << "TAxis, ns" << std::setw(16) << "lookup, ns" << std::setw(16)
+                  << "TH1::Fill, ns" << std::setw(16) << "fast Fill, ns" << std::endl;
+
+        std::vector<double> mass_bins = { 0, 20, 40, 60, 80, 100, 120, 140, 160, 180, 200, 225, 250, 275, 300, 350,
+                                          400, 450, 500, 600, 700, 800, 1000, 1250, 1500, 2000, 3000 };
+        std::exponential_distribution<double> mass_distr(1. / 150);
+        std::vector<double> masses(args.n_values());
+        for(double& x : masses)
+            x = 20 + mass_distr(gen);
+        Measure("mass", mass_bins, masses);
+
+        std::vector<double> score_bins;
+        for(int n = 0; n < 9; ++n)
+            score_bins.push_back(n * 0.1);
+        for(int n = 0; n < 20; ++n)
+            score_bins.push_back(0.9 + n * 0.005);
+        score_bins.push_back(1);
+        std::uniform_real_distribution<double> score_distr(0, 1);
+        std::bernoulli_distribution is_signal(0.3);
+        std::vector<double> scores(args.n_values());
+        for(double& x : scores) {
+            const double u = std::pow(score_distr(gen), 4);
+            x = is_signal(gen) ? 1 - u : u;
+        }
+        Measure("MVA", score_bins, scores);
+    }
+
+private:
+    void Measure(const std::string& name, const std::vector<double>& bins, const std::vector<double>& values)
+    {
+        const int n_bins = static_cast<int>(bins.size()) - 1;
+        TAxis axis(n_bins, bins.data());
+        const analysis::VariableBinLookup lookup(bins);
+        Hist hist_ref(name + "_ref", bins), hist_fast(name + "_fast", bins);
+        hist_fast.EnableFastBinLookup();
+
+        double axis_time = 0, lookup_time = 0, fill_time = 0, fast_fill_time = 0;
+        long long axis_sum = 0, lookup_sum = 0;
+        for(unsigned run = 0; run < args.n_runs(); ++run) {
+            auto start = clock::now();
+            for(double x : values)
+                axis_sum += axis.FindBin(x);
+            UpdateMin(axis_time, start, run);
+
+            start = clock::now();
+            for(double x : values)
+                lookup_sum += lookup.FindBin(x);
+            UpdateMin(lookup_time, start, run);
+
+            hist_ref.Reset();
+            start = clock::now();
+            for(double x : values)
+                hist_ref.TH1D::Fill(x, 0.5);
+            UpdateMin(fill_time, start, run);
+
+            hist_fast.Reset();
+            start = clock::now();
+            for(double x : values)
+                hist_fast.Fill(x, 0.5);
+            UpdateMin(fast_fill_time, start, run);
+        }
+
+        if(axis_sum != lookup_sum)
+            throw analysis::exception("Bin look-up results are different for '%1%'.") % name;
+        for(int bin = 0; bin <= n_bins + 1; ++bin) {
+            if(hist_ref.GetBinContent(bin) != hist_fast.GetBinContent(bin)
+                    || hist_ref.GetBinError(bin) != hist_fast.GetBinError(bin))
+                throw analysis::exception("Histogram contents are different for '%1%' in bin %2%.") % name % bin;
+        }
+        if(hist_ref.GetEntries() != hist_fast.GetEntries() || hist_ref.GetMean() != hist_fast.GetMean()
+                || hist_ref.GetStdDev() != hist_fast.GetStdDev())
+            throw analysis::exception("Histogram statistics are different for '%1%'.") % name;
+
+        const double n = static_cast<double>(values.size());
+        std::cout << std::left << std::setw(10) << name << std::right << std::setw(8) << n_bins << std::fixed
+                  << std::setprecision(2) << std::setw(16) << axis_time / n << std::setw(16) << lookup_time / n
+                  << std::setw(16) << fill_time / n << std::setw(16) << fast_fill_time / n << std::endl;
+    }
+
+    static void UpdateMin(double& min_time, const clock::time_point& start, unsigned run)
+    {
+        const double time = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+        if(run == 0 || time < min_time)
+            min_time = time;
+    }
+
+private:
+    Arguments args;
+    std::mt19937_64 gen;
+};
+
+PROGRAM_MAIN(Benchmark_BinLookup, Arguments)
@@ -0,0 +1,248 @@
+/*! Compare performance of the insertion-ordered map_vec and flat_map_vec with the standard associative containers.
+Key sets are modelled after the typical analysis use cases: names of the samples (dataset names with the production
+campaign suffixes) and names of the histograms (variable, channel, category, region and systematic uncertainty).
+For each container the time of the filling, of the look-up of all keys and of the iteration in the insertion order
+is measured.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <random>
+#include <unordered_map>
+#include "AnalysisTools/Core/include/flat_map_vec.h"
+#include "AnalysisTools/Core/include/map_vec.h"
+#include "AnalysisTools/Run/include/program_main.h"
+
+struct Arguments {
+    OPT_ARG(unsigned, n_runs, 5);
+    OPT_ARG(unsigned, n_lookups, 10);
+    OPT_ARG(unsigned, seed, 12345);
+};
+
+namespace bench {
+
+// std::map with a vector of pointers that keeps the insertion order: a look-up followed by a separate insertion.
+template<typename Key, typename Value>
+class tree_map_vec {
+public:
+    using std_vec = std::vector<std::pair<Key, const Value*>>;
+
+    Value& operator[](const Key& key)
+    {
+        auto iter = map.find(key);
+        if(iter == map.end()) {
+            iter = map.emplace(key, Value()).first;
+            vec.emplace_back(key, &iter->second);
+        }
+        return iter->second;
+    }
+
+    const Value* find(const Key& key) const
+    {
+        const auto iter = map.find(key);
+        return iter == map.end() ? nullptr : &iter->second;
+    }
+
+    const std_vec& get_ordered_by_insertion() const { return vec; }
+
+private:
+    std::map<Key, Value> map;
+    std_vec vec;
+};
+
+template<typename Key, typename Value>
+struct unordered_map_vec {
+    using std_vec = std::vector<std::pair<Key, const Value*>>;
+
+    Value& operator[](const Key& key)
+    {
+        auto iter = map.find(key);
+        if(iter == map.end()) {
+            iter = map.emplace(key, Value()).first;
+            vec.emplace_back(key, &iter->second);
+        }
+        return iter->second;
+    }
+
+    const Value* find(const Key& key) const
+    {
+        const auto iter = map.find(key);
+        return iter == map.end() ? nullptr : &iter->second;
+    }
+
+    const std_vec& get_ordered_by_insertion() const { return vec; }
+
+private:
+    std::unordered_map<Key, Value> map;
+    std_vec vec;
+};
+
+template<typename Key, typename Value>
+struct map_vec_adapter : analysis::map_vec<Key, Value> {
+    using Base = analysis::map_vec<Key, Value>;
+
+    const Value* find(const Key& key) const
+    {
+        const auto iter = Base::find(key);
+        return iter == Base::end() ? nullptr : &iter->second;
+    }
+};
+
+template<typename Key, typename Value>
+struct flat_map_vec_adapter : analysis::flat_map_vec<Key, Value> {
+    using Base = analysis::flat_map_vec<Key, Value>;
+
+    const Value* find(const Key& key) const
+    {
+        const auto iter = Base::find(key);
+        return iter == Base::end() ? nullptr : &iter->second;
+    }
+};
+
+inline double Value(double x) { return x; }
+inline double Value(const double* x) { return *x; }
+
+} // namespace bench
+
+class Benchmark_MapVec {
+public:
+    using clock = std::chrono::steady_clock;
+    using KeySet = std::vector<std::string>;
+
+    struct Result {
+        double fill_time{0}, lookup_time{0}, iteration_time{0}; // ns per key, minimum over the runs
+        double checksum{0};
+    };
+
+    Benchmark_MapVec(const Arguments& _args) : args(_args), gen(args.seed())
+    {
+        if(!args.n_runs() || !args.n_lookups())
+            throw analysis::exception("Number of runs and number of look-ups should be positive.");
+    }
+
+    void Run()
+    {
+        const KeySet sample_names = CreateSampleNames();
+        const KeySet hist_names = CreateHistogramNames();
+        RunKeySet("samples", sample_names);
+        RunKeySet("histograms", hist_names);
+    }
+
+private:
+    void RunKeySet(const std::string& name, const KeySet& keys)
+    {
+        KeySet lookup_keys = keys;
+        std::shuffle(lookup_keys.begin(), lookup_keys.end(), gen);
+
+        std::cout << "Key set '" << name << "': " << keys.size() << " keys" << std::endl;
+        std::cout << std::left << std::setw(30) << "Container" << std::right << std::setw(14) << "fill, ns/key"
+                  << std::setw(16) << "lookup, ns/key" << std::setw(14) << "iter, ns/key" << std::endl;
+        const Result tree = Measure<bench::tree_map_vec<std::string, double>>("std::map + vector", keys,
+                                                                                lookup_keys);
+        const Result hash = Measure<bench::unordered_map_vec<std::string, double>>("std::unordered_map + vector",
+                                                                                    keys, lookup_keys);
+        const Result ordered = Measure<bench::map_vec_adapter<std::string, double>>("map_vec", keys, lookup_keys);
+        const Result flat = Measure<bench::flat_map_vec_adapter<std::string, double>>("flat_map_vec", keys,
+                                                                                      lookup_keys);
+        if(tree.checksum != ordered.checksum || hash.checksum != ordered.checksum || flat.checksum != ordered.checksum)
+            throw analysis::exception("Containers give different results.");
+        std::cout << std::endl;
+    }
+
+    template<typename Map>
+    Result Measure(const std::string& name, const KeySet& keys, const KeySet& lookup_keys)
+    {
+        Result result;
+        const double n_keys = static_cast<double>(keys.size());
+        for(unsigned run = 0; run < args.n_runs(); ++run) {
+            auto start = clock::now();
+            Map map;
+            for(size_t n = 0; n < keys.size(); ++n)
+                map[keys[n]] += static_cast<double>(n);
+            const double fill_time = ElapsedNs(start) / n_keys;
+
+            double checksum = 0;
+            start = clock::now();
+            for(unsigned n = 0; n < args.n_lookups(); ++n) {
+                for(const auto& key : lookup_keys)
+                    checksum += *map.find(key);
+            }
+            const double lookup_time = ElapsedNs(start) / n_keys / args.n_lookups();
+
+            start = clock::now();
+            double weighted_sum = 0, index = 0;
+            for(const auto& item : map.get_ordered_by_insertion())
+                weighted_sum += ++index * bench::Value(item.second);
+            const double iteration_time = ElapsedNs(start) / n_keys;
+
+            result.checksum = checksum + weighted_sum;
+            if(run == 0 || fill_time < result.fill_time) result.fill_time = fill_time;
+            if(run == 0 || lookup_time < result.lookup_time) result.lookup_time = lookup_time;
+            if(run == 0 || iteration_time < result.iteration_time) result.iteration_time = iteration_time;
+        }
+
+        std::cout << std::left << std::setw(30) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(14) << result.fill_time << std::setw(16) << result.lookup_time
+                  << std::setw(14) << result.iteration_time << std::endl;
+        return result;
+    }
+
+    static double ElapsedNs(const clock::time_point& start)
+    {
+        return std::chrono::duration<double, std::nano>(clock::now() - start).count();
+    }
+
+    KeySet CreateSampleNames()
+    {
+        static const KeySet processes = {
+            "TTToSemiLeptonic", "TTTo2L2Nu", "TTToHadronic", "DYJetsToLL_M-50", "DYJetsToLL_M-10to50",
+            "WJetsToLNu", "ST_t-channel_top_4f_InclusiveDecays", "ST_tW_antitop_5f_inclusiveDecays",
+            "GluGluToHHTo2B2Tau", "VBFHHTo2B2Tau_CV_1_C2V_1_C3_1", "GluGluHToTauTau_M125", "ZZTo2L2Q", "WZTo3LNu",
+            "WWTo2L2Nu", "TTWJetsToLNu", "TTZToLLNuNu_M-10", "ttHToTauTau_M125", "EWKZ2Jets_ZToLL_M-50",
+        };
+        static const KeySet bins = { "", "_HT-70to100", "_HT-100to200", "_HT-200to400", "_HT-400to600",
+                                     "_HT-600to800", "_0J", "_1J", "_2J" };
+        static const KeySet campaigns = { "RunIISummer20UL16", "RunIISummer20UL16APV", "RunIISummer20UL17",
+                                          "RunIISummer20UL18" };
+        KeySet names;
+        for(const auto& process : processes) {
+            for(const auto& bin : bins) {
+                for(const auto& campaign : campaigns)
+                    names.push_back(process + bin + "_TuneCP5_13TeV-madgraphMLM-pythia8_" + campaign);
+            }
+        }
+        return names;
+    }
+
+    KeySet CreateHistogramNames()
+    {
+        static const KeySet variables = { "m_ttbb", "m_sv", "m_tt_vis", "m_bb", "pt_1", "pt_2", "eta_1", "eta_2",
+                                          "MET", "mt_1", "mt_2", "dR_bb", "dR_tautau", "kinFit_m", "kinFit_chi2",
+                                          "MT2", "HT_otherjets", "deepFlavour_b1", "deepFlavour_b2", "dnn_score" };
+        static const KeySet channels = { "eTau", "muTau", "tauTau" };
+        static const KeySet categories = { "res1b", "res2b", "boosted", "VBF", "2j", "2j0bR_noVBF" };
+        static const KeySet regions = { "OS_Isolated", "OS_AntiIsolated", "SS_Isolated", "SS_AntiIsolated" };
+        static const KeySet uncertainties = { "Central", "TauES_Up", "TauES_Down", "JetEnTotal_Up",
+                                              "JetEnTotal_Down", "TopPt_Up" };
+        KeySet names;
+        for(const auto& variable : variables) {
+            for(const auto& channel : channels) {
+                for(const auto& category : categories) {
+                    for(const auto& region : regions) {
+                        for(const auto& unc : uncertainties)
+                            names.push_back(variable + "_" + channel + "_" + category + "_" + region + "_" + unc);
+                    }
+                }
+            }
+        }
+        return names;
+    }
+
+private:
+    Arguments args;
+    std::mt19937_64 gen;
+};
+
+PROGRAM_MAIN(Benchmark_MapVec, Arguments)
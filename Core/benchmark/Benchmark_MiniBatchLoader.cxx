@@ -0,0 +1,73 @@
+/*! Measure the rate at which the mini-batch loader streams events from root files.
+The batches are only consumed (summed), so the measured rate is the upper limit for the training input pipeline.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <chrono>
+#include <iomanip>
+#include <boost/filesystem.hpp>
+#include "AnalysisTools/Core/include/MiniBatchLoader.h"
+#include "AnalysisTools/Core/include/TextIO.h"
+#include "AnalysisTools/Run/include/program_main.h"
+
+struct Arguments {
+    REQ_ARG(std::vector<std::string>, input_files);
+    OPT_ARG(std::string, tree, "events");
+    OPT_ARG(std::string, features, "");
+    OPT_ARG(size_t, batch_size, 256);
+    OPT_ARG(size_t, shuffle_buffer, 100000);
+    OPT_ARG(size_t, n_threads, 4);
+    OPT_ARG(size_t, n_epochs, 2);
+    OPT_ARG(uint64_t, seed, 0);
+};
+
+class Benchmark_MiniBatchLoader {
+public:
+    using clock = std::chrono::steady_clock;
+
+    Benchmark_MiniBatchLoader(const Arguments& _args) : args(_args)
+    {
+        config.files = args.input_files();
+        config.tree_name = args.tree();
+        config.features = analysis::SplitValueList(args.features(), false, ",");
+        config.batch_size = args.batch_size();
+        config.shuffle_buffer_size = args.shuffle_buffer();
+        config.n_threads = args.n_threads();
+        config.seed = args.seed();
+    }
+
+    void Run()
+    {
+        analysis::MiniBatchLoader loader(config);
+        uint64_t input_size = 0;
+        for(const auto& file : config.files)
+            input_size += boost::filesystem::file_size(file);
+        std::cout << loader.GetNumberOfEvents() << " events in " << loader.GetChunks().size() << " chunks, "
+                  << std::fixed << std::setprecision(1) << input_size / (1024. * 1024.) << " MiB on disk."
+                  << std::endl;
+
+        analysis::MiniBatch batch;
+        for(size_t epoch = 0; epoch < args.n_epochs(); ++epoch) {
+            const auto start = clock::now();
+            loader.StartEpoch(epoch);
+            size_t n_events = 0, n_batches = 0;
+            double sum = 0;
+            while(loader.Next(batch)) {
+                for(float value : batch.values)
+                    sum += value;
+                n_events += batch.size();
+                ++n_batches;
+            }
+            const double time = std::chrono::duration<double>(clock::now() - start).count();
+            std::cout << "epoch " << epoch << ": " << n_batches << " batches, " << n_events << " events in "
+                      << std::setprecision(2) << time << " s (" << std::setprecision(1) << n_events / time / 1000.
+                      << " kHz, " << input_size / (1024. * 1024.) / time << " MiB/s on disk), sum = "
+                      << std::setprecision(6) << sum << std::endl;
+        }
+    }
+
+private:
+    Arguments args;
+    analysis::MiniBatchLoader::Config config;
+};
+
+PROGRAM_MAIN(Benchmark_MiniBatchLoader, Arguments)
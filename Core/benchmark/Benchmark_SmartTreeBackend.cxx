@@ -0,0 +1,178 @@
+/*! Compare write and read performance of the TTree and RNTuple storage backends of SmartTree.
+Both backends are filled with the same pseudo-random events of a representative analysis tuple schema (event ids,
+scalar kinematic variables and variable-length jet collections). RNTuple backend is measured only if AnalysisTools is
+built with the RNTuple support.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <chrono>
+#include <iomanip>
+#include <random>
+#include <boost/filesystem.hpp>
+#include <Math/LorentzVector.h>
+#include <Math/PtEtaPhiM4D.h>
+#include "AnalysisTools/Core/include/RootExt.h"
+#include "AnalysisTools/Core/include/SmartTree.h"
+#include "AnalysisTools/Run/include/program_main.h"
+
+namespace bench {
+using LorentzVectorM = ROOT::Math::LorentzVector<ROOT::Math::PtEtaPhiM4D<float>>;
+}
+
+#define BENCH_EVENT_DATA() \
+    VAR(UInt_t, run) \
+    VAR(UInt_t, lumi) \
+    VAR(ULong64_t, evt) \
+    VAR(Int_t, npv) \
+    VAR(Float_t, met_pt) \
+    VAR(Float_t, met_phi) \
+    VAR(Double_t, weight) \
+    VAR(bench::LorentzVectorM, lep_p4) \
+    VAR(Int_t, lep_charge) \
+    VAR(std::vector<float>, jet_pt) \
+    VAR(std::vector<float>, jet_eta) \
+    VAR(std::vector<float>, jet_phi) \
+    VAR(std::vector<float>, jet_btag) \
+    VAR(std::vector<int>, jet_flavour) \
+    /**/
+
+#define VAR(type, name) DECLARE_BRANCH_VARIABLE(type, name)
+DECLARE_TREE(bench, Event, EventTree, BENCH_EVENT_DATA, "events")
+#undef VAR
+
+#define VAR(type, name) ADD_DATA_TREE_BRANCH(name)
+INITIALIZE_TREE(bench, EventTree, BENCH_EVENT_DATA)
+#undef VAR
+#undef BENCH_EVENT_DATA
+
+struct Arguments {
+    REQ_ARG(std::string, work_dir);
+    OPT_ARG(unsigned, n_entries, 500000);
+    OPT_ARG(unsigned, n_runs, 3);
+    OPT_ARG(std::string, compression, "ZSTD");
+    OPT_ARG(int, compression_level, 5);
+};
+
+class Benchmark_SmartTreeBackend {
+public:
+    using clock = std::chrono::steady_clock;
+
+    struct Result {
+        double write_time{0}, read_time{0}; // seconds, minimum over the runs
+        uint64_t file_size{0};
+        double checksum{0};
+    };
+
+    Benchmark_SmartTreeBackend(const Arguments& _args) :
+        args(_args), compression(root_ext::ParseCompressionAlgorithm(args.compression()))
+    {
+        if(!args.n_runs() || !args.n_entries())
+            throw analysis::exception("Number of runs and number of entries should be positive.");
+        boost::filesystem::create_directories(args.work_dir());
+    }
+
+    void Run()
+    {
+        std::cout << "Backend      write, s  read, s  write, kHz  read, kHz  size, MiB" << std::endl;
+        const Result tree_result = Measure<bench::EventTree>("TTree");
+#ifdef ANALYSIS_TOOLS_HAS_RNTUPLE
+        const Result ntuple_result = Measure<bench::EventTreeNTuple>("RNTuple");
+        if(ntuple_result.checksum != tree_result.checksum)
+            throw analysis::exception("Data read back from TTree and RNTuple are different.");
+#else
+        (void) tree_result;
+        std::cout << "RNTuple backend is not available in this build." << std::endl;
+#endif
+    }
+
+private:
+    template<typename Tree>
+    Result Measure(const std::string& backend)
+    {
+        const std::string file_name =
+                (boost::filesystem::path(args.work_dir()) / ("Benchmark_SmartTreeBackend_" + backend + ".root"))
+                .string();
+        Result result;
+        for(unsigned run = 0; run < args.n_runs(); ++run) {
+            const double write_time = Write<Tree>(file_name);
+            double checksum = 0;
+            const double read_time = Read<Tree>(file_name, checksum);
+            result.write_time = run ? std::min(result.write_time, write_time) : write_time;
+            result.read_time = run ? std::min(result.read_time, read_time) : read_time;
+            result.checksum = checksum;
+        }
+        result.file_size = boost::filesystem::file_size(file_name);
+        boost::filesystem::remove(file_name);
+
+        const double n_k_entries = args.n_entries() / 1000.;
+        std::cout << std::left << std::setw(10) << backend << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(10) << result.write_time << std::setw(9) << result.read_time << std::setprecision(1)
+                  << std::setw(12) << n_k_entries / result.write_time << std::setw(11)
+                  << n_k_entries / result.read_time << std::setprecision(2) << std::setw(11)
+                  << result.file_size / (1024. * 1024.) << std::endl;
+        return result;
+    }
+
+    template<typename Tree>
+    double Write(const std::string& file_name) const
+    {
+        std::mt19937_64 gen(12345);
+        auto file = root_ext::CreateRootFile(file_name, compression, args.compression_level());
+        Tree tree(file.get(), false);
+        const auto start = clock::now();
+        for(unsigned n = 0; n < args.n_entries(); ++n) {
+            FillEvent(tree(), n, gen);
+            tree.Fill();
+        }
+        tree.Write();
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    template<typename Tree>
+    static double Read(const std::string& file_name, double& checksum)
+    {
+        auto file = root_ext::OpenRootFile(file_name);
+        Tree tree(file.get(), true);
+        const auto start = clock::now();
+        const Long64_t n_entries = tree.GetEntries();
+        for(Long64_t n = 0; n < n_entries; ++n) {
+            tree.GetEntry(n);
+            const bench::Event& event = tree();
+            checksum += event.evt + event.met_pt + event.weight + event.lep_p4.pt();
+            for(size_t jet = 0; jet < event.jet_pt.size(); ++jet)
+                checksum += event.jet_pt.at(jet) * event.jet_btag.at(jet) + event.jet_flavour.at(jet);
+        }
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    static void FillEvent(bench::Event& event, unsigned n, std::mt19937_64& gen)
+    {
+        std::uniform_real_distribution<float> uniform(0.f, 1.f);
+        std::exponential_distribution<float> pt(1.f / 40.f);
+        std::poisson_distribution<unsigned> n_jets(4.);
+
+        event.run = 1 + n / 100000;
+        event.lumi = 1 + n / 1000;
+        event.evt = n;
+        event.npv = static_cast<Int_t>(20 + 30 * uniform(gen));
+        event.met_pt = pt(gen);
+        event.met_phi = 6.28f * uniform(gen) - 3.14f;
+        event.weight = 0.5 + uniform(gen);
+        event.lep_p4 = bench::LorentzVectorM(20 + pt(gen), 5 * uniform(gen) - 2.5f, 6.28f * uniform(gen) - 3.14f,
+                                             0.106f);
+        event.lep_charge = uniform(gen) < 0.5f ? -1 : 1;
+        const unsigned n_jet = n_jets(gen);
+        for(unsigned jet = 0; jet < n_jet; ++jet) {
+            event.jet_pt.push_back(20 + pt(gen));
+            event.jet_eta.push_back(9.4f * uniform(gen) - 4.7f);
+            event.jet_phi.push_back(6.28f * uniform(gen) - 3.14f);
+            event.jet_btag.push_back(uniform(gen));
+            event.jet_flavour.push_back(static_cast<int>(6 * uniform(gen)));
+        }
+    }
+
+private:
+    Arguments args;
+    ROOT::ECompressionAlgorithm compression;
+};
+
+PROGRAM_MAIN(Benchmark_SmartTreeBackend, Arguments)
@@ -0,0 +1,66 @@
+/*! Measure the start-up time of the executables.
+Each executable is started with an argument that makes it exit right after the initialization (by default, --help).
+The first run is reported separately as the cold start, while the following runs are used to estimate
+the warm start-up time.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <numeric>
+#include <sys/wait.h>
+#include "AnalysisTools/Run/include/program_main.h"
+#include "AnalysisTools/Core/include/TextIO.h"
+
+struct Arguments {
+    REQ_ARG(std::vector<std::string>, executables);
+    OPT_ARG(unsigned, n_runs, 20);
+    OPT_ARG(std::string, exe_args, "--help");
+};
+
+class Benchmark_StartupTime {
+public:
+    using clock = std::chrono::steady_clock;
+
+    Benchmark_StartupTime(const Arguments& _args) : args(_args)
+    {
+        if(args.n_runs() < 2)
+            throw analysis::exception("At least two runs are required.");
+    }
+
+    void Run()
+    {
+        std::cout << std::left << std::setw(30) << "Executable" << std::right << std::setw(12) << "cold, ms"
+                  << std::setw(12) << "min, ms" << std::setw(12) << "median, ms" << std::setw(12) << "mean, ms"
+                  << std::endl;
+        for(const std::string& exe : args.executables()) {
+            const std::string cmd = exe + " " + args.exe_args() + " > /dev/null 2>&1";
+            const double cold = Measure(cmd);
+            std::vector<double> times;
+            for(unsigned n = 1; n < args.n_runs(); ++n)
+                times.push_back(Measure(cmd));
+            std::sort(times.begin(), times.end());
+            const double mean = std::accumulate(times.begin(), times.end(), 0.) / static_cast<double>(times.size());
+            std::cout << std::left << std::setw(30) << analysis::GetFileNameWithoutPath(exe) << std::right
+                      << std::fixed << std::setprecision(1) << std::setw(12) << cold << std::setw(12) << times.front()
+                      << std::setw(12) << times.at(times.size() / 2) << std::setw(12) << mean << std::endl;
+        }
+    }
+
+private:
+    static double Measure(const std::string& cmd)
+    {
+        const auto start = clock::now();
+        const int status = std::system(cmd.c_str());
+        const auto stop = clock::now();
+        if(status == -1 || !WIFEXITED(status) || WEXITSTATUS(status) == 126 || WEXITSTATUS(status) == 127)
+            throw analysis::exception("Unable to run '%1%'.") % cmd;
+        return std::chrono::duration<double, std::milli>(stop - start).count();
+    }
+
+private:
+    Arguments args;
+};
+
+PROGRAM_MAIN(Benchmark_StartupTime, Arguments)
@@ -0,0 +1,229 @@
+/*! Measure the effect of separate I/O and compute executors and of the thread affinity on a read-heavy SmartTree
+workload. Each input file is read in chunks of entries (file access and decompression), and each chunk is then
+processed by a CPU-bound event loop (combinatorics over the jet collection). The workload is run with a single
+shared thread pull, where each task reads and processes a whole file, and with the separate executors, where the
+reading tasks run on the I/O pull and pass the chunks to the compute pull, without and with the thread pinning.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <random>
+#include <boost/filesystem.hpp>
+#include <TROOT.h>
+#include "AnalysisTools/Core/include/RootExt.h"
+#include "AnalysisTools/Core/include/SmartTree.h"
+#include "AnalysisTools/Run/include/MultiThread.h"
+#include "AnalysisTools/Run/include/program_main.h"
+
+#define BENCH_EVENT_DATA() \
+    VAR(ULong64_t, evt) \
+    VAR(Float_t, met_pt) \
+    VAR(Float_t, met_phi) \
+    VAR(Double_t, weight) \
+    VAR(std::vector<float>, jet_pt) \
+    VAR(std::vector<float>, jet_eta) \
+    VAR(std::vector<float>, jet_phi) \
+    VAR(std::vector<float>, jet_btag) \
+    /**/
+
+#define VAR(type, name) DECLARE_BRANCH_VARIABLE(type, name)
+DECLARE_TREE(bench, PoolEvent, PoolEventTree, BENCH_EVENT_DATA, "events")
+#undef VAR
+
+#define VAR(type, name) ADD_DATA_TREE_BRANCH(name)
+INITIALIZE_TREE(bench, PoolEventTree, BENCH_EVENT_DATA)
+#undef VAR
+#undef BENCH_EVENT_DATA
+
+struct Arguments {
+    REQ_ARG(std::string, work_dir);
+    OPT_ARG(unsigned, n_files, 8);
+    OPT_ARG(unsigned, n_entries, 200000);
+    OPT_ARG(unsigned, chunk_size, 10000);
+    OPT_ARG(unsigned, n_threads, std::max(std::thread::hardware_concurrency(), 1u));
+    OPT_ARG(unsigned, n_io_threads, 4);
+    OPT_ARG(unsigned, n_iterations, 4);
+};
+
+class Benchmark_ThreadPull {
+public:
+    using clock = std::chrono::steady_clock;
+    using Chunk = std::vector<bench::PoolEvent>;
+    using ChunkPtr = std::shared_ptr<const Chunk>;
+
+    Benchmark_ThreadPull(const Arguments& _args) : args(_args)
+    {
+        if(!args.n_files() || !args.n_entries() || !args.chunk_size() || !args.n_threads() || !args.n_io_threads())
+            throw analysis::exception("All benchmark parameters should be positive.");
+        boost::filesystem::create_directories(args.work_dir());
+        ROOT::EnableThreadSafety();
+    }
+
+    void Run()
+    {
+        CreateInputs();
+        std::cout << std::left << std::setw(36) << "Configuration" << std::right << std::setw(10) << "time, s"
+                  << std::setw(12) << "rate, kHz" << std::endl;
+        const double reference = MeasureSharedPull();
+        using run::ThreadAffinity;
+        for(auto affinity : { ThreadAffinity::None, ThreadAffinity::NumaNode, ThreadAffinity::Core }) {
+            if(MeasureExecutors(affinity) != reference)
+                throw analysis::exception("Results of the shared and separate thread pulls are different.");
+        }
+        for(const auto& file_name : file_names)
+            boost::filesystem::remove(file_name);
+    }
+
+private:
+    void CreateInputs()
+    {
+        for(unsigned n = 0; n < args.n_files(); ++n) {
+            const std::string file_name = (boost::filesystem::path(args.work_dir())
+                                           / ("Benchmark_ThreadPull_" + std::to_string(n) + ".root")).string();
+            std::mt19937_64 gen(n);
+            auto file = root_ext::CreateRootFile(file_name);
+            bench::PoolEventTree tree(file.get(), false);
+            for(unsigned entry = 0; entry < args.n_entries(); ++entry) {
+                FillEvent(tree(), entry, gen);
+                tree.Fill();
+            }
+            tree.Write();
+            file_names.push_back(file_name);
+        }
+    }
+
+    double MeasureSharedPull()
+    {
+        const auto start = clock::now();
+        double result = 0;
+        {
+            run::ThreadPull pull(args.n_threads(), false);
+            std::vector<std::future<double>> results;
+            for(const auto& file_name : file_names) {
+                results.push_back(pull.run([this](const std::string& name) {
+                    double sum = 0;
+                    ReadFile(name, [&](const ChunkPtr& chunk) { sum += Process(*chunk); });
+                    return sum;
+                }, file_name));
+            }
+            for(auto& file_result : results)
+                result += file_result.get();
+        }
+        Report("shared pull", start);
+        return result;
+    }
+
+    double MeasureExecutors(run::ThreadAffinity affinity)
+    {
+        static const std::map<run::ThreadAffinity, std::string> affinity_names = {
+            { run::ThreadAffinity::None, "none" }, { run::ThreadAffinity::NumaNode, "NUMA node" },
+            { run::ThreadAffinity::Core, "core" },
+        };
+        run::Executors::Config config;
+        config.io = run::ThreadPullConfig(args.n_io_threads());
+        config.compute = run::ThreadPullConfig(args.n_threads(), affinity);
+
+        const auto start = clock::now();
+        std::vector<double> chunk_results;
+        {
+            run::Executors executors(config, false);
+            std::mutex mutex;
+            std::vector<std::future<double>> compute_results;
+            std::vector<std::future<void>> io_results;
+            for(const auto& file_name : file_names) {
+                io_results.push_back(executors.run_io([&](const std::string& name) {
+                    ReadFile(name, [&](const ChunkPtr& chunk) {
+                        auto result = executors.run_compute([this](const ChunkPtr& c) { return Process(*c); }, chunk);
+                        std::lock_guard<std::mutex> lock(mutex);
+                        compute_results.push_back(std::move(result));
+                    });
+                }, file_name));
+            }
+            for(auto& io_result : io_results)
+                io_result.get();
+            for(auto& compute_result : compute_results)
+                chunk_results.push_back(compute_result.get());
+        }
+        Report("separate executors, affinity: " + affinity_names.at(affinity), start);
+
+        // Chunk results are rounded, so the sum does not depend on the order of the chunks.
+        double result = 0;
+        for(double chunk_result : chunk_results)
+            result += chunk_result;
+        return result;
+    }
+
+    template<typename Callback>
+    void ReadFile(const std::string& file_name, Callback&& callback) const
+    {
+        auto file = root_ext::OpenRootFile(file_name);
+        bench::PoolEventTree tree(file.get(), true);
+        const Long64_t n_entries = tree.GetEntries();
+        for(Long64_t first = 0; first < n_entries; first += args.chunk_size()) {
+            auto chunk = std::make_shared<Chunk>();
+            const Long64_t last = std::min<Long64_t>(first + args.chunk_size(), n_entries);
+            chunk->reserve(static_cast<size_t>(last - first));
+            for(Long64_t entry = first; entry < last; ++entry) {
+                tree.GetEntry(entry);
+                chunk->push_back(tree());
+            }
+            callback(chunk);
+        }
+    }
+
+    // CPU-bound processing: the sum of the invariant masses of all jet pairs, repeated n_iterations times.
+    double Process(const Chunk& chunk) const
+    {
+        double sum = 0;
+        for(unsigned iteration = 0; iteration < args.n_iterations(); ++iteration) {
+            for(const auto& event : chunk) {
+                for(size_t i = 0; i < event.jet_pt.size(); ++i) {
+                    for(size_t j = i + 1; j < event.jet_pt.size(); ++j) {
+                        const double m2 = 2 * event.jet_pt[i] * event.jet_pt[j]
+                                * (std::cosh(event.jet_eta[i] - event.jet_eta[j])
+                                   - std::cos(event.jet_phi[i] - event.jet_phi[j]));
+                        sum += std::sqrt(std::max(m2, 0.)) * event.weight;
+                    }
+                }
+            }
+        }
+        return std::round(sum);
+    }
+
+    void Report(const std::string& name, const clock::time_point& start) const
+    {
+        const double time = std::chrono::duration<double>(clock::now() - start).count();
+        const double n_k_entries = args.n_files() * (args.n_entries() / 1000.);
+        std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(10) << time << std::setprecision(1) << std::setw(12) << n_k_entries / time
+                  << std::endl;
+    }
+
+    static void FillEvent(bench::PoolEvent& event, unsigned n, std::mt19937_64& gen)
+    {
+        std::uniform_real_distribution<float> uniform(0.f, 1.f);
+        std::exponential_distribution<float> pt(1.f / 40.f);
+        std::poisson_distribution<unsigned> n_jets(6.);
+
+        event.evt = n;
+        event.met_pt = pt(gen);
+        event.met_phi = 6.28f * uniform(gen) - 3.14f;
+        event.weight = 0.5 + uniform(gen);
+        const unsigned n_jet = n_jets(gen);
+        for(unsigned jet = 0; jet < n_jet; ++jet) {
+            event.jet_pt.push_back(20 + pt(gen));
+            event.jet_eta.push_back(9.4f * uniform(gen) - 4.7f);
+            event.jet_phi.push_back(6.28f * uniform(gen) - 3.14f);
+            event.jet_btag.push_back(uniform(gen));
+        }
+    }
+
+private:
+    Arguments args;
+    std::vector<std::string> file_names;
+};
+
+PROGRAM_MAIN(Benchmark_ThreadPull, Arguments)
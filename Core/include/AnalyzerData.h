@@ -3,10 +3,12 @@ This file is part of https://github.com/hh-italian-group/AnalysisTools. */
 
 #pragma once
 
+#include <atomic>
 #include <vector>
 #include <unordered_map>
 #include <utility>
 
+#include "MemoryAccounting.h"
 #include "RootExt.h"
 #include "TextIO.h"
 #include "SmartHistogram.h"
@@ -91,6 +93,15 @@ public:
     void AddHistogram(HistPtr hist);
     const HistContainer& GetHistograms() const;
 
+    // Estimated memory used by the histograms. The usage is reported to the global memory accounting under the
+    // "AnalyzerData" component when histograms are added, after each MemoryUpdateInterval histogram accesses through
+    // the entries, before the histograms are written and when UpdateMemoryUsage is called. So the growth after the
+    // creation (e.g. Sumw2 or filled vector-backed histograms) is accounted.
+    static constexpr size_t MemoryUpdateInterval = 100000;
+    size_t GetMemoryUsage() const;
+    void UpdateMemoryUsage();
+    void NotifyHistogramAccess();
+
     template<typename Histogram>
     std::map<std::string, std::shared_ptr<SmartHistogram<Histogram>>> GetHistogramsEx() const
     {
@@ -129,6 +140,8 @@ private:
     EntryContainer entries;
     HistContainer histograms;
     std::unique_ptr<Mutex> mutex;
+    analysis::MemoryTracker memory_tracker{"AnalyzerData"};
+    std::atomic<size_t> n_histogram_accesses{0};
 };
 
 
@@ -155,6 +168,7 @@ struct AnalyzerDataEntry : AnalyzerDataEntryBase  {
     Hist& operator()()
     {
         std::lock_guard<Mutex> lock(GetMutex());
+        data->NotifyHistogramAccess();
         if(!default_hist) {
             default_hist = std::make_shared<Hist>(GetMasterHist());
             histograms[""] = default_hist;
@@ -170,6 +184,7 @@ struct AnalyzerDataEntry : AnalyzerDataEntryBase  {
         const auto key = SuffixToKey(std::forward<KeySuffix>(suffix)...);
         if(key == "")
             return (*this)();
+        data->NotifyHistogramAccess();
         auto iter = histograms.find(key);
         if(iter != histograms.end())
             return *iter->second;
@@ -0,0 +1,49 @@
+/*! Definition of the constant-time bin look-up for the variable-width binning.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace analysis {
+
+// Finds the bin of a variable-width binning using a uniform fine grid over the binning range. Each grid cell stores
+// the bin that contains the low edge of the cell. The grid step does not exceed the width of the narrowest bin
+// (unless the grid size limit is reached), so the candidate bin taken from the grid needs at most one correction
+// step, apart from the rounding at the cell boundaries. The correction makes the result exact in all cases. Bin
+// numbering follows TAxis::FindBin for a non-extendable axis: 0 is the underflow and n_bins + 1 is
+// the overflow (including NaN), bin i covers [edges[i-1], edges[i]).
+class VariableBinLookup {
+public:
+    static constexpr size_t DefaultMaxGridSize = 1 << 16;
+
+    explicit VariableBinLookup(const std::vector<double>& _edges, size_t max_grid_size = DefaultMaxGridSize);
+
+    int FindBin(double x) const
+    {
+        if(x < x_min) return 0;
+        if(!(x < x_max)) return n_bins + 1;
+        size_t cell = static_cast<size_t>((x - x_min) * inv_cell_width);
+        if(cell >= grid.size())
+            cell = grid.size() - 1;
+        int bin = grid[cell];
+        while(x < edges[static_cast<size_t>(bin - 1)])
+            --bin;
+        while(!(x < edges[static_cast<size_t>(bin)]))
+            ++bin;
+        return bin;
+    }
+
+    int GetNbins() const { return n_bins; }
+    const std::vector<double>& GetEdges() const { return edges; }
+    size_t GetGridSize() const { return grid.size(); }
+
+private:
+    std::vector<double> edges;
+    std::vector<int> grid;
+    int n_bins;
+    double x_min, x_max, inv_cell_width;
+};
+
+} // namespace analysis
@@ -0,0 +1,52 @@
+/*! Helpers to write and read values in the native binary format, used by the catalog files.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include "AnalysisTools/Core/include/exception.h"
+
+namespace analysis {
+namespace binary_io {
+
+template<typename T>
+void WriteValue(std::ostream& os, const T& value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be written.");
+    os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Strings are stored as the 32-bit length followed by the characters.
+inline void WriteString(std::ostream& os, const std::string& str)
+{
+    WriteValue(os, static_cast<uint32_t>(str.size()));
+    os.write(str.data(), static_cast<std::streamsize>(str.size()));
+}
+
+template<typename T>
+T ReadValue(std::istream& is)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be read.");
+    T value;
+    is.read(reinterpret_cast<char*>(&value), sizeof(T));
+    if(!is)
+        throw exception("Unexpected end of the binary data.");
+    return value;
+}
+
+inline std::string ReadString(std::istream& is)
+{
+    const auto size = ReadValue<uint32_t>(is);
+    std::string str(size, '\0');
+    is.read(&str[0], static_cast<std::streamsize>(size));
+    if(!is)
+        throw exception("Unexpected end of the binary data.");
+    return str;
+}
+
+} // namespace binary_io
+} // namespace analysis
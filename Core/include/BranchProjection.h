@@ -0,0 +1,40 @@
+/*! Definition of the parallel projection of a tree branch from multiple files into histograms.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <TH1.h>
+
+namespace analysis {
+
+// Fills a histogram with the values of a branch, separately for each input file. Files are processed in parallel.
+// Branch values are read directly with the branch type, without TTreeFormula: scalar branches of the fundamental
+// types are read basket by basket with the bulk I/O, and the other branches entry by entry. For branches of the
+// std::vector type all elements are filled, as in TTree::Draw. Any other TTree::Draw expression (formula, member of
+// an object, array branch, etc.) is evaluated with TTreeFormula.
+class BranchProjection {
+public:
+    using HistPtr = std::shared_ptr<TH1D>;
+
+    BranchProjection(const std::string& _tree_name, const std::string& _branch_name, int _n_bins, double _x_min,
+                     double _x_max);
+
+    // Returns histograms in the order of the input files. If n_threads is 0, the number of threads is chosen
+    // automatically.
+    std::vector<HistPtr> Project(const std::vector<std::string>& file_names, unsigned n_threads = 0) const;
+    HistPtr ProjectFile(const std::string& file_name) const;
+
+private:
+    HistPtr CreateHistogram() const;
+    void Fill(const std::string& file_name, TH1D& hist) const;
+
+private:
+    std::string tree_name, branch_name;
+    int n_bins;
+    double x_min, x_max;
+};
+
+} // namespace analysis
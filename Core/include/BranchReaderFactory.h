@@ -0,0 +1,74 @@
+/*! Definition of the factory of typed readers for the branches with fundamental and std::vector value types.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <Rtypes.h>
+
+class TBranch;
+
+namespace root_ext {
+
+enum class BranchValueKind { Unsupported, Scalar, Vector };
+
+// Value type of a branch: a single fundamental value or a std::vector of the fundamental values. Branches with
+// C-style arrays (fixed or variable length), several leaves or objects of other classes are unsupported, because
+// their values can't be read into a single variable of the fundamental type.
+struct BranchValueType {
+    BranchValueKind kind{BranchValueKind::Unsupported};
+    EDataType data_type{kOther_t};
+    std::string reason; // why the branch is unsupported
+
+    bool IsSupported() const { return kind != BranchValueKind::Unsupported; }
+};
+
+BranchValueType GetBranchValueType(TBranch& branch);
+
+// Placeholder for the value kinds that are not supported by the reader.
+template<typename T>
+struct UnsupportedBranchReader {
+    static constexpr std::nullptr_t Make = nullptr;
+};
+
+// Finds the Make method of ScalarReader<T> or VectorReader<T>, where T is the fundamental value type of the branch.
+// Returns nullptr, if the branch is not supported.
+template<typename MakeMethodPtr, template<typename> class ScalarReader,
+         template<typename> class VectorReader = UnsupportedBranchReader>
+struct BranchReaderFactory {
+    static MakeMethodPtr FindMakeMethod(TBranch& branch)
+    {
+        const BranchValueType value_type = GetBranchValueType(branch);
+        if(value_type.kind == BranchValueKind::Scalar)
+            return FindMakeMethod<ScalarReader>(value_type.data_type);
+        if(value_type.kind == BranchValueKind::Vector)
+            return FindMakeMethod<VectorReader>(value_type.data_type);
+        return nullptr;
+    }
+
+private:
+    template<template<typename> class Reader>
+    static MakeMethodPtr FindMakeMethod(EDataType data_type)
+    {
+        static const std::map<EDataType, MakeMethodPtr> makeMethods = {
+            { kChar_t, Reader<Char_t>::Make },
+            { kUChar_t, Reader<UChar_t>::Make },
+            { kShort_t, Reader<Short_t>::Make },
+            { kUShort_t, Reader<UShort_t>::Make },
+            { kInt_t, Reader<Int_t>::Make },
+            { kUInt_t, Reader<UInt_t>::Make },
+            { kLong_t, Reader<Long_t>::Make },
+            { kULong_t, Reader<ULong_t>::Make },
+            { kLong64_t, Reader<Long64_t>::Make },
+            { kULong64_t, Reader<ULong64_t>::Make },
+            { kFloat_t, Reader<Float_t>::Make },
+            { kDouble_t, Reader<Double_t>::Make },
+            { kBool_t, Reader<Bool_t>::Make },
+        };
+        auto iter = makeMethods.find(data_type);
+        return iter != makeMethods.end() ? iter->second : nullptr;
+    }
+};
+
+} // namespace root_ext
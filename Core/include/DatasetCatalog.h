@@ -0,0 +1,80 @@
+/*! Definition of the catalog that caches metadata of the dataset files.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <Rtypes.h>
+
+class TDirectory;
+
+namespace analysis {
+
+class DatasetCatalog {
+public:
+    struct TreeInfo {
+        std::string name;
+        Long64_t n_entries{0};
+        std::vector<Long64_t> cluster_starts;
+        bool has_weights{false};
+        double sum_weights{0};
+    };
+
+    struct FileInfo {
+        std::string path;
+        uint64_t size{0};
+        int64_t mtime{0};
+        std::string weight_branch;
+        std::vector<TreeInfo> trees;
+
+        const TreeInfo* FindTree(const std::string& tree_name) const;
+    };
+
+    struct EntryRange {
+        std::string file;
+        Long64_t first_entry, last_entry;
+        Long64_t size() const { return last_entry - first_entry; }
+    };
+
+    using FileMap = std::map<std::string, FileInfo>;
+
+    static constexpr uint32_t FormatVersion = 1;
+
+    // Loads the catalog from the index file, if it exists.
+    explicit DatasetCatalog(const std::string& index_file);
+
+    // Brings the catalog in sync with the given list of files: new or modified files are (re)scanned in parallel,
+    // and files that are not in the list are removed from the catalog.
+    // Returns the number of (re)scanned files.
+    size_t Update(const std::vector<std::string>& files, const std::string& weight_branch = "",
+                  unsigned n_threads = 1);
+    void Save() const;
+
+    const FileMap& GetFiles() const { return files; }
+    bool Has(const std::string& path) const { return files.count(path) != 0; }
+    const FileInfo& at(const std::string& path) const;
+
+    Long64_t TotalEntries(const std::string& tree_name) const;
+    double TotalSumOfWeights(const std::string& tree_name) const;
+
+    // Splits the entries of the given tree into ranges with at most max_entries (unless a single cluster is larger),
+    // aligned to the cluster boundaries.
+    std::vector<EntryRange> PlanSplits(const std::string& tree_name, Long64_t max_entries) const;
+
+    static FileInfo ScanFile(const std::string& path, const std::string& weight_branch);
+    static bool IsUpToDate(const FileInfo& info, const std::string& weight_branch);
+
+private:
+    static void ScanDirectory(TDirectory& dir, const std::string& dir_name, const std::string& weight_branch,
+                              std::vector<TreeInfo>& trees);
+    void Load();
+
+private:
+    std::string index_file;
+    FileMap files;
+};
+
+} // namespace analysis
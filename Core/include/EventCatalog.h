@@ -0,0 +1,93 @@
+/*! Definition of the dataset-wide catalog that maps event identifiers to their location in the dataset files.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <Rtypes.h>
+#include "EventIdentifier.h"
+
+namespace boost { namespace interprocess { class mapped_region; } }
+
+namespace analysis {
+
+// Sorted catalog of (run, lumi, evt) -> (file index, entry) records.
+// The records are stored in the catalog file as a plain sorted array which is memory-mapped on open, so a lookup
+// costs a binary search over the mapped pages and does not require to load the whole catalog in memory.
+class EventCatalog {
+public:
+    // Packed record: run and lumi share the first word, file index and entry share the last one.
+    struct Record {
+        static constexpr unsigned EntryBits = 40;
+        static constexpr uint64_t MaxRunLumi = std::numeric_limits<uint32_t>::max();
+        static constexpr uint64_t MaxFileIndex = (uint64_t(1) << (64 - EntryBits)) - 1;
+        static constexpr uint64_t MaxEntry = (uint64_t(1) << EntryBits) - 1;
+
+        uint64_t run_lumi, event, location;
+
+        static Record Make(const EventIdentifier& id, size_t file_index, Long64_t entry);
+        static uint64_t PackRunLumi(const EventIdentifier& id);
+
+        EventIdentifier Id() const;
+        uint32_t FileIndex() const { return static_cast<uint32_t>(location >> EntryBits); }
+        Long64_t Entry() const { return static_cast<Long64_t>(location & MaxEntry); }
+
+        bool operator<(const Record& other) const;
+    };
+
+    struct FileEntry {
+        std::string path;
+        uint64_t size{0};
+        int64_t mtime{0};
+        Long64_t n_entries{0};
+    };
+
+    struct Match {
+        EventIdentifier id;
+        Long64_t entry;
+    };
+
+    // Matches grouped by the file index. Entries inside each file are sorted.
+    using FileMatches = std::map<uint32_t, std::vector<Match>>;
+
+    static constexpr uint32_t FormatVersion = 1;
+    static const std::string& DefaultIdBranches();
+
+    explicit EventCatalog(const std::string& catalog_file);
+
+    const std::string& TreeName() const { return tree_name; }
+    const std::vector<std::string>& IdBranches() const { return id_branches; }
+    const std::vector<FileEntry>& GetFiles() const { return files; }
+    size_t size() const { return n_records; }
+    const Record* begin() const { return records; }
+    const Record* end() const { return records + n_records; }
+
+    std::pair<const Record*, const Record*> Find(const EventIdentifier& id) const;
+    FileMatches Locate(const std::vector<EventIdentifier>& ids, std::vector<EventIdentifier>* not_found = nullptr) const;
+
+    // Brings the catalog in sync with the given list of files. The records of the unchanged files are taken from the
+    // existing catalog, new or modified files are scanned in parallel and merged in.
+    // Returns the number of scanned files.
+    static size_t Update(const std::string& catalog_file, const std::vector<std::string>& file_list,
+                         const std::string& tree_name, const std::string& id_branches, unsigned n_threads = 1);
+    static void Write(const std::string& catalog_file, const std::string& tree_name, const std::string& id_branches,
+                      const std::vector<FileEntry>& files, const std::vector<Record>& sorted_records);
+    static std::vector<Record> ScanFile(const std::string& path, size_t file_index, const std::string& tree_name,
+                                       const std::vector<std::string>& id_branches, FileEntry& file_entry);
+    static bool IsUpToDate(const FileEntry& file_entry);
+
+private:
+    std::shared_ptr<boost::interprocess::mapped_region> region;
+    std::string tree_name;
+    std::vector<std::string> id_branches;
+    std::vector<FileEntry> files;
+    const Record* records{nullptr};
+    size_t n_records{0};
+};
+
+} // namespace analysis
@@ -0,0 +1,101 @@
+/*! Definition of deterministic event sharding and sampling based on the event identifier hash.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include "EventIdentifier.h"
+
+namespace analysis {
+
+// Selects events by the hash of (run, lumi, evt), so the decision depends only on the event itself and not on the
+// order of input files or entries. The hash space [0, 2^64) is split into intervals: shard k of N selects the k-th
+// of N equal intervals, fraction range [a, b) selects hashes in [a * 2^64, b * 2^64).
+// Shards of the same N (or adjacent fraction ranges) with the same seed are disjoint and cover all events.
+class EventSampler {
+public:
+    using IdType = EventIdentifier::IdType;
+
+    static constexpr uint64_t DefaultSeed = 0;
+
+    static constexpr uint64_t Mix(uint64_t x)
+    {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+    static constexpr uint64_t Hash(IdType run, IdType lumi, IdType evt, uint64_t seed = DefaultSeed)
+    {
+        return Mix(Mix(Mix(seed + 0x9e3779b97f4a7c15ULL * (run + 1)) ^ lumi) ^ evt);
+    }
+
+    // Selects all events.
+    EventSampler() : EventSampler(0, std::numeric_limits<uint64_t>::max(), DefaultSeed) {}
+
+    static EventSampler Shard(size_t shard_index, size_t n_shards, uint64_t seed = DefaultSeed);
+    static EventSampler Fraction(double fraction, uint64_t seed = DefaultSeed);
+    static EventSampler FractionRange(double begin, double end, uint64_t seed = DefaultSeed);
+
+    // Accepted formats: "k/N" - shard k of N (k = 0..N-1), "x%" - x percents of events,
+    // "a:b" - fraction range [a, b) (e.g. "0:0.8" and "0.8:1" for train/test split).
+    static EventSampler Parse(const std::string& str, uint64_t seed = DefaultSeed);
+
+    uint64_t Seed() const { return seed; }
+    uint64_t LowerBound() const { return lower; }
+    uint64_t WidthMinusOne() const { return width_minus_one; }
+    bool SelectsAll() const { return width_minus_one == std::numeric_limits<uint64_t>::max(); }
+
+    bool Accept(IdType run, IdType lumi, IdType evt) const
+    {
+        return Hash(run, lumi, evt, seed) - lower <= width_minus_one;
+    }
+
+    bool operator()(const EventIdentifier& id) const { return Accept(id.runId, id.lumiBlock, id.eventId); }
+
+    template<typename Event>
+    bool operator()(const Event& event) const { return Accept(event.run, event.lumi, event.evt); }
+
+    // Evaluates the selection for n events stored in the id columns. The loop has no branches and is vectorized by
+    // the compiler for the common column types.
+    template<typename Run, typename Lumi, typename Evt>
+    void Select(const Run* run, const Lumi* lumi, const Evt* evt, size_t n, uint8_t* mask) const
+    {
+        for(size_t i = 0; i < n; ++i)
+            mask[i] = Hash(static_cast<IdType>(run[i]), static_cast<IdType>(lumi[i]), static_cast<IdType>(evt[i]),
+                           seed) - lower <= width_minus_one;
+    }
+
+    // Same as Select, but returns the number of selected events and writes their indices to the output.
+    template<typename Run, typename Lumi, typename Evt>
+    size_t SelectIndices(const Run* run, const Lumi* lumi, const Evt* evt, size_t n, size_t* indices) const
+    {
+        size_t n_selected = 0;
+        for(size_t i = 0; i < n; ++i) {
+            indices[n_selected] = i;
+            n_selected += Hash(static_cast<IdType>(run[i]), static_cast<IdType>(lumi[i]),
+                               static_cast<IdType>(evt[i]), seed) - lower <= width_minus_one;
+        }
+        return n_selected;
+    }
+
+    std::string ToString() const;
+
+private:
+    EventSampler(uint64_t _lower, uint64_t _width_minus_one, uint64_t _seed) :
+        lower(_lower), width_minus_one(_width_minus_one), seed(_seed) {}
+
+private:
+    uint64_t lower, width_minus_one, seed;
+    std::string description;
+};
+
+std::ostream& operator<<(std::ostream& s, const EventSampler& sampler);
+
+} // namespace analysis
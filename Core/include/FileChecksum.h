@@ -0,0 +1,89 @@
+/*! Definition of checksums of file contents and of the persistent checksum cache.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <boost/crc.hpp>
+#include "AnalysisTools/Core/include/EnumNameMap.h"
+
+namespace analysis {
+
+enum class ChecksumType { CRC32, Adler32, XXH64 };
+ENUM_NAMES(ChecksumType) = {
+    { ChecksumType::CRC32, "crc32" },
+    { ChecksumType::Adler32, "adler32" },
+    { ChecksumType::XXH64, "xxh64" },
+};
+
+// Streaming checksum: data can be processed in several consecutive calls.
+class Checksum {
+public:
+    explicit Checksum(ChecksumType type);
+
+    void Process(const void* data, size_t size);
+    uint64_t Value() const;
+    ChecksumType GetType() const { return type; }
+
+    static std::string ToString(uint64_t value, ChecksumType type = ChecksumType::CRC32);
+
+    // CRC32 and Adler32 of the concatenated data can be computed from the checksums of the parts, so large files
+    // can be processed in independent chunks.
+    static bool IsCombinable(ChecksumType type) { return type != ChecksumType::XXH64; }
+    static uint64_t Combine(ChecksumType type, uint64_t first, uint64_t second, uint64_t second_size);
+
+private:
+    void ProcessXXH64(const unsigned char* data, size_t size);
+    uint64_t XXH64Value() const;
+
+private:
+    struct XXH64State {
+        uint64_t acc[4];
+        uint64_t total_size{0};
+        unsigned char buffer[32];
+        size_t buffer_size{0};
+    };
+
+    ChecksumType type;
+    boost::crc_32_type crc;
+    uint32_t adler_a{1}, adler_b{0};
+    XXH64State xxh;
+};
+
+uint64_t ComputeFileChecksum(const std::string& path, ChecksumType type, size_t buffer_size = 4 << 20);
+
+// Checksums of files stored together with the file size and modification time, so the checksum is recomputed only
+// if the file has been changed. Access is thread safe.
+class ChecksumCache {
+public:
+    struct Entry {
+        uint64_t size{0};
+        int64_t mtime{0};
+        uint64_t checksum{0};
+    };
+
+    // Loads the cache from the file, if it exists. Empty file name means that the cache is kept only in memory.
+    explicit ChecksumCache(const std::string& file_name);
+
+    bool Find(const std::string& path, ChecksumType type, uint64_t& checksum) const;
+    void Add(const std::string& path, ChecksumType type, uint64_t checksum);
+    // Returns the cached checksum or computes it and adds to the cache.
+    uint64_t Get(const std::string& path, ChecksumType type);
+    void Save() const;
+
+    size_t size() const;
+
+private:
+    using EntryKey = std::pair<std::string, ChecksumType>;
+    static std::string CacheKey(const std::string& path);
+
+private:
+    std::string file_name;
+    std::map<EntryKey, Entry> entries;
+    mutable std::mutex mutex;
+};
+
+} // namespace analysis
@@ -0,0 +1,74 @@
+/*! Definition of the service that opens ROOT files asynchronously ahead of their processing.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include <TFile.h>
+
+namespace run { class ThreadPull; }
+
+namespace root_ext {
+
+struct FileOpenServiceConfig {
+    size_t n_ahead{2}; // number of files that are opened ahead of the consumer; 0 - open synchronously
+    unsigned n_attempts{3};
+    double initial_backoff{1}; // seconds
+    double backoff_factor{2};
+    double max_backoff{30}; // seconds
+};
+
+// Opens the input files in the background, at most n_ahead files ahead of the consumer, and hands them out in the
+// input order. The number of files that are being opened at the same time is limited globally for all services in
+// the process, so the storage system is not flooded by concurrent requests. Failed opens are retried with an
+// exponential backoff; if all attempts fail, the error is reported when the corresponding file is requested.
+// Local files that do not exist or are not readable are reported at the first attempt.
+// If the global executors are defined (see run::Executors), the files are opened on their I/O executor, otherwise
+// the service starts its own threads. ROOT thread safety is enabled only when read-ahead is used, so a service with
+// n_ahead = 0 or without input files does not change the global state of ROOT.
+class FileOpenService {
+public:
+    using FilePtr = std::shared_ptr<TFile>;
+    using Opener = std::function<FilePtr(const std::string&)>;
+
+    using Config = FileOpenServiceConfig;
+
+    // If opener is not specified, root_ext::OpenRootFile is used.
+    explicit FileOpenService(const std::vector<std::string>& _file_names, const Config& _config = Config(),
+                             const Opener& _opener = Opener());
+    FileOpenService(const FileOpenService&) = delete;
+    FileOpenService& operator=(const FileOpenService&) = delete;
+    ~FileOpenService();
+
+    // Returns the next file in the input order, waiting until it is opened. After the last file, returns false
+    // (nullptr for the second overload).
+    bool Next(std::string& file_name, FilePtr& file);
+    FilePtr Next();
+
+    size_t size() const { return file_names.size(); }
+    size_t GetNumberOfConsumedFiles() const { return n_consumed; }
+
+    // Global limit on the number of files that are being opened at the same time (default: 4).
+    static void SetMaxConcurrentOpens(size_t max_concurrent_opens);
+    static size_t GetMaxConcurrentOpens();
+
+private:
+    void Schedule();
+    FilePtr Open(const std::string& file_name) const;
+
+private:
+    std::vector<std::string> file_names;
+    Config config;
+    Opener opener;
+    std::unique_ptr<run::ThreadPull> pool;
+    std::deque<std::future<FilePtr>> pending;
+    size_t n_scheduled{0}, n_consumed{0};
+    bool read_ahead{false};
+};
+
+} // namespace root_ext
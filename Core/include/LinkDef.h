@@ -1,4 +1,7 @@
 /*! Definition of pre-processor directives to generate ROOT dictionaries.
+Collections supported by BranchEntryFactory and used as branch types of the DECLARE_TREE data classes, for which ROOT
+does not provide a compiled dictionary, are listed here to avoid header parsing by the interpreter at run time.
+Data classes themselves do not need dictionaries, since each data member is stored in a separate branch.
 This file is part of https://github.com/hh-italian-group/AnalysisTools. */
 
 #pragma once
@@ -12,4 +15,9 @@ This file is part of https://github.com/hh-italian-group/AnalysisTools. */
 #pragma link C++ class std::vector<ROOT::Math::LorentzVector<ROOT::Math::PtEtaPhiM4D<float>>>;
 #pragma link C++ class std::vector<ROOT::Math::LorentzVector<ROOT::Math::PxPyPzE4D<float>>>;
 #pragma link C++ class std::vector<ROOT::Math::LorentzVector<ROOT::Math::PxPyPzM4D<float>>>;
+#pragma link C++ class std::vector<ROOT::Math::PositionVector3D<ROOT::Math::Cartesian3D<float>,ROOT::Math::DefaultCoordinateSystemTag>>;
+#pragma link C++ class std::vector<std::vector<int>>;
+#pragma link C++ class std::vector<std::vector<float>>;
+#pragma link C++ class std::vector<std::vector<double>>;
+#pragma link C++ class std::map<std::string,float>;
 #endif
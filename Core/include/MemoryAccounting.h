@@ -0,0 +1,117 @@
+/*! Definition of the accounting of the memory used by the major components of the library.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class TH1;
+class TTree;
+
+namespace analysis {
+
+// Process-wide registry of the memory used by the library components (AnalyzerData, SmartTree, RootFilesMerger,
+// etc.). Usage is reported by the components with explicit size estimates and aggregated by the component name and
+// by the directory (output directory, tree path or any other grouping chosen by the component). For each entry, each
+// component and for the total, the current and the peak values are kept.
+class MemoryAccounting {
+public:
+    struct Usage {
+        size_t current{0}, peak{0};
+    };
+
+    using Key = std::pair<std::string, std::string>; // component, directory
+    using UsageMap = std::map<Key, Usage>;
+
+    static MemoryAccounting& Global();
+
+    // Changes the usage of the given component and directory by delta bytes.
+    void Add(const std::string& component, const std::string& directory, int64_t delta);
+
+    Usage GetUsage(const std::string& component, const std::string& directory) const;
+    Usage GetComponentUsage(const std::string& component) const;
+    Usage GetTotalUsage() const;
+    UsageMap GetUsageByDirectory() const;
+    std::map<std::string, Usage> GetUsageByComponent() const;
+    bool empty() const;
+    void clear();
+
+    // Prints the current and peak usage by component and directory, together with the resident memory of the process.
+    void PrintSummary(std::ostream& os) const;
+
+    // Resident memory of the process and its peak value (0, if not available).
+    static Usage GetProcessResidentMemory();
+
+    // The summary is printed at the end of the programs (see program_main.h) only if the environment variable
+    // ANALYSIS_TOOLS_MEMORY_SUMMARY is set to a non-empty value other than "0".
+    static bool IsSummaryRequested();
+
+private:
+    static void Update(Usage& usage, int64_t delta);
+
+private:
+    mutable std::mutex mutex;
+    UsageMap entries;
+    std::map<std::string, Usage> components;
+    Usage total;
+};
+
+// Reports the memory used by one object to the global accounting. Contribution of the tracker is removed, when it is
+// destroyed, so the current usage of the component reflects only the live objects.
+class MemoryTracker {
+public:
+    explicit MemoryTracker(const std::string& _component, const std::string& _directory = "");
+    MemoryTracker(const MemoryTracker&) = delete;
+    MemoryTracker& operator=(const MemoryTracker&) = delete;
+    ~MemoryTracker();
+
+    void Update(size_t bytes);
+    void Add(size_t bytes);
+    void SetDirectory(const std::string& _directory);
+
+    const std::string& GetComponent() const { return component; }
+    const std::string& GetDirectory() const { return directory; }
+    size_t GetCurrent() const { return current; }
+
+private:
+    std::string component, directory;
+    size_t current{0};
+};
+
+// Size estimates of the standard containers: allocated elements and, for the node-based containers, the node
+// overhead of the typical implementation (3 pointers and the color for the tree node, 1 pointer for the hash node
+// and 1 pointer per bucket).
+template<typename T, typename Alloc>
+size_t EstimateMemoryUsage(const std::vector<T, Alloc>& v) { return v.capacity() * sizeof(T); }
+
+template<typename K, typename T, typename Compare, typename Alloc>
+size_t EstimateMemoryUsage(const std::map<K, T, Compare, Alloc>& m)
+{
+    return m.size() * (sizeof(typename std::map<K, T, Compare, Alloc>::value_type) + 4 * sizeof(void*));
+}
+
+template<typename K, typename T, typename Hash, typename KeyEqual, typename Alloc>
+size_t EstimateMemoryUsage(const std::unordered_map<K, T, Hash, KeyEqual, Alloc>& m)
+{
+    using Map = std::unordered_map<K, T, Hash, KeyEqual, Alloc>;
+    return m.size() * (sizeof(typename Map::value_type) + sizeof(void*)) + m.bucket_count() * sizeof(void*);
+}
+
+} // namespace analysis
+
+namespace root_ext {
+
+// Memory used by the histogram bins: contents, sum of squares of weights and variable bin edges.
+size_t EstimateMemoryUsage(const TH1& hist);
+// Memory used by the tree buffers: one basket buffer per branch and the read cache.
+size_t EstimateMemoryUsage(TTree& tree);
+
+} // namespace root_ext
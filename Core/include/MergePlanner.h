@@ -0,0 +1,63 @@
+/*! Definition of the planner of hierarchical merging of ROOT files.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <Rtypes.h>
+
+namespace analysis {
+
+// Splits the input files into balanced merge tasks and arranges them into a reduction tree: outputs of the tasks at
+// level n are the inputs of the tasks at level n + 1. The last level consists of a single task that produces the
+// final output.
+class MergePlanner {
+public:
+    struct Input {
+        std::string path;
+        uint64_t size{0};
+        Long64_t n_entries{0};
+    };
+
+    struct Task {
+        size_t level{0}, index{0};
+        std::vector<std::string> inputs;
+        std::string output;
+        uint64_t size{0};
+        Long64_t n_entries{0};
+    };
+
+    using Level = std::vector<Task>;
+
+    // Limits per merge task. Zero means that the corresponding quantity is not limited.
+    struct Limits {
+        size_t max_files{100};
+        uint64_t max_size{0};
+        Long64_t max_entries{0};
+    };
+
+    MergePlanner(const Limits& limits, const std::string& work_dir, const std::string& output);
+
+    std::vector<Level> Plan(const std::vector<Input>& inputs) const;
+
+    // Splits inputs into the minimal number of groups allowed by the limits. Inputs are assigned in the order of
+    // decreasing size to the least loaded group (LPT rule), so the groups have similar size and number of entries.
+    // Returns indices of the inputs in each group, sorted in the original order.
+    static std::vector<std::vector<size_t>> Partition(const std::vector<Input>& inputs, const Limits& limits);
+
+    static uint32_t FileChecksum(const std::string& path);
+
+    // The checksum of a merge output is stored next to it in "<path>.crc32", so the task that reads the output at the
+    // next level can verify it, also when the levels run as separate jobs.
+    static std::string ChecksumFileName(const std::string& path);
+    static uint32_t WriteChecksum(const std::string& path);
+    static void VerifyChecksum(const std::string& path);
+
+private:
+    Limits limits;
+    std::string work_dir, output;
+};
+
+} // namespace analysis
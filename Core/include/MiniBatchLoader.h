@@ -0,0 +1,111 @@
+/*! Definition of the streaming loader of shuffled mini-batches for the ML training.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <Rtypes.h>
+#include "AnalysisTools/Run/include/EntryQueue.h"
+
+namespace analysis {
+
+// Mini-batch of events stored in the row-major order: n_features values per event.
+struct MiniBatch {
+    size_t n_features{0};
+    std::vector<float> values;
+
+    size_t size() const { return n_features ? values.size() / n_features : 0; }
+    bool empty() const { return values.empty(); }
+    const float* data() const { return values.data(); }
+    const float* operator[](size_t n) const { return values.data() + n * n_features; }
+};
+
+// Bounded buffer that returns events in a random order. Once the buffer is full, each new event replaces a randomly
+// selected one, which is returned. The order of the returned events depends only on the input order and the seed.
+class ShuffleBuffer {
+public:
+    ShuffleBuffer(size_t _capacity, size_t _n_features, uint64_t seed);
+
+    size_t size() const { return n_events; }
+    bool empty() const { return n_events == 0; }
+
+    // Adds an event. If the buffer is full, a randomly selected event is written to output and true is returned.
+    bool Push(const float* event, float* output);
+    // Removes a randomly selected event from the buffer. Returns false if the buffer is empty.
+    bool Pop(float* output);
+
+private:
+    size_t capacity, n_features, n_events{0};
+    std::vector<float> events;
+    std::mt19937_64 gen;
+};
+
+// Streams fixed-size mini-batches of the selected branches from many root files.
+// Input trees are split into chunks of whole clusters, so each chunk is read by one thread without the basket
+// re-reading. Chunks are read in a random order by the pool of threads and passed to the shuffle buffer in the
+// order of the chunk list, so the sequence of batches is reproducible for the given seed and epoch, independently
+// of the number of threads. Each thread keeps its input file open until it reads a chunk from another file.
+// The batches are prepared in a background thread and kept in the prefetch queue.
+class MiniBatchLoader {
+public:
+    struct Config {
+        std::vector<std::string> files;
+        std::string tree_name;
+        // Scalar numeric branches. Element k of a vector branch can be selected as "name[k]".
+        std::vector<std::string> features;
+        size_t batch_size{256};
+        size_t shuffle_buffer_size{100000}; // no shuffling if 0
+        uint64_t seed{0};
+        size_t n_threads{1};
+        size_t prefetch_size{8}; // number of prepared batches
+        size_t chunk_size{10000}; // minimal number of entries in a chunk
+        float default_value{0}; // value of the missing elements of vector branches
+        bool drop_last{false}; // skip the last incomplete batch of the epoch
+    };
+
+    struct Chunk {
+        size_t file_index;
+        Long64_t first_entry, n_entries;
+    };
+
+    explicit MiniBatchLoader(const Config& _config);
+    MiniBatchLoader(const MiniBatchLoader&) = delete;
+    MiniBatchLoader& operator=(const MiniBatchLoader&) = delete;
+    ~MiniBatchLoader();
+
+    const Config& GetConfig() const { return config; }
+    size_t GetNumberOfFeatures() const { return config.features.size(); }
+    Long64_t GetNumberOfEvents() const { return n_events; }
+    const std::vector<Chunk>& GetChunks() const { return chunks; }
+
+    // Starts streaming of the new epoch. Chunks and events are shuffled differently for each epoch.
+    void StartEpoch(size_t epoch);
+    // Returns false when all events of the current epoch have been returned.
+    bool Next(MiniBatch& batch);
+
+private:
+    using BatchPtr = std::shared_ptr<MiniBatch>;
+    struct ChunkReader;
+
+    void Stop();
+    void Produce(size_t epoch);
+    std::vector<float> ReadChunk(const Chunk& chunk, ChunkReader& reader) const;
+    std::vector<Chunk> CollectChunks(size_t file_index) const;
+
+private:
+    Config config;
+    std::vector<Chunk> chunks;
+    Long64_t n_events{0};
+    std::unique_ptr<run::EntryQueue<BatchPtr>> queue;
+    std::thread producer;
+    std::atomic<bool> stop_requested{false};
+    std::exception_ptr producer_error;
+};
+
+} // namespace analysis
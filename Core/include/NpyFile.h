@@ -0,0 +1,181 @@
+/*! Definition of writer and memory-mapped reader of one-dimensional arrays in the NumPy .npy format.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "AnalysisTools/Core/include/exception.h"
+
+namespace boost { namespace interprocess { class mapped_region; } }
+
+namespace analysis {
+
+// NumPy type descriptor of the C++ type. Data are stored in the native byte order, which is assumed to be
+// little-endian.
+template<typename T>
+struct NpyType;
+
+#define NPY_TYPE(type, descr) \
+    template<> struct NpyType<type> { static const char* Descr() { return descr; } }; \
+    /**/
+
+NPY_TYPE(bool, "|b1")
+NPY_TYPE(char, "|i1")
+NPY_TYPE(signed char, "|i1")
+NPY_TYPE(unsigned char, "|u1")
+NPY_TYPE(short, "<i2")
+NPY_TYPE(unsigned short, "<u2")
+NPY_TYPE(int, "<i4")
+NPY_TYPE(unsigned int, "<u4")
+NPY_TYPE(long, "<i8")
+NPY_TYPE(unsigned long, "<u8")
+NPY_TYPE(long long, "<i8")
+NPY_TYPE(unsigned long long, "<u8")
+NPY_TYPE(float, "<f4")
+NPY_TYPE(double, "<f8")
+
+#undef NPY_TYPE
+
+struct NpyHeader {
+    static constexpr size_t Alignment = 64;
+
+    std::string descr;
+    bool fortran_order{false};
+    std::vector<size_t> shape;
+    size_t data_offset{0};
+
+    size_t NumberOfElements() const;
+    static NpyHeader Parse(const char* data, size_t size, const std::string& file_name);
+};
+
+// Writes a one-dimensional array element by element. The header is written with a fixed size, so the number of
+// elements is updated in place when the file is closed. The data start at a 64-byte aligned offset.
+class NpyWriter {
+public:
+    NpyWriter(const std::string& _file_name, const std::string& _descr, size_t _element_size);
+    NpyWriter(const NpyWriter&) = delete;
+    NpyWriter& operator=(const NpyWriter&) = delete;
+    ~NpyWriter();
+
+    template<typename T>
+    static std::unique_ptr<NpyWriter> Create(const std::string& file_name)
+    {
+        return std::make_unique<NpyWriter>(file_name, NpyType<T>::Descr(), sizeof(T));
+    }
+
+    template<typename T>
+    void Append(const T& value)
+    {
+        if(sizeof(T) != element_size)
+            throw exception("Invalid element size for '%1%'.") % file_name;
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+        ++n_elements;
+        if(buffer.size() >= BufferSize)
+            Flush();
+    }
+
+    size_t size() const { return n_elements; }
+    const std::string& GetFileName() const { return file_name; }
+    void Close();
+
+private:
+    static constexpr size_t BufferSize = 1 << 20;
+
+    std::string CreateHeader(size_t header_size) const;
+    void Flush();
+
+private:
+    std::string file_name, descr;
+    size_t element_size, n_elements{0}, header_size;
+    std::ofstream stream;
+    std::vector<char> buffer;
+};
+
+// Read-only view of a contiguous array.
+template<typename T>
+class NpyArrayView {
+public:
+    NpyArrayView() : first(nullptr), n(0) {}
+    NpyArrayView(const T* _first, size_t _n) : first(_first), n(_n) {}
+
+    const T* data() const { return first; }
+    size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+    const T* begin() const { return first; }
+    const T* end() const { return first + n; }
+    const T& operator[](size_t i) const { return first[i]; }
+    const T& at(size_t i) const
+    {
+        if(i >= n)
+            throw exception("Index %1% is out of range [0, %2%).") % i % n;
+        return first[i];
+    }
+
+private:
+    const T* first;
+    size_t n;
+};
+
+// Maps the .npy file into the memory. The data are accessed without copying.
+class MappedNpyFile {
+public:
+    explicit MappedNpyFile(const std::string& _file_name);
+    ~MappedNpyFile();
+
+    const std::string& GetFileName() const { return file_name; }
+    const NpyHeader& GetHeader() const { return header; }
+    size_t size() const { return header.NumberOfElements(); }
+
+    template<typename T>
+    NpyArrayView<T> View() const
+    {
+        if(header.descr != NpyType<T>::Descr())
+            throw exception("Type '%1%' of array in '%2%' does not correspond to the requested type '%3%'.")
+                % header.descr % file_name % NpyType<T>::Descr();
+        return NpyArrayView<T>(static_cast<const T*>(Data(sizeof(T))), size());
+    }
+
+private:
+    const void* Data(size_t element_size) const;
+
+private:
+    std::string file_name;
+    std::unique_ptr<boost::interprocess::mapped_region> region;
+    NpyHeader header;
+};
+
+// Jagged column stored as the flat array of values (<name>.npy) and the row offsets (<name>.offsets.npy) with
+// n_rows + 1 elements: row i occupies values [offsets[i], offsets[i+1]).
+std::string NpyOffsetsFileName(const std::string& values_file_name);
+
+template<typename T>
+class MappedJaggedColumn {
+public:
+    explicit MappedJaggedColumn(const std::string& values_file_name) :
+        values_file(values_file_name), offsets_file(NpyOffsetsFileName(values_file_name)),
+        values(values_file.View<T>()), offsets(offsets_file.View<uint64_t>())
+    {
+        if(offsets.empty() || offsets[offsets.size() - 1] != values.size())
+            throw exception("Inconsistent offsets of the jagged column '%1%'.") % values_file_name;
+    }
+
+    size_t size() const { return offsets.size() - 1; }
+    const NpyArrayView<T>& GetValues() const { return values; }
+    const NpyArrayView<uint64_t>& GetOffsets() const { return offsets; }
+    NpyArrayView<T> operator[](size_t i) const
+    {
+        return NpyArrayView<T>(values.data() + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+
+private:
+    MappedNpyFile values_file, offsets_file;
+    NpyArrayView<T> values;
+    NpyArrayView<uint64_t> offsets;
+};
+
+} // namespace analysis
@@ -0,0 +1,27 @@
+/*! Conversion of trees between the TTree and the RNTuple formats.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#pragma once
+
+#ifdef ANALYSIS_TOOLS_HAS_RNTUPLE
+
+#include <string>
+#include <Compression.h>
+#include <Rtypes.h>
+
+class TDirectory;
+
+namespace root_ext {
+
+// Converts the top-level tree of the input file into RNTuple with the same name in the output file, which is created
+// or updated. Returns the number of converted entries.
+Long64_t ConvertTreeToNTuple(const std::string& input_file, const std::string& name, const std::string& output_file,
+                             ROOT::ECompressionAlgorithm compression, int compression_level);
+
+// Converts RNTuple into TTree with the same name. Top-level fields are mapped to branches: fundamental types are
+// stored as leaves and all other types as objects using their dictionaries. Returns the number of converted entries.
+Long64_t ConvertNTupleToTree(TDirectory& input_dir, TDirectory& output_dir, const std::string& name);
+
+} // namespace root_ext
+
+#endif
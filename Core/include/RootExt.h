@@ -89,6 +89,9 @@ enum class ClassInheritance { TH1, TTree, TDirectory };
 
 ClassInheritance FindClassInheritance(const std::string& class_name);
 
+// Parses name of the compression algorithm: ZLIB, LZMA, LZ4 or ZSTD.
+ROOT::ECompressionAlgorithm ParseCompressionAlgorithm(const std::string& name);
+
 struct WarningSuppressor {
     const Int_t old_ignore_level;
     WarningSuppressor(Int_t ignore_level)
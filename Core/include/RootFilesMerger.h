@@ -3,15 +3,21 @@ This file is part of https://github.com/hh-italian-group/AnalysisTools. */
 
 #pragma once
 
+#include <functional>
 #include <iostream>
+#include <map>
+#include <set>
 #include <unordered_map>
 #include <TROOT.h>
 #include <TKey.h>
 #include <TSystem.h>
 #include <TTree.h>
 #include <TChain.h>
+#include <TEntryList.h>
 #include <TH1.h>
 #include <memory>
+#include "AnalysisTools/Core/include/EventSampler.h"
+#include "AnalysisTools/Core/include/MemoryAccounting.h"
 #include "AnalysisTools/Core/include/RootExt.h"
 #include "AnalysisTools/Core/include/TextIO.h"
 
@@ -33,8 +39,9 @@ public:
         using ChainPtr = std::unique_ptr<TChain>;
         static std::atomic<size_t>& NumberOfFiles();
         std::vector<std::string> file_names;
+        std::set<int> compression_settings; // compression settings of the input files
         TreeDescriptor();
-        void AddFile(const std::string& file_name);
+        void AddFile(const std::string& file_name, int file_compression_settings);
         ChainPtr CreateChain(const std::string& full_name) const;
     };
 
@@ -53,6 +60,37 @@ public:
         std::hash<std::string> h;
     };
 
+    // Selection, event sampling and branch pruning applied to a tree while merging. Branch names can contain
+    // wildcards. The sampler is evaluated on the event id columns (run, lumi, evt) in addition to the selection. The id
+    // columns are read as integer branches, so 64-bit event numbers reach the sampler unchanged.
+    struct TreeFilter {
+        std::string selection;
+        EventSampler sampler;
+        std::vector<std::string> id_columns{ "run", "lumi", "evt" };
+        std::vector<std::string> include_branches, exclude_branches;
+        bool HasEntrySelection() const { return !selection.empty() || !sampler.SelectsAll(); }
+        bool empty() const { return !HasEntrySelection() && include_branches.empty() && exclude_branches.empty(); }
+        void Apply(TTree& tree) const;
+    };
+
+    // Limits per output file used to split the merged trees into several parts. Zero means not limited.
+    struct SplitLimits {
+        uint64_t max_size{0}; // bytes, estimated from the compressed size of the selected entries and kept branches
+        Long64_t max_entries{0};
+        unsigned n_writers{1};
+        bool enabled() const { return max_size || max_entries; }
+    };
+
+    struct ClusterInfo {
+        Long64_t first_entry, n_entries;
+        double size; // estimated output size
+        Long64_t n_selected; // estimated number of output entries
+    };
+
+    struct EntryRange {
+        Long64_t first_entry{0}, n_entries{0};
+    };
+
     using HistCollection = std::unordered_map<Key, HistDescriptor, KeyHash>;
     using TreeCollection = std::unordered_map<Key, TreeDescriptor, KeyHash>;
 
@@ -64,29 +102,93 @@ public:
     using HistPtr = HistDescriptor::HistPtr;
     using ChainPtr = TreeDescriptor::ChainPtr;
 
+    // Histogram keys are split into shards by their hash. Each shard is merged in a separate pass over the input
+    // files, so only histograms of one shard are kept in memory at the same time.
+    struct HistShard {
+        size_t index, n_shards;
+        HistShard(size_t _index = 0, size_t _n_shards = 1) : index(_index), n_shards(_n_shards) {}
+        bool Contains(const Key& key) const { return n_shards <= 1 || KeyHash()(key) % n_shards == index; }
+    };
+
     RootFilesMerger(const std::string& output, const std::vector<std::string>& input_dirs,
                     const std::string& file_name_pattern, const std::string& exclude_list,
                     const std::string& exclude_dir_list, unsigned n_threads, ROOT::ECompressionAlgorithm compression,
                     int compression_level);
+    RootFilesMerger(const std::string& output, const std::vector<std::string>& input_files, unsigned n_threads,
+                    ROOT::ECompressionAlgorithm compression, int compression_level);
 
     virtual ~RootFilesMerger() {}
 
     void Process(bool process_histograms, bool process_trees);
+
+    // Number of passes over the input files used to merge histograms (1 - all histograms are kept in memory).
+    void SetNumberOfHistogramShards(size_t n_shards);
+    // If set, the number of histogram shards is chosen to keep the estimated memory used by the histograms below
+    // the limit. The estimate is based on the uncompressed size of the histograms stored in the input files.
+    void SetHistogramMemoryLimit(size_t max_bytes);
+    // Sets filter for a tree with the given name (full path or name without directory). Filter with an empty tree
+    // name is applied to all trees without a dedicated filter.
+    void SetTreeFilter(const std::string& tree_name, const TreeFilter& filter);
+    // If enabled, trees are split into several output files. The first part is written into the output file together
+    // with histograms, part n > 0 into <output stem>_<n>.root. Parts are written in parallel and listed in
+    // <output stem>_manifest.txt with the merged entry ranges. If the global executors are defined (see
+    // run::Executors), the parts are written on the I/O executor and the input trees are scanned on the compute one.
+    void SetOutputSplitting(const SplitLimits& limits);
+
+    // Splits consecutive clusters into n_parts ranges of similar size. Range boundaries are aligned to the clusters.
+    static std::vector<EntryRange> SplitClusters(const std::vector<ClusterInfo>& clusters, size_t n_parts);
+    // A tree is written into a part only if its range is not empty. A tree without entries is written into the
+    // first part, so that it is present in the output.
+    static bool IsPartUsed(const std::vector<EntryRange>& ranges, size_t part_index);
+    static std::string PartFileName(const std::string& output, size_t part_index);
     static std::vector<std::string> FindInputFiles(const std::vector<std::string>& dirs,
                                                    const std::string& file_name_pattern,
                                                    const std::string& exclude_list,
                                                    const std::string& exclude_dir_list);
+    static std::vector<std::string> ReadFileList(const std::string& file_list);
 
 private:
     virtual void ProcessFile(const std::string& /*file_name*/, const std::shared_ptr<TFile>& /*file*/) {}
 
     static void ProcessDirectory(const std::string& file_name, const std::string& dir_name, TDirectory* dir,
-                                 ObjectCollection& objects, bool process_histograms, bool process_trees);
+                                 ObjectCollection& objects, bool process_histograms, bool process_trees,
+                                 const HistShard& hist_shard = HistShard());
+    void MergeHistograms();
+    // Reports the estimated memory used by the histograms and tree descriptors to the global memory accounting under
+    // the "RootFilesMerger" component, aggregated by the directory in the input files.
+    void UpdateMemoryUsage();
+    size_t EstimateNumberOfHistogramShards() const;
+    const TreeFilter* FindTreeFilter(const Key& key) const;
+    // Evaluates the selection and the sampler in the given range of the chain entries. It should be called before
+    // the branches are pruned, so all branches used in the selection are read.
+    static std::unique_ptr<TEntryList> SelectEntries(TChain& chain, const TreeFilter& filter,
+                                                     Long64_t first_entry, Long64_t n_entries);
+    // Calls the function for each entry in the given range of the chain that passes the selection and the sampler.
+    static void ForEachSelectedEntry(TChain& chain, const TreeFilter& filter, Long64_t first_entry,
+                                     Long64_t n_entries, const std::function<void(Long64_t)>& function);
+    void MergeTrees(const std::map<Key, const TreeDescriptor*>& trees);
+    void MergeSplitTrees(const std::map<Key, const TreeDescriptor*>& trees);
+    void WritePart(const std::vector<std::pair<Key, const TreeDescriptor*>>& trees,
+                   const std::vector<std::vector<EntryRange>>& tree_ranges, size_t part_index, TFile* file,
+                   std::vector<Long64_t>& n_written) const;
+    // Sizes of the clusters are estimated after the selection and the branch pruning of the filter (if any): number
+    // of the selected entries times the compressed size per entry of the kept branches.
+    static std::vector<ClusterInfo> CollectClusters(const Key& key, const TreeDescriptor& tree,
+                                                    const TreeFilter* filter);
+    static void CollectHistogramSizes(const std::string& dir_name, TDirectory* dir,
+                                      std::unordered_map<Key, std::pair<size_t, size_t>, KeyHash>& hist_sizes);
 
 protected:
     const std::vector<std::string> input_files;
     std::shared_ptr<TFile> output_file;
+    std::string output_name;
+    ROOT::ECompressionAlgorithm compression;
+    int compression_level;
     ObjectCollection objects;
+    size_t n_hist_shards{1}, hist_memory_limit{0};
+    std::map<std::string, TreeFilter> tree_filters;
+    SplitLimits split_limits;
+    std::map<std::string, MemoryTracker> memory_trackers;
 };
 
 } // namespace analysis
@@ -101,6 +101,35 @@ struct SmartBranchEntry<std::vector<ValueType>, false> : BaseSmartBranchEntry {
     static BaseSmartBranchEntry* Make() { return new SmartBranchEntry(); }
 };
 
+template<typename ValueType>
+struct SmartBranchEntry<std::vector<std::vector<ValueType>>, false> : BaseSmartBranchEntry {
+    using DataType = std::vector<std::vector<ValueType>>;
+    DataType* value;
+    SmartBranchEntry() : value(new DataType()) {}
+    virtual ~SmartBranchEntry() override { delete value; }
+
+    virtual void SetBranchAddress(TBranch& branch) override
+    {
+        branch.GetTree()->SetBranchAddress(branch.GetName(), &value);
+    }
+
+    virtual bool IsCollection() const override { return true; }
+    std::string ToString() const override
+    {
+        std::ostringstream ss;
+        ss << "size = " << value->size() << std::endl;
+        for(size_t n = 0; n < value->size(); ++n) {
+            ss << boost::format("\t%1%: size = %2%:") % n % value->at(n).size();
+            for(const auto& element : value->at(n))
+                ss << " " << element;
+            ss << "\n";
+        }
+        return ss.str();
+    }
+
+    static BaseSmartBranchEntry* Make() { return new SmartBranchEntry(); }
+};
+
 template<>
 struct SmartBranchEntry<std::vector<bool>, false> : BaseSmartBranchEntry {
     using DataType = std::vector<bool>;
@@ -167,6 +196,9 @@ struct BranchEntryFactory {
             BRANCH_ENTRY(vector<long>),
             BRANCH_ENTRY(vector<unsigned long>),
             BRANCH_ENTRY(vector<ULong64_t>),
+            BRANCH_ENTRY(vector<vector<int> >),
+            BRANCH_ENTRY(vector<vector<float> >),
+            BRANCH_ENTRY(vector<vector<double> >),
             BRANCH_ENTRY(vector<ROOT::Math::LorentzVector<ROOT::Math::PtEtaPhiM4D<double> > >),
             BRANCH_ENTRY(ROOT::Math::LorentzVector<ROOT::Math::PtEtaPhiM4D<float> >),
             BRANCH_ENTRY(vector<ROOT::Math::LorentzVector<ROOT::Math::PtEtaPhiE4D<float> > >),
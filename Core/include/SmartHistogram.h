@@ -17,6 +17,8 @@ This file is part of https://github.com/hh-italian-group/AnalysisTools. */
 #include <TTree.h>
 #include <TGraph.h>
 
+#include "BinLookup.h"
+#include "MemoryAccounting.h"
 #include "RootExt.h"
 #include "TextIO.h"
 #include "NumericPrimitives.h"
@@ -35,6 +37,8 @@ public:
 
     virtual void WriteRootObject() = 0;
     virtual void SetOutputDirectory(TDirectory* directory) { outputDirectory = directory; }
+    // Estimated memory used by the histogram content (bytes).
+    virtual size_t GetMemoryUsage() const { return 0; }
 
     TDirectory* GetOutputDirectory() const { return outputDirectory; }
     const std::string& Name() const { return name; }
@@ -69,6 +73,8 @@ public:
         data.push_back(value);
     }
 
+    virtual size_t GetMemoryUsage() const override { return data.size() * sizeof(ValueType); }
+
     virtual void WriteRootObject()
     {
         std::lock_guard<Mutex> lock(GetMutex());
@@ -128,6 +134,8 @@ public:
         data.push_back(Value(x, y));
     }
 
+    virtual size_t GetMemoryUsage() const override { return data.size() * sizeof(Value); }
+
     virtual void WriteRootObject()
     {
         std::lock_guard<Mutex> lock(GetMutex());
@@ -303,11 +311,44 @@ public:
             p_config.Read("blind_ranges", blind_ranges);
             if(p_config.Has("y_min"))
                 y_min = p_config.Get<double>("y_min");
+            bool fast_bin_lookup = false;
+            p_config.Read("fast_bin_lookup", fast_bin_lookup);
+            if(fast_bin_lookup)
+                EnableFastBinLookup();
         } catch(analysis::exception& e) {
             throw analysis::exception("Invalid property set for histogram '%1%'. %2%") % Name() % e.message();
         }
     }
 
+    using TH1D::Fill;
+
+    virtual Int_t Fill(Double_t x) override
+    {
+        if(!bin_lookup || fBuffer) return TH1D::Fill(x);
+        return FastFill(x, 1.);
+    }
+
+    virtual Int_t Fill(Double_t x, Double_t w) override
+    {
+        if(!bin_lookup || fBuffer) return TH1D::Fill(x, w);
+        return FastFill(x, w);
+    }
+
+    // Replaces the binary search over the bin edges in TAxis::FindBin by VariableBinLookup for the histograms with
+    // variable-width bins. The filled contents and statistics are identical to TH1::Fill. The look-up should be
+    // enabled again if the binning is changed. For the uniform and extendable axes the standard filling is used.
+    void EnableFastBinLookup(bool enable = true)
+    {
+        std::lock_guard<Mutex> lock(GetMutex());
+        bin_lookup.reset();
+        const TArrayD* x_bins = fXaxis.GetXbins();
+        if(!enable || !x_bins->GetSize() || fXaxis.CanExtend()) return;
+        bin_lookup = std::make_shared<analysis::VariableBinLookup>(
+                std::vector<double>(x_bins->GetArray(), x_bins->GetArray() + x_bins->GetSize()));
+    }
+
+    bool HasFastBinLookup() const { return bin_lookup != nullptr; }
+
     virtual void SetName(const char* _name) override
     {
         std::lock_guard<Mutex> lock(GetMutex());
@@ -329,6 +370,8 @@ public:
             root_ext::WriteObject(*this);
     }
 
+    virtual size_t GetMemoryUsage() const override { return root_ext::EstimateMemoryUsage(*this); }
+
     virtual void SetOutputDirectory(TDirectory* directory) override
     {
         std::lock_guard<Mutex> lock(GetMutex());
@@ -400,6 +443,26 @@ public:
         Add(&other, 1);
     }
 
+private:
+    // Follows TH1::Fill(x, w) with the bin found by VariableBinLookup.
+    Int_t FastFill(Double_t x, Double_t w)
+    {
+        const Int_t bin = bin_lookup->FindBin(x);
+        ++fEntries;
+        if(!fSumw2.fN && w != 1. && !TestBit(TH1::kIsNotW))
+            Sumw2();
+        if(fSumw2.fN)
+            fSumw2.fArray[bin] += w * w;
+        AddBinContent(bin, w);
+        if((bin == 0 || bin > bin_lookup->GetNbins()) && !GetStatOverflowsBehaviour())
+            return -1;
+        fTsumw += w;
+        fTsumw2 += w * w;
+        fTsumwx += w * x;
+        fTsumwx2 += w * x * x;
+        return bin;
+    }
+
 private:
     bool store{true};
     bool use_log_x{false}, use_log_y{false};
@@ -409,6 +472,7 @@ private:
     std::string legend_title;
     MultiRange blind_ranges;
     double syst_unc{0}, postfit_sf{1};
+    std::shared_ptr<const analysis::VariableBinLookup> bin_lookup;
 };
 
 template<>
@@ -444,6 +508,8 @@ public:
             root_ext::WriteObject(*this);
     }
 
+    virtual size_t GetMemoryUsage() const override { return root_ext::EstimateMemoryUsage(*this); }
+
     virtual void SetName(const char* _name) override
     {
         std::lock_guard<Mutex> lock(GetMutex());
@@ -514,6 +580,11 @@ public:
     const DataVector& GetXvalues() const { return x_vector; }
     const DataVector& GetYvalues() const { return y_vector; }
 
+    virtual size_t GetMemoryUsage() const override
+    {
+        return analysis::EstimateMemoryUsage(x_vector) + analysis::EstimateMemoryUsage(y_vector);
+    }
+
     virtual void WriteRootObject() override
     {
         std::lock_guard<Mutex> lock(GetMutex());
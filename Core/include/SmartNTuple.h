@@ -0,0 +1,186 @@
+/*! Definition of SmartNTuple class: RNTuple-based storage with the SmartTree interface.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <TDirectory.h>
+#include <TFile.h>
+#include <RVersion.h>
+#include <ROOT/RNTuple.hxx>
+#include <ROOT/RNTupleModel.hxx>
+#include <ROOT/RNTupleReader.hxx>
+#include <ROOT/RNTupleWriter.hxx>
+
+#include "AnalysisTools/Core/include/SmartTree.h"
+
+namespace root_ext {
+
+namespace rntuple {
+using namespace ROOT::Experimental;
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6, 34, 0)
+using RNTuple = ROOT::RNTuple;
+#endif
+} // namespace rntuple
+
+// Stores data members of the DECLARE_TREE data class as RNTuple fields. Fields are added by AddBranch during
+// the initialization; the reader or the writer is created on the first access to the data, when all fields are known.
+// In the write mode, the dataset is committed by Write (or in the destructor), after which no more entries can be
+// filled.
+class SmartNTuple {
+public:
+    using Mutex = std::recursive_mutex;
+
+    SmartNTuple(const std::string& _name, TDirectory* _directory, bool _readMode,
+                const std::set<std::string>& _disabled_branches = {},
+                const std::set<std::string>& _enabled_branches = {}) :
+        name(_name), directory(_directory), readMode(_readMode), disabled_branches(_disabled_branches),
+        enabled_branches(_enabled_branches), model(rntuple::RNTupleModel::CreateBare())
+    {
+        if(!directory)
+            throw std::runtime_error("SmartNTuple: directory should be specified.");
+        if(readMode) {
+            anchor.reset(directory->Get<rntuple::RNTuple>(name.c_str()));
+            if(!anchor)
+                throw std::runtime_error("SmartNTuple: RNTuple '" + name + "' not found.");
+            info_reader = rntuple::RNTupleReader::Open(*anchor);
+        }
+    }
+
+    SmartNTuple(const SmartNTuple& other) = delete;
+    SmartNTuple& operator=(const SmartNTuple& other) = delete;
+
+    virtual ~SmartNTuple() {}
+
+    Int_t Fill()
+    {
+        std::lock_guard<Mutex> lock(mutex);
+        if(readMode)
+            throw std::runtime_error("SmartNTuple: can't fill in the read mode.");
+        if(committed)
+            throw std::runtime_error("SmartNTuple: can't fill after the dataset has been written.");
+        Prepare();
+        const size_t n_bytes = writer->Fill(*entry);
+        ++n_filled;
+        for(auto& tree_entry : entries)
+            tree_entry.second->clear();
+        return static_cast<Int_t>(n_bytes);
+    }
+
+    Long64_t GetEntries() const
+    {
+        return readMode ? static_cast<Long64_t>(info_reader->GetNEntries()) : n_filled;
+    }
+    Long64_t GetReadEntry() const { return read_entry; }
+    size_t size() const { return static_cast<size_t>(GetEntries()); }
+
+    Int_t GetEntry(Long64_t entry_index)
+    {
+        std::lock_guard<Mutex> lock(mutex);
+        if(!readMode)
+            throw std::runtime_error("SmartNTuple: can't read in the write mode.");
+        if(entry_index < 0 || entry_index >= GetEntries()) {
+            std::ostringstream ss;
+            ss << "SmartNTuple: entry " << entry_index << " does not exists.";
+            throw std::runtime_error(ss.str());
+        }
+        Prepare();
+        reader->LoadEntry(static_cast<rntuple::NTupleSize_t>(entry_index), *entry);
+        read_entry = entry_index;
+        return 1;
+    }
+
+    // Commits the dataset to the directory.
+    Int_t Write()
+    {
+        std::lock_guard<Mutex> lock(mutex);
+        if(readMode || committed) return 0;
+        Prepare();
+        writer.reset();
+        committed = true;
+        return 1;
+    }
+
+    Mutex& GetMutex() { return mutex; }
+    const std::set<std::string>& GetActiveBranches() const { return active_branches; }
+
+protected:
+    template<typename DataType>
+    void AddBranch(const std::string& branch_name, DataType& value)
+    {
+        std::lock_guard<Mutex> lock(mutex);
+        if(disabled_branches.count(branch_name) || (enabled_branches.size() && !enabled_branches.count(branch_name)))
+            return;
+        if(entry)
+            throw std::runtime_error("SmartNTuple: fields can't be added after the first access to the data.");
+        if(readMode && info_reader->GetDescriptor().FindFieldId(branch_name) == rntuple::kInvalidDescriptorId) {
+            std::cerr << "ERROR: Field '" << branch_name << "' not found." << std::endl;
+            return;
+        }
+        using PtrEntry = typename detail::EntryTypeSelector<DataType>::PtrEntry;
+        if(entries.count(branch_name))
+            throw std::runtime_error("Entry is already defined.");
+        entries[branch_name] = std::make_shared<PtrEntry>(value);
+        model->AddField(std::make_unique<rntuple::RField<DataType>>(branch_name));
+        DataType* ptr = &value;
+        binders.push_back([branch_name, ptr](rntuple::REntry& e) { e.BindRawPtr(branch_name, ptr); });
+        active_branches.insert(branch_name);
+    }
+
+    bool HasBranch(const std::string& branch_name) const
+    {
+        return entries.count(branch_name) != 0;
+    }
+
+private:
+    void Prepare()
+    {
+        if(entry) return;
+        if(readMode) {
+            reader = rntuple::RNTupleReader::Open(std::move(model), *anchor);
+            entry = reader->GetModel().CreateBareEntry();
+        } else {
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6, 36, 0)
+            writer = rntuple::RNTupleWriter::Append(std::move(model), name, *directory);
+#else
+            // Before ROOT 6.36, Append accepts only TFile, so RNTuple can be written only at the top level of a file.
+            TFile* file = dynamic_cast<TFile*>(directory);
+            if(!file)
+                throw std::runtime_error("SmartNTuple: RNTuple '" + name + "' can be written only into the top-level"
+                                         " directory of a file.");
+            writer = rntuple::RNTupleWriter::Append(std::move(model), name, *file);
+#endif
+            entry = writer->GetModel().CreateBareEntry();
+        }
+        for(const auto& bind : binders)
+            bind(*entry);
+    }
+
+private:
+    std::string name;
+    TDirectory* directory;
+    bool readMode;
+    std::set<std::string> disabled_branches, enabled_branches, active_branches;
+    std::unique_ptr<rntuple::RNTupleModel> model;
+    std::unique_ptr<rntuple::RNTuple> anchor;
+    std::unique_ptr<rntuple::RNTupleReader> info_reader, reader;
+    std::unique_ptr<rntuple::RNTupleWriter> writer;
+    std::unique_ptr<rntuple::REntry> entry;
+    std::vector<std::function<void(rntuple::REntry&)>> binders;
+    Long64_t n_filled{0}, read_entry{-1};
+    bool committed{false};
+    Mutex mutex;
+
+protected:
+    detail::SmartTreeEntryMap entries;
+};
+
+} // namespace root_ext
@@ -11,11 +11,16 @@ This file is part of https://github.com/hh-italian-group/AnalysisTools. */
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <utility>
 
 #include <TFile.h>
+#include <TKey.h>
 #include <TTree.h>
 #include <Rtypes.h>
 
+#include "AnalysisTools/Core/include/MemoryAccounting.h"
+#include "AnalysisTools/Core/include/TreeColumns.h"
+
 #define DECLARE_BRANCH_VARIABLE(type, name) type name;
 #define ADD_DATA_TREE_BRANCH(name) AddBranch(#name, _data->name);
 
@@ -36,6 +41,16 @@ This file is part of https://github.com/hh-italian-group/AnalysisTools. */
     private: \
         inline void Initialize(); \
     }; \
+    class tree_class_name##Columns : public root_ext::detail::BaseColumns<data_class_name> { \
+    public: \
+        tree_class_name##Columns(const std::set<std::string>& disabled_branches = {}, \
+                                 const std::set<std::string>& enabled_branches = {}) \
+            : BaseColumns(disabled_branches, enabled_branches) { Initialize(); } \
+    private: \
+        inline void Initialize(); \
+    }; \
+    using data_class_name##Columns = tree_class_name##Columns; \
+    DECLARE_NTUPLE_CLASS(data_class_name, tree_class_name, tree_name) \
     } \
     /**/
 
@@ -44,9 +59,42 @@ This file is part of https://github.com/hh-italian-group/AnalysisTools. */
         inline void tree_class_name::Initialize() { \
             data_macro() \
             if (GetEntries() > 0) GetEntry(0); \
+            UpdateMemoryUsage(); \
         } \
+        inline void tree_class_name##Columns::Initialize() { data_macro() } \
+        INITIALIZE_NTUPLE_CLASS(tree_class_name, data_macro) \
+    } \
+    /**/
+
+#ifdef ANALYSIS_TOOLS_HAS_RNTUPLE
+// RNTuple-based counterpart of the tree class with the same interface (<tree_class_name>NTuple).
+#define DECLARE_NTUPLE_CLASS(data_class_name, tree_class_name, tree_name) \
+    class tree_class_name##NTuple : public root_ext::detail::BaseSmartTree<data_class_name, root_ext::SmartNTuple> { \
+    public: \
+        static const std::string& Name() { static const std::string name = tree_name; return name; } \
+        tree_class_name##NTuple(TDirectory* directory, bool readMode, \
+                                const std::set<std::string>& disabled_branches = {}, \
+                                const std::set<std::string>& enabled_branches = {}) \
+            : BaseSmartTree(Name(), directory, readMode, disabled_branches, enabled_branches) { Initialize(); } \
+        tree_class_name##NTuple(const std::string& name, TDirectory* directory, bool readMode, \
+                                const std::set<std::string>& disabled_branches = {}, \
+                                const std::set<std::string>& enabled_branches = {}) \
+            : BaseSmartTree(name, directory, readMode, disabled_branches, enabled_branches) { Initialize(); } \
+    private: \
+        inline void Initialize(); \
+    }; \
+    /**/
+
+#define INITIALIZE_NTUPLE_CLASS(tree_class_name, data_macro) \
+    inline void tree_class_name##NTuple::Initialize() { \
+        data_macro() \
+        if (GetEntries() > 0) GetEntry(0); \
     } \
     /**/
+#else
+#define DECLARE_NTUPLE_CLASS(data_class_name, tree_class_name, tree_name)
+#define INITIALIZE_NTUPLE_CLASS(tree_class_name, data_macro)
+#endif
 
 namespace root_ext {
 template<typename type>
@@ -202,6 +250,8 @@ public:
                 throw std::runtime_error("Tree not found.");
             if(tree->GetNbranches())
                 tree->SetBranchStatus("*", 0);
+            if(auto reference = dynamic_cast<TNamed*>(tree->GetUserInfo()->FindObject(ReferenceTreeKey())))
+                reference_name = reference->GetTitle();
         } else {
             tree = new TTree(name.c_str(), name.c_str());
             tree->SetDirectory(directory);
@@ -213,9 +263,12 @@ public:
         }
     }
     SmartTree(const SmartTree& other) = delete;
-    SmartTree(const SmartTree&& other)
-        : name(other.name), directory(other.directory), tree(other.tree),
-          disabled_branches(other.disabled_branches), enabled_branches(other.enabled_branches), entries(other.entries) {}
+    SmartTree(SmartTree&& other)
+        : name(other.name), directory(std::exchange(other.directory, nullptr)), readMode(other.readMode),
+          tree(std::exchange(other.tree, nullptr)),
+          disabled_branches(other.disabled_branches), enabled_branches(other.enabled_branches),
+          reference_name(other.reference_name), reference_tree(std::move(other.reference_tree)),
+          entries(other.entries) {}
 
     virtual ~SmartTree()
     {
@@ -282,12 +335,38 @@ public:
     Mutex& GetMutex() { return mutex; }
     const std::set<std::string>& GetActiveBranches() const { return active_branches; }
 
+    // Reports the estimated size of the branch buffers and of the read cache to the global memory accounting under
+    // the "SmartTree" component. It is called after the branches are initialized.
+    void UpdateMemoryUsage()
+    {
+        std::lock_guard<Mutex> lock(mutex);
+        memory_tracker.SetDirectory(directory ? directory->GetPath() : "");
+        memory_tracker.Update(EstimateMemoryUsage(*tree));
+    }
+
+    // Marks the tree as a variation of the reference tree stored in the same directory. The variation tree should
+    // be created with only the varied branches enabled and filled entry by entry in the same order as the reference
+    // tree. When the variation is read, branches that are not stored in it are read from the reference tree.
+    void SetReferenceTree(const std::string& _reference_name)
+    {
+        std::lock_guard<Mutex> lock(mutex);
+        if(readMode)
+            throw std::runtime_error("SmartTree: reference tree can be set only in the write mode.");
+        reference_name = _reference_name;
+        tree->GetUserInfo()->Add(new TNamed(ReferenceTreeKey(), reference_name.c_str()));
+    }
+
+    const std::string& GetReferenceTreeName() const { return reference_name; }
+    static const char* ReferenceTreeKey() { return "SmartTree_ReferenceTree"; }
+
 protected:
     template<typename DataType>
     void AddBranch(const std::string& branch_name, DataType& value)
     {
         std::lock_guard<Mutex> lock(mutex);
         if (!disabled_branches.count(branch_name) && (!enabled_branches.size() || enabled_branches.count(branch_name))){
+            if(readMode && !reference_tree && reference_name.size() && !tree->GetBranch(branch_name.c_str()))
+                AttachReferenceTree();
             detail::BranchCreator<DataType> creator;
             creator.Create(*tree, branch_name, value, readMode, entries);
             active_branches.insert(branch_name);
@@ -299,25 +378,55 @@ protected:
         return entries.count(branch_name) != 0;
     }
 
+private:
+    // The reference tree is read as a separate instance, so it does not share branch addresses with other trees
+    // that read it, and is attached as a friend: its entries are read together with the entries of this tree.
+    // The instance is owned by this tree and removed from the list of the directory objects, so it is neither
+    // returned by TDirectory::Get to other readers nor deleted together with a tree of the same name.
+    // TTree::SetDirectory(nullptr) is not used, because it would also detach the branches from the file.
+    void AttachReferenceTree()
+    {
+        TKey* key = directory->GetKey(reference_name.c_str());
+        if(!key)
+            throw std::runtime_error("SmartTree: reference tree '" + reference_name + "' not found.");
+        std::unique_ptr<TObject> object(key->ReadObj());
+        directory->Remove(object.get());
+        reference_tree.reset(dynamic_cast<TTree*>(object.get()));
+        if(!reference_tree)
+            throw std::runtime_error("SmartTree: '" + reference_name + "' is not a tree.");
+        object.release();
+        if(reference_tree->GetEntries() != tree->GetEntries())
+            throw std::runtime_error("SmartTree: numbers of entries in the tree '" + name + "' and in the reference "
+                                     "tree '" + reference_name + "' are different.");
+        reference_tree->SetBranchStatus("*", 0);
+        tree->AddFriend(reference_tree.get());
+    }
+
 private:
     std::string name;
     TDirectory* directory;
     bool readMode;
     TTree* tree;
     std::set<std::string> disabled_branches, enabled_branches, active_branches;
+    std::string reference_name;
+    std::unique_ptr<TTree> reference_tree;
     Mutex mutex;
+    analysis::MemoryTracker memory_tracker{"SmartTree"};
 
 protected:
     detail::SmartTreeEntryMap entries;
 };
 
 namespace detail {
-template<typename Data>
-class BaseSmartTree : public SmartTree {
+template<typename Data, typename Base = SmartTree>
+class BaseSmartTree : public Base {
 public:
+    using Mutex = typename Base::Mutex;
+    using DataType = Data;
+
     struct iterator {
     public:
-        iterator(BaseSmartTree<Data>& _tree, Long64_t _pos) : tree(&_tree), data_read(false), pos(_pos) {}
+        iterator(BaseSmartTree<Data, Base>& _tree, Long64_t _pos) : tree(&_tree), data_read(false), pos(_pos) {}
 
         iterator& operator++() { data_read = false; ++pos; return *this; }
         iterator operator++(int) const { return ++iterator(*this); }
@@ -345,15 +454,15 @@ public:
         }
 
     private:
-        BaseSmartTree<Data>* tree;
+        BaseSmartTree<Data, Base>* tree;
         bool data_read;
         Data data;
         Long64_t pos;
     };
 
-    using SmartTree::SmartTree;
-    BaseSmartTree(const BaseSmartTree&& other)
-        : SmartTree(other), _data(other._data) {}
+    using Base::Base;
+    BaseSmartTree(BaseSmartTree&& other)
+        : Base(std::move(other)), _data(other._data) {}
 
     Data& operator()() { return *_data; }
     const Data& operator()() const { return *_data; }
@@ -362,8 +471,8 @@ public:
     template<typename T>
     T& get(const std::string& branch_name)
     {
-        auto iter = entries.find(branch_name);
-        if(iter == entries.end())
+        auto iter = this->entries.find(branch_name);
+        if(iter == this->entries.end())
             throw_branch_not_found(branch_name);
         auto base_entry = dynamic_cast<detail::SmartTreePtrEntry<T>*>(iter->second.get());
         if(!base_entry)
@@ -374,8 +483,8 @@ public:
     template<typename T>
     const T& get(const std::string& branch_name) const
     {
-        auto iter = entries.find(branch_name);
-        if(iter == entries.end())
+        auto iter = this->entries.find(branch_name);
+        if(iter == this->entries.end())
             throw_branch_not_found(branch_name);
         auto base_entry = dynamic_cast<const detail::SmartTreePtrEntry<T>*>(iter->second.get());
         if(!base_entry)
@@ -384,7 +493,7 @@ public:
     }
 
     iterator begin() { return iterator(*this, 0); }
-    iterator end() { return iterator(*this, GetEntries()); }
+    iterator end() { return iterator(*this, this->GetEntries()); }
 
 private:
     void throw_branch_not_found(const std::string& branch_name) const
@@ -406,3 +515,7 @@ protected:
 };
 } // detail
 } // root_ext
+
+#ifdef ANALYSIS_TOOLS_HAS_RNTUPLE
+#include "AnalysisTools/Core/include/SmartNTuple.h"
+#endif
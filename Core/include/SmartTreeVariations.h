@@ -0,0 +1,97 @@
+/*! Definition of the reader of the nominal tree together with its delta-encoded variation trees.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include "AnalysisTools/Core/include/SmartTree.h"
+
+namespace root_ext {
+
+// Reads the nominal tree and the variation trees (see SmartTree::SetReferenceTree) in one pass. Branches of the
+// nominal tree are decompressed only once per entry: each variation receives a copy of the nominal data, and only
+// the branches stored in the variation tree are read from it.
+template<typename Tree>
+class SmartTreeVariations {
+public:
+    using Data = typename Tree::DataType;
+
+    SmartTreeVariations(TDirectory* directory, const std::string& nominal_name,
+                        const std::vector<std::string>& _variation_names,
+                        const std::set<std::string>& enabled_branches = {}) :
+        variation_names(_variation_names)
+    {
+        nominal = std::make_unique<Tree>(nominal_name, directory, true, std::set<std::string>(), enabled_branches);
+        for(const auto& variation_name : variation_names) {
+            std::set<std::string> stored_branches = GetStoredBranches(directory, variation_name);
+            if(enabled_branches.size()) {
+                std::set<std::string> selected;
+                std::set_intersection(stored_branches.begin(), stored_branches.end(), enabled_branches.begin(),
+                                      enabled_branches.end(), std::inserter(selected, selected.end()));
+                stored_branches = selected;
+            }
+            if(stored_branches.empty()) {
+                variations.emplace_back();
+                standalone_data.push_back(std::make_unique<Data>());
+                variation_data.push_back(standalone_data.back().get());
+            } else {
+                variations.push_back(std::make_unique<Tree>(variation_name, directory, true,
+                                                            std::set<std::string>(), stored_branches));
+                if(variations.back()->GetEntries() != nominal->GetEntries())
+                    throw std::runtime_error("Numbers of entries in the nominal tree '" + nominal_name
+                                             + "' and in the variation tree '" + variation_name + "' are different.");
+                variation_data.push_back(&(*variations.back())());
+            }
+        }
+    }
+
+    Long64_t GetEntries() const { return nominal->GetEntries(); }
+    size_t size() const { return variation_names.size(); }
+    const std::vector<std::string>& GetVariationNames() const { return variation_names; }
+
+    void GetEntry(Long64_t entry)
+    {
+        nominal->GetEntry(entry);
+        const Data& nominal_data = (*nominal)();
+        for(size_t n = 0; n < variations.size(); ++n) {
+            *variation_data.at(n) = nominal_data;
+            if(variations.at(n))
+                variations.at(n)->GetEntry(entry);
+        }
+    }
+
+    const Data& GetNominal() const { return (*nominal)(); }
+    const Data& GetVariation(size_t n) const { return *variation_data.at(n); }
+    const Data& GetVariation(const std::string& name) const
+    {
+        const auto iter = std::find(variation_names.begin(), variation_names.end(), name);
+        if(iter == variation_names.end())
+            throw std::runtime_error("Variation '" + name + "' not found.");
+        return GetVariation(static_cast<size_t>(iter - variation_names.begin()));
+    }
+
+private:
+    static std::set<std::string> GetStoredBranches(TDirectory* directory, const std::string& tree_name)
+    {
+        std::unique_ptr<TTree> tree;
+        if(TKey* key = directory->GetKey(tree_name.c_str()))
+            tree.reset(dynamic_cast<TTree*>(key->ReadObj()));
+        if(!tree)
+            throw std::runtime_error("Tree '" + tree_name + "' not found.");
+        std::set<std::string> branches;
+        TObjArray* branch_list = tree->GetListOfBranches();
+        for(Int_t n = 0; n < branch_list->GetEntries(); ++n)
+            branches.insert(branch_list->At(n)->GetName());
+        return branches;
+    }
+
+private:
+    std::vector<std::string> variation_names;
+    std::unique_ptr<Tree> nominal;
+    std::vector<std::unique_ptr<Tree>> variations;
+    std::vector<std::unique_ptr<Data>> standalone_data;
+    std::vector<Data*> variation_data;
+};
+
+} // namespace root_ext
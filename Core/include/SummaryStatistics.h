@@ -0,0 +1,80 @@
+/*! Definition of streaming mergeable accumulators for summary statistics.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace analysis {
+
+// Quantile sketch with a relative accuracy guarantee (DDSketch algorithm).
+// Values are stored into logarithmically spaced buckets, which makes the sketch mergeable and its size independent
+// of the number of accumulated values.
+class QuantileSketch {
+public:
+    explicit QuantileSketch(double relative_accuracy = 0.01);
+
+    void Add(double x, uint64_t n = 1);
+    void Merge(const QuantileSketch& other);
+
+    uint64_t Count() const { return count; }
+    double RelativeAccuracy() const { return relative_accuracy; }
+    double Quantile(double q) const;
+    std::vector<uint64_t> Histogram(size_t n_bins, double x_min, double x_max) const;
+
+private:
+    struct Store {
+        std::vector<uint64_t> counts;
+        int offset{0};
+
+        void Add(int index, uint64_t n);
+        void Merge(const Store& other);
+        bool empty() const { return counts.empty(); }
+    };
+
+    int Index(double abs_x) const;
+    double Value(int index) const;
+
+    template<typename Function>
+    void ForEachBucket(Function&& fn) const;
+
+private:
+    double relative_accuracy, gamma, inv_log_gamma;
+    Store positive, negative;
+    uint64_t zero_count{0}, count{0};
+};
+
+// Accumulator of the number of entries, moments, extremes and quantile sketch of a column.
+// Non-finite values are counted separately and do not contribute to the other statistics.
+class SummaryAccumulator {
+public:
+    explicit SummaryAccumulator(double relative_accuracy = 0.01);
+
+    void AddEntry() { ++n_entries; }
+    void Add(double x);
+    void Merge(const SummaryAccumulator& other);
+
+    uint64_t NumberOfEntries() const { return n_entries; }
+    uint64_t NumberOfValues() const { return n_values; }
+    uint64_t NumberOfNaN() const { return n_nan; }
+    uint64_t NumberOfPositiveInf() const { return n_pos_inf; }
+    uint64_t NumberOfNegativeInf() const { return n_neg_inf; }
+    double Sum() const { return sum; }
+    double Mean() const;
+    double Variance() const;
+    double StdDev() const;
+    double Min() const;
+    double Max() const;
+    const QuantileSketch& Sketch() const { return sketch; }
+
+private:
+    uint64_t n_entries{0}, n_values{0}, n_nan{0}, n_pos_inf{0}, n_neg_inf{0};
+    double sum{0}, mean{0}, m2{0};
+    double min{std::numeric_limits<double>::infinity()}, max{-std::numeric_limits<double>::infinity()};
+    QuantileSketch sketch;
+};
+
+} // namespace analysis
@@ -0,0 +1,231 @@
+/*! Definition of the columnar (structure-of-arrays) representation of the DECLARE_TREE data classes.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <Rtypes.h>
+
+namespace root_ext {
+
+// Column of a vector branch: values of all rows are stored in one contiguous array, and the row boundaries are
+// defined by offsets (row n occupies [offsets[n], offsets[n+1]) of the values).
+template<typename T>
+class JaggedColumn {
+public:
+    using value_type = T;
+
+    class Row {
+    public:
+        Row(const T* _begin, const T* _end) : first(_begin), last(_end) {}
+        const T* begin() const { return first; }
+        const T* end() const { return last; }
+        const T* data() const { return first; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+        bool empty() const { return first == last; }
+        const T& operator[](size_t n) const { return first[n]; }
+
+    private:
+        const T* first;
+        const T* last;
+    };
+
+    JaggedColumn() : offsets(1, 0) {}
+
+    size_t size() const { return offsets.size() - 1; }
+    bool empty() const { return size() == 0; }
+    Row operator[](size_t n) const { return Row(values.data() + offsets[n], values.data() + offsets[n + 1]); }
+    Row at(size_t n) const
+    {
+        if(n >= size())
+            throw std::out_of_range("JaggedColumn: row index is out of range.");
+        return (*this)[n];
+    }
+
+    const std::vector<T>& GetValues() const { return values; }
+    const std::vector<size_t>& GetOffsets() const { return offsets; }
+
+    template<typename Collection>
+    void push_back(const Collection& row)
+    {
+        values.insert(values.end(), row.begin(), row.end());
+        offsets.push_back(values.size());
+    }
+
+    void clear()
+    {
+        values.clear();
+        offsets.assign(1, 0);
+    }
+
+    void reserve(size_t n_rows) { offsets.reserve(n_rows + 1); }
+
+private:
+    std::vector<T> values;
+    std::vector<size_t> offsets;
+};
+
+// Type of the column that stores values of the branch type. bool is stored as char to keep the column contiguous.
+template<typename T>
+struct ColumnTraits { using Column = std::vector<T>; };
+template<>
+struct ColumnTraits<bool> { using Column = std::vector<char>; };
+template<typename T>
+struct ColumnTraits<std::vector<T>> { using Column = JaggedColumn<T>; };
+template<>
+struct ColumnTraits<std::vector<bool>> { using Column = JaggedColumn<char>; };
+
+template<typename T>
+using Column = typename ColumnTraits<T>::Column;
+
+namespace detail {
+    struct BaseColumnEntry {
+        virtual ~BaseColumnEntry() {}
+        virtual void Append(const void* row) = 0;
+        virtual void clear() = 0;
+        virtual void reserve(size_t n_rows) = 0;
+    };
+
+    // Column of one data member. The member is located in the row by its offset from the beginning of the data class.
+    template<typename T>
+    struct ColumnEntry : BaseColumnEntry {
+        Column<T> column;
+        const std::ptrdiff_t offset;
+
+        explicit ColumnEntry(std::ptrdiff_t _offset) : offset(_offset) {}
+
+        virtual void Append(const void* row) override
+        {
+            const void* member = static_cast<const char*>(row) + offset;
+            column.push_back(*static_cast<const T*>(member));
+        }
+        virtual void clear() override { column.clear(); }
+        virtual void reserve(size_t n_rows) override { column.reserve(n_rows); }
+    };
+
+    // Columns are registered by the same data macro that defines branches of the tree (see INITIALIZE_TREE).
+    template<typename Data>
+    class BaseColumns {
+    public:
+        using DataType = Data;
+
+        BaseColumns(const std::set<std::string>& _disabled_branches = {},
+                    const std::set<std::string>& _enabled_branches = {})
+            : disabled_branches(_disabled_branches), enabled_branches(_enabled_branches) {}
+
+        BaseColumns(const BaseColumns&) = delete;
+        BaseColumns& operator=(const BaseColumns&) = delete;
+        virtual ~BaseColumns() {}
+
+        size_t size() const { return n_rows; }
+        bool empty() const { return n_rows == 0; }
+        const std::vector<std::string>& GetColumnNames() const { return names; }
+        bool HasColumn(const std::string& name) const { return columns.count(name) != 0; }
+
+        void push_back(const Data& row)
+        {
+            for(const auto& entry : ordered_columns)
+                entry->Append(&row);
+            ++n_rows;
+        }
+
+        void clear()
+        {
+            for(const auto& entry : ordered_columns)
+                entry->clear();
+            n_rows = 0;
+        }
+
+        void reserve(size_t n)
+        {
+            for(const auto& entry : ordered_columns)
+                entry->reserve(n);
+        }
+
+        template<typename T>
+        const Column<T>& get(const std::string& name) const
+        {
+            auto iter = columns.find(name);
+            if(iter == columns.end()) {
+                std::ostringstream ss;
+                ss << "Column '" << name << "' not found.";
+                throw std::runtime_error(ss.str());
+            }
+            auto entry = dynamic_cast<const ColumnEntry<T>*>(iter->second.get());
+            if(!entry) {
+                std::ostringstream ss;
+                ss << "Invalid type for column '" << name << "'.";
+                throw std::runtime_error(ss.str());
+            }
+            return entry->column;
+        }
+
+        // Appends entries [first_entry, first_entry + n_entries) of the tree. Only active branches of the tree are
+        // read, so the tree should be opened with the same set of enabled branches. Returns number of added rows.
+        template<typename Tree>
+        size_t Fill(Tree& tree, Long64_t first_entry, Long64_t n_entries)
+        {
+            const Long64_t last_entry = std::min(first_entry + n_entries, tree.GetEntries());
+            if(last_entry > first_entry)
+                reserve(n_rows + static_cast<size_t>(last_entry - first_entry));
+            for(Long64_t entry = first_entry; entry < last_entry; ++entry) {
+                tree.GetEntry(entry);
+                push_back(tree());
+            }
+            return last_entry > first_entry ? static_cast<size_t>(last_entry - first_entry) : 0;
+        }
+
+    protected:
+        template<typename T>
+        void AddBranch(const std::string& name, T& member)
+        {
+            if(disabled_branches.count(name) || (enabled_branches.size() && !enabled_branches.count(name)))
+                return;
+            if(columns.count(name))
+                throw std::runtime_error("Column is already defined.");
+            const std::ptrdiff_t offset = reinterpret_cast<const char*>(&member)
+                                          - reinterpret_cast<const char*>(_data.get());
+            auto entry = std::make_shared<ColumnEntry<T>>(offset);
+            columns[name] = entry;
+            ordered_columns.push_back(entry);
+            names.push_back(name);
+        }
+
+    protected:
+        // Prototype of the data class, used to find the location of the members during the initialization.
+        std::shared_ptr<Data> _data{new Data()};
+
+    private:
+        std::set<std::string> disabled_branches, enabled_branches;
+        std::vector<std::string> names;
+        std::unordered_map<std::string, std::shared_ptr<BaseColumnEntry>> columns;
+        std::vector<std::shared_ptr<BaseColumnEntry>> ordered_columns;
+        size_t n_rows{0};
+    };
+} // namespace detail
+
+// Reads the tree in consecutive batches of up to batch_size entries and calls the function for each batch with
+// the columns and the index of the first entry of the batch. The columns are reused between batches.
+template<typename Columns, typename Tree, typename Function>
+void ForEachBatch(Tree& tree, Columns& columns, size_t batch_size, Function&& function)
+{
+    if(!batch_size)
+        throw std::invalid_argument("ForEachBatch: batch size should be positive.");
+    const Long64_t n_entries = tree.GetEntries();
+    for(Long64_t first_entry = 0; first_entry < n_entries; first_entry += static_cast<Long64_t>(batch_size)) {
+        columns.clear();
+        columns.Fill(tree, first_entry, static_cast<Long64_t>(batch_size));
+        function(static_cast<const Columns&>(columns), first_entry);
+    }
+}
+
+} // namespace root_ext
@@ -0,0 +1,194 @@
+/*! Definition of the flat hash map that keeps the elements in the insertion order.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace analysis {
+
+// Alternative to map_vec for the cases where neither the key order nor stable references are needed. Elements are
+// stored contiguously in the insertion order and located using an open-addressing hash index (linear probing) that
+// stores only positions of the elements. Iteration goes through the elements in the insertion order, and
+// get_ordered_by_insertion returns the elements themselves. Similarly to std::vector, insertion invalidates iterators
+// and references. Keys should not be modified through the iterators.
+template<typename _Key, class _Tp, class _Hash = std::hash<_Key>, class _KeyEqual = std::equal_to<_Key>>
+class flat_map_vec {
+public:
+    using key_type = _Key;
+    using mapped_type = _Tp;
+    using value_type = std::pair<key_type, mapped_type>;
+    using hasher = _Hash;
+    using key_equal = _KeyEqual;
+    using std_vec = std::vector<value_type>;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using iterator = typename std_vec::iterator;
+    using const_iterator = typename std_vec::const_iterator;
+    using size_type = typename std_vec::size_type;
+
+    flat_map_vec() {}
+    explicit flat_map_vec(size_type n) { reserve(n); }
+
+    iterator begin() { return elements.begin(); }
+    const_iterator begin() const { return elements.begin(); }
+    iterator end() { return elements.end(); }
+    const_iterator end() const { return elements.end(); }
+
+    mapped_type& at(const key_type& key)
+    {
+        const size_type index = find_index(key);
+        if(index == npos)
+            throw std::out_of_range("flat_map_vec::at: key not found.");
+        return elements[index].second;
+    }
+
+    const mapped_type& at(const key_type& key) const
+    {
+        const size_type index = find_index(key);
+        if(index == npos)
+            throw std::out_of_range("flat_map_vec::at: key not found.");
+        return elements[index].second;
+    }
+
+    bool empty() const { return elements.empty(); }
+    size_type size() const { return elements.size(); }
+    size_type count(const key_type& key) const { return find_index(key) == npos ? 0 : 1; }
+
+    iterator find(const key_type& key)
+    {
+        const size_type index = find_index(key);
+        return index == npos ? end() : begin() + static_cast<std::ptrdiff_t>(index);
+    }
+
+    const_iterator find(const key_type& key) const
+    {
+        const size_type index = find_index(key);
+        return index == npos ? end() : begin() + static_cast<std::ptrdiff_t>(index);
+    }
+
+    mapped_type& operator[](const key_type& key)
+    {
+        const size_t hash = hasher()(key);
+        size_type slot = find_slot(key, hash);
+        if(slots[slot] != npos)
+            return elements[slots[slot]].second;
+        slot = prepare_insert(hash, slot);
+        elements.emplace_back(key, mapped_type());
+        hashes.push_back(hash);
+        slots[slot] = elements.size() - 1;
+        return elements.back().second;
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value)
+    {
+        const size_t hash = hasher()(value.first);
+        size_type slot = find_slot(value.first, hash);
+        if(slots[slot] != npos)
+            return std::make_pair(begin() + static_cast<std::ptrdiff_t>(slots[slot]), false);
+        slot = prepare_insert(hash, slot);
+        elements.push_back(value);
+        hashes.push_back(hash);
+        slots[slot] = elements.size() - 1;
+        return std::make_pair(end() - 1, true);
+    }
+
+    void reserve(size_type n)
+    {
+        elements.reserve(n);
+        hashes.reserve(n);
+        if(n > max_load(slots.size()))
+            rehash(n);
+    }
+
+    void clear()
+    {
+        elements.clear();
+        hashes.clear();
+        std::fill(slots.begin(), slots.end(), npos);
+    }
+
+    const std_vec& get_ordered_by_insertion() const { return elements; }
+
+private:
+    static constexpr size_type npos = std::numeric_limits<size_type>::max();
+    static constexpr size_type min_slots = 8;
+
+    // The index is kept at most 3/4 full.
+    static size_type max_load(size_type n_slots) { return n_slots / 4 * 3; }
+
+    // Fibonacci hashing: spreads poorly distributed hashes (e.g. of integers) over the whole index.
+    size_type home_slot(size_t hash) const
+    {
+        return static_cast<size_type>((static_cast<uint64_t>(hash) * UINT64_C(0x9E3779B97F4A7C15)) >> hash_shift);
+    }
+
+    // Returns the slot that contains the key or, if the key is not found, the first empty slot of its probe sequence.
+    size_type find_slot(const key_type& key, size_t hash)
+    {
+        if(slots.empty())
+            rehash(1);
+        return find_slot_impl(key, hash);
+    }
+
+    size_type find_slot_impl(const key_type& key, size_t hash) const
+    {
+        const size_type mask = slots.size() - 1;
+        for(size_type slot = home_slot(hash); ; slot = (slot + 1) & mask) {
+            const size_type index = slots[slot];
+            if(index == npos || (hashes[index] == hash && key_equal()(elements[index].first, key)))
+                return slot;
+        }
+    }
+
+    size_type find_index(const key_type& key) const
+    {
+        if(slots.empty()) return npos;
+        return slots[find_slot_impl(key, hasher()(key))];
+    }
+
+    // Returns the slot of a new element, which changes if the index has to grow.
+    size_type prepare_insert(size_t hash, size_type slot)
+    {
+        if(elements.size() + 1 <= max_load(slots.size()))
+            return slot;
+        rehash(elements.size() + 1);
+        const size_type mask = slots.size() - 1;
+        for(slot = home_slot(hash); slots[slot] != npos; slot = (slot + 1) & mask) {}
+        return slot;
+    }
+
+    void rehash(size_type n_elements)
+    {
+        size_type n_slots = min_slots;
+        unsigned n_bits = 3;
+        while(max_load(n_slots) < n_elements) {
+            n_slots *= 2;
+            ++n_bits;
+        }
+        if(n_slots <= slots.size()) return;
+        slots.assign(n_slots, npos);
+        hash_shift = 64 - n_bits;
+        const size_type mask = n_slots - 1;
+        for(size_type index = 0; index < elements.size(); ++index) {
+            size_type slot = home_slot(hashes[index]);
+            while(slots[slot] != npos)
+                slot = (slot + 1) & mask;
+            slots[slot] = index;
+        }
+    }
+
+private:
+    std_vec elements;
+    std::vector<size_t> hashes;
+    std::vector<size_type> slots;
+    unsigned hash_shift{64};
+};
+
+} // namespace analysis
@@ -4,9 +4,13 @@ This file is part of https://github.com/hh-italian-group/AnalysisTools. */
 #pragma once
 
 #include <map>
+#include <vector>
 
 namespace analysis {
 
+// std::map that also keeps the insertion order: get_ordered_by_insertion returns keys with pointers to the mapped
+// values in the order in which they were inserted. Iteration follows the key order and references to the values
+// stay valid after insertions, as for std::map. A new key is inserted with a single look-up in the map.
 template<typename _Key, class _Tp, class _Compare = std::less<_Key>>
 class map_vec {
 public:
@@ -37,23 +41,24 @@ public:
 
     mapped_type& operator[](const key_type& key)
     {
-        if(!map.count(key)) {
-            mapped_type& v = map[key];
-            vec.push_back({key, &v});
+        auto iter = map.lower_bound(key);
+        if(iter == map.end() || map.key_comp()(key, iter->first)) {
+            iter = map.emplace_hint(iter, key, mapped_type());
+            vec.emplace_back(key, &iter->second);
         }
-        return map[key];
+        return iter->second;
     }
 
     std::pair<iterator, bool> insert(const value_type& value)
     {
         auto result = map.insert(value);
-        if(result.second) {
-            mapped_type& v = *result.first;
-            vec.push_back({value.first, &v});
-        }
+        if(result.second)
+            vec.emplace_back(value.first, &result.first->second);
         return result;
     }
 
+    void reserve(size_type n) { vec.reserve(n); }
+
     void clear()
     {
         map.clear();
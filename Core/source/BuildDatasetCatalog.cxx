@@ -0,0 +1,52 @@
+/*! Build or refresh the catalog with metadata of the dataset files.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include "AnalysisTools/Core/include/DatasetCatalog.h"
+#include "AnalysisTools/Core/include/RootFilesMerger.h"
+#include "AnalysisTools/Run/include/program_main.h"
+
+struct Arguments {
+    run::Argument<std::string> catalog{"catalog", "catalog index file"};
+    run::Argument<std::vector<std::string>> input_dirs{"input-dir", "input directory"};
+    run::Argument<std::string> file_name_pattern{"file-name-pattern", "regex expression to match file names",
+                                                 "^.*\\.root$"};
+    run::Argument<std::string> exclude_list{"exclude-list", "comma separated list of files to exclude", ""};
+    run::Argument<std::string> exclude_dir_list{"exclude-dir-list",
+                                                "comma separated list of directories to exclude", ""};
+    run::Argument<std::string> weight_branch{"weight-branch", "branch to compute the sum of weights", ""};
+    run::Argument<std::string> tree_name{"tree", "tree for which the summary should be printed", ""};
+    run::Argument<Long64_t> max_entries{"max-entries", "print entry splits with at most the given number of entries",
+                                        0};
+    run::Argument<unsigned> n_threads{"n-threads", "number of threads", 1};
+};
+
+class BuildDatasetCatalog {
+public:
+    BuildDatasetCatalog(const Arguments& _args) : args(_args), catalog(args.catalog()) {}
+
+    void Run()
+    {
+        const auto input_files = analysis::RootFilesMerger::FindInputFiles(args.input_dirs(),
+                args.file_name_pattern(), args.exclude_list(), args.exclude_dir_list());
+        const size_t n_scanned = catalog.Update(input_files, args.weight_branch(), args.n_threads());
+        catalog.Save();
+        std::cout << "Catalog '" << args.catalog() << "': " << catalog.GetFiles().size() << " files, "
+                  << n_scanned << " (re)scanned." << std::endl;
+
+        if(args.tree_name().empty()) return;
+        std::cout << "Tree '" << args.tree_name() << "': " << catalog.TotalEntries(args.tree_name()) << " entries";
+        if(!args.weight_branch().empty())
+            std::cout << ", sum of weights = " << catalog.TotalSumOfWeights(args.tree_name());
+        std::cout << "." << std::endl;
+        if(args.max_entries() > 0) {
+            for(const auto& range : catalog.PlanSplits(args.tree_name(), args.max_entries()))
+                std::cout << range.file << " " << range.first_entry << " " << range.last_entry << "\n";
+        }
+    }
+
+private:
+    Arguments args;
+    analysis::DatasetCatalog catalog;
+};
+
+PROGRAM_MAIN(BuildDatasetCatalog, Arguments)
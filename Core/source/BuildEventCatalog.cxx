@@ -0,0 +1,41 @@
+/*! Build or incrementally update the catalog that maps event identifiers to their location in the dataset.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include "AnalysisTools/Core/include/EventCatalog.h"
+#include "AnalysisTools/Core/include/RootFilesMerger.h"
+#include "AnalysisTools/Run/include/program_main.h"
+
+struct Arguments {
+    run::Argument<std::string> catalog{"catalog", "event catalog file"};
+    run::Argument<std::string> tree_name{"tree", "name of the tree with events"};
+    run::Argument<std::vector<std::string>> input_dirs{"input-dir", "input directory"};
+    run::Argument<std::string> file_name_pattern{"file-name-pattern", "regex expression to match file names",
+                                                 "^.*\\.root$"};
+    run::Argument<std::string> exclude_list{"exclude-list", "comma separated list of files to exclude", ""};
+    run::Argument<std::string> exclude_dir_list{"exclude-dir-list",
+                                                "comma separated list of directories to exclude", ""};
+    run::Argument<std::string> id_branches{"id-branches", "run, lumi and event branch names",
+                                           analysis::EventCatalog::DefaultIdBranches()};
+    run::Argument<unsigned> n_threads{"n-threads", "number of threads", 1};
+};
+
+class BuildEventCatalog {
+public:
+    BuildEventCatalog(const Arguments& _args) : args(_args) {}
+
+    void Run()
+    {
+        const auto input_files = analysis::RootFilesMerger::FindInputFiles(args.input_dirs(),
+                args.file_name_pattern(), args.exclude_list(), args.exclude_dir_list());
+        const size_t n_scanned = analysis::EventCatalog::Update(args.catalog(), input_files, args.tree_name(),
+                                                                args.id_branches(), args.n_threads());
+        const analysis::EventCatalog catalog(args.catalog());
+        std::cout << "Event catalog '" << args.catalog() << "': " << catalog.size() << " events in "
+                  << catalog.GetFiles().size() << " files, " << n_scanned << " files (re)scanned." << std::endl;
+    }
+
+private:
+    Arguments args;
+};
+
+PROGRAM_MAIN(BuildEventCatalog, Arguments)
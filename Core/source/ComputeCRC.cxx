@@ -1,26 +1,177 @@
-/*! Compute CRC32 for an input string.
+/*! Compute CRC32 for an input string or checksums of the file contents.
 This file is part of https://github.com/hh-italian-group/AnalysisTools. */
 
-#include <boost/crc.hpp>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <iomanip>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include "AnalysisTools/Core/include/FileChecksum.h"
+#include "AnalysisTools/Run/include/MultiThread.h"
 #include "AnalysisTools/Run/include/program_main.h"
 
 struct Arguments {
     REQ_ARG(std::vector<std::string>, inputStrings);
+    OPT_ARG(bool, files, false);
+    OPT_ARG(analysis::ChecksumType, checksum, analysis::ChecksumType::CRC32);
+    OPT_ARG(unsigned, nThreads, 1);
+    OPT_ARG(size_t, chunkSize, 64);
+    OPT_ARG(std::string, cache, "");
 };
 
 class ComputeCRC {
 public:
+    using Checksum = analysis::Checksum;
+    using Clock = std::chrono::steady_clock;
+
     ComputeCRC(const Arguments& _args) : args(_args) {}
 
     void Run()
+    {
+        if(args.files())
+            ProcessFiles();
+        else
+            ProcessStrings();
+    }
+
+private:
+    struct FileTask {
+        std::string path;
+        uint64_t size{0};
+        bool cached{false};
+        uint64_t checksum{0};
+        std::shared_ptr<boost::interprocess::mapped_region> region;
+        std::vector<std::future<uint64_t>> chunks;
+        std::vector<uint64_t> chunk_sizes;
+    };
+
+    void ProcessStrings() const
     {
         for(const std::string& str : args.inputStrings()) {
-            boost::crc_32_type crc;
-            crc.process_bytes(str.data(), str.size());
-            std::cout << crc.checksum() << std::endl;
+            Checksum checksum(args.checksum());
+            checksum.Process(str.data(), str.size());
+            std::cout << checksum.Value() << std::endl;
         }
     }
 
+    // Files are memory-mapped and split into chunks that are processed in parallel. The number of chunks in flight
+    // is limited, so only a few files are mapped at the same time. XXH64 can't be combined, so each file is
+    // processed as a single chunk.
+    void ProcessFiles() const
+    {
+        const auto files = CollectFiles();
+        analysis::ChecksumCache cache(args.cache());
+        const size_t n_threads = std::max(args.nThreads(), 1u);
+        const size_t max_pending_chunks = 4 * n_threads;
+        const uint64_t chunk_size = Checksum::IsCombinable(args.checksum())
+                ? std::max<uint64_t>(args.chunkSize(), 1) * 1024 * 1024 : std::numeric_limits<uint64_t>::max();
+
+        const auto start = Clock::now();
+        uint64_t bytes_processed = 0;
+        size_t n_cached = 0;
+        {
+            run::ThreadPull pool(n_threads, false);
+            std::deque<FileTask> tasks;
+            size_t n_pending_chunks = 0;
+            const auto finalize_front = [&]() {
+                FileTask& task = tasks.front();
+                n_pending_chunks -= task.chunks.size();
+                Finalize(task, cache);
+                if(task.cached)
+                    ++n_cached;
+                else
+                    bytes_processed += task.size;
+                tasks.pop_front();
+            };
+
+            for(const auto& file : files) {
+                tasks.push_back(PrepareTask(file, cache, chunk_size, pool));
+                n_pending_chunks += tasks.back().chunks.size();
+                while(n_pending_chunks > max_pending_chunks)
+                    finalize_front();
+            }
+            while(!tasks.empty())
+                finalize_front();
+        }
+        cache.Save();
+
+        // The summary goes to stderr, so the list of checksums on stdout can be used directly.
+        const double time = std::chrono::duration<double>(Clock::now() - start).count();
+        std::cerr << files.size() << " files (" << n_cached << " from cache), " << std::fixed << std::setprecision(1)
+                  << bytes_processed / (1024. * 1024.) << " MiB processed in " << time << " s ("
+                  << (time > 0 ? bytes_processed / (1024. * 1024.) / time : 0.) << " MiB/s)." << std::endl;
+    }
+
+    std::vector<std::string> CollectFiles() const
+    {
+        std::vector<std::string> files;
+        for(const auto& input : args.inputStrings()) {
+            if(boost::filesystem::is_directory(input)) {
+                std::vector<std::string> dir_files;
+                for(const auto& entry : boost::filesystem::recursive_directory_iterator(input)) {
+                    if(boost::filesystem::is_regular_file(entry))
+                        dir_files.push_back(entry.path().string());
+                }
+                std::sort(dir_files.begin(), dir_files.end());
+                files.insert(files.end(), dir_files.begin(), dir_files.end());
+            } else if(boost::filesystem::is_regular_file(input)) {
+                files.push_back(input);
+            } else {
+                throw analysis::exception("File '%1%' not found.") % input;
+            }
+        }
+        return files;
+    }
+
+    FileTask PrepareTask(const std::string& file, const analysis::ChecksumCache& cache, uint64_t chunk_size,
+                         run::ThreadPull& pool) const
+    {
+        namespace ip = boost::interprocess;
+        FileTask task;
+        task.path = file;
+        task.size = boost::filesystem::file_size(file);
+        if(cache.Find(file, args.checksum(), task.checksum)) {
+            task.cached = true;
+            return task;
+        }
+        if(!task.size) return task;
+        ip::file_mapping mapping(file.c_str(), ip::read_only);
+        task.region = std::make_shared<ip::mapped_region>(mapping, ip::read_only);
+        task.region->advise(ip::mapped_region::advice_sequential);
+        const char* data = static_cast<const char*>(task.region->get_address());
+        for(uint64_t offset = 0; offset < task.size; offset += chunk_size) {
+            const uint64_t size = std::min(chunk_size, task.size - offset);
+            task.chunks.push_back(pool.run(&ComputeCRC::ChunkChecksum, data + offset, size, args.checksum()));
+            task.chunk_sizes.push_back(size);
+        }
+        return task;
+    }
+
+    void Finalize(FileTask& task, analysis::ChecksumCache& cache) const
+    {
+        if(!task.cached) {
+            task.checksum = Checksum(args.checksum()).Value();
+            for(size_t n = 0; n < task.chunks.size(); ++n) {
+                const uint64_t chunk_checksum = task.chunks.at(n).get();
+                task.checksum = n == 0 ? chunk_checksum
+                                       : Checksum::Combine(args.checksum(), task.checksum, chunk_checksum,
+                                                           task.chunk_sizes.at(n));
+            }
+            task.region.reset();
+            cache.Add(task.path, args.checksum(), task.checksum);
+        }
+        std::cout << Checksum::ToString(task.checksum, args.checksum()) << "  " << task.path << std::endl;
+    }
+
+    static uint64_t ChunkChecksum(const char* data, uint64_t size, analysis::ChecksumType type)
+    {
+        Checksum checksum(type);
+        checksum.Process(data, size);
+        return checksum.Value();
+    }
+
 private:
     Arguments args;
 };
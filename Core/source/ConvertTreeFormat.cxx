@@ -0,0 +1,99 @@
+/*! Convert trees stored in a root file between the TTree and the RNTuple formats.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <chrono>
+#include <iomanip>
+#include <set>
+#include <TKey.h>
+#include <TROOT.h>
+#include "AnalysisTools/Core/include/RNTupleConversion.h"
+#include "AnalysisTools/Core/include/RootExt.h"
+#include "AnalysisTools/Run/include/program_main.h"
+
+struct Arguments {
+    run::Argument<std::string> input{"input", "input root file"};
+    run::Argument<std::string> output{"output", "output root file"};
+    run::Argument<std::vector<std::string>> names{"name", "name of the tree or RNTuple to convert (default: all)",
+                                                  {}};
+    run::Argument<std::string> compression{"compression", "compression algorithm: ZLIB, LZMA, LZ4 or ZSTD", "ZSTD"};
+    run::Argument<int> compression_level{"compression-level", "compression level", 5};
+};
+
+// Each top-level TTree of the input file is converted into RNTuple and each RNTuple into TTree.
+class ConvertTreeFormat {
+public:
+    using exception = analysis::exception;
+    using Clock = std::chrono::steady_clock;
+
+    ConvertTreeFormat(const Arguments& _args) :
+        args(_args), compression(root_ext::ParseCompressionAlgorithm(args.compression()))
+    {
+        if(args.input() == args.output())
+            throw exception("Input and output files should be different.");
+    }
+
+#ifdef ANALYSIS_TOOLS_HAS_RNTUPLE
+    void Run()
+    {
+        std::vector<std::string> trees, ntuples;
+        {
+            auto input_file = root_ext::OpenRootFile(args.input());
+            const std::set<std::string> selected(args.names().begin(), args.names().end());
+            std::set<std::string> processed;
+            TIter next_key(input_file->GetListOfKeys());
+            for(TKey* key; (key = dynamic_cast<TKey*>(next_key()));) {
+                const std::string name = key->GetName(), class_name = key->GetClassName();
+                if(!processed.insert(name).second || (!selected.empty() && !selected.count(name))) continue;
+                TClass* cl = gROOT->GetClass(class_name.c_str());
+                if(cl && cl->InheritsFrom("TTree"))
+                    trees.push_back(name);
+                else if(class_name == "ROOT::RNTuple" || class_name == "ROOT::Experimental::RNTuple")
+                    ntuples.push_back(name);
+            }
+            for(const auto& name : selected) {
+                if(!processed.count(name))
+                    throw exception("Object '%1%' not found in '%2%'.") % name % args.input();
+            }
+        }
+        if(trees.empty() && ntuples.empty())
+            throw exception("Nothing to convert in '%1%'.") % args.input();
+
+        {
+            auto input_file = root_ext::OpenRootFile(args.input());
+            auto output_file = root_ext::CreateRootFile(args.output(), compression, args.compression_level());
+            for(const auto& name : ntuples) {
+                const auto start = Clock::now();
+                const Long64_t n_entries = root_ext::ConvertNTupleToTree(*input_file, *output_file, name);
+                Report(name, "TTree", n_entries, start);
+            }
+        }
+        // The importer opens the output file by itself, so the trees are converted after the file has been closed.
+        for(const auto& name : trees) {
+            const auto start = Clock::now();
+            const Long64_t n_entries = root_ext::ConvertTreeToNTuple(args.input(), name, args.output(), compression,
+                                                                     args.compression_level());
+            Report(name, "RNTuple", n_entries, start);
+        }
+    }
+#else
+    void Run()
+    {
+        throw exception("RNTuple support is not available: AnalysisTools should be built with ROOT 6.32 or newer.");
+    }
+#endif
+
+private:
+    static void Report(const std::string& name, const std::string& format, Long64_t n_entries,
+                       const Clock::time_point& start)
+    {
+        const double time = std::chrono::duration<double>(Clock::now() - start).count();
+        std::cout << "'" << name << "' converted into " << format << ": " << n_entries << " entries in "
+                  << std::fixed << std::setprecision(1) << time << " s." << std::endl;
+    }
+
+private:
+    Arguments args;
+    ROOT::ECompressionAlgorithm compression;
+};
+
+PROGRAM_MAIN(ConvertTreeFormat, Arguments)
@@ -0,0 +1,261 @@
+/*! Merge a large number of root files through a multi-level reduction tree.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <fcntl.h>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <boost/filesystem.hpp>
+#include "AnalysisTools/Core/include/DatasetCatalog.h"
+#include "AnalysisTools/Core/include/MergePlanner.h"
+#include "AnalysisTools/Core/include/RootFilesMerger.h"
+#include "AnalysisTools/Run/include/program_main.h"
+
+struct Arguments {
+    run::Argument<std::string> output{"output", "output root file"};
+    run::Argument<std::string> work_dir{"work-dir", "directory for the intermediate files and job definitions"};
+    run::Argument<std::vector<std::string>> input_dirs{"input-dir", "input directory"};
+    run::Argument<std::string> file_name_pattern{"file-name-pattern", "regex expression to match file names",
+                                                 "^.*\\.root$"};
+    run::Argument<std::string> exclude_list{"exclude-list", "comma separated list of files to exclude", ""};
+    run::Argument<std::string> exclude_dir_list{"exclude-dir-list",
+                                                "comma separated list of directories to exclude", ""};
+    run::Argument<size_t> max_files{"max-files", "maximal number of inputs per merge task", 100};
+    run::Argument<double> max_size{"max-size", "maximal total size of the input files per leaf task in MiB"
+                                               " (0 - not limited)", 0};
+    run::Argument<Long64_t> max_entries{"max-entries", "maximal number of entries per leaf task (0 - not limited);"
+                                                       " requires a dataset catalog", 0};
+    run::Argument<std::string> catalog{"catalog", "dataset catalog used to get number of entries in the inputs", ""};
+    run::Argument<std::string> mode{"mode", "'local' to run the merge tree in parallel on this machine or 'jobs'"
+                                            " to write job definitions for each level", "local"};
+    run::Argument<unsigned> n_parallel{"n-parallel", "number of merge tasks running in parallel in the local mode",
+                                       1};
+    run::Argument<std::string> merge_exe{"merge-exe", "merge executable that runs each task",
+                                         "MergeRootFiles"};
+    run::Argument<bool> keep_intermediate{"keep-intermediate", "keep intermediate files", false};
+};
+
+class HierarchicalMerge {
+public:
+    using exception = analysis::exception;
+    using MergePlanner = analysis::MergePlanner;
+    using Task = MergePlanner::Task;
+
+    HierarchicalMerge(const Arguments& _args) : args(_args)
+    {
+        MergePlanner::Limits limits;
+        limits.max_files = args.max_files();
+        limits.max_size = static_cast<uint64_t>(args.max_size() * 1024 * 1024);
+        limits.max_entries = args.max_entries();
+        if(limits.max_entries && args.catalog().empty())
+            throw exception("Dataset catalog is required to limit the number of entries per task.");
+        if(args.mode() != "local" && args.mode() != "jobs")
+            throw exception("Unknown mode '%1%'.") % args.mode();
+        const MergePlanner planner(limits, args.work_dir(), args.output());
+        levels = planner.Plan(CollectInputs());
+    }
+
+    void Run()
+    {
+        std::cout << "Merge plan:";
+        for(const auto& level : levels)
+            std::cout << " " << level.size();
+        std::cout << " tasks per level." << std::endl;
+        for(size_t level_id = 0; level_id + 1 < levels.size(); ++level_id)
+            boost::filesystem::create_directories(boost::filesystem::path(levels.at(level_id).front().output)
+                                                  .parent_path());
+        if(args.mode() == "jobs")
+            WriteJobs();
+        else
+            RunLocally();
+    }
+
+private:
+    std::vector<MergePlanner::Input> CollectInputs() const
+    {
+        const auto files = analysis::RootFilesMerger::FindInputFiles(args.input_dirs(), args.file_name_pattern(),
+                                                                     args.exclude_list(), args.exclude_dir_list());
+        std::shared_ptr<analysis::DatasetCatalog> catalog;
+        if(!args.catalog().empty()) {
+            catalog = std::make_shared<analysis::DatasetCatalog>(args.catalog());
+            if(catalog->Update(files, "", std::max(args.n_parallel(), 1u)))
+                catalog->Save();
+        }
+        std::vector<MergePlanner::Input> inputs;
+        for(const auto& file : files) {
+            MergePlanner::Input input;
+            input.path = file;
+            input.size = boost::filesystem::file_size(file);
+            if(catalog) {
+                for(const auto& tree : catalog->at(file).trees)
+                    input.n_entries += tree.n_entries;
+            }
+            inputs.push_back(input);
+        }
+        return inputs;
+    }
+
+    std::string FileListName(const Task& task) const
+    {
+        const auto dir = boost::filesystem::path(args.work_dir()) / ("level_" + std::to_string(task.level));
+        return (dir / ("inputs_" + std::to_string(task.index) + ".txt")).string();
+    }
+
+    // Each task is merged by a separate process of the merge executable. Intermediate outputs are stored with their
+    // checksums, which are verified by the tasks of the next level.
+    std::vector<std::string> TaskArguments(const Task& task) const
+    {
+        std::vector<std::string> arguments = { args.merge_exe(), "--output", task.output,
+                                               "--file-list", FileListName(task), "--write-checksum", "1" };
+        if(task.level > 0) {
+            arguments.push_back("--verify-checksums");
+            arguments.push_back("1");
+        }
+        return arguments;
+    }
+
+    // Command line of the task for the job definitions, which are run by the shell.
+    std::string TaskCommand(const Task& task) const
+    {
+        std::ostringstream command;
+        bool first = true;
+        for(const auto& argument : TaskArguments(task)) {
+            if(!first)
+                command << " ";
+            command << ShellQuote(argument);
+            first = false;
+        }
+        return command.str();
+    }
+
+    static std::string ShellQuote(const std::string& str)
+    {
+        static const std::string safe_chars = "@%+=:,./-_";
+        const bool is_safe = !str.empty() && std::all_of(str.begin(), str.end(), [](char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || safe_chars.find(c) != std::string::npos;
+        });
+        if(is_safe) return str;
+        std::string quoted = "'";
+        for(char c : str) {
+            if(c == '\'')
+                quoted += "'\\''";
+            else
+                quoted += c;
+        }
+        return quoted + "'";
+    }
+
+    void WriteFileList(const Task& task) const
+    {
+        boost::filesystem::create_directories(boost::filesystem::path(FileListName(task)).parent_path());
+        std::ofstream file_list(FileListName(task));
+        for(const auto& input : task.inputs)
+            file_list << input << "\n";
+    }
+
+    void WriteJobs() const
+    {
+        for(size_t level_id = 0; level_id < levels.size(); ++level_id) {
+            const std::string jobs_file = (boost::filesystem::path(args.work_dir())
+                                           / ("merge_level_" + std::to_string(level_id) + ".txt")).string();
+            std::ofstream jobs(jobs_file);
+            jobs << "# name n_threads memory command\n";
+            for(const auto& task : levels.at(level_id)) {
+                WriteFileList(task);
+                jobs << "merge_" << task.level << "_" << task.index << " 1 - " << TaskCommand(task) << "\n";
+            }
+            std::cout << "Level " << level_id << " jobs: " << jobs_file << std::endl;
+        }
+        std::cout << "Run the levels in order, e.g. with RunLocalJobs, after all jobs of the previous level have"
+                     " successfully finished." << std::endl;
+    }
+
+    // Tasks run in separate processes, so they do not share the global state of ROOT and of RootFilesMerger, and the
+    // output of each task goes to its own log file.
+    void RunLocally() const
+    {
+        const size_t n_parallel = std::max(args.n_parallel(), 1u);
+        for(size_t level_id = 0; level_id < levels.size(); ++level_id) {
+            const auto& level = levels.at(level_id);
+            std::cout << "Merging level " << level_id << " (" << level.size() << " tasks)..." << std::endl;
+            std::map<pid_t, const Task*> running;
+            std::vector<const Task*> failed;
+            for(size_t task_id = 0; task_id < level.size() || !running.empty();) {
+                if(task_id < level.size() && running.size() < n_parallel) {
+                    const Task& task = level.at(task_id++);
+                    running[Start(task)] = &task;
+                    continue;
+                }
+                int status;
+                pid_t pid;
+                while((pid = waitpid(-1, &status, 0)) < 0) {
+                    if(errno != EINTR)
+                        throw exception("Error while waiting for the merge tasks.");
+                }
+                auto iter = running.find(pid);
+                if(iter == running.end()) continue;
+                if(!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                    failed.push_back(iter->second);
+                running.erase(iter);
+            }
+            for(const Task* task : failed)
+                std::cerr << "ERROR: merge task " << task->level << "_" << task->index << " failed. See '"
+                          << LogFileName(*task) << "' for details." << std::endl;
+            if(!failed.empty())
+                throw exception("%1% of %2% merge tasks failed at level %3%.") % failed.size() % level.size()
+                    % level_id;
+            if(level_id > 0 && !args.keep_intermediate()) {
+                for(const auto& task : levels.at(level_id - 1)) {
+                    boost::filesystem::remove(task.output);
+                    boost::filesystem::remove(MergePlanner::ChecksumFileName(task.output));
+                }
+            }
+        }
+        std::ifstream checksum_file(MergePlanner::ChecksumFileName(args.output()));
+        std::string checksum;
+        checksum_file >> checksum;
+        std::cout << "Output '" << args.output() << "' successfully created. CRC32 = " << checksum << std::endl;
+    }
+
+    std::string LogFileName(const Task& task) const
+    {
+        return boost::filesystem::path(FileListName(task)).replace_extension(".log").string();
+    }
+
+    pid_t Start(const Task& task) const
+    {
+        WriteFileList(task);
+        // The task is started without the shell, so the paths are passed to the merge executable as they are.
+        const std::vector<std::string> arguments = TaskArguments(task);
+        std::vector<char*> argv;
+        for(const auto& argument : arguments)
+            argv.push_back(const_cast<char*>(argument.c_str()));
+        argv.push_back(nullptr);
+        const std::string log_file = LogFileName(task);
+        const pid_t pid = fork();
+        if(pid < 0)
+            throw exception("Unable to start merge task %1%_%2%.") % task.level % task.index;
+        if(pid == 0) {
+            const int fd = open(log_file.c_str(), O_WRONLY | O_TRUNC | O_CREAT, 0644);
+            if(fd >= 0) {
+                dup2(fd, STDOUT_FILENO);
+                dup2(fd, STDERR_FILENO);
+                close(fd);
+            }
+            execvp(argv.at(0), argv.data());
+            _exit(127);
+        }
+        return pid;
+    }
+
+private:
+    Arguments args;
+    std::vector<MergePlanner::Level> levels;
+};
+
+PROGRAM_MAIN(HierarchicalMerge, Arguments)
@@ -1,32 +1,113 @@
 /*! Merge multiple root files into a single file.
 This file is part of https://github.com/hh-italian-group/AnalysisTools. */
 
+#include "AnalysisTools/Core/include/MergePlanner.h"
 #include "AnalysisTools/Core/include/RootFilesMerger.h"
+#include "AnalysisTools/Run/include/MultiThread.h"
 #include "AnalysisTools/Run/include/program_main.h"
 
 struct Arguments {
     run::Argument<std::string> output{"output", "output root file"};
-    run::Argument<std::vector<std::string>> input_dirs{"input-dir", "input directory"};
+    run::Argument<std::vector<std::string>> input_dirs{"input-dir", "input directory", {}};
     run::Argument<std::string> file_name_pattern{"file-name-pattern", "regex expression to match file names",
                                                  "^.*\\.root$"};
     run::Argument<std::string> exclude_list{"exclude-list", "comma separated list of files to exclude", ""};
     run::Argument<std::string> exclude_dir_list{"exclude-dir-list",
                                                 "comma separated list of directories to exclude", ""};
     run::Argument<unsigned> n_threads{"n-threads", "number of threads", 1};
+    run::Argument<std::string> file_list{"file-list", "text file with the list of input files, one per line", ""};
+    run::Argument<size_t> hist_shards{"hist-shards", "number of passes over inputs used to merge histograms", 1};
+    run::Argument<double> hist_memory{"hist-memory", "memory limit for histograms in MiB; if set, the number of"
+                                                     " passes is chosen automatically", 0};
+    run::Argument<std::string> selection{"selection", "selection applied to the tree entries while merging", ""};
+    run::Argument<std::string> sample{"sample", "keep a deterministic sample of events: 'k/N' - shard k of N, 'x%'"
+                                                " - x percents, 'a:b' - fraction range [a, b) (all if empty)", ""};
+    run::Argument<uint64_t> sample_seed{"sample-seed", "seed of the event id hash", 0};
+    run::Argument<std::string> id_columns{"id-columns", "comma separated run, lumi and event id columns used for"
+                                                        " the sampling", "run,lumi,evt"};
+    run::Argument<std::string> include_branches{"include-branches", "comma separated list of branches to keep"
+                                                                    " (wildcards are allowed)", ""};
+    run::Argument<std::string> exclude_branches{"exclude-branches", "comma separated list of branches to drop"
+                                                                    " (wildcards are allowed)", ""};
+    run::Argument<std::string> filter_trees{"filter-trees", "comma separated list of trees to which the selection,"
+                                                            " the sample and the branch lists are applied (all"
+                                                            " trees if empty)", ""};
+    run::Argument<double> max_output_size{"max-output-size", "maximal size of the output file in MiB; trees are"
+                                                             " split into several files if needed (0 - not limited)",
+                                          0};
+    run::Argument<Long64_t> max_output_entries{"max-output-entries", "maximal number of tree entries per output"
+                                                                     " file (0 - not limited)", 0};
+    run::Argument<unsigned> n_writers{"n-writers", "number of output files written in parallel", 1};
+    run::Argument<unsigned> n_io_threads{"n-io-threads", "number of threads used to open the input files and to"
+                                                         " write the output parts", 2};
+    run::Argument<run::ThreadAffinity> affinity{"affinity", "placement of the I/O and the compute threads on the"
+                                                            " CPUs: none, core or numa", run::ThreadAffinity::None};
+    run::Argument<bool> verify_checksums{"verify-checksums", "verify inputs against their checksum files, written"
+                                                             " by --write-checksum", false};
+    run::Argument<bool> write_checksum{"write-checksum", "write CRC32 of the output into '<output>.crc32'", false};
 };
 
 class MergeRootFiles : public analysis::RootFilesMerger {
 public:
-    MergeRootFiles(const Arguments& args) :
-        RootFilesMerger(args.output(), args.input_dirs(), args.file_name_pattern(), args.exclude_list(),
-                        args.exclude_dir_list(), args.n_threads(), ROOT::kZLIB, 9)
+    MergeRootFiles(const Arguments& _args) :
+        RootFilesMerger(_args.output(), CollectInputFiles(_args), _args.n_threads(), ROOT::kZLIB, 9), args(_args),
+        executors(run::Executors::Config(std::max(args.n_io_threads(), 1u), std::max(args.n_threads(), 1u),
+                                         args.affinity()))
     {
+        SetNumberOfHistogramShards(args.hist_shards());
+        SetHistogramMemoryLimit(static_cast<size_t>(args.hist_memory() * 1024 * 1024));
+        TreeFilter filter;
+        filter.selection = args.selection();
+        if(!args.sample().empty())
+            filter.sampler = analysis::EventSampler::Parse(args.sample(), args.sample_seed());
+        filter.id_columns = analysis::SplitValueList(args.id_columns(), false, ",");
+        filter.include_branches = analysis::SplitValueList(args.include_branches(), false, ",");
+        filter.exclude_branches = analysis::SplitValueList(args.exclude_branches(), false, ",");
+        const auto filter_trees = analysis::SplitValueList(args.filter_trees(), false, ",");
+        if(filter_trees.empty())
+            SetTreeFilter("", filter);
+        for(const auto& tree_name : filter_trees)
+            SetTreeFilter(tree_name, filter);
+        SplitLimits split;
+        split.max_size = static_cast<uint64_t>(args.max_output_size() * 1024 * 1024);
+        split.max_entries = args.max_output_entries();
+        split.n_writers = args.n_writers();
+        SetOutputSplitting(split);
     }
 
     void Run()
     {
+        if(args.verify_checksums()) {
+            for(const auto& input : input_files)
+                analysis::MergePlanner::VerifyChecksum(input);
+        }
         Process(true, true);
+        if(args.write_checksum()) {
+            // The file should be complete before its checksum is computed.
+            output_file->Close();
+            analysis::MergePlanner::WriteChecksum(args.output());
+        }
     }
+
+private:
+    static std::vector<std::string> CollectInputFiles(const Arguments& args)
+    {
+        std::vector<std::string> files;
+        if(!args.input_dirs().empty())
+            files = FindInputFiles(args.input_dirs(), args.file_name_pattern(), args.exclude_list(),
+                                   args.exclude_dir_list());
+        if(!args.file_list().empty()) {
+            const auto listed_files = ReadFileList(args.file_list());
+            files.insert(files.end(), listed_files.begin(), listed_files.end());
+        }
+        if(files.empty())
+            throw analysis::exception("No input files are specified.");
+        return files;
+    }
+
+private:
+    Arguments args;
+    run::Executors executors;
 };
 
 PROGRAM_MAIN(MergeRootFiles, Arguments)
@@ -0,0 +1,102 @@
+/*! Fetch the selected events from the dataset using the event catalog.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <fstream>
+#include <TTree.h>
+#include "AnalysisTools/Core/include/EventCatalog.h"
+#include "AnalysisTools/Core/include/RootExt.h"
+#include "AnalysisTools/Run/include/program_main.h"
+
+struct Arguments {
+    run::Argument<std::string> catalog{"catalog", "event catalog file"};
+    run::Argument<std::string> output{"output", "output ROOT file; if empty, only the event locations are printed",
+                                      ""};
+    run::Argument<std::string> events_file{"events-file", "file with the list of events, one run:lumi:evt per line",
+                                           ""};
+    run::Argument<std::vector<std::string>> events{"events", "list of events in run:lumi:evt format", {}};
+};
+
+class PickEvents {
+public:
+    using EventIdentifier = analysis::EventIdentifier;
+    using EventCatalog = analysis::EventCatalog;
+
+    PickEvents(const Arguments& _args) : args(_args), catalog(args.catalog()) {}
+
+    void Run()
+    {
+        const auto ids = CollectEventIds();
+        std::vector<EventIdentifier> not_found;
+        const auto matches = catalog.Locate(ids, &not_found);
+        for(const auto& id : not_found)
+            std::cerr << "Event " << id << " not found in the catalog." << std::endl;
+
+        if(args.output().empty()) {
+            for(const auto& file_matches : matches) {
+                const auto& path = catalog.GetFiles().at(file_matches.first).path;
+                for(const auto& match : file_matches.second)
+                    std::cout << match.id << " " << path << " " << match.entry << "\n";
+            }
+            return;
+        }
+        CopyEvents(matches);
+    }
+
+private:
+    std::vector<EventIdentifier> CollectEventIds() const
+    {
+        std::vector<EventIdentifier> ids;
+        for(const auto& id_str : args.events())
+            ids.emplace_back(id_str);
+        if(!args.events_file().empty()) {
+            std::ifstream cfg(args.events_file());
+            if(cfg.fail())
+                throw analysis::exception("Failed to open file '%1%'.") % args.events_file();
+            std::string line;
+            while(std::getline(cfg, line)) {
+                if(line.empty() || line.at(0) == '#') continue;
+                ids.emplace_back(line);
+            }
+        }
+        return ids;
+    }
+
+    void CopyEvents(const EventCatalog::FileMatches& matches) const
+    {
+        auto output_file = root_ext::CreateRootFile(args.output());
+        TTree* output_tree = nullptr;
+        size_t n_copied = 0;
+        for(const auto& file_matches : matches) {
+            const auto& file_entry = catalog.GetFiles().at(file_matches.first);
+            if(!EventCatalog::IsUpToDate(file_entry))
+                throw analysis::exception("File '%1%' has been modified after the event catalog was built.")
+                    % file_entry.path;
+            auto file = root_ext::OpenRootFile(file_entry.path);
+            auto tree = root_ext::ReadObject<TTree>(*file, catalog.TreeName());
+            if(!output_tree) {
+                output_tree = tree->CloneTree(0);
+                output_tree->SetDirectory(output_file.get());
+            } else {
+                tree->CopyAddresses(output_tree);
+            }
+            for(const auto& match : file_matches.second) {
+                if(tree->GetEntry(match.entry) <= 0)
+                    throw analysis::exception("Unable to read entry %1% from '%2%'.") % match.entry
+                        % file_entry.path;
+                output_tree->Fill();
+                ++n_copied;
+            }
+            tree->CopyAddresses(output_tree, true);
+        }
+        if(output_tree)
+            root_ext::WriteObject(*output_tree);
+        std::cout << n_copied << " events copied from " << matches.size() << " files into '" << args.output()
+                  << "'." << std::endl;
+    }
+
+private:
+    Arguments args;
+    EventCatalog catalog;
+};
+
+PROGRAM_MAIN(PickEvents, Arguments)
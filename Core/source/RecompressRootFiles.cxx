@@ -0,0 +1,276 @@
+/*! Recompress root files with a different compression algorithm or level.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <iomanip>
+#include <set>
+#include <boost/crc.hpp>
+#include <boost/filesystem.hpp>
+#include <TLeaf.h>
+#include "AnalysisTools/Core/include/BranchReaderFactory.h"
+#include "AnalysisTools/Core/include/RootFilesMerger.h"
+#include "AnalysisTools/Run/include/MultiThread.h"
+#include "AnalysisTools/Run/include/program_main.h"
+
+struct Arguments {
+    run::Argument<std::string> output_dir{"output-dir", "output directory"};
+    run::Argument<std::vector<std::string>> input_dirs{"input-dir", "input directory", {}};
+    run::Argument<std::string> file_name_pattern{"file-name-pattern", "regex expression to match file names",
+                                                 "^.*\\.root$"};
+    run::Argument<std::string> file_list{"file-list", "text file with the list of input files, one per line", ""};
+    run::Argument<std::string> compression{"compression", "compression algorithm: ZLIB, LZMA, LZ4 or ZSTD", "LZ4"};
+    run::Argument<int> compression_level{"compression-level", "compression level", 4};
+    run::Argument<unsigned> n_parallel{"n-parallel", "number of files processed in parallel", 1};
+    run::Argument<unsigned> n_threads{"n-threads", "number of threads used to (de)compress baskets of each file", 1};
+    run::Argument<bool> verify{"verify", "compare number of entries and content checksums of the trees", true};
+};
+
+namespace {
+// Adds values of a std::vector branch to the checksum. TLeaf::GetValue does not expose elements of STL containers,
+// so the branch is read into a std::vector of its value type.
+struct VectorBranchHasher {
+    virtual ~VectorBranchHasher() {}
+    virtual void Process(boost::crc_32_type& crc) const = 0;
+};
+
+template<typename T>
+struct TypedVectorBranchHasher : VectorBranchHasher {
+    std::vector<T>* value{nullptr};
+
+    TypedVectorBranchHasher(TTree& tree, TBranch& branch) { tree.SetBranchAddress(branch.GetName(), &value); }
+    virtual ~TypedVectorBranchHasher() override { delete value; }
+
+    virtual void Process(boost::crc_32_type& crc) const override
+    {
+        const uint64_t size = value ? value->size() : 0;
+        crc.process_bytes(&size, sizeof(size));
+        for(size_t n = 0; n < size; ++n) {
+            const T x = (*value)[n];
+            crc.process_bytes(&x, sizeof(x));
+        }
+    }
+
+    static VectorBranchHasher* Make(TTree& tree, TBranch& branch)
+    {
+        return new TypedVectorBranchHasher<T>(tree, branch);
+    }
+};
+
+using VectorBranchHasherFactory =
+    root_ext::BranchReaderFactory<VectorBranchHasher* (*)(TTree&, TBranch&), root_ext::UnsupportedBranchReader,
+                                  TypedVectorBranchHasher>;
+} // anonymous namespace
+
+class RecompressRootFiles {
+public:
+    using exception = analysis::exception;
+    using Clock = std::chrono::steady_clock;
+
+    struct FileStats {
+        std::string input, output;
+        uint64_t input_size{0}, output_size{0};
+        Long64_t tree_bytes{0}; // uncompressed size of the trees
+        size_t n_trees{0}, n_objects{0};
+        double time{0}; // seconds
+    };
+
+    RecompressRootFiles(const Arguments& _args) :
+        args(_args), compression(root_ext::ParseCompressionAlgorithm(args.compression()))
+    {
+        if(!args.input_dirs().empty())
+            input_files = analysis::RootFilesMerger::FindInputFiles(args.input_dirs(), args.file_name_pattern(), "",
+                                                                    "");
+        if(!args.file_list().empty()) {
+            const auto listed_files = analysis::RootFilesMerger::ReadFileList(args.file_list());
+            input_files.insert(input_files.end(), listed_files.begin(), listed_files.end());
+        }
+        if(input_files.empty())
+            throw exception("No input files are specified.");
+        std::set<std::string> output_names;
+        for(const auto& file : input_files) {
+            const std::string name = boost::filesystem::path(file).filename().string();
+            if(!output_names.insert(name).second)
+                throw exception("Several input files have the same name '%1%'.") % name;
+        }
+        boost::filesystem::create_directories(args.output_dir());
+    }
+
+    void Run()
+    {
+        ROOT::EnableThreadSafety();
+        if(args.n_threads() > 1)
+            ROOT::EnableImplicitMT(args.n_threads());
+        const auto start = Clock::now();
+        std::vector<FileStats> stats(input_files.size());
+        {
+            run::ThreadPull pool(std::max(args.n_parallel(), 1u), false);
+            std::vector<std::future<void>> results;
+            for(size_t n = 0; n < input_files.size(); ++n)
+                results.push_back(pool.run(&RecompressRootFiles::ProcessFile, this, std::cref(input_files.at(n)),
+                                           std::ref(stats.at(n))));
+            for(auto& result : results)
+                result.get();
+        }
+        const double total_time = std::chrono::duration<double>(Clock::now() - start).count();
+        PrintSummary(stats, total_time);
+    }
+
+private:
+    void ProcessFile(const std::string& input, FileStats& stats) const
+    {
+        const auto start = Clock::now();
+        stats.input = input;
+        stats.output = (boost::filesystem::path(args.output_dir())
+                        / boost::filesystem::path(input).filename()).string();
+        std::vector<std::string> tree_names;
+        {
+            auto input_file = root_ext::OpenRootFile(input);
+            auto output_file = root_ext::CreateRootFile(stats.output, compression, args.compression_level());
+            CopyDirectory(*input_file, *output_file, "", tree_names, stats);
+            output_file->Close();
+        }
+        if(args.verify())
+            Verify(stats, tree_names);
+        stats.input_size = boost::filesystem::file_size(stats.input);
+        stats.output_size = boost::filesystem::file_size(stats.output);
+        stats.time = std::chrono::duration<double>(Clock::now() - start).count();
+        std::cout << "'" << input << "' recompressed in " << std::fixed << std::setprecision(1) << stats.time
+                  << " s." << std::endl;
+    }
+
+    // Copies all objects keeping the directory structure. Only the latest cycle of each key is copied.
+    static void CopyDirectory(TDirectory& input_dir, TDirectory& output_dir, const std::string& path,
+                              std::vector<std::string>& tree_names, FileStats& stats)
+    {
+        std::set<std::string> processed;
+        TIter next_key(input_dir.GetListOfKeys());
+        for(TKey* key; (key = dynamic_cast<TKey*>(next_key()));) {
+            const std::string name = key->GetName();
+            if(!processed.insert(name).second) continue;
+            TClass* cl = gROOT->GetClass(key->GetClassName());
+            if(cl && cl->InheritsFrom("TDirectory")) {
+                auto input_subdir = root_ext::ReadObject<TDirectory>(input_dir, name);
+                TDirectory* output_subdir = output_dir.mkdir(name.c_str(), key->GetTitle());
+                if(!output_subdir)
+                    throw exception("Unable to create directory '%1%%2%'.") % path % name;
+                CopyDirectory(*input_subdir, *output_subdir, path + name + "/", tree_names, stats);
+            } else if(cl && cl->InheritsFrom("TTree")) {
+                std::unique_ptr<TTree> tree(root_ext::ReadObject<TTree>(input_dir, name));
+                output_dir.cd();
+                // Entries are read and filled again, so all baskets are decompressed and compressed with the new
+                // settings. With implicit MT enabled, baskets of different branches are processed in parallel.
+                std::unique_ptr<TTree> output_tree(tree->CloneTree(-1));
+                if(!output_tree)
+                    throw exception("Unable to copy tree '%1%%2%'.") % path % name;
+                output_dir.WriteTObject(output_tree.get(), name.c_str(), "Overwrite");
+                tree_names.push_back(path + name);
+                stats.tree_bytes += tree->GetTotBytes();
+                ++stats.n_trees;
+            } else {
+                std::unique_ptr<TObject> object(key->ReadObj());
+                output_dir.WriteTObject(object.get(), name.c_str(), "Overwrite");
+                ++stats.n_objects;
+            }
+        }
+    }
+
+    static void Verify(const FileStats& stats, const std::vector<std::string>& tree_names)
+    {
+        auto input_file = root_ext::OpenRootFile(stats.input);
+        auto output_file = root_ext::OpenRootFile(stats.output);
+        for(const auto& tree_name : tree_names) {
+            std::unique_ptr<TTree> input_tree(root_ext::ReadObject<TTree>(*input_file, tree_name));
+            std::unique_ptr<TTree> output_tree(root_ext::ReadObject<TTree>(*output_file, tree_name));
+            if(input_tree->GetEntries() != output_tree->GetEntries())
+                throw exception("Number of entries in '%1%' tree differs between '%2%' and '%3%'.") % tree_name
+                    % stats.input % stats.output;
+            if(TreeChecksum(*input_tree) != TreeChecksum(*output_tree))
+                throw exception("Content of '%1%' tree differs between '%2%' and '%3%'.") % tree_name % stats.input
+                    % stats.output;
+        }
+    }
+
+    // CRC32 of the values of all entries. Values of the basic leaves are taken as they are exposed by TLeaf::GetValue,
+    // std::vector branches are read through the typed readers of root_ext::BranchReaderFactory. Other STL containers
+    // and objects (TLeafElement and TLeafObject) can't be content-hashed, so the verification fails for them.
+    static uint32_t TreeChecksum(TTree& tree)
+    {
+        std::vector<TLeaf*> basic_leaves;
+        std::vector<TBranch*> branches, object_branches;
+        TObjArray* leaves = tree.GetListOfLeaves();
+        for(int leaf_id = 0; leaf_id < leaves->GetEntriesFast(); ++leaf_id) {
+            TLeaf* leaf = dynamic_cast<TLeaf*>(leaves->UncheckedAt(leaf_id));
+            TBranch* branch = leaf->GetBranch();
+            if(std::find(branches.begin(), branches.end(), branch) == branches.end())
+                branches.push_back(branch);
+            if(!leaf->InheritsFrom("TLeafElement") && !leaf->InheritsFrom("TLeafObject"))
+                basic_leaves.push_back(leaf);
+            else if(std::find(object_branches.begin(), object_branches.end(), branch) == object_branches.end())
+                object_branches.push_back(branch);
+        }
+
+        std::vector<std::unique_ptr<VectorBranchHasher>> vector_hashers;
+        for(TBranch* branch : object_branches) {
+            const auto make = VectorBranchHasherFactory::FindMakeMethod(*branch);
+            if(!make) {
+                const root_ext::BranchValueType value_type = root_ext::GetBranchValueType(*branch);
+                const std::string reason = value_type.reason.empty() ? "a split object" : value_type.reason;
+                throw exception("Content of branch '%1%' of '%2%' tree can't be verified: it stores %3%. Use"
+                                " --verify 0 to skip the verification.") % branch->GetName() % tree.GetName()
+                                % reason;
+            }
+            vector_hashers.emplace_back((*make)(tree, *branch));
+        }
+
+        boost::crc_32_type crc;
+        const Long64_t n_entries = tree.GetEntries();
+        for(Long64_t entry = 0; entry < n_entries; ++entry) {
+            for(TBranch* branch : branches) {
+                if(branch->GetEntry(entry) < 0)
+                    throw exception("Unable to read entry %1% of branch '%2%'.") % entry % branch->GetName();
+            }
+            for(TLeaf* leaf : basic_leaves) {
+                const Int_t len = leaf->GetLen();
+                crc.process_bytes(&len, sizeof(len));
+                for(Int_t n = 0; n < len; ++n) {
+                    const Double_t value = leaf->GetValue(n);
+                    crc.process_bytes(&value, sizeof(value));
+                }
+            }
+            for(const auto& hasher : vector_hashers)
+                hasher->Process(crc);
+        }
+        tree.ResetBranchAddresses();
+        return crc.checksum();
+    }
+
+    void PrintSummary(const std::vector<FileStats>& stats, double total_time) const
+    {
+        static constexpr double MiB = 1024. * 1024.;
+        uint64_t input_size = 0, output_size = 0;
+        Long64_t tree_bytes = 0;
+        for(const auto& file_stats : stats) {
+            input_size += file_stats.input_size;
+            output_size += file_stats.output_size;
+            tree_bytes += file_stats.tree_bytes;
+        }
+        std::cout << std::fixed << std::setprecision(1) << stats.size() << " files recompressed with "
+                  << args.compression() << "-" << args.compression_level() << " in " << total_time << " s.\n"
+                  << "Input size: " << input_size / MiB << " MiB, output size: " << output_size / MiB
+                  << " MiB (ratio " << std::setprecision(3)
+                  << (input_size ? static_cast<double>(output_size) / input_size : 0.) << ").\n"
+                  << std::setprecision(1) << "Throughput: "
+                  << (total_time > 0 ? input_size / MiB / total_time : 0.) << " MiB/s compressed input, "
+                  << (total_time > 0 ? tree_bytes / MiB / total_time : 0.) << " MiB/s uncompressed tree data."
+                  << std::endl;
+    }
+
+private:
+    Arguments args;
+    ROOT::ECompressionAlgorithm compression;
+    std::vector<std::string> input_files;
+};
+
+PROGRAM_MAIN(RecompressRootFiles, Arguments)
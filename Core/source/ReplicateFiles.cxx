@@ -0,0 +1,241 @@
+/*! Copy files between local or mounted file systems in parallel, verifying the content with checksums.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <future>
+#include <iomanip>
+#include <map>
+#include <unistd.h>
+#include <boost/filesystem.hpp>
+#include <boost/regex.hpp>
+#include "AnalysisTools/Core/include/FileChecksum.h"
+#include "AnalysisTools/Run/include/MultiThread.h"
+#include "AnalysisTools/Run/include/program_main.h"
+
+struct Arguments {
+    run::Argument<std::string> input_dir{"input-dir", "source directory"};
+    run::Argument<std::string> output_dir{"output-dir", "destination directory"};
+    run::Argument<std::string> file_name_pattern{"file-name-pattern", "regex expression to match file names",
+                                                 "^.*\\.root$"};
+    run::Argument<analysis::ChecksumType> checksum_type{"checksum", "checksum type: crc32, adler32 or xxh64",
+                                                        analysis::ChecksumType::Adler32};
+    run::Argument<std::string> cache{"cache", "file with the checksum cache (not stored if empty)", ""};
+    run::Argument<unsigned> n_parallel{"n-parallel", "number of files copied in parallel", 4};
+    run::Argument<size_t> buffer_size{"buffer-size", "size of the copy buffer in MiB", 16};
+    run::Argument<bool> verify{"verify", "read the destination after copy and compare the checksums", true};
+};
+
+namespace {
+enum class CopyStatus { Copied, Resumed, Skipped, Failed };
+
+struct CopyResult {
+    std::string source;
+    CopyStatus status{CopyStatus::Failed};
+    uint64_t bytes_copied{0}, checksum{0};
+};
+
+struct FileDescriptor {
+    int fd;
+    FileDescriptor(const std::string& path, int flags, mode_t mode = 0644) : fd(open(path.c_str(), flags, mode))
+    {
+        if(fd < 0)
+            throw analysis::exception("Unable to open file '%1%'.") % path;
+    }
+    FileDescriptor(const FileDescriptor&) = delete;
+    ~FileDescriptor() { close(fd); }
+};
+
+struct AlignedBuffer {
+    static constexpr size_t alignment = 4096;
+    char* data{nullptr};
+    const size_t size;
+    explicit AlignedBuffer(size_t _size) : size(_size)
+    {
+        void* ptr;
+        if(posix_memalign(&ptr, alignment, size))
+            throw analysis::exception("Unable to allocate copy buffer of %1% bytes.") % size;
+        data = static_cast<char*>(ptr);
+    }
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    ~AlignedBuffer() { free(data); }
+};
+
+size_t ReadAll(int fd, char* data, size_t size, const std::string& path)
+{
+    size_t n_read = 0;
+    while(n_read < size) {
+        const ssize_t n = read(fd, data + n_read, size - n_read);
+        if(n < 0 && errno == EINTR) continue;
+        if(n < 0)
+            throw analysis::exception("Error while reading file '%1%'.") % path;
+        if(n == 0) break;
+        n_read += static_cast<size_t>(n);
+    }
+    return n_read;
+}
+
+void WriteAll(int fd, const char* data, size_t size, const std::string& path)
+{
+    size_t n_written = 0;
+    while(n_written < size) {
+        const ssize_t n = write(fd, data + n_written, size - n_written);
+        if(n < 0 && errno == EINTR) continue;
+        if(n <= 0)
+            throw analysis::exception("Error while writing file '%1%'.") % path;
+        n_written += static_cast<size_t>(n);
+    }
+}
+} // anonymous namespace
+
+class ReplicateFiles {
+public:
+    using exception = analysis::exception;
+    using Clock = std::chrono::steady_clock;
+    using Checksum = analysis::Checksum;
+
+    ReplicateFiles(const Arguments& _args) : args(_args), cache(args.cache())
+    {
+        if(!args.buffer_size())
+            throw exception("Buffer size should be positive.");
+        const boost::regex pattern(args.file_name_pattern());
+        const boost::filesystem::path input_dir(args.input_dir());
+        for(const auto& entry : boost::filesystem::recursive_directory_iterator(input_dir)) {
+            if(!boost::filesystem::is_regular_file(entry) || !boost::regex_match(entry.path().string(), pattern))
+                continue;
+            files.push_back(entry.path().lexically_relative(input_dir).string());
+        }
+        std::sort(files.begin(), files.end());
+    }
+
+    void Run()
+    {
+        std::cout << "Replicating " << files.size() << " files from '" << args.input_dir() << "' to '"
+                  << args.output_dir() << "'." << std::endl;
+        const auto start = Clock::now();
+        std::vector<CopyResult> results(files.size());
+        {
+            run::ThreadPull pool(std::max(args.n_parallel(), 1u), false);
+            std::vector<std::future<void>> futures;
+            for(size_t n = 0; n < files.size(); ++n)
+                futures.push_back(pool.run(&ReplicateFiles::ProcessFile, this, std::cref(files.at(n)),
+                                           std::ref(results.at(n))));
+            for(size_t n = 0; n < futures.size(); ++n) {
+                try {
+                    futures.at(n).get();
+                } catch(std::exception& e) {
+                    results.at(n).status = CopyStatus::Failed;
+                    std::cerr << "ERROR: " << files.at(n) << ": " << e.what() << std::endl;
+                }
+            }
+        }
+        cache.Save();
+        const double time = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::map<CopyStatus, size_t> n_files;
+        uint64_t bytes_copied = 0;
+        for(const auto& result : results) {
+            ++n_files[result.status];
+            bytes_copied += result.bytes_copied;
+        }
+        std::cout << "Copied: " << n_files[CopyStatus::Copied] << ", resumed: " << n_files[CopyStatus::Resumed]
+                  << ", skipped: " << n_files[CopyStatus::Skipped] << ", failed: " << n_files[CopyStatus::Failed]
+                  << ".\n" << std::fixed << std::setprecision(1) << bytes_copied / (1024. * 1024.)
+                  << " MiB copied in " << time << " s (" << (time > 0 ? bytes_copied / (1024. * 1024.) / time : 0.)
+                  << " MiB/s)." << std::endl;
+        if(n_files[CopyStatus::Failed])
+            throw exception("%1% files were not replicated.") % n_files[CopyStatus::Failed];
+    }
+
+private:
+    void ProcessFile(const std::string& file, CopyResult& result)
+    {
+        const auto source = (boost::filesystem::path(args.input_dir()) / file).string();
+        const auto destination = (boost::filesystem::path(args.output_dir()) / file).string();
+        result.source = source;
+        if(IsReplicated(source, destination)) {
+            result.status = CopyStatus::Skipped;
+            return;
+        }
+        boost::filesystem::create_directories(boost::filesystem::path(destination).parent_path());
+        const std::string partial = destination + ".part";
+        Copy(source, partial, true, result);
+        if(args.verify() && analysis::ComputeFileChecksum(partial, args.checksum_type()) != result.checksum) {
+            if(result.status != CopyStatus::Resumed)
+                throw exception("Checksum mismatch after copying '%1%'.") % source;
+            // Previously copied part could be corrupted: copy the whole file again.
+            std::cout << "Checksum mismatch for the resumed copy of '" << source << "'. Restarting." << std::endl;
+            boost::filesystem::remove(partial);
+            Copy(source, partial, false, result);
+            if(analysis::ComputeFileChecksum(partial, args.checksum_type()) != result.checksum)
+                throw exception("Checksum mismatch after copying '%1%'.") % source;
+        }
+        boost::filesystem::rename(partial, destination);
+        boost::filesystem::last_write_time(destination, boost::filesystem::last_write_time(source));
+        cache.Add(source, args.checksum_type(), result.checksum);
+        cache.Add(destination, args.checksum_type(), result.checksum);
+        std::cout << (result.status == CopyStatus::Resumed ? "resumed: " : "copied: ") << file << " "
+                  << args.checksum_type() << "=" << Checksum::ToString(result.checksum, args.checksum_type())
+                  << std::endl;
+    }
+
+    bool IsReplicated(const std::string& source, const std::string& destination)
+    {
+        if(!boost::filesystem::exists(destination)
+                || boost::filesystem::file_size(destination) != boost::filesystem::file_size(source))
+            return false;
+        return cache.Get(source, args.checksum_type()) == cache.Get(destination, args.checksum_type());
+    }
+
+    // Copies the source into the destination and computes the checksum of the source in the same pass.
+    // If resume is allowed and the destination already exists, only the missing tail is copied.
+    void Copy(const std::string& source, const std::string& destination, bool resume, CopyResult& result) const
+    {
+        const uint64_t source_size = boost::filesystem::file_size(source);
+        uint64_t offset = 0;
+        if(resume && boost::filesystem::exists(destination)) {
+            offset = boost::filesystem::file_size(destination);
+            if(offset > source_size) {
+                boost::filesystem::remove(destination);
+                offset = 0;
+            }
+        }
+        result.status = offset ? CopyStatus::Resumed : CopyStatus::Copied;
+        result.bytes_copied = 0;
+
+        FileDescriptor input(source, O_RDONLY);
+        FileDescriptor output(destination, O_WRONLY | O_CREAT | (offset ? 0 : O_TRUNC));
+        posix_fadvise(input.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        AlignedBuffer buffer(args.buffer_size() * 1024 * 1024);
+        Checksum checksum(args.checksum_type());
+
+        // The part that is already present in the destination is only read to compute the checksum.
+        for(uint64_t pos = 0; pos < offset;) {
+            const size_t n = ReadAll(input.fd, buffer.data, std::min<uint64_t>(buffer.size, offset - pos), source);
+            if(!n)
+                throw exception("Unexpected end of file '%1%'.") % source;
+            checksum.Process(buffer.data, n);
+            pos += n;
+        }
+        if(ftruncate(output.fd, static_cast<off_t>(offset))
+                || lseek(output.fd, static_cast<off_t>(offset), SEEK_SET) < 0)
+            throw exception("Unable to resume writing of '%1%'.") % destination;
+        for(size_t n; (n = ReadAll(input.fd, buffer.data, buffer.size, source)) > 0;) {
+            checksum.Process(buffer.data, n);
+            WriteAll(output.fd, buffer.data, n, destination);
+            result.bytes_copied += n;
+        }
+        if(fsync(output.fd))
+            throw exception("Unable to flush file '%1%'.") % destination;
+        result.checksum = checksum.Value();
+    }
+
+private:
+    Arguments args;
+    analysis::ChecksumCache cache;
+    std::vector<std::string> files;
+};
+
+PROGRAM_MAIN(ReplicateFiles, Arguments)
@@ -25,7 +25,10 @@ AnalyzerData::AnalyzerData() : directory(nullptr), readMode(false), mutex(std::m
 
 AnalyzerData::AnalyzerData(const std::string& outputFileName) :
     outputFile(CreateRootFile(outputFileName)), directory(outputFile.get()), readMode(false),
-    mutex(std::make_unique<Mutex>()) {}
+    mutex(std::make_unique<Mutex>())
+{
+    memory_tracker.SetDirectory(directory->GetPath());
+}
 
 AnalyzerData::AnalyzerData(std::shared_ptr<TFile> _outputFile, const std::string& directoryName,
                            bool _readMode) :
@@ -34,6 +37,7 @@ AnalyzerData::AnalyzerData(std::shared_ptr<TFile> _outputFile, const std::string
     if(!outputFile)
         throw analysis::exception("Output file is nullptr.");
     directory = directoryName.size() ? GetDirectory(*outputFile, directoryName, true) : outputFile.get();
+    memory_tracker.SetDirectory(directory->GetPath());
 }
 
 AnalyzerData::AnalyzerData(TDirectory* _directory, const std::string& subDirectoryName, bool _readMode) :
@@ -42,10 +46,12 @@ AnalyzerData::AnalyzerData(TDirectory* _directory, const std::string& subDirecto
     if(!_directory)
         throw analysis::exception("Output directory is nullptr.");
     directory = subDirectoryName.size() ? GetDirectory(*_directory, subDirectoryName, true) : _directory;
+    memory_tracker.SetDirectory(directory->GetPath());
 }
 
 AnalyzerData::~AnalyzerData()
 {
+    UpdateMemoryUsage();
     if(directory && !readMode) {
         for(const auto& hist : histograms)
             hist.second->WriteRootObject();
@@ -67,9 +73,31 @@ void AnalyzerData::AddHistogram(HistPtr hist)
     TDirectory* hist_dir = readMode ? nullptr : directory;
     hist->SetOutputDirectory(hist_dir);
     histograms[hist->Name()] = hist;
+    memory_tracker.Add(hist->GetMemoryUsage());
 }
 const AnalyzerData::HistContainer& AnalyzerData::GetHistograms() const { return histograms; }
 
+size_t AnalyzerData::GetMemoryUsage() const
+{
+    std::lock_guard<Mutex> lock(*mutex);
+    size_t usage = 0;
+    for(const auto& hist : histograms)
+        usage += hist.second->GetMemoryUsage();
+    return usage;
+}
+
+void AnalyzerData::UpdateMemoryUsage()
+{
+    std::lock_guard<Mutex> lock(*mutex);
+    memory_tracker.Update(GetMemoryUsage());
+}
+
+void AnalyzerData::NotifyHistogramAccess()
+{
+    if(++n_histogram_accesses % MemoryUpdateInterval == 0)
+        UpdateMemoryUsage();
+}
+
 void AnalyzerData::AddEntry(Entry& entry)
 {
     std::lock_guard<Mutex> lock(*mutex);
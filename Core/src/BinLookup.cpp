@@ -0,0 +1,43 @@
+/*! Implementation of the constant-time bin look-up for the variable-width binning.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include "AnalysisTools/Core/include/BinLookup.h"
+
+#include <algorithm>
+#include <cmath>
+#include "AnalysisTools/Core/include/exception.h"
+
+namespace analysis {
+
+VariableBinLookup::VariableBinLookup(const std::vector<double>& _edges, size_t max_grid_size) :
+    edges(_edges)
+{
+    if(edges.size() < 2)
+        throw exception("At least two bin edges are required.");
+    if(!max_grid_size)
+        throw exception("Grid size limit should be positive.");
+    double min_width = edges.at(1) - edges.at(0);
+    for(size_t n = 1; n < edges.size(); ++n) {
+        const double width = edges.at(n) - edges.at(n - 1);
+        if(!std::isfinite(edges.at(n - 1)) || !std::isfinite(edges.at(n)) || !(width > 0))
+            throw exception("Bin edges should be finite and strictly increasing.");
+        min_width = std::min(min_width, width);
+    }
+    n_bins = static_cast<int>(edges.size()) - 1;
+    x_min = edges.front();
+    x_max = edges.back();
+
+    const double n_cells = std::ceil((x_max - x_min) / min_width);
+    const size_t grid_size = n_cells < static_cast<double>(max_grid_size) ? static_cast<size_t>(n_cells)
+                                                                          : max_grid_size;
+    inv_cell_width = static_cast<double>(grid_size) / (x_max - x_min);
+    grid.resize(grid_size);
+    const double cell_width = (x_max - x_min) / static_cast<double>(grid_size);
+    for(size_t cell = 0; cell < grid_size; ++cell) {
+        const double cell_low_edge = x_min + cell_width * static_cast<double>(cell);
+        const auto iter = std::upper_bound(edges.begin(), edges.end(), cell_low_edge);
+        grid[cell] = std::max(1, std::min(n_bins, static_cast<int>(iter - edges.begin())));
+    }
+}
+
+} // namespace analysis
@@ -0,0 +1,190 @@
+/*! Implementation of the parallel projection of a tree branch from multiple files into histograms.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include "AnalysisTools/Core/include/BranchProjection.h"
+
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <Bytes.h>
+#include <TBranch.h>
+#include <TBufferFile.h>
+#include <TROOT.h>
+#include <TTree.h>
+#include <TTreeFormula.h>
+#include "AnalysisTools/Core/include/BranchReaderFactory.h"
+#include "AnalysisTools/Core/include/RootExt.h"
+#include "AnalysisTools/Run/include/MultiThread.h"
+
+namespace analysis {
+
+namespace {
+
+constexpr Long64_t CacheSize = 10000000;
+
+struct BranchReader {
+    virtual ~BranchReader() {}
+    virtual void Fill(TTree& tree, const std::string& name, TH1D& hist) = 0;
+};
+
+template<typename T>
+struct ScalarBranchReader : BranchReader {
+    virtual void Fill(TTree& tree, const std::string& name, TH1D& hist) override
+    {
+        if(!FillBulk(*tree.GetBranch(name.c_str()), tree.GetEntries(), hist))
+            FillByEntry(tree, name, hist);
+    }
+
+    // Reads the branch basket by basket. Values are stored in the big-endian byte order. Returns false, if the bulk
+    // I/O is not supported for the branch.
+    static bool FillBulk(TBranch& branch, Long64_t n_entries, TH1D& hist)
+    {
+        TBufferFile buffer(TBuffer::kWrite, 32 * 1024);
+        Long64_t entry = 0;
+        while(entry < n_entries) {
+            const Int_t n_read = branch.GetBulkRead().GetEntriesSerialized(entry, buffer);
+            if(n_read <= 0) {
+                if(entry == 0) return false;
+                throw exception("Error while reading branch '%1%' at entry %2%.") % branch.GetName() % entry;
+            }
+            const Long64_t n = std::min<Long64_t>(n_read, n_entries - entry);
+            char* data = buffer.GetCurrent();
+            for(Long64_t k = 0; k < n; ++k) {
+                T value;
+                frombuf(data, &value);
+                hist.Fill(static_cast<double>(value));
+            }
+            entry += n;
+        }
+        return true;
+    }
+
+    static void FillByEntry(TTree& tree, const std::string& name, TH1D& hist)
+    {
+        T value;
+        TBranch* branch = nullptr;
+        tree.SetBranchAddress(name.c_str(), &value, &branch);
+        const Long64_t n_entries = tree.GetEntries();
+        for(Long64_t entry = 0; entry < n_entries; ++entry) {
+            if(branch->GetEntry(entry) < 0)
+                throw exception("Error while reading branch '%1%' at entry %2%.") % name % entry;
+            hist.Fill(static_cast<double>(value));
+        }
+        tree.ResetBranchAddresses();
+    }
+
+    static BranchReader* Make() { return new ScalarBranchReader<T>(); }
+};
+
+template<typename T>
+struct VectorBranchReader : BranchReader {
+    virtual void Fill(TTree& tree, const std::string& name, TH1D& hist) override
+    {
+        std::vector<T>* value = nullptr;
+        TBranch* branch = nullptr;
+        tree.SetBranchAddress(name.c_str(), &value, &branch);
+        const Long64_t n_entries = tree.GetEntries();
+        for(Long64_t entry = 0; entry < n_entries; ++entry) {
+            if(branch->GetEntry(entry) < 0)
+                throw exception("Error while reading branch '%1%' at entry %2%.") % name % entry;
+            for(const T& x : *value)
+                hist.Fill(static_cast<double>(x));
+        }
+        tree.ResetBranchAddresses();
+        delete value;
+    }
+
+    static BranchReader* Make() { return new VectorBranchReader<T>(); }
+};
+
+using BranchReaderFactory = root_ext::BranchReaderFactory<BranchReader* (*)(), ScalarBranchReader, VectorBranchReader>;
+
+// Fills all instances of an arbitrary TTree::Draw expression (formula, member of an object stored in the branch,
+// etc.), as TTree::Draw does. The expression is evaluated directly with TTreeFormula, because TTree::Draw looks for
+// the output histogram in the current directory, which is not suitable for the histograms filled in parallel.
+void FillFormula(TTree& tree, const std::string& expression, TH1D& hist)
+{
+    TTreeFormula formula("projection", expression.c_str(), &tree);
+    if(formula.GetNdim() == 0)
+        throw exception("Invalid expression '%1%'.") % expression;
+    const Long64_t n_entries = tree.GetEntries();
+    for(Long64_t entry = 0; entry < n_entries; ++entry) {
+        if(tree.LoadTree(entry) < 0)
+            throw exception("Error while reading entry %1% for expression '%2%'.") % entry % expression;
+        const Int_t n_data = formula.GetNdata();
+        for(Int_t n = 0; n < n_data; ++n)
+            hist.Fill(formula.EvalInstance(n));
+    }
+}
+
+} // anonymous namespace
+
+BranchProjection::BranchProjection(const std::string& _tree_name, const std::string& _branch_name, int _n_bins,
+                                   double _x_min, double _x_max) :
+    tree_name(_tree_name), branch_name(_branch_name), n_bins(_n_bins), x_min(_x_min), x_max(_x_max)
+{
+    if(n_bins <= 0)
+        throw exception("Number of bins should be positive.");
+}
+
+std::vector<BranchProjection::HistPtr> BranchProjection::Project(const std::vector<std::string>& file_names,
+                                                                 unsigned n_threads) const
+{
+    if(!n_threads)
+        n_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    n_threads = static_cast<unsigned>(std::min<size_t>(n_threads, file_names.size()));
+
+    // Histograms are created in the main thread, so they are not registered in the directories of the worker threads.
+    std::vector<HistPtr> histograms;
+    for(size_t n = 0; n < file_names.size(); ++n)
+        histograms.push_back(CreateHistogram());
+    if(n_threads <= 1) {
+        for(size_t n = 0; n < file_names.size(); ++n)
+            Fill(file_names.at(n), *histograms.at(n));
+        return histograms;
+    }
+
+    ROOT::EnableThreadSafety();
+    run::ThreadPull pool(n_threads, false);
+    std::vector<std::future<void>> results;
+    for(size_t n = 0; n < file_names.size(); ++n)
+        results.push_back(pool.run(&BranchProjection::Fill, this, file_names.at(n), std::ref(*histograms.at(n))));
+    for(auto& result : results)
+        result.get();
+    return histograms;
+}
+
+BranchProjection::HistPtr BranchProjection::ProjectFile(const std::string& file_name) const
+{
+    auto hist = CreateHistogram();
+    Fill(file_name, *hist);
+    return hist;
+}
+
+BranchProjection::HistPtr BranchProjection::CreateHistogram() const
+{
+    const std::string name = branch_name + "_hist";
+    auto hist = std::make_shared<TH1D>(name.c_str(), name.c_str(), n_bins, x_min, x_max);
+    hist->SetDirectory(nullptr);
+    return hist;
+}
+
+void BranchProjection::Fill(const std::string& file_name, TH1D& hist) const
+{
+    auto file = root_ext::OpenRootFile(file_name);
+    std::unique_ptr<TTree> tree(root_ext::ReadObject<TTree>(*file, tree_name));
+    TBranch* branch = tree->GetBranch(branch_name.c_str());
+    const auto make = branch ? BranchReaderFactory::FindMakeMethod(*branch) : nullptr;
+    if(!make) {
+        FillFormula(*tree, branch_name, hist);
+        return;
+    }
+    std::unique_ptr<BranchReader> reader((*make)());
+    tree->SetBranchStatus("*", 0);
+    tree->SetBranchStatus(branch_name.c_str(), 1);
+    tree->SetCacheSize(CacheSize);
+    tree->AddBranchToCache(branch_name.c_str(), true);
+    reader->Fill(*tree, branch_name, hist);
+}
+
+} // namespace analysis
@@ -0,0 +1,56 @@
+/*! Implementation of the factory of typed readers for the branches with fundamental and std::vector value types.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include "AnalysisTools/Core/include/BranchReaderFactory.h"
+
+#include <TBranch.h>
+#include <TClass.h>
+#include <TLeaf.h>
+#include <TObjArray.h>
+
+namespace root_ext {
+
+BranchValueType GetBranchValueType(TBranch& branch)
+{
+    static const std::map<std::string, EDataType> vectorTypes = {
+        { "vector<char>", kChar_t }, { "vector<unsigned char>", kUChar_t },
+        { "vector<short>", kShort_t }, { "vector<unsigned short>", kUShort_t },
+        { "vector<int>", kInt_t }, { "vector<unsigned int>", kUInt_t },
+        { "vector<long>", kLong_t }, { "vector<unsigned long>", kULong_t },
+        { "vector<Long64_t>", kLong64_t }, { "vector<ULong64_t>", kULong64_t },
+        { "vector<long long>", kLong64_t }, { "vector<unsigned long long>", kULong64_t },
+        { "vector<float>", kFloat_t }, { "vector<double>", kDouble_t }, { "vector<bool>", kBool_t },
+    };
+
+    BranchValueType value_type;
+    TClass *branch_class;
+    EDataType branch_type;
+    branch.GetExpectedType(branch_class, branch_type);
+    if(branch_class) {
+        auto iter = vectorTypes.find(branch_class->GetName());
+        if(iter == vectorTypes.end()) {
+            value_type.reason = std::string("objects of class ") + branch_class->GetName();
+        } else {
+            value_type.kind = BranchValueKind::Vector;
+            value_type.data_type = iter->second;
+        }
+        return value_type;
+    }
+
+    // GetExpectedType reports the type of the leaf also for arrays and for the first leaf of the multi-leaf branches.
+    TObjArray* leaves = branch.GetListOfLeaves();
+    if(!leaves || leaves->GetEntries() != 1) {
+        value_type.reason = "several leaves";
+        return value_type;
+    }
+    const TLeaf* leaf = dynamic_cast<const TLeaf*>(leaves->At(0));
+    if(!leaf || leaf->GetLeafCount() || leaf->GetLenStatic() > 1) {
+        value_type.reason = "an array";
+        return value_type;
+    }
+    value_type.kind = BranchValueKind::Scalar;
+    value_type.data_type = branch_type;
+    return value_type;
+}
+
+} // namespace root_ext
@@ -0,0 +1,292 @@
+/*! Definition of the catalog that caches metadata of the dataset files.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include "AnalysisTools/Core/include/DatasetCatalog.h"
+
+#include <algorithm>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <set>
+#include <boost/filesystem.hpp>
+#include <TKey.h>
+#include <TTree.h>
+#include "AnalysisTools/Core/include/BinaryIO.h"
+#include "AnalysisTools/Core/include/RootExt.h"
+#include "AnalysisTools/Run/include/MultiThread.h"
+
+namespace {
+using namespace analysis::binary_io;
+
+static constexpr char CatalogMagic[4] = { 'D', 'S', 'C', 'T' };
+
+template<typename T>
+double SumBranchValues(TTree& tree, TBranch& branch)
+{
+    T value;
+    tree.SetBranchStatus(branch.GetName(), 1);
+    tree.SetBranchAddress(branch.GetName(), &value);
+    double sum = 0;
+    const Long64_t n_entries = tree.GetEntries();
+    for(Long64_t n = 0; n < n_entries; ++n) {
+        if(branch.GetEntry(n) < 0)
+            throw analysis::exception("Error while reading branch '%1%'.") % branch.GetName();
+        sum += value;
+    }
+    tree.ResetBranchAddresses();
+    return sum;
+}
+} // anonymous namespace
+
+namespace analysis {
+
+const DatasetCatalog::TreeInfo* DatasetCatalog::FileInfo::FindTree(const std::string& tree_name) const
+{
+    for(const auto& tree : trees) {
+        if(tree.name == tree_name)
+            return &tree;
+    }
+    return nullptr;
+}
+
+DatasetCatalog::DatasetCatalog(const std::string& _index_file) :
+    index_file(_index_file)
+{
+    if(boost::filesystem::exists(index_file))
+        Load();
+}
+
+size_t DatasetCatalog::Update(const std::vector<std::string>& file_list, const std::string& weight_branch,
+                              unsigned n_threads)
+{
+    const std::set<std::string> file_set(file_list.begin(), file_list.end());
+    for(auto iter = files.begin(); iter != files.end();) {
+        if(file_set.count(iter->first))
+            ++iter;
+        else
+            iter = files.erase(iter);
+    }
+
+    std::vector<std::string> to_scan;
+    for(const auto& path : file_set) {
+        auto iter = files.find(path);
+        if(iter == files.end() || !IsUpToDate(iter->second, weight_branch))
+            to_scan.push_back(path);
+    }
+    if(to_scan.empty()) return 0;
+
+    if(n_threads > 1)
+        ROOT::EnableThreadSafety();
+    run::ThreadPull pool(std::max(n_threads, 1u), false);
+    std::vector<std::future<FileInfo>> results;
+    for(const auto& path : to_scan)
+        results.push_back(pool.run(&DatasetCatalog::ScanFile, path, weight_branch));
+    for(auto& result : results) {
+        FileInfo info = result.get();
+        const std::string path = info.path;
+        files[path] = std::move(info);
+    }
+    return to_scan.size();
+}
+
+void DatasetCatalog::Save() const
+{
+    const std::string tmp_file = index_file + ".tmp";
+    {
+        std::ofstream os(tmp_file, std::ios::binary);
+        if(!os.is_open())
+            throw exception("Unable to create dataset catalog '%1%'.") % tmp_file;
+        os.write(CatalogMagic, sizeof(CatalogMagic));
+        WriteValue(os, FormatVersion);
+        WriteValue(os, static_cast<uint64_t>(files.size()));
+        for(const auto& file_entry : files) {
+            const FileInfo& info = file_entry.second;
+            WriteString(os, info.path);
+            WriteValue(os, info.size);
+            WriteValue(os, info.mtime);
+            WriteString(os, info.weight_branch);
+            WriteValue(os, static_cast<uint32_t>(info.trees.size()));
+            for(const auto& tree : info.trees) {
+                WriteString(os, tree.name);
+                WriteValue(os, tree.n_entries);
+                WriteValue(os, static_cast<uint8_t>(tree.has_weights));
+                WriteValue(os, tree.sum_weights);
+                WriteValue(os, static_cast<uint64_t>(tree.cluster_starts.size()));
+                os.write(reinterpret_cast<const char*>(tree.cluster_starts.data()),
+                         static_cast<std::streamsize>(tree.cluster_starts.size() * sizeof(Long64_t)));
+            }
+        }
+        if(!os)
+            throw exception("Error while writing dataset catalog '%1%'.") % tmp_file;
+    }
+    boost::filesystem::rename(tmp_file, index_file);
+}
+
+void DatasetCatalog::Load()
+{
+    std::ifstream is(index_file, std::ios::binary);
+    if(!is.is_open())
+        throw exception("Unable to open dataset catalog '%1%'.") % index_file;
+    char magic[sizeof(CatalogMagic)];
+    is.read(magic, sizeof(magic));
+    if(!is || !std::equal(std::begin(magic), std::end(magic), std::begin(CatalogMagic)))
+        throw exception("'%1%' is not a dataset catalog.") % index_file;
+    const auto version = ReadValue<uint32_t>(is);
+    if(version != FormatVersion) {
+        std::cerr << "WARNING: dataset catalog '" << index_file << "' has format version " << version
+                  << ", while version " << FormatVersion << " is expected. The catalog will be rebuilt."
+                  << std::endl;
+        return;
+    }
+    const auto n_files = ReadValue<uint64_t>(is);
+    for(uint64_t n = 0; n < n_files; ++n) {
+        FileInfo info;
+        info.path = ReadString(is);
+        info.size = ReadValue<uint64_t>(is);
+        info.mtime = ReadValue<int64_t>(is);
+        info.weight_branch = ReadString(is);
+        const auto n_trees = ReadValue<uint32_t>(is);
+        for(uint32_t k = 0; k < n_trees; ++k) {
+            TreeInfo tree;
+            tree.name = ReadString(is);
+            tree.n_entries = ReadValue<Long64_t>(is);
+            tree.has_weights = ReadValue<uint8_t>(is) != 0;
+            tree.sum_weights = ReadValue<double>(is);
+            tree.cluster_starts.resize(ReadValue<uint64_t>(is));
+            is.read(reinterpret_cast<char*>(tree.cluster_starts.data()),
+                    static_cast<std::streamsize>(tree.cluster_starts.size() * sizeof(Long64_t)));
+            if(!is)
+                throw exception("Unexpected end of the dataset catalog '%1%'.") % index_file;
+            info.trees.push_back(std::move(tree));
+        }
+        files[info.path] = std::move(info);
+    }
+}
+
+const DatasetCatalog::FileInfo& DatasetCatalog::at(const std::string& path) const
+{
+    auto iter = files.find(path);
+    if(iter == files.end())
+        throw exception("File '%1%' not found in the dataset catalog '%2%'.") % path % index_file;
+    return iter->second;
+}
+
+Long64_t DatasetCatalog::TotalEntries(const std::string& tree_name) const
+{
+    Long64_t n_entries = 0;
+    for(const auto& file_entry : files) {
+        if(const TreeInfo* tree = file_entry.second.FindTree(tree_name))
+            n_entries += tree->n_entries;
+    }
+    return n_entries;
+}
+
+double DatasetCatalog::TotalSumOfWeights(const std::string& tree_name) const
+{
+    double sum = 0;
+    for(const auto& file_entry : files) {
+        if(const TreeInfo* tree = file_entry.second.FindTree(tree_name)) {
+            if(!tree->has_weights)
+                throw exception("Sum of weights for tree '%1%' is not available for '%2%'.") % tree_name
+                    % file_entry.first;
+            sum += tree->sum_weights;
+        }
+    }
+    return sum;
+}
+
+std::vector<DatasetCatalog::EntryRange> DatasetCatalog::PlanSplits(const std::string& tree_name,
+                                                                   Long64_t max_entries) const
+{
+    if(max_entries <= 0)
+        throw exception("Maximal number of entries per split should be positive.");
+    std::vector<EntryRange> ranges;
+    for(const auto& file_entry : files) {
+        const TreeInfo* tree = file_entry.second.FindTree(tree_name);
+        if(!tree || !tree->n_entries) continue;
+        std::vector<Long64_t> bounds = tree->cluster_starts;
+        bounds.push_back(tree->n_entries);
+        Long64_t first = 0;
+        for(size_t n = 1; n < bounds.size(); ++n) {
+            if(bounds[n] - first > max_entries && bounds[n - 1] > first) {
+                ranges.push_back({ file_entry.first, first, bounds[n - 1] });
+                first = bounds[n - 1];
+            }
+        }
+        ranges.push_back({ file_entry.first, first, tree->n_entries });
+    }
+    return ranges;
+}
+
+DatasetCatalog::FileInfo DatasetCatalog::ScanFile(const std::string& path, const std::string& weight_branch)
+{
+    FileInfo info;
+    info.path = path;
+    info.size = boost::filesystem::file_size(path);
+    info.mtime = static_cast<int64_t>(boost::filesystem::last_write_time(path));
+    info.weight_branch = weight_branch;
+    auto file = root_ext::OpenRootFile(path);
+    ScanDirectory(*file, "", weight_branch, info.trees);
+    return info;
+}
+
+bool DatasetCatalog::IsUpToDate(const FileInfo& info, const std::string& weight_branch)
+{
+    boost::system::error_code ec;
+    const auto size = boost::filesystem::file_size(info.path, ec);
+    if(ec) return false;
+    const auto mtime = boost::filesystem::last_write_time(info.path, ec);
+    if(ec) return false;
+    return size == info.size && static_cast<int64_t>(mtime) == info.mtime && weight_branch == info.weight_branch;
+}
+
+void DatasetCatalog::ScanDirectory(TDirectory& dir, const std::string& dir_name, const std::string& weight_branch,
+                                   std::vector<TreeInfo>& trees)
+{
+    using ClassInheritance = root_ext::ClassInheritance;
+    std::set<std::string> processed;
+    TIter nextkey(dir.GetListOfKeys());
+    for(TKey* t_key; (t_key = dynamic_cast<TKey*>(nextkey()));) {
+        const std::string name = t_key->GetName();
+        if(processed.count(name)) continue;
+        processed.insert(name);
+        ClassInheritance inheritance;
+        try {
+            inheritance = root_ext::FindClassInheritance(t_key->GetClassName());
+        } catch(exception&) {
+            continue;
+        }
+        if(inheritance == ClassInheritance::TDirectory) {
+            auto subdir = root_ext::ReadObject<TDirectory>(dir, name);
+            ScanDirectory(*subdir, dir_name + name + "/", weight_branch, trees);
+        } else if(inheritance == ClassInheritance::TTree) {
+            auto tree = root_ext::ReadObject<TTree>(dir, name);
+            TreeInfo tree_info;
+            tree_info.name = dir_name + name;
+            tree_info.n_entries = tree->GetEntries();
+            auto cluster_iter = tree->GetClusterIterator(0);
+            for(Long64_t start; (start = cluster_iter.Next()) < tree_info.n_entries;)
+                tree_info.cluster_starts.push_back(start);
+            if(!weight_branch.empty()) {
+                TBranch* branch = tree->GetBranch(weight_branch.c_str());
+                if(branch) {
+                    TClass* branch_class;
+                    EDataType branch_type;
+                    branch->GetExpectedType(branch_class, branch_type);
+                    tree->SetBranchStatus("*", 0);
+                    if(!branch_class && branch_type == kFloat_t)
+                        tree_info.sum_weights = SumBranchValues<Float_t>(*tree, *branch);
+                    else if(!branch_class && branch_type == kDouble_t)
+                        tree_info.sum_weights = SumBranchValues<Double_t>(*tree, *branch);
+                    else
+                        throw exception("Weight branch '%1%' in '%2%' should be float or double.")
+                            % weight_branch % tree_info.name;
+                    tree_info.has_weights = true;
+                }
+            }
+            trees.push_back(std::move(tree_info));
+        }
+    }
+}
+
+} // namespace analysis
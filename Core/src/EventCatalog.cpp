@@ -0,0 +1,316 @@
+/*! Definition of the dataset-wide catalog that maps event identifiers to their location in the dataset files.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include "AnalysisTools/Core/include/EventCatalog.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <set>
+#include <sstream>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <TTree.h>
+#include "AnalysisTools/Core/include/BinaryIO.h"
+#include "AnalysisTools/Core/include/RootExt.h"
+#include "AnalysisTools/Core/include/SmartBranch.h"
+#include "AnalysisTools/Run/include/MultiThread.h"
+
+namespace {
+using namespace analysis::binary_io;
+
+static constexpr char CatalogMagic[4] = { 'E', 'V', 'T', 'C' };
+
+// Fixed size header at the beginning of the catalog file. Records follow the header, so they are properly aligned
+// in the mapped region. Metadata (tree name, id branches and the list of files) is stored after the records.
+struct CatalogHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t n_records;
+    uint64_t records_offset;
+    uint64_t meta_offset;
+    uint64_t meta_size;
+    uint64_t reserved[3];
+};
+static_assert(sizeof(CatalogHeader) == 64, "Unexpected size of the event catalog header.");
+static_assert(sizeof(analysis::EventCatalog::Record) == 24, "Unexpected size of the event catalog record.");
+
+struct RecordKeyLess {
+    using Record = analysis::EventCatalog::Record;
+    bool operator()(const Record& a, const Record& b) const
+    {
+        return a.run_lumi < b.run_lumi || (a.run_lumi == b.run_lumi && a.event < b.event);
+    }
+};
+
+analysis::EventCatalog::FileEntry GetFileStatus(const std::string& path)
+{
+    analysis::EventCatalog::FileEntry entry;
+    entry.path = path;
+    entry.size = boost::filesystem::file_size(path);
+    entry.mtime = static_cast<int64_t>(boost::filesystem::last_write_time(path));
+    return entry;
+}
+} // anonymous namespace
+
+namespace analysis {
+
+EventCatalog::Record EventCatalog::Record::Make(const EventIdentifier& id, size_t file_index, Long64_t entry)
+{
+    if(file_index > MaxFileIndex)
+        throw exception("File index %1% can't be stored in the event catalog.") % file_index;
+    if(entry < 0 || static_cast<uint64_t>(entry) > MaxEntry)
+        throw exception("Entry %1% can't be stored in the event catalog.") % entry;
+    Record record;
+    record.run_lumi = PackRunLumi(id);
+    record.event = id.eventId;
+    record.location = (static_cast<uint64_t>(file_index) << EntryBits) | static_cast<uint64_t>(entry);
+    return record;
+}
+
+uint64_t EventCatalog::Record::PackRunLumi(const EventIdentifier& id)
+{
+    if(id.runId > MaxRunLumi || id.lumiBlock > MaxRunLumi)
+        throw exception("Event %1% can't be stored in the event catalog: run or lumi is out of range.") % id;
+    return (id.runId << 32) | id.lumiBlock;
+}
+
+EventIdentifier EventCatalog::Record::Id() const
+{
+    return EventIdentifier(run_lumi >> 32, run_lumi & MaxRunLumi, event);
+}
+
+bool EventCatalog::Record::operator<(const Record& other) const
+{
+    if(run_lumi != other.run_lumi) return run_lumi < other.run_lumi;
+    if(event != other.event) return event < other.event;
+    return location < other.location;
+}
+
+const std::string& EventCatalog::DefaultIdBranches()
+{
+    static const std::string id_branches = "run:lumi:evt";
+    return id_branches;
+}
+
+EventCatalog::EventCatalog(const std::string& catalog_file)
+{
+    namespace ip = boost::interprocess;
+    if(!boost::filesystem::exists(catalog_file))
+        throw exception("Event catalog '%1%' not found.") % catalog_file;
+    ip::file_mapping mapping(catalog_file.c_str(), ip::read_only);
+    region = std::make_shared<ip::mapped_region>(mapping, ip::read_only);
+    const char* data = static_cast<const char*>(region->get_address());
+    const size_t file_size = region->get_size();
+
+    CatalogHeader header;
+    if(file_size < sizeof(header))
+        throw exception("'%1%' is not an event catalog.") % catalog_file;
+    std::memcpy(&header, data, sizeof(header));
+    if(!std::equal(std::begin(header.magic), std::end(header.magic), std::begin(CatalogMagic)))
+        throw exception("'%1%' is not an event catalog.") % catalog_file;
+    if(header.version != FormatVersion)
+        throw exception("Event catalog '%1%' has format version %2%, while version %3% is expected.")
+            % catalog_file % header.version % FormatVersion;
+    if(header.records_offset + header.n_records * sizeof(Record) > file_size
+            || header.meta_offset + header.meta_size > file_size)
+        throw exception("Event catalog '%1%' is truncated.") % catalog_file;
+
+    records = reinterpret_cast<const Record*>(data + header.records_offset);
+    n_records = header.n_records;
+
+    std::istringstream meta(std::string(data + header.meta_offset, header.meta_size));
+    tree_name = ReadString(meta);
+    id_branches = EventIdentifier::Split(ReadString(meta));
+    files.resize(ReadValue<uint64_t>(meta));
+    for(auto& file : files) {
+        file.path = ReadString(meta);
+        file.size = ReadValue<uint64_t>(meta);
+        file.mtime = ReadValue<int64_t>(meta);
+        file.n_entries = ReadValue<Long64_t>(meta);
+    }
+    region->advise(ip::mapped_region::advice_random);
+}
+
+std::pair<const EventCatalog::Record*, const EventCatalog::Record*> EventCatalog::Find(const EventIdentifier& id) const
+{
+    if(id.runId > Record::MaxRunLumi || id.lumiBlock > Record::MaxRunLumi)
+        return std::make_pair(end(), end());
+    Record key;
+    key.run_lumi = Record::PackRunLumi(id);
+    key.event = id.eventId;
+    key.location = 0;
+    return std::equal_range(begin(), end(), key, RecordKeyLess());
+}
+
+EventCatalog::FileMatches EventCatalog::Locate(const std::vector<EventIdentifier>& ids,
+                                               std::vector<EventIdentifier>* not_found) const
+{
+    FileMatches matches;
+    for(const auto& id : ids) {
+        const auto range = Find(id);
+        if(range.first == range.second && not_found)
+            not_found->push_back(id);
+        for(auto iter = range.first; iter != range.second; ++iter)
+            matches[iter->FileIndex()].push_back(Match{ iter->Id(), iter->Entry() });
+    }
+    for(auto& file_matches : matches) {
+        auto& file_list = file_matches.second;
+        std::sort(file_list.begin(), file_list.end(),
+                  [](const Match& a, const Match& b) { return a.entry < b.entry; });
+        file_list.erase(std::unique(file_list.begin(), file_list.end(),
+                        [](const Match& a, const Match& b) { return a.entry == b.entry; }), file_list.end());
+    }
+    return matches;
+}
+
+size_t EventCatalog::Update(const std::string& catalog_file, const std::vector<std::string>& file_list,
+                            const std::string& tree_name, const std::string& id_branches, unsigned n_threads)
+{
+    const std::vector<std::string> id_branch_names = EventIdentifier::Split(id_branches);
+    const std::set<std::string> file_set(file_list.begin(), file_list.end());
+
+    std::vector<FileEntry> files;
+    std::vector<Record> records;
+    std::set<std::string> known_files;
+    if(boost::filesystem::exists(catalog_file)) {
+        const EventCatalog old_catalog(catalog_file);
+        if(old_catalog.TreeName() != tree_name || old_catalog.IdBranches() != id_branch_names)
+            throw exception("Existing event catalog '%1%' was built for a different tree or id branches.")
+                % catalog_file;
+        std::vector<size_t> index_map(old_catalog.GetFiles().size(), std::numeric_limits<size_t>::max());
+        for(size_t n = 0; n < old_catalog.GetFiles().size(); ++n) {
+            const FileEntry& old_entry = old_catalog.GetFiles().at(n);
+            if(!file_set.count(old_entry.path) || !IsUpToDate(old_entry)) continue;
+            index_map.at(n) = files.size();
+            files.push_back(old_entry);
+            known_files.insert(old_entry.path);
+        }
+        records.reserve(old_catalog.size());
+        for(const Record& record : old_catalog) {
+            const size_t new_index = index_map.at(record.FileIndex());
+            if(new_index != std::numeric_limits<size_t>::max())
+                records.push_back(Record::Make(record.Id(), new_index, record.Entry()));
+        }
+    }
+
+    std::vector<std::string> to_scan;
+    for(const auto& path : file_list) {
+        if(!known_files.count(path)) {
+            to_scan.push_back(path);
+            known_files.insert(path);
+        }
+    }
+
+    if(!to_scan.empty()) {
+        if(n_threads > 1)
+            ROOT::EnableThreadSafety();
+        run::ThreadPull pool(std::max(n_threads, 1u), false);
+        std::vector<FileEntry> new_files(to_scan.size());
+        std::vector<std::future<std::vector<Record>>> results;
+        for(size_t n = 0; n < to_scan.size(); ++n) {
+            results.push_back(pool.run(&EventCatalog::ScanFile, to_scan.at(n), files.size() + n, tree_name,
+                                       id_branch_names, std::ref(new_files.at(n))));
+        }
+        std::vector<Record> new_records;
+        for(auto& result : results) {
+            const auto file_records = result.get();
+            new_records.insert(new_records.end(), file_records.begin(), file_records.end());
+        }
+        std::sort(new_records.begin(), new_records.end());
+        const size_t n_old = records.size();
+        records.insert(records.end(), new_records.begin(), new_records.end());
+        std::inplace_merge(records.begin(), records.begin() + static_cast<std::ptrdiff_t>(n_old), records.end());
+        files.insert(files.end(), new_files.begin(), new_files.end());
+    }
+
+    Write(catalog_file, tree_name, id_branches, files, records);
+    return to_scan.size();
+}
+
+void EventCatalog::Write(const std::string& catalog_file, const std::string& tree_name,
+                         const std::string& id_branches, const std::vector<FileEntry>& files,
+                         const std::vector<Record>& sorted_records)
+{
+    std::ostringstream meta;
+    WriteString(meta, tree_name);
+    WriteString(meta, id_branches);
+    WriteValue(meta, static_cast<uint64_t>(files.size()));
+    for(const auto& file : files) {
+        WriteString(meta, file.path);
+        WriteValue(meta, file.size);
+        WriteValue(meta, file.mtime);
+        WriteValue(meta, file.n_entries);
+    }
+    const std::string meta_str = meta.str();
+
+    CatalogHeader header{};
+    std::copy(std::begin(CatalogMagic), std::end(CatalogMagic), std::begin(header.magic));
+    header.version = FormatVersion;
+    header.n_records = sorted_records.size();
+    header.records_offset = sizeof(header);
+    header.meta_offset = header.records_offset + header.n_records * sizeof(Record);
+    header.meta_size = meta_str.size();
+
+    const std::string tmp_file = catalog_file + ".tmp";
+    {
+        std::ofstream os(tmp_file, std::ios::binary);
+        if(!os.is_open())
+            throw exception("Unable to create event catalog '%1%'.") % tmp_file;
+        WriteValue(os, header);
+        os.write(reinterpret_cast<const char*>(sorted_records.data()),
+                 static_cast<std::streamsize>(sorted_records.size() * sizeof(Record)));
+        os.write(meta_str.data(), static_cast<std::streamsize>(meta_str.size()));
+        if(!os)
+            throw exception("Error while writing event catalog '%1%'.") % tmp_file;
+    }
+    boost::filesystem::rename(tmp_file, catalog_file);
+}
+
+std::vector<EventCatalog::Record> EventCatalog::ScanFile(const std::string& path, size_t file_index,
+                                                         const std::string& tree_name,
+                                                         const std::vector<std::string>& id_branches,
+                                                         FileEntry& file_entry)
+{
+    using IdType = EventIdentifier::IdType;
+    if(id_branches.size() != 3)
+        throw exception("Three id branches (run, lumi, event) are expected.");
+    file_entry = GetFileStatus(path);
+    auto file = root_ext::OpenRootFile(path);
+    auto tree = root_ext::ReadObject<TTree>(*file, tree_name);
+    tree->SetBranchStatus("*", 0);
+    std::vector<root_ext::SmartBranch> branches;
+    for(const auto& name : id_branches) {
+        branches.emplace_back(*tree, name);
+        branches.back().Enable();
+    }
+
+    file_entry.n_entries = tree->GetEntries();
+    std::vector<Record> records;
+    records.reserve(static_cast<size_t>(file_entry.n_entries));
+    for(Long64_t n = 0; n < file_entry.n_entries; ++n) {
+        for(auto& branch : branches) {
+            if(branch->GetEntry(n) < 0)
+                throw exception("Error while reading branch '%1%' in '%2%'.") % branch->GetName() % path;
+        }
+        const EventIdentifier id(branches.at(0).GetValue<IdType>(), branches.at(1).GetValue<IdType>(),
+                                 branches.at(2).GetValue<IdType>());
+        records.push_back(Record::Make(id, file_index, n));
+    }
+    tree->ResetBranchAddresses();
+    return records;
+}
+
+bool EventCatalog::IsUpToDate(const FileEntry& file_entry)
+{
+    boost::system::error_code ec;
+    const auto size = boost::filesystem::file_size(file_entry.path, ec);
+    if(ec) return false;
+    const auto mtime = boost::filesystem::last_write_time(file_entry.path, ec);
+    if(ec) return false;
+    return size == file_entry.size && static_cast<int64_t>(mtime) == file_entry.mtime;
+}
+
+} // namespace analysis
@@ -0,0 +1,115 @@
+/*! Definition of deterministic event sharding and sampling based on the event identifier hash.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include "AnalysisTools/Core/include/EventSampler.h"
+
+#include <cmath>
+#include <sstream>
+#include <boost/algorithm/string.hpp>
+#include "AnalysisTools/Core/include/exception.h"
+
+namespace {
+// Returns ceil(k * 2^64 / n) modulo 2^64.
+uint64_t ShardBoundary(uint64_t k, uint64_t n)
+{
+    const uint64_t q = std::numeric_limits<uint64_t>::max() / n;
+    const uint64_t r = std::numeric_limits<uint64_t>::max() % n;
+    return k * q + (k * (r + 1) + n - 1) / n;
+}
+
+// Returns x * 2^64 modulo 2^64.
+uint64_t FractionBoundary(double x)
+{
+    const double scaled = std::ldexp(x, 64);
+    if(scaled >= std::ldexp(1., 64)) return 0;
+    return static_cast<uint64_t>(scaled);
+}
+
+template<typename T>
+T ParseNumber(const std::string& str, const std::string& sampler_str)
+{
+    std::istringstream ss(boost::algorithm::trim_copy(str));
+    T value;
+    ss >> value;
+    if(ss.fail() || !ss.eof())
+        throw analysis::exception("Invalid event sampler '%1%'.") % sampler_str;
+    return value;
+}
+} // anonymous namespace
+
+namespace analysis {
+
+EventSampler EventSampler::Shard(size_t shard_index, size_t n_shards, uint64_t seed)
+{
+    if(n_shards == 0 || n_shards > std::numeric_limits<uint32_t>::max())
+        throw exception("Invalid number of shards = %1%.") % n_shards;
+    if(shard_index >= n_shards)
+        throw exception("Shard index %1% is out of range [0, %2%).") % shard_index % n_shards;
+    const uint64_t lower = ShardBoundary(shard_index, n_shards);
+    const uint64_t upper = ShardBoundary(shard_index + 1, n_shards);
+    EventSampler sampler(lower, upper - lower - 1, seed);
+    sampler.description = std::to_string(shard_index) + "/" + std::to_string(n_shards);
+    return sampler;
+}
+
+EventSampler EventSampler::Fraction(double fraction, uint64_t seed)
+{
+    EventSampler sampler = FractionRange(0, fraction, seed);
+    std::ostringstream ss;
+    ss << fraction * 100 << "%";
+    sampler.description = ss.str();
+    return sampler;
+}
+
+EventSampler EventSampler::FractionRange(double begin, double end, uint64_t seed)
+{
+    if(!(begin >= 0 && begin < end && end <= 1))
+        throw exception("Invalid event fraction range [%1%, %2%).") % begin % end;
+    const uint64_t lower = FractionBoundary(begin);
+    const uint64_t upper = FractionBoundary(end);
+    EventSampler sampler(lower, upper - lower - 1, seed);
+    std::ostringstream ss;
+    ss << begin << ":" << end;
+    sampler.description = ss.str();
+    return sampler;
+}
+
+EventSampler EventSampler::Parse(const std::string& str, uint64_t seed)
+{
+    const std::string trimmed = boost::algorithm::trim_copy(str);
+    if(trimmed.empty() || trimmed == "all") {
+        EventSampler sampler;
+        sampler.seed = seed;
+        return sampler;
+    }
+    if(trimmed.back() == '%')
+        return Fraction(ParseNumber<double>(trimmed.substr(0, trimmed.size() - 1), str) / 100, seed);
+    std::vector<std::string> parts;
+    if(trimmed.find('/') != std::string::npos) {
+        boost::split(parts, trimmed, boost::is_any_of("/"));
+        if(parts.size() == 2)
+            return Shard(ParseNumber<size_t>(parts.at(0), str), ParseNumber<size_t>(parts.at(1), str), seed);
+    } else if(trimmed.find(':') != std::string::npos) {
+        boost::split(parts, trimmed, boost::is_any_of(":"));
+        if(parts.size() == 2)
+            return FractionRange(ParseNumber<double>(parts.at(0), str), ParseNumber<double>(parts.at(1), str), seed);
+    }
+    throw exception("Invalid event sampler '%1%'. Supported formats: 'k/N', 'x%%', 'a:b'.") % str;
+}
+
+std::string EventSampler::ToString() const
+{
+    std::ostringstream ss;
+    ss << (description.empty() ? std::string("all") : description);
+    if(seed != DefaultSeed)
+        ss << " (seed = " << seed << ")";
+    return ss.str();
+}
+
+std::ostream& operator<<(std::ostream& s, const EventSampler& sampler)
+{
+    s << sampler.ToString();
+    return s;
+}
+
+} // namespace analysis
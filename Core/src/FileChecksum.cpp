@@ -0,0 +1,324 @@
+/*! Definition of checksums of file contents and of the persistent checksum cache.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include "AnalysisTools/Core/include/FileChecksum.h"
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include "AnalysisTools/Core/include/exception.h"
+
+namespace {
+constexpr uint32_t adler_mod = 65521;
+constexpr uint64_t xxh_prime1 = 11400714785074694791ULL, xxh_prime2 = 14029467366897019727ULL,
+                   xxh_prime3 = 1609587929392839161ULL, xxh_prime4 = 9650029242287828579ULL,
+                   xxh_prime5 = 2870177450012600261ULL;
+
+inline uint64_t RotateLeft(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline uint64_t Read64(const unsigned char* p)
+{
+    uint64_t x;
+    std::memcpy(&x, p, sizeof(x));
+    return x;
+}
+
+inline uint32_t Read32(const unsigned char* p)
+{
+    uint32_t x;
+    std::memcpy(&x, p, sizeof(x));
+    return x;
+}
+
+inline uint64_t XXH64Round(uint64_t acc, uint64_t input)
+{
+    acc += input * xxh_prime2;
+    return RotateLeft(acc, 31) * xxh_prime1;
+}
+
+inline uint64_t XXH64MergeRound(uint64_t acc, uint64_t value)
+{
+    acc ^= XXH64Round(0, value);
+    return acc * xxh_prime1 + xxh_prime4;
+}
+
+// Multiplication of the 32x32 matrix over GF(2) by a vector (see crc32_combine in zlib).
+uint32_t GF2MatrixTimes(const uint32_t* matrix, uint32_t vector)
+{
+    uint32_t sum = 0;
+    for(; vector; vector >>= 1, ++matrix) {
+        if(vector & 1)
+            sum ^= *matrix;
+    }
+    return sum;
+}
+
+void GF2MatrixSquare(uint32_t* square, const uint32_t* matrix)
+{
+    for(size_t n = 0; n < 32; ++n)
+        square[n] = GF2MatrixTimes(matrix, matrix[n]);
+}
+
+uint32_t CombineCRC32(uint32_t crc1, uint32_t crc2, uint64_t size2)
+{
+    if(!size2) return crc1;
+    uint32_t even[32], odd[32];
+    odd[0] = 0xEDB88320u; // reflected CRC-32 polynomial
+    uint32_t row = 1;
+    for(size_t n = 1; n < 32; ++n, row <<= 1)
+        odd[n] = row;
+    GF2MatrixSquare(even, odd);
+    GF2MatrixSquare(odd, even);
+    // Apply size2 zero bytes to crc1.
+    do {
+        GF2MatrixSquare(even, odd);
+        if(size2 & 1)
+            crc1 = GF2MatrixTimes(even, crc1);
+        size2 >>= 1;
+        if(!size2) break;
+        GF2MatrixSquare(odd, even);
+        if(size2 & 1)
+            crc1 = GF2MatrixTimes(odd, crc1);
+        size2 >>= 1;
+    } while(size2);
+    return crc1 ^ crc2;
+}
+
+uint32_t CombineAdler32(uint32_t adler1, uint32_t adler2, uint64_t size2)
+{
+    const uint32_t rem = static_cast<uint32_t>(size2 % adler_mod);
+    uint32_t sum1 = adler1 & 0xFFFF;
+    uint32_t sum2 = static_cast<uint32_t>((static_cast<uint64_t>(rem) * sum1) % adler_mod);
+    sum1 += (adler2 & 0xFFFF) + adler_mod - 1;
+    sum2 += ((adler1 >> 16) & 0xFFFF) + ((adler2 >> 16) & 0xFFFF) + adler_mod - rem;
+    if(sum1 >= adler_mod) sum1 -= adler_mod;
+    if(sum1 >= adler_mod) sum1 -= adler_mod;
+    if(sum2 >= (adler_mod << 1)) sum2 -= (adler_mod << 1);
+    if(sum2 >= adler_mod) sum2 -= adler_mod;
+    return sum1 | (sum2 << 16);
+}
+} // anonymous namespace
+
+namespace analysis {
+
+Checksum::Checksum(ChecksumType _type) : type(_type)
+{
+    xxh.acc[0] = xxh_prime1 + xxh_prime2;
+    xxh.acc[1] = xxh_prime2;
+    xxh.acc[2] = 0;
+    xxh.acc[3] = 0 - xxh_prime1;
+}
+
+void Checksum::Process(const void* data, size_t size)
+{
+    if(type == ChecksumType::CRC32) {
+        crc.process_bytes(data, size);
+    } else if(type == ChecksumType::Adler32) {
+        // Largest number of bytes for which the sums do not overflow before the modulo operation.
+        static constexpr size_t max_block = 5552;
+        const auto bytes = static_cast<const unsigned char*>(data);
+        for(size_t pos = 0; pos < size; pos += max_block) {
+            const size_t block_end = std::min(size, pos + max_block);
+            for(size_t n = pos; n < block_end; ++n) {
+                adler_a += bytes[n];
+                adler_b += adler_a;
+            }
+            adler_a %= adler_mod;
+            adler_b %= adler_mod;
+        }
+    } else if(type == ChecksumType::XXH64) {
+        ProcessXXH64(static_cast<const unsigned char*>(data), size);
+    } else {
+        throw exception("Unsupported checksum type '%1%'.") % type;
+    }
+}
+
+uint64_t Checksum::Value() const
+{
+    if(type == ChecksumType::CRC32)
+        return crc.checksum();
+    if(type == ChecksumType::XXH64)
+        return XXH64Value();
+    return (static_cast<uint64_t>(adler_b) << 16) | adler_a;
+}
+
+void Checksum::ProcessXXH64(const unsigned char* data, size_t size)
+{
+    xxh.total_size += size;
+    if(xxh.buffer_size + size < sizeof(xxh.buffer)) {
+        std::memcpy(xxh.buffer + xxh.buffer_size, data, size);
+        xxh.buffer_size += size;
+        return;
+    }
+    const unsigned char* end = data + size;
+    if(xxh.buffer_size) {
+        const size_t n_missing = sizeof(xxh.buffer) - xxh.buffer_size;
+        std::memcpy(xxh.buffer + xxh.buffer_size, data, n_missing);
+        for(size_t n = 0; n < 4; ++n)
+            xxh.acc[n] = XXH64Round(xxh.acc[n], Read64(xxh.buffer + n * 8));
+        data += n_missing;
+        xxh.buffer_size = 0;
+    }
+    for(; data + 32 <= end; data += 32) {
+        for(size_t n = 0; n < 4; ++n)
+            xxh.acc[n] = XXH64Round(xxh.acc[n], Read64(data + n * 8));
+    }
+    xxh.buffer_size = static_cast<size_t>(end - data);
+    std::memcpy(xxh.buffer, data, xxh.buffer_size);
+}
+
+uint64_t Checksum::XXH64Value() const
+{
+    uint64_t h;
+    if(xxh.total_size >= 32) {
+        h = RotateLeft(xxh.acc[0], 1) + RotateLeft(xxh.acc[1], 7) + RotateLeft(xxh.acc[2], 12)
+            + RotateLeft(xxh.acc[3], 18);
+        for(size_t n = 0; n < 4; ++n)
+            h = XXH64MergeRound(h, xxh.acc[n]);
+    } else {
+        h = xxh_prime5;
+    }
+    h += xxh.total_size;
+
+    const unsigned char* p = xxh.buffer;
+    const unsigned char* end = xxh.buffer + xxh.buffer_size;
+    for(; p + 8 <= end; p += 8)
+        h = RotateLeft(h ^ XXH64Round(0, Read64(p)), 27) * xxh_prime1 + xxh_prime4;
+    if(p + 4 <= end) {
+        h = RotateLeft(h ^ (static_cast<uint64_t>(Read32(p)) * xxh_prime1), 23) * xxh_prime2 + xxh_prime3;
+        p += 4;
+    }
+    for(; p < end; ++p)
+        h = RotateLeft(h ^ (*p * xxh_prime5), 11) * xxh_prime1;
+
+    h ^= h >> 33;
+    h *= xxh_prime2;
+    h ^= h >> 29;
+    h *= xxh_prime3;
+    h ^= h >> 32;
+    return h;
+}
+
+std::string Checksum::ToString(uint64_t value, ChecksumType type)
+{
+    std::ostringstream ss;
+    ss << std::hex << std::setw(type == ChecksumType::XXH64 ? 16 : 8) << std::setfill('0') << value;
+    return ss.str();
+}
+
+uint64_t Checksum::Combine(ChecksumType type, uint64_t first, uint64_t second, uint64_t second_size)
+{
+    if(type == ChecksumType::CRC32)
+        return CombineCRC32(static_cast<uint32_t>(first), static_cast<uint32_t>(second), second_size);
+    if(type == ChecksumType::Adler32)
+        return CombineAdler32(static_cast<uint32_t>(first), static_cast<uint32_t>(second), second_size);
+    throw exception("Checksums of type '%1%' can't be combined.") % type;
+}
+
+uint64_t ComputeFileChecksum(const std::string& path, ChecksumType type, size_t buffer_size)
+{
+    std::ifstream f(path, std::ios::binary);
+    if(f.fail())
+        throw exception("Failed to open file '%1%'.") % path;
+    Checksum checksum(type);
+    std::vector<char> buffer(buffer_size);
+    while(f) {
+        f.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        checksum.Process(buffer.data(), static_cast<size_t>(f.gcount()));
+    }
+    if(!f.eof())
+        throw exception("Error while reading file '%1%'.") % path;
+    return checksum.Value();
+}
+
+ChecksumCache::ChecksumCache(const std::string& _file_name) : file_name(_file_name)
+{
+    if(file_name.empty() || !boost::filesystem::exists(file_name)) return;
+    std::ifstream f(file_name);
+    if(f.fail())
+        throw exception("Failed to open checksum cache '%1%'.") % file_name;
+    std::string line;
+    for(size_t line_number = 1; std::getline(f, line); ++line_number) {
+        if(line.empty() || line.at(0) == '#') continue;
+        std::istringstream ss(line);
+        ChecksumType type;
+        std::string type_str, path;
+        Entry entry;
+        ss >> type_str >> std::hex >> entry.checksum >> std::dec >> entry.size >> entry.mtime;
+        std::getline(ss >> std::ws, path);
+        if(ss.fail() || path.empty() || !EnumNameMap<ChecksumType>::GetDefault().TryParse(type_str, type))
+            throw exception("Invalid entry at line %1% in checksum cache '%2%'.") % line_number % file_name;
+        entries[EntryKey(path, type)] = entry;
+    }
+}
+
+std::string ChecksumCache::CacheKey(const std::string& path)
+{
+    return boost::filesystem::absolute(path).lexically_normal().string();
+}
+
+bool ChecksumCache::Find(const std::string& path, ChecksumType type, uint64_t& checksum) const
+{
+    boost::system::error_code ec;
+    const uint64_t size = boost::filesystem::file_size(path, ec);
+    if(ec) return false;
+    const auto mtime = static_cast<int64_t>(boost::filesystem::last_write_time(path, ec));
+    if(ec) return false;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto iter = entries.find(EntryKey(CacheKey(path), type));
+    if(iter == entries.end() || iter->second.size != size || iter->second.mtime != mtime)
+        return false;
+    checksum = iter->second.checksum;
+    return true;
+}
+
+void ChecksumCache::Add(const std::string& path, ChecksumType type, uint64_t checksum)
+{
+    Entry entry;
+    entry.size = boost::filesystem::file_size(path);
+    entry.mtime = static_cast<int64_t>(boost::filesystem::last_write_time(path));
+    entry.checksum = checksum;
+    std::lock_guard<std::mutex> lock(mutex);
+    entries[EntryKey(CacheKey(path), type)] = entry;
+}
+
+uint64_t ChecksumCache::Get(const std::string& path, ChecksumType type)
+{
+    uint64_t checksum;
+    if(Find(path, type, checksum))
+        return checksum;
+    checksum = ComputeFileChecksum(path, type);
+    Add(path, type, checksum);
+    return checksum;
+}
+
+void ChecksumCache::Save() const
+{
+    if(file_name.empty()) return;
+    const std::string tmp_file = file_name + ".tmp";
+    {
+        std::ofstream f(tmp_file);
+        if(f.fail())
+            throw exception("Unable to create checksum cache '%1%'.") % tmp_file;
+        f << "# type checksum size mtime path\n";
+        std::lock_guard<std::mutex> lock(mutex);
+        for(const auto& entry : entries) {
+            f << entry.first.second << " " << Checksum::ToString(entry.second.checksum, entry.first.second) << " "
+              << entry.second.size << " " << entry.second.mtime << " " << entry.first.first << "\n";
+        }
+        if(f.fail())
+            throw exception("Error while writing checksum cache '%1%'.") % tmp_file;
+    }
+    boost::filesystem::rename(tmp_file, file_name);
+}
+
+size_t ChecksumCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+} // namespace analysis
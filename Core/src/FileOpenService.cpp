@@ -0,0 +1,166 @@
+/*! Implementation of the service that opens ROOT files asynchronously ahead of their processing.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include "AnalysisTools/Core/include/FileOpenService.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <TROOT.h>
+#include <TSystem.h>
+#include "AnalysisTools/Core/include/RootExt.h"
+#include "AnalysisTools/Run/include/MultiThread.h"
+
+namespace root_ext {
+
+namespace {
+// Counting semaphore that limits the number of concurrent opens in the process.
+class OpenSlots {
+public:
+    static OpenSlots& Global()
+    {
+        static OpenSlots slots;
+        return slots;
+    }
+
+    void SetLimit(size_t _limit)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        limit = _limit;
+        cond_var.notify_all();
+    }
+
+    size_t GetLimit()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return limit;
+    }
+
+    void Acquire()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond_var.wait(lock, [&] { return n_active < limit; });
+        ++n_active;
+    }
+
+    void Release()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        --n_active;
+        cond_var.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cond_var;
+    size_t limit{4}, n_active{0};
+};
+
+struct OpenSlotGuard {
+    OpenSlotGuard() { OpenSlots::Global().Acquire(); }
+    ~OpenSlotGuard() { OpenSlots::Global().Release(); }
+};
+
+bool IsLocalPath(const std::string& file_name) { return file_name.find("://") == std::string::npos; }
+} // anonymous namespace
+
+FileOpenService::FileOpenService(const std::vector<std::string>& _file_names, const Config& _config,
+                                 const Opener& _opener) :
+    file_names(_file_names), config(_config), opener(_opener)
+{
+    if(!config.n_attempts)
+        throw analysis::exception("Number of attempts to open a file should be positive.");
+    if(config.initial_backoff < 0 || config.backoff_factor < 1 || config.max_backoff < 0)
+        throw analysis::exception("Invalid backoff parameters.");
+    read_ahead = config.n_ahead > 0;
+    Schedule();
+}
+
+FileOpenService::~FileOpenService()
+{
+    // Opens that run on the global I/O executor refer to this service, so they should be finished before it is gone.
+    // The own pool is stopped by its destructor.
+    if(pool) return;
+    for(auto& future : pending) {
+        if(future.valid())
+            future.wait();
+    }
+}
+
+bool FileOpenService::Next(std::string& file_name, FilePtr& file)
+{
+    if(n_consumed >= file_names.size()) return false;
+    file_name = file_names.at(n_consumed++);
+    if(!read_ahead) {
+        file = Open(file_name);
+        return true;
+    }
+    auto future = std::move(pending.front());
+    pending.pop_front();
+    Schedule();
+    file = future.get();
+    return true;
+}
+
+FileOpenService::FilePtr FileOpenService::Next()
+{
+    std::string file_name;
+    FilePtr file;
+    Next(file_name, file);
+    return file;
+}
+
+void FileOpenService::SetMaxConcurrentOpens(size_t max_concurrent_opens)
+{
+    if(!max_concurrent_opens)
+        throw analysis::exception("Maximal number of concurrent opens should be positive.");
+    OpenSlots::Global().SetLimit(max_concurrent_opens);
+}
+
+size_t FileOpenService::GetMaxConcurrentOpens() { return OpenSlots::Global().GetLimit(); }
+
+void FileOpenService::Schedule()
+{
+    if(!read_ahead || n_scheduled >= file_names.size()) return;
+    // ROOT is used concurrently by the consumer and the read-ahead threads only from the first scheduled open.
+    if(!n_scheduled) {
+        ROOT::EnableThreadSafety();
+        if(!run::Executors::IsGlobalDefined())
+            pool = std::make_unique<run::ThreadPull>(std::min(config.n_ahead, file_names.size()), false);
+    }
+    while(n_scheduled < file_names.size() && pending.size() < config.n_ahead) {
+        const std::string& file_name = file_names.at(n_scheduled);
+        pending.push_back(pool ? pool->run(&FileOpenService::Open, this, file_name)
+                               : run::async_io(&FileOpenService::Open, this, file_name));
+        ++n_scheduled;
+    }
+}
+
+FileOpenService::FilePtr FileOpenService::Open(const std::string& file_name) const
+{
+    // A missing or unreadable local file is a permanent failure, which is reported without retries.
+    if(!opener && IsLocalPath(file_name) && gSystem->AccessPathName(file_name.c_str(), kReadPermission))
+        throw analysis::exception("File '%1%' does not exist or is not readable.") % file_name;
+    double backoff = config.initial_backoff;
+    for(unsigned attempt = 1; ; ++attempt) {
+        try {
+            OpenSlotGuard slot;
+            FilePtr file = opener ? opener(file_name) : OpenRootFile(file_name);
+            if(!file)
+                throw analysis::exception("File '%1%' not opened.") % file_name;
+            return file;
+        } catch(std::exception& e) {
+            if(attempt >= config.n_attempts)
+                throw;
+            std::cerr << "WARNING: attempt " << attempt << " to open '" << file_name << "' failed: " << e.what()
+                      << " Retrying in " << backoff << " s." << std::endl;
+            std::this_thread::sleep_for(std::chrono::duration<double>(backoff));
+            backoff = std::min(backoff * config.backoff_factor, config.max_backoff);
+        }
+    }
+}
+
+} // namespace root_ext
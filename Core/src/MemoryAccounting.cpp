@@ -0,0 +1,228 @@
+/*! Implementation of the accounting of the memory used by the major components of the library.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include "AnalysisTools/Core/include/MemoryAccounting.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <TArrayC.h>
+#include <TArrayF.h>
+#include <TArrayI.h>
+#include <TArrayS.h>
+#include <TBranch.h>
+#include <TH1.h>
+#include <TObjArray.h>
+#include <TTree.h>
+
+namespace analysis {
+
+MemoryAccounting& MemoryAccounting::Global()
+{
+    static MemoryAccounting accounting;
+    return accounting;
+}
+
+void MemoryAccounting::Add(const std::string& component, const std::string& directory, int64_t delta)
+{
+    if(!delta) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    Update(entries[Key(component, directory)], delta);
+    Update(components[component], delta);
+    Update(total, delta);
+}
+
+MemoryAccounting::Usage MemoryAccounting::GetUsage(const std::string& component, const std::string& directory) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto iter = entries.find(Key(component, directory));
+    return iter != entries.end() ? iter->second : Usage();
+}
+
+MemoryAccounting::Usage MemoryAccounting::GetComponentUsage(const std::string& component) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto iter = components.find(component);
+    return iter != components.end() ? iter->second : Usage();
+}
+
+MemoryAccounting::Usage MemoryAccounting::GetTotalUsage() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return total;
+}
+
+MemoryAccounting::UsageMap MemoryAccounting::GetUsageByDirectory() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries;
+}
+
+std::map<std::string, MemoryAccounting::Usage> MemoryAccounting::GetUsageByComponent() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return components;
+}
+
+bool MemoryAccounting::empty() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.empty();
+}
+
+void MemoryAccounting::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    components.clear();
+    total = Usage();
+}
+
+void MemoryAccounting::PrintSummary(std::ostream& os) const
+{
+    static constexpr double MiB = 1024. * 1024.;
+    static constexpr int name_width = 60, value_width = 12;
+
+    const auto print_line = [&](const std::string& name, const Usage& usage) {
+        os << std::left << std::setw(name_width) << name << std::right << std::fixed << std::setprecision(1)
+           << std::setw(value_width) << usage.current / MiB << std::setw(value_width) << usage.peak / MiB << "\n";
+    };
+
+    UsageMap entries_copy;
+    std::map<std::string, Usage> components_copy;
+    Usage total_copy;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries_copy = entries;
+        components_copy = components;
+        total_copy = total;
+    }
+
+    os << std::left << std::setw(name_width) << "Memory usage, MiB" << std::right << std::setw(value_width)
+       << "current" << std::setw(value_width) << "peak" << "\n";
+    for(const auto& component : components_copy) {
+        print_line(component.first, component.second);
+        for(auto iter = entries_copy.lower_bound(Key(component.first, "")); iter != entries_copy.end()
+                && iter->first.first == component.first; ++iter)
+            print_line("  " + (iter->first.second.empty() ? "<no directory>" : iter->first.second), iter->second);
+    }
+    print_line("Total tracked", total_copy);
+    const Usage process = GetProcessResidentMemory();
+    if(process.current || process.peak)
+        print_line("Process resident memory", process);
+    os << std::flush;
+}
+
+MemoryAccounting::Usage MemoryAccounting::GetProcessResidentMemory()
+{
+    Usage usage;
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while(std::getline(status, line)) {
+        std::istringstream ss(line);
+        std::string name;
+        size_t value;
+        if(!(ss >> name >> value)) continue;
+        if(name == "VmRSS:")
+            usage.current = value * 1024;
+        else if(name == "VmHWM:")
+            usage.peak = value * 1024;
+    }
+    return usage;
+}
+
+bool MemoryAccounting::IsSummaryRequested()
+{
+    const char* value = std::getenv("ANALYSIS_TOOLS_MEMORY_SUMMARY");
+    return value && *value && std::string(value) != "0";
+}
+
+void MemoryAccounting::Update(Usage& usage, int64_t delta)
+{
+    if(delta < 0)
+        usage.current -= std::min(usage.current, static_cast<size_t>(-delta));
+    else
+        usage.current += static_cast<size_t>(delta);
+    usage.peak = std::max(usage.peak, usage.current);
+}
+
+MemoryTracker::MemoryTracker(const std::string& _component, const std::string& _directory) :
+    component(_component), directory(_directory)
+{
+    // The accounting is created before the tracker, so it is destroyed after the static trackers.
+    MemoryAccounting::Global();
+}
+
+MemoryTracker::~MemoryTracker()
+{
+    Update(0);
+}
+
+void MemoryTracker::Update(size_t bytes)
+{
+    MemoryAccounting::Global().Add(component, directory, static_cast<int64_t>(bytes) - static_cast<int64_t>(current));
+    current = bytes;
+}
+
+void MemoryTracker::Add(size_t bytes)
+{
+    Update(current + bytes);
+}
+
+void MemoryTracker::SetDirectory(const std::string& _directory)
+{
+    if(_directory == directory) return;
+    const size_t bytes = current;
+    Update(0);
+    directory = _directory;
+    Update(bytes);
+}
+
+} // namespace analysis
+
+namespace root_ext {
+
+namespace {
+size_t EstimateBranchBuffers(TObjArray* branches)
+{
+    size_t size = 0;
+    if(!branches) return size;
+    for(Int_t n = 0; n <= branches->GetLast(); ++n) {
+        auto branch = dynamic_cast<TBranch*>(branches->At(n));
+        if(!branch) continue;
+        size += static_cast<size_t>(std::max(branch->GetBasketSize(), 0));
+        size += EstimateBranchBuffers(branch->GetListOfBranches());
+    }
+    return size;
+}
+} // anonymous namespace
+
+size_t EstimateMemoryUsage(const TH1& hist)
+{
+    size_t bin_size = sizeof(Double_t);
+    if(dynamic_cast<const TArrayF*>(&hist))
+        bin_size = sizeof(Float_t);
+    else if(dynamic_cast<const TArrayI*>(&hist))
+        bin_size = sizeof(Int_t);
+    else if(dynamic_cast<const TArrayS*>(&hist))
+        bin_size = sizeof(Short_t);
+    else if(dynamic_cast<const TArrayC*>(&hist))
+        bin_size = sizeof(Char_t);
+
+    size_t n_edges = 0;
+    for(const TAxis* axis : { hist.GetXaxis(), hist.GetYaxis(), hist.GetZaxis() })
+        n_edges += static_cast<size_t>(axis->GetXbins()->GetSize());
+
+    return static_cast<size_t>(hist.GetNcells()) * bin_size
+            + (static_cast<size_t>(hist.GetSumw2N()) + n_edges) * sizeof(Double_t);
+}
+
+size_t EstimateMemoryUsage(TTree& tree)
+{
+    return EstimateBranchBuffers(tree.GetListOfBranches())
+            + static_cast<size_t>(std::max<Long64_t>(tree.GetCacheSize(), 0));
+}
+
+} // namespace root_ext
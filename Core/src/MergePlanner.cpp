@@ -0,0 +1,150 @@
+/*! Definition of the planner of hierarchical merging of ROOT files.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include "AnalysisTools/Core/include/MergePlanner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <queue>
+#include <boost/filesystem.hpp>
+#include "AnalysisTools/Core/include/FileChecksum.h"
+#include "AnalysisTools/Core/include/exception.h"
+
+namespace analysis {
+
+MergePlanner::MergePlanner(const Limits& _limits, const std::string& _work_dir, const std::string& _output) :
+    limits(_limits), work_dir(_work_dir), output(_output)
+{
+    if(limits.max_files == 1)
+        throw exception("Merge task should have at least two inputs.");
+}
+
+std::vector<MergePlanner::Level> MergePlanner::Plan(const std::vector<Input>& inputs) const
+{
+    if(inputs.empty())
+        throw exception("No inputs to merge.");
+    std::vector<Level> levels;
+    std::vector<Input> level_inputs = inputs;
+    // Size and entry limits define the leaf tasks. At the upper levels only the number of files is limited,
+    // otherwise the reduction would not converge.
+    Limits level_limits = limits;
+    while(true) {
+        const auto groups = Partition(level_inputs, level_limits);
+        const size_t level_id = levels.size();
+        Level level;
+        std::vector<Input> next_inputs;
+        for(size_t n = 0; n < groups.size(); ++n) {
+            Task task;
+            task.level = level_id;
+            task.index = n;
+            for(size_t input_id : groups.at(n)) {
+                const Input& input = level_inputs.at(input_id);
+                task.inputs.push_back(input.path);
+                task.size += input.size;
+                task.n_entries += input.n_entries;
+            }
+            if(groups.size() == 1) {
+                task.output = output;
+            } else {
+                const auto level_dir = boost::filesystem::path(work_dir) / ("level_" + std::to_string(level_id));
+                task.output = (level_dir / ("merge_" + std::to_string(n) + ".root")).string();
+            }
+            next_inputs.push_back(Input{ task.output, task.size, task.n_entries });
+            level.push_back(task);
+        }
+        levels.push_back(level);
+        if(groups.size() == 1) break;
+        level_inputs = next_inputs;
+        level_limits.max_size = 0;
+        level_limits.max_entries = 0;
+    }
+    return levels;
+}
+
+std::vector<std::vector<size_t>> MergePlanner::Partition(const std::vector<Input>& inputs, const Limits& limits)
+{
+    uint64_t total_size = 0;
+    Long64_t total_entries = 0;
+    for(const auto& input : inputs) {
+        total_size += input.size;
+        total_entries += input.n_entries;
+    }
+
+    const auto n_groups_for = [](double total, double limit) {
+        return limit > 0 ? static_cast<size_t>(std::ceil(total / limit)) : size_t(1);
+    };
+    const size_t n_groups = std::max({ size_t(1), n_groups_for(static_cast<double>(inputs.size()),
+                                                               static_cast<double>(limits.max_files)),
+                                       n_groups_for(static_cast<double>(total_size),
+                                                    static_cast<double>(limits.max_size)),
+                                       n_groups_for(static_cast<double>(total_entries),
+                                                    static_cast<double>(limits.max_entries)) });
+    const size_t max_group_files = limits.max_files ? limits.max_files : inputs.size();
+
+    // Normalized load of an input: if limits are not set, the totals are used as the scale.
+    const double size_scale = static_cast<double>(limits.max_size ? limits.max_size : std::max<uint64_t>(total_size, 1));
+    const double entries_scale = static_cast<double>(limits.max_entries ? limits.max_entries
+                                                                         : std::max<Long64_t>(total_entries, 1));
+    const auto load = [&](const Input& input) {
+        return static_cast<double>(input.size) / size_scale + static_cast<double>(input.n_entries) / entries_scale;
+    };
+
+    std::vector<size_t> order(inputs.size());
+    for(size_t n = 0; n < order.size(); ++n)
+        order[n] = n;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return load(inputs.at(a)) > load(inputs.at(b));
+    });
+
+    using GroupLoad = std::pair<double, size_t>;
+    std::priority_queue<GroupLoad, std::vector<GroupLoad>, std::greater<GroupLoad>> group_loads;
+    for(size_t n = 0; n < n_groups; ++n)
+        group_loads.emplace(0., n);
+    std::vector<std::vector<size_t>> groups(n_groups);
+    for(size_t input_id : order) {
+        GroupLoad group = group_loads.top();
+        group_loads.pop();
+        groups.at(group.second).push_back(input_id);
+        group.first += load(inputs.at(input_id));
+        if(groups.at(group.second).size() < max_group_files)
+            group_loads.push(group);
+    }
+
+    groups.erase(std::remove_if(groups.begin(), groups.end(),
+                                [](const std::vector<size_t>& group) { return group.empty(); }), groups.end());
+    for(auto& group : groups)
+        std::sort(group.begin(), group.end());
+    std::sort(groups.begin(), groups.end());
+    return groups;
+}
+
+uint32_t MergePlanner::FileChecksum(const std::string& path)
+{
+    return static_cast<uint32_t>(ComputeFileChecksum(path, ChecksumType::CRC32));
+}
+
+std::string MergePlanner::ChecksumFileName(const std::string& path) { return path + ".crc32"; }
+
+uint32_t MergePlanner::WriteChecksum(const std::string& path)
+{
+    const uint32_t checksum = FileChecksum(path);
+    std::ofstream f(ChecksumFileName(path));
+    f << std::hex << checksum << std::endl;
+    if(f.fail())
+        throw exception("Unable to write checksum of '%1%'.") % path;
+    return checksum;
+}
+
+void MergePlanner::VerifyChecksum(const std::string& path)
+{
+    std::ifstream f(ChecksumFileName(path));
+    uint32_t expected;
+    f >> std::hex >> expected;
+    if(f.fail())
+        throw exception("Unable to read the checksum of '%1%' from '%2%'.") % path % ChecksumFileName(path);
+    if(FileChecksum(path) != expected)
+        throw exception("Checksum mismatch for '%1%'.") % path;
+}
+
+} // namespace analysis
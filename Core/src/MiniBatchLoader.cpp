@@ -0,0 +1,355 @@
+/*! Implementation of the streaming loader of shuffled mini-batches for the ML training.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include "AnalysisTools/Core/include/MiniBatchLoader.h"
+
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <numeric>
+#include <TLeaf.h>
+#include <TROOT.h>
+#include "AnalysisTools/Core/include/BranchReaderFactory.h"
+#include "AnalysisTools/Core/include/RootExt.h"
+#include "AnalysisTools/Core/include/SmartTree.h"
+#include "AnalysisTools/Core/include/TextIO.h"
+#include "AnalysisTools/Run/include/MultiThread.h"
+
+namespace analysis {
+
+namespace {
+struct FeatureDescriptor {
+    std::string branch;
+    size_t index{0};
+};
+
+FeatureDescriptor ParseFeature(const std::string& feature)
+{
+    FeatureDescriptor desc;
+    const size_t pos = feature.find('[');
+    desc.branch = feature.substr(0, pos);
+    if(pos != std::string::npos) {
+        if(feature.back() != ']')
+            throw exception("Invalid feature '%1%'.") % feature;
+        desc.index = Parse<size_t>(feature.substr(pos + 1, feature.size() - pos - 2));
+    }
+    if(desc.branch.empty())
+        throw exception("Invalid feature '%1%'.") % feature;
+    return desc;
+}
+
+struct FeatureReader {
+    virtual ~FeatureReader() {}
+    virtual float Get(float default_value) const = 0;
+};
+
+// Fundamental scalars and C-style arrays are read through the leaf.
+struct LeafFeatureReader : FeatureReader {
+    TLeaf* leaf;
+    size_t index;
+
+    LeafFeatureReader(TLeaf* _leaf, size_t _index) : leaf(_leaf), index(_index) {}
+
+    virtual float Get(float default_value) const override
+    {
+        if(index >= static_cast<size_t>(leaf->GetLen())) return default_value;
+        return static_cast<float>(leaf->GetValue(static_cast<Int_t>(index)));
+    }
+};
+
+// TLeaf::GetValue does not return elements of the STL collections, so std::vector branches are read into a vector.
+template<typename T>
+struct VectorFeatureReader : FeatureReader {
+    std::vector<T>* value{nullptr};
+    size_t index;
+
+    VectorFeatureReader(TTree& tree, const std::string& branch_name, size_t _index) : index(_index)
+    {
+        tree.SetBranchAddress(branch_name.c_str(), &value);
+    }
+
+    virtual ~VectorFeatureReader() override { delete value; }
+
+    virtual float Get(float default_value) const override
+    {
+        if(!value || index >= value->size()) return default_value;
+        return static_cast<float>((*value)[index]);
+    }
+
+    static FeatureReader* Make(TTree& tree, const std::string& branch_name, size_t index)
+    {
+        return new VectorFeatureReader<T>(tree, branch_name, index);
+    }
+};
+
+using VectorFeatureReaderFactory =
+    root_ext::BranchReaderFactory<FeatureReader* (*)(TTree&, const std::string&, size_t),
+                                  root_ext::UnsupportedBranchReader, VectorFeatureReader>;
+} // anonymous namespace
+
+// Input tree of one file, which stays open between the chunks read by the same thread. The readers are declared
+// before the tree, so the tree that holds their addresses is deleted first.
+struct MiniBatchLoader::ChunkReader {
+    size_t file_index{0};
+    std::shared_ptr<TFile> file;
+    std::vector<std::unique_ptr<FeatureReader>> features;
+    std::unique_ptr<TTree> tree;
+};
+
+ShuffleBuffer::ShuffleBuffer(size_t _capacity, size_t _n_features, uint64_t seed) :
+    capacity(_capacity), n_features(_n_features), events(capacity * n_features), gen(seed)
+{
+    if(!capacity)
+        throw exception("Capacity of the shuffle buffer should be positive.");
+}
+
+bool ShuffleBuffer::Push(const float* event, float* output)
+{
+    if(n_events < capacity) {
+        std::copy(event, event + n_features, events.data() + n_events * n_features);
+        ++n_events;
+        return false;
+    }
+    std::uniform_int_distribution<size_t> distr(0, capacity - 1);
+    float* selected = events.data() + distr(gen) * n_features;
+    std::copy(selected, selected + n_features, output);
+    std::copy(event, event + n_features, selected);
+    return true;
+}
+
+bool ShuffleBuffer::Pop(float* output)
+{
+    if(!n_events) return false;
+    std::uniform_int_distribution<size_t> distr(0, n_events - 1);
+    float* selected = events.data() + distr(gen) * n_features;
+    float* last = events.data() + (n_events - 1) * n_features;
+    std::copy(selected, selected + n_features, output);
+    std::copy(last, last + n_features, selected);
+    --n_events;
+    return true;
+}
+
+MiniBatchLoader::MiniBatchLoader(const Config& _config) :
+    config(_config)
+{
+    if(config.files.empty())
+        throw exception("No input files are specified.");
+    if(config.features.empty())
+        throw exception("No features are specified.");
+    if(!config.batch_size)
+        throw exception("Batch size should be positive.");
+    for(const auto& feature : config.features)
+        ParseFeature(feature);
+    config.n_threads = std::max<size_t>(config.n_threads, 1);
+    config.prefetch_size = std::max<size_t>(config.prefetch_size, 1);
+    config.chunk_size = std::max<size_t>(config.chunk_size, 1);
+
+    ROOT::EnableThreadSafety();
+    run::ThreadPull pool(config.n_threads, false);
+    std::vector<std::future<std::vector<Chunk>>> file_chunks;
+    for(size_t n = 0; n < config.files.size(); ++n)
+        file_chunks.push_back(pool.run(&MiniBatchLoader::CollectChunks, this, n));
+    for(auto& result : file_chunks) {
+        for(const Chunk& chunk : result.get()) {
+            chunks.push_back(chunk);
+            n_events += chunk.n_entries;
+        }
+    }
+}
+
+MiniBatchLoader::~MiniBatchLoader()
+{
+    Stop();
+}
+
+void MiniBatchLoader::StartEpoch(size_t epoch)
+{
+    Stop();
+    stop_requested = false;
+    producer_error = nullptr;
+    queue = std::make_unique<run::EntryQueue<BatchPtr>>(config.prefetch_size);
+    producer = std::thread(&MiniBatchLoader::Produce, this, epoch);
+}
+
+bool MiniBatchLoader::Next(MiniBatch& batch)
+{
+    if(!queue)
+        StartEpoch(0);
+    BatchPtr next_batch;
+    if(!queue->Pop(next_batch)) {
+        if(producer_error)
+            std::rethrow_exception(producer_error);
+        return false;
+    }
+    std::swap(batch, *next_batch);
+    return true;
+}
+
+void MiniBatchLoader::Stop()
+{
+    if(!producer.joinable()) return;
+    stop_requested = true;
+    queue->SetAllDone();
+    producer.join();
+}
+
+void MiniBatchLoader::Produce(size_t epoch)
+{
+    try {
+        const size_t n_features = config.features.size();
+        const bool shuffle = config.shuffle_buffer_size > 0;
+        std::seed_seq seed_seq{ static_cast<uint32_t>(config.seed), static_cast<uint32_t>(config.seed >> 32),
+                                static_cast<uint32_t>(epoch) };
+        std::mt19937_64 gen(seed_seq);
+
+        std::vector<size_t> order(chunks.size());
+        std::iota(order.begin(), order.end(), 0);
+        if(shuffle)
+            std::shuffle(order.begin(), order.end(), gen);
+        std::unique_ptr<ShuffleBuffer> buffer;
+        if(shuffle)
+            buffer = std::make_unique<ShuffleBuffer>(config.shuffle_buffer_size, n_features, gen());
+
+        auto batch = std::make_shared<MiniBatch>();
+        const auto add_event = [&](const float* event) {
+            if(batch->values.empty()) {
+                batch->n_features = n_features;
+                batch->values.reserve(config.batch_size * n_features);
+            }
+            batch->values.insert(batch->values.end(), event, event + n_features);
+            if(batch->size() == config.batch_size) {
+                queue->Push(batch);
+                batch = std::make_shared<MiniBatch>();
+            }
+        };
+
+        // No more than n_threads chunks are read at the same time, so a free reader is always available. A reader
+        // that has the file of the chunk already open is preferred. Readers are declared before the pool to
+        // outlive the running tasks.
+        std::mutex readers_mutex;
+        std::vector<std::unique_ptr<ChunkReader>> free_readers;
+        for(size_t n = 0; n < config.n_threads; ++n)
+            free_readers.push_back(std::make_unique<ChunkReader>());
+        const auto read_chunk = [&](const Chunk& chunk) {
+            std::unique_ptr<ChunkReader> reader;
+            {
+                std::lock_guard<std::mutex> lock(readers_mutex);
+                auto iter = std::find_if(free_readers.begin(), free_readers.end(), [&](const auto& r) {
+                    return r->tree && r->file_index == chunk.file_index;
+                });
+                if(iter == free_readers.end())
+                    iter = free_readers.begin();
+                reader = std::move(*iter);
+                free_readers.erase(iter);
+            }
+            const auto release = [&]() {
+                std::lock_guard<std::mutex> lock(readers_mutex);
+                free_readers.push_back(std::move(reader));
+            };
+            std::vector<float> values;
+            try {
+                values = ReadChunk(chunk, *reader);
+            } catch(...) {
+                release();
+                throw;
+            }
+            release();
+            return values;
+        };
+
+        std::vector<float> selected(n_features);
+        run::ThreadPull pool(config.n_threads, false);
+        std::deque<std::future<std::vector<float>>> pending;
+        const size_t max_pending = 2 * config.n_threads;
+        for(size_t next_chunk = 0; !stop_requested && (next_chunk < order.size() || !pending.empty());) {
+            while(next_chunk < order.size() && pending.size() < max_pending) {
+                const Chunk& chunk = chunks.at(order.at(next_chunk++));
+                pending.push_back(pool.run(read_chunk, std::cref(chunk)));
+            }
+            const std::vector<float> values = pending.front().get();
+            pending.pop_front();
+            for(size_t pos = 0; pos < values.size() && !stop_requested; pos += n_features) {
+                if(!shuffle)
+                    add_event(values.data() + pos);
+                else if(buffer->Push(values.data() + pos, selected.data()))
+                    add_event(selected.data());
+            }
+        }
+        while(shuffle && !stop_requested && buffer->Pop(selected.data()))
+            add_event(selected.data());
+        if(!stop_requested && !batch->empty() && !config.drop_last)
+            queue->Push(batch);
+    } catch(...) {
+        producer_error = std::current_exception();
+    }
+    queue->SetAllDone();
+}
+
+std::vector<float> MiniBatchLoader::ReadChunk(const Chunk& chunk, ChunkReader& reader) const
+{
+    const std::string& file_name = config.files.at(chunk.file_index);
+    if(!reader.tree || reader.file_index != chunk.file_index) {
+        // The tree is owned by the file directory, so it should be deleted before the file is closed.
+        reader.tree.reset();
+        reader.features.clear();
+        reader.file.reset();
+        auto file = root_ext::OpenRootFile(file_name);
+        std::unique_ptr<TTree> tree(root_ext::ReadObject<TTree>(*file, config.tree_name));
+        tree->SetBranchStatus("*", 0);
+        std::vector<std::unique_ptr<FeatureReader>> features;
+        for(const auto& feature : config.features) {
+            const FeatureDescriptor desc = ParseFeature(feature);
+            root_ext::detail::EnableBranch(*tree, desc.branch);
+            TBranch* branch = tree->GetBranch(desc.branch.c_str());
+            const auto make = branch ? VectorFeatureReaderFactory::FindMakeMethod(*branch) : nullptr;
+            if(make) {
+                features.emplace_back((*make)(*tree, desc.branch, desc.index));
+                continue;
+            }
+            TLeaf* leaf = tree->GetLeaf(desc.branch.c_str());
+            if(!leaf)
+                throw exception("Leaf '%1%' not found in '%2%'.") % desc.branch % file_name;
+            features.push_back(std::make_unique<LeafFeatureReader>(leaf, desc.index));
+        }
+        reader.file_index = chunk.file_index;
+        reader.file = file;
+        reader.features = std::move(features);
+        reader.tree = std::move(tree);
+    }
+    TTree* tree = reader.tree.get();
+    tree->SetCacheEntryRange(chunk.first_entry, chunk.first_entry + chunk.n_entries);
+
+    std::vector<float> values;
+    values.reserve(static_cast<size_t>(chunk.n_entries) * reader.features.size());
+    for(Long64_t entry = chunk.first_entry; entry < chunk.first_entry + chunk.n_entries; ++entry) {
+        if(tree->GetEntry(entry) <= 0)
+            throw exception("Unable to read entry %1% from '%2%'.") % entry % file_name;
+        for(const auto& feature : reader.features)
+            values.push_back(feature->Get(config.default_value));
+    }
+    return values;
+}
+
+// Consecutive clusters are grouped, until the chunk has at least chunk_size entries.
+std::vector<MiniBatchLoader::Chunk> MiniBatchLoader::CollectChunks(size_t file_index) const
+{
+    auto file = root_ext::OpenRootFile(config.files.at(file_index));
+    std::unique_ptr<TTree> tree(root_ext::ReadObject<TTree>(*file, config.tree_name));
+    const Long64_t n_entries = tree->GetEntries();
+    std::vector<Chunk> file_chunks;
+    Chunk chunk{ file_index, 0, 0 };
+    auto cluster_iter = tree->GetClusterIterator(0);
+    for(Long64_t start; (start = cluster_iter.Next()) < n_entries;) {
+        chunk.n_entries += std::min(cluster_iter.GetNextEntry(), n_entries) - start;
+        if(chunk.n_entries >= static_cast<Long64_t>(config.chunk_size)) {
+            file_chunks.push_back(chunk);
+            chunk = Chunk{ file_index, chunk.first_entry + chunk.n_entries, 0 };
+        }
+    }
+    if(chunk.n_entries)
+        file_chunks.push_back(chunk);
+    return file_chunks;
+}
+
+} // namespace analysis
@@ -0,0 +1,179 @@
+/*! Implementation of writer and memory-mapped reader of one-dimensional arrays in the NumPy .npy format.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include "AnalysisTools/Core/include/NpyFile.h"
+
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include "AnalysisTools/Core/include/TextIO.h"
+
+namespace analysis {
+
+namespace {
+const std::string Magic = "\x93NUMPY";
+constexpr size_t PreambleSize = 10; // magic, version and 2-byte header length of the format version 1.0
+constexpr size_t MaxShapeDigits = 20;
+
+// Returns the value of the key in the python dict literal, e.g. "'<f4'" for 'descr'.
+std::string FindDictValue(const std::string& dict, const std::string& key, const std::string& file_name)
+{
+    const std::string quoted_key = "'" + key + "':";
+    size_t pos = dict.find(quoted_key);
+    if(pos == std::string::npos)
+        throw exception("Key '%1%' not found in the header of '%2%'.") % key % file_name;
+    pos = dict.find_first_not_of(' ', pos + quoted_key.size());
+    size_t end_pos;
+    if(dict.at(pos) == '(')
+        end_pos = dict.find(')', pos) + 1;
+    else if(dict.at(pos) == '\'')
+        end_pos = dict.find('\'', pos + 1) + 1;
+    else
+        end_pos = dict.find_first_of(",}", pos);
+    if(end_pos == std::string::npos || end_pos == 0)
+        throw exception("Invalid value of '%1%' in the header of '%2%'.") % key % file_name;
+    return dict.substr(pos, end_pos - pos);
+}
+} // anonymous namespace
+
+size_t NpyHeader::NumberOfElements() const
+{
+    size_t n = 1;
+    for(size_t dim : shape)
+        n *= dim;
+    return n;
+}
+
+NpyHeader NpyHeader::Parse(const char* data, size_t size, const std::string& file_name)
+{
+    if(size < PreambleSize || std::memcmp(data, Magic.data(), Magic.size()) != 0)
+        throw exception("'%1%' is not a .npy file.") % file_name;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    const unsigned major_version = bytes[6];
+    size_t header_length, header_start;
+    if(major_version == 1) {
+        header_length = bytes[8] | static_cast<size_t>(bytes[9]) << 8;
+        header_start = 10;
+    } else if(major_version == 2 || major_version == 3) {
+        if(size < 12)
+            throw exception("'%1%' is not a .npy file.") % file_name;
+        header_length = bytes[8] | static_cast<size_t>(bytes[9]) << 8 | static_cast<size_t>(bytes[10]) << 16
+                | static_cast<size_t>(bytes[11]) << 24;
+        header_start = 12;
+    } else {
+        throw exception("Unsupported .npy format version %1% of '%2%'.") % major_version % file_name;
+    }
+    if(header_start + header_length > size)
+        throw exception("Truncated header of '%1%'.") % file_name;
+
+    const std::string dict(data + header_start, header_length);
+    NpyHeader header;
+    header.data_offset = header_start + header_length;
+    const std::string descr = FindDictValue(dict, "descr", file_name);
+    if(descr.size() < 2 || descr.front() != '\'')
+        throw exception("Unsupported data type %1% in '%2%'.") % descr % file_name;
+    header.descr = descr.substr(1, descr.size() - 2);
+    header.fortran_order = FindDictValue(dict, "fortran_order", file_name) == "True";
+    const std::string shape = FindDictValue(dict, "shape", file_name);
+    for(const auto& dim : SplitValueList(shape.substr(1, shape.size() - 2), true, ", "))
+        header.shape.push_back(analysis::Parse<size_t>(dim));
+    return header;
+}
+
+NpyWriter::NpyWriter(const std::string& _file_name, const std::string& _descr, size_t _element_size) :
+    file_name(_file_name), descr(_descr), element_size(_element_size),
+    stream(file_name, std::ios::binary | std::ios::trunc)
+{
+    if(!stream.is_open())
+        throw exception("Unable to create '%1%'.") % file_name;
+    header_size = PreambleSize + CreateHeader(0).size();
+    header_size = (header_size + NpyHeader::Alignment - 1) / NpyHeader::Alignment * NpyHeader::Alignment;
+    stream << CreateHeader(header_size);
+    buffer.reserve(BufferSize + element_size);
+}
+
+NpyWriter::~NpyWriter()
+{
+    try {
+        Close();
+    } catch(std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+    }
+}
+
+// The header has space reserved for the maximal number of elements. If total_size is 0, the unpadded dict is returned.
+std::string NpyWriter::CreateHeader(size_t total_size) const
+{
+    std::ostringstream ss;
+    ss << "{'descr': '" << descr << "', 'fortran_order': False, 'shape': (" << n_elements << ",), }";
+    std::string dict = ss.str();
+    if(!total_size)
+        return dict + std::string(MaxShapeDigits, ' ') + "\n";
+    const size_t dict_size = total_size - PreambleSize;
+    dict += std::string(dict_size - dict.size() - 1, ' ') + "\n";
+    std::string header = Magic;
+    header += static_cast<char>(1);
+    header += static_cast<char>(0);
+    header += static_cast<char>(dict_size & 0xff);
+    header += static_cast<char>((dict_size >> 8) & 0xff);
+    return header + dict;
+}
+
+void NpyWriter::Flush()
+{
+    stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    if(stream.fail())
+        throw exception("Error while writing '%1%'.") % file_name;
+    buffer.clear();
+}
+
+void NpyWriter::Close()
+{
+    if(!stream.is_open()) return;
+    Flush();
+    stream.seekp(0);
+    stream << CreateHeader(header_size);
+    stream.close();
+    if(stream.fail())
+        throw exception("Error while writing '%1%'.") % file_name;
+}
+
+MappedNpyFile::MappedNpyFile(const std::string& _file_name) :
+    file_name(_file_name)
+{
+    namespace ip = boost::interprocess;
+    try {
+        ip::file_mapping mapping(file_name.c_str(), ip::read_only);
+        region = std::make_unique<ip::mapped_region>(mapping, ip::read_only);
+    } catch(ip::interprocess_exception& e) {
+        throw exception("Unable to map '%1%': %2%") % file_name % e.what();
+    }
+    header = NpyHeader::Parse(static_cast<const char*>(region->get_address()), region->get_size(), file_name);
+    if(header.fortran_order && header.shape.size() > 1)
+        throw exception("Arrays in the Fortran order are not supported ('%1%').") % file_name;
+    if(header.data_offset > region->get_size())
+        throw exception("Truncated file '%1%'.") % file_name;
+}
+
+MappedNpyFile::~MappedNpyFile() {}
+
+const void* MappedNpyFile::Data(size_t element_size) const
+{
+    if(header.data_offset + size() * element_size > region->get_size())
+        throw exception("Truncated file '%1%'.") % file_name;
+    return static_cast<const char*>(region->get_address()) + header.data_offset;
+}
+
+std::string NpyOffsetsFileName(const std::string& values_file_name)
+{
+    static const std::string ext = ".npy";
+    const bool has_ext = values_file_name.size() > ext.size()
+            && values_file_name.compare(values_file_name.size() - ext.size(), ext.size(), ext) == 0;
+    const std::string stem = has_ext ? values_file_name.substr(0, values_file_name.size() - ext.size())
+                                     : values_file_name;
+    return stem + ".offsets.npy";
+}
+
+} // namespace analysis
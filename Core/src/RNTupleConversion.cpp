@@ -0,0 +1,75 @@
+/*! Conversion of trees between the TTree and the RNTuple formats.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include "AnalysisTools/Core/include/RNTupleConversion.h"
+
+#ifdef ANALYSIS_TOOLS_HAS_RNTUPLE
+
+#include <deque>
+#include <map>
+#include <ROOT/RNTupleImporter.hxx>
+#include "AnalysisTools/Core/include/RootExt.h"
+#include "AnalysisTools/Core/include/SmartNTuple.h"
+
+namespace root_ext {
+
+Long64_t ConvertTreeToNTuple(const std::string& input_file, const std::string& name, const std::string& output_file,
+                             ROOT::ECompressionAlgorithm compression, int compression_level)
+{
+    auto importer = rntuple::RNTupleImporter::Create(input_file, name, output_file).Unwrap();
+    rntuple::RNTupleWriteOptions options;
+    options.SetCompression(ROOT::CompressionSettings(compression, compression_level));
+    importer->SetWriteOptions(options);
+    importer->SetIsQuiet(true);
+    importer->Import();
+
+    auto output = OpenRootFile(output_file);
+    std::unique_ptr<rntuple::RNTuple> anchor(output->Get<rntuple::RNTuple>(name.c_str()));
+    if(!anchor)
+        throw analysis::exception("Unable to convert tree '%1%' into RNTuple.") % name;
+    return static_cast<Long64_t>(rntuple::RNTupleReader::Open(*anchor)->GetNEntries());
+}
+
+Long64_t ConvertNTupleToTree(TDirectory& input_dir, TDirectory& output_dir, const std::string& name)
+{
+    static const std::map<std::string, std::string> leaf_types = {
+        { "bool", "O" }, { "char", "B" }, { "std::int8_t", "B" }, { "std::uint8_t", "b" },
+        { "std::int16_t", "S" }, { "std::uint16_t", "s" }, { "std::int32_t", "I" }, { "std::uint32_t", "i" },
+        { "std::int64_t", "L" }, { "std::uint64_t", "l" }, { "float", "F" }, { "double", "D" },
+    };
+
+    std::unique_ptr<rntuple::RNTuple> anchor(input_dir.Get<rntuple::RNTuple>(name.c_str()));
+    if(!anchor)
+        throw analysis::exception("Unable to read RNTuple '%1%'.") % name;
+    auto reader = rntuple::RNTupleReader::Open(*anchor);
+    auto entry = reader->GetModel().CreateEntry();
+
+    output_dir.cd();
+    auto tree = std::make_unique<TTree>(name.c_str(), name.c_str());
+    std::deque<void*> object_ptrs;
+    for(const auto field : reader->GetModel().GetFieldZero().GetSubFields()) {
+        const std::string field_name = field->GetFieldName(), type_name = field->GetTypeName();
+        void* ptr = entry->GetPtr<void>(field_name).get();
+        auto leaf_type = leaf_types.find(type_name);
+        if(leaf_type != leaf_types.end()) {
+            tree->Branch(field_name.c_str(), ptr, (field_name + "/" + leaf_type->second).c_str());
+        } else {
+            if(!TClass::GetClass(type_name.c_str()))
+                throw analysis::exception("Field '%1%' of RNTuple '%2%' has type '%3%' without a dictionary.")
+                    % field_name % name % type_name;
+            object_ptrs.push_back(ptr);
+            tree->Branch(field_name.c_str(), type_name.c_str(), &object_ptrs.back());
+        }
+    }
+
+    for(auto entry_index : reader->GetEntryRange()) {
+        reader->LoadEntry(entry_index, *entry);
+        tree->Fill();
+    }
+    output_dir.WriteTObject(tree.get(), name.c_str(), "Overwrite");
+    return tree->GetEntries();
+}
+
+} // namespace root_ext
+
+#endif
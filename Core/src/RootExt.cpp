@@ -13,6 +13,7 @@ This file is part of https://github.com/hh-italian-group/AnalysisTools. */
 #include <TFile.h>
 #include <Compression.h>
 
+#include "AnalysisTools/Core/include/EnumNameMap.h"
 #include "AnalysisTools/Core/include/exception.h"
 
 namespace root_ext {
@@ -84,6 +85,14 @@ ClassInheritance FindClassInheritance(const std::string& class_name)
 
     return inheritance;
 }
+
+ROOT::ECompressionAlgorithm ParseCompressionAlgorithm(const std::string& name)
+{
+    static const analysis::EnumNameMap<ROOT::ECompressionAlgorithm> names("ECompressionAlgorithm", {
+        { ROOT::kZLIB, "ZLIB" }, { ROOT::kLZMA, "LZMA" }, { ROOT::kLZ4, "LZ4" }, { ROOT::kZSTD, "ZSTD" }
+    });
+    return names.Parse(name);
+}
 } // namespace root_ext
 
 
@@ -3,8 +3,13 @@ This file is part of https://github.com/hh-italian-group/AnalysisTools. */
 
 #include "AnalysisTools/Core/include/RootFilesMerger.h"
 
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <fstream>
 #include <iostream>
 #include <unordered_map>
+#include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/regex.hpp>
 #include <TROOT.h>
@@ -12,10 +17,16 @@ This file is part of https://github.com/hh-italian-group/AnalysisTools. */
 #include <TSystem.h>
 #include <TTree.h>
 #include <TChain.h>
+#include <TEntryList.h>
+#include <TTreeFormula.h>
 #include <TH1.h>
 #include <memory>
+#include "AnalysisTools/Core/include/BranchReaderFactory.h"
+#include "AnalysisTools/Core/include/FileOpenService.h"
+#include "AnalysisTools/Core/include/MemoryAccounting.h"
 #include "AnalysisTools/Core/include/RootExt.h"
 #include "AnalysisTools/Core/include/TextIO.h"
+#include "AnalysisTools/Run/include/MultiThread.h"
 
 namespace {
 void CollectInputFiles(const boost::filesystem::path& dir, std::vector<std::string>& files,
@@ -31,6 +42,53 @@ void CollectInputFiles(const boost::filesystem::path& dir, std::vector<std::stri
             files.push_back(entry.path().string());
     }
 }
+
+// Reads an event id column through a branch of its own type, so the ids are exact for the whole range of the 64-bit
+// integers.
+struct IdColumnReader {
+    virtual ~IdColumnReader() {}
+    // Should be called when the chain is switched to the next tree.
+    virtual void Update() = 0;
+    virtual analysis::EventSampler::IdType Read(Long64_t tree_entry) = 0;
+};
+
+template<typename T>
+struct TypedIdColumnReader : IdColumnReader {
+    TChain& chain;
+    std::string branch_name;
+    T value{};
+    TBranch* branch{nullptr};
+
+    TypedIdColumnReader(TChain& _chain, const std::string& _branch_name) : chain(_chain), branch_name(_branch_name)
+    {
+        if(chain.SetBranchAddress(branch_name.c_str(), &value) < 0)
+            throw analysis::exception("Unable to read event id column '%1%'.") % branch_name;
+    }
+
+    // The chain is used to copy the selected entries afterwards, so it should not keep the address of the value.
+    virtual ~TypedIdColumnReader() override
+    {
+        if(TBranch* chain_branch = chain.GetBranch(branch_name.c_str()))
+            chain.ResetBranchAddress(chain_branch);
+    }
+
+    virtual void Update() override { branch = chain.GetBranch(branch_name.c_str()); }
+
+    virtual analysis::EventSampler::IdType Read(Long64_t tree_entry) override
+    {
+        if(!branch || branch->GetEntry(tree_entry) < 0)
+            throw analysis::exception("Unable to read event id column '%1%'.") % branch_name;
+        return static_cast<analysis::EventSampler::IdType>(value);
+    }
+
+    static IdColumnReader* Make(TChain& chain, const std::string& branch_name)
+    {
+        return new TypedIdColumnReader<T>(chain, branch_name);
+    }
+};
+
+using IdColumnReaderFactory =
+    root_ext::BranchReaderFactory<IdColumnReader* (*)(TChain&, const std::string&), TypedIdColumnReader>;
 }
 
 namespace analysis {
@@ -70,7 +128,11 @@ std::atomic<size_t>& RootFilesMerger::TreeDescriptor::NumberOfFiles()
 }
 
 RootFilesMerger::TreeDescriptor::TreeDescriptor() { file_names.reserve(NumberOfFiles()); }
-void RootFilesMerger::TreeDescriptor::AddFile(const std::string& file_name) { file_names.push_back(file_name); }
+void RootFilesMerger::TreeDescriptor::AddFile(const std::string& file_name, int file_compression_settings)
+{
+    file_names.push_back(file_name);
+    compression_settings.insert(file_compression_settings);
+}
 
 RootFilesMerger::TreeDescriptor::ChainPtr RootFilesMerger::TreeDescriptor::CreateChain(
     const std::string& full_name) const
@@ -85,57 +147,528 @@ RootFilesMerger::RootFilesMerger(const std::string& output, const std::vector<st
                 const std::string& file_name_pattern, const std::string& exclude_list,
                 const std::string& exclude_dir_list, unsigned n_threads, ROOT::ECompressionAlgorithm compression,
                 int compression_level) :
-    input_files(FindInputFiles(input_dirs, file_name_pattern, exclude_list, exclude_dir_list)),
-    output_file(root_ext::CreateRootFile(output, compression, compression_level))
+    RootFilesMerger(output, FindInputFiles(input_dirs, file_name_pattern, exclude_list, exclude_dir_list), n_threads,
+                    compression, compression_level)
+{
+}
+
+RootFilesMerger::RootFilesMerger(const std::string& output, const std::vector<std::string>& _input_files,
+                unsigned n_threads, ROOT::ECompressionAlgorithm _compression, int _compression_level) :
+    input_files(_input_files),
+    output_file(root_ext::CreateRootFile(output, _compression, _compression_level)),
+    output_name(output), compression(_compression), compression_level(_compression_level)
 {
     TreeDescriptor::NumberOfFiles() = input_files.size();
     if(n_threads > 1)
         ROOT::EnableImplicitMT(n_threads);
 }
 
-void RootFilesMerger::Process(bool process_histograms, bool process_trees)
+void RootFilesMerger::SetNumberOfHistogramShards(size_t n_shards)
 {
-    for(const auto& file_name : input_files) {
-        std::cout << "file: " << file_name << std::endl;
-        auto file = root_ext::OpenRootFile(file_name);
-        ProcessDirectory(file_name, "", file.get(), objects, process_histograms, process_trees);
-        ProcessFile(file_name, file);
-    }
+    if(!n_shards)
+        throw exception("Number of histogram shards should be positive.");
+    n_hist_shards = n_shards;
+}
 
-    if(process_histograms) {
-        std::cout << "Writing histograms..." << std::endl;
-        {
-            std::map<Key, const HistDescriptor*> ordered_histograms;
-            for(auto& hist_entry : objects.hists) {
-                hist_entry.second.Merge();
-                ordered_histograms[hist_entry.first] = &hist_entry.second;
-            }
+void RootFilesMerger::SetHistogramMemoryLimit(size_t max_bytes) { hist_memory_limit = max_bytes; }
 
-            for(auto& hist_entry : ordered_histograms) {
-                auto dir = root_ext::GetDirectory(*output_file, hist_entry.first.dir_name);
-                root_ext::WriteObject(*hist_entry.second->GetMergedHisto(), dir);
-            }
-            objects.hists.clear();
+void RootFilesMerger::Process(bool process_histograms, bool process_trees)
+{
+    const size_t n_shards = process_histograms && hist_memory_limit ? EstimateNumberOfHistogramShards()
+                                                                    : n_hist_shards;
+    if(process_histograms && n_shards > 1)
+        std::cout << "Histograms will be merged in " << n_shards << " passes." << std::endl;
+
+    for(size_t shard_index = 0; shard_index < n_shards; ++shard_index) {
+        const HistShard hist_shard{shard_index, n_shards};
+        const bool first_pass = shard_index == 0;
+        if(!process_histograms && !first_pass) break;
+        root_ext::FileOpenService file_service(input_files);
+        std::string file_name;
+        std::shared_ptr<TFile> file;
+        while(file_service.Next(file_name, file)) {
+            std::cout << "file: " << file_name << std::endl;
+            ProcessDirectory(file_name, "", file.get(), objects, process_histograms, process_trees && first_pass,
+                             hist_shard);
+            if(first_pass)
+                ProcessFile(file_name, file);
         }
+        // Descriptors only grow while the files of the shard are read, so the usage is reported once per shard,
+        // when it is at its peak, instead of walking all descriptors after each file.
+        UpdateMemoryUsage();
+        if(process_histograms)
+            MergeHistograms();
     }
 
     if(process_trees) {
         std::map<Key, const TreeDescriptor*> ordered_trees;
         for(auto& tree_entry : objects.trees)
             ordered_trees[tree_entry.first] = &tree_entry.second;
-        for(auto& tree : ordered_trees) {
-            std::cout << "tree: " << tree.first.full_name << std::endl;
-            auto dir = root_ext::GetDirectory(*output_file, tree.first.dir_name);
-            Long64_t n_entries = -1;
-            dir->cd();
-            {
-                auto chain = tree.second->CreateChain(tree.first.full_name);
+        if(split_limits.enabled())
+            MergeSplitTrees(ordered_trees);
+        else
+            MergeTrees(ordered_trees);
+    }
+}
+
+void RootFilesMerger::MergeTrees(const std::map<Key, const TreeDescriptor*>& ordered_trees)
+{
+    for(const auto& tree : ordered_trees) {
+        std::cout << "tree: " << tree.first.full_name << std::endl;
+        auto dir = root_ext::GetDirectory(*output_file, tree.first.dir_name);
+        Long64_t n_entries = -1;
+        const TreeFilter* filter = FindTreeFilter(tree.first);
+        dir->cd();
+        {
+            std::unique_ptr<TEntryList> selected_entries;
+            auto chain = tree.second->CreateChain(tree.first.full_name);
+            if(filter && filter->HasEntrySelection()) {
+                selected_entries = SelectEntries(*chain, *filter, 0, chain->GetEntries());
+                chain->SetEntryList(selected_entries.get());
+            }
+            if(filter)
+                filter->Apply(*chain);
+            if(selected_entries) {
+                // The selection is evaluated before the branches are pruned, so it can use the excluded branches.
+                // The selected entries are copied one by one: the kept branches are decompressed and compressed
+                // again, while the pruned branches are not read.
+                std::unique_ptr<TTree> selected_tree(chain->CopyTree(""));
+                if(!selected_tree)
+                    throw exception("Unable to copy the selected entries of '%1%' tree.") % tree.first.full_name;
+                n_entries = selected_tree->GetEntries();
+                dir->WriteTObject(selected_tree.get(), tree.first.name.c_str(), "Overwrite");
+                std::cout << "\tselected " << n_entries << " out of " << chain->GetEntries() << " entries."
+                          << std::endl;
+            } else {
+                // Without the entry selection, the baskets of the kept branches are copied without decompression,
+                // if the inputs are compressed in the same way as the output.
                 n_entries = chain->GetEntries();
-                chain->Merge(output_file.get(), 0, "C keep");
+                const bool copy_baskets = tree.second->compression_settings
+                        == std::set<int>{ output_file->GetCompressionSettings() };
+                chain->Merge(output_file.get(), 0, copy_baskets ? "C keep fast" : "C keep");
             }
-            std::unique_ptr<TTree> merged_tree(root_ext::ReadObject<TTree>(*output_file, tree.first.full_name));
-            if(merged_tree->GetEntries() != n_entries)
-                throw analysis::exception("Not all files were merged for '%1%' tree.") % tree.first.full_name;
+        }
+        std::unique_ptr<TTree> merged_tree(root_ext::ReadObject<TTree>(*output_file, tree.first.full_name));
+        if(merged_tree->GetEntries() != n_entries)
+            throw analysis::exception("Not all files were merged for '%1%' tree.") % tree.first.full_name;
+    }
+}
+
+std::unique_ptr<TEntryList> RootFilesMerger::SelectEntries(TChain& chain, const TreeFilter& filter,
+                                                           Long64_t first_entry, Long64_t n_entries)
+{
+    auto entry_list = std::make_unique<TEntryList>("selected_entries", filter.selection.c_str());
+    entry_list->SetDirectory(nullptr);
+    ForEachSelectedEntry(chain, filter, first_entry, n_entries, [&](Long64_t entry) {
+        entry_list->Enter(entry, &chain);
+    });
+    return entry_list;
+}
+
+void RootFilesMerger::ForEachSelectedEntry(TChain& chain, const TreeFilter& filter, Long64_t first_entry,
+                                           Long64_t n_entries, const std::function<void(Long64_t)>& function)
+{
+    std::unique_ptr<TTreeFormula> selection;
+    if(!filter.selection.empty()) {
+        selection = std::make_unique<TTreeFormula>("selection", filter.selection.c_str(), &chain);
+        if(selection->GetNdim() == 0)
+            throw exception("Invalid selection '%1%'.") % filter.selection;
+    }
+    std::vector<std::unique_ptr<IdColumnReader>> ids;
+    if(!filter.sampler.SelectsAll()) {
+        if(filter.id_columns.size() != 3)
+            throw exception("Sampling requires exactly three event id columns (run, lumi, evt).");
+        for(const auto& column : filter.id_columns) {
+            TBranch* branch = chain.GetBranch(column.c_str());
+            if(!branch)
+                throw exception("Event id column '%1%' not found in '%2%' tree.") % column % chain.GetName();
+            const auto make = IdColumnReaderFactory::FindMakeMethod(*branch);
+            if(!make)
+                throw exception("Event id column '%1%' of '%2%' tree should be a branch with a single fundamental"
+                                " value.") % column % chain.GetName();
+            ids.emplace_back(make(chain, column));
+        }
+    }
+
+    Int_t tree_number = -1;
+    for(Long64_t entry = first_entry; entry < first_entry + n_entries; ++entry) {
+        const Long64_t tree_entry = chain.LoadTree(entry);
+        if(tree_entry < 0) break;
+        if(chain.GetTreeNumber() != tree_number) {
+            tree_number = chain.GetTreeNumber();
+            if(selection)
+                selection->UpdateFormulaLeaves();
+            for(auto& id : ids)
+                id->Update();
+        }
+        // As in TTree::CopyTree, an entry is selected if the selection passes for at least one instance.
+        bool pass = !selection;
+        const Int_t n_data = selection ? selection->GetNdata() : 0;
+        for(Int_t n = 0; n < n_data && !pass; ++n)
+            pass = selection->EvalInstance(n) != 0;
+        if(pass && !ids.empty()) {
+            EventSampler::IdType id_values[3];
+            for(size_t n = 0; n < ids.size(); ++n)
+                id_values[n] = ids.at(n)->Read(tree_entry);
+            pass = filter.sampler.Accept(id_values[0], id_values[1], id_values[2]);
+        }
+        if(pass)
+            function(entry);
+    }
+}
+
+void RootFilesMerger::TreeFilter::Apply(TTree& tree) const
+{
+    if(!include_branches.empty()) {
+        tree.SetBranchStatus("*", 0);
+        for(const auto& branch : include_branches)
+            tree.SetBranchStatus(branch.c_str(), 1);
+    }
+    for(const auto& branch : exclude_branches)
+        tree.SetBranchStatus(branch.c_str(), 0);
+}
+
+void RootFilesMerger::SetTreeFilter(const std::string& tree_name, const TreeFilter& filter)
+{
+    tree_filters[tree_name] = filter;
+}
+
+const RootFilesMerger::TreeFilter* RootFilesMerger::FindTreeFilter(const Key& key) const
+{
+    for(const auto& name : { key.full_name, key.name, std::string() }) {
+        auto iter = tree_filters.find(name);
+        if(iter != tree_filters.end())
+            return iter->second.empty() ? nullptr : &iter->second;
+    }
+    return nullptr;
+}
+
+void RootFilesMerger::SetOutputSplitting(const SplitLimits& limits)
+{
+    if(!limits.n_writers)
+        throw exception("Number of output writers should be positive.");
+    split_limits = limits;
+}
+
+std::string RootFilesMerger::PartFileName(const std::string& output, size_t part_index)
+{
+    if(part_index == 0) return output;
+    const boost::filesystem::path path(output);
+    const std::string name = path.stem().string() + "_" + std::to_string(part_index) + path.extension().string();
+    return (path.parent_path() / name).string();
+}
+
+std::vector<RootFilesMerger::EntryRange> RootFilesMerger::SplitClusters(const std::vector<ClusterInfo>& clusters,
+                                                                        size_t n_parts)
+{
+    if(!n_parts)
+        throw exception("Number of parts should be positive.");
+    double total_size = 0;
+    for(const auto& cluster : clusters)
+        total_size += cluster.size;
+    // If sizes are not known, entries are distributed uniformly.
+    const bool use_size = total_size > 0;
+    const auto weight = [&](const ClusterInfo& cluster) {
+        return use_size ? cluster.size : static_cast<double>(cluster.n_entries);
+    };
+    double total = 0;
+    for(const auto& cluster : clusters)
+        total += weight(cluster);
+
+    std::vector<EntryRange> ranges(n_parts);
+    double cumulative = 0;
+    for(const auto& cluster : clusters) {
+        const double w = weight(cluster);
+        // The cluster goes to the part that contains its middle point.
+        const size_t part = total > 0
+                ? std::min(n_parts - 1, static_cast<size_t>((cumulative + w / 2) * n_parts / total)) : 0;
+        EntryRange& range = ranges.at(part);
+        if(!range.n_entries)
+            range.first_entry = cluster.first_entry;
+        range.n_entries += cluster.n_entries;
+        cumulative += w;
+    }
+    Long64_t end = 0;
+    for(auto& range : ranges) {
+        if(!range.n_entries)
+            range.first_entry = end;
+        end = range.first_entry + range.n_entries;
+    }
+    return ranges;
+}
+
+bool RootFilesMerger::IsPartUsed(const std::vector<EntryRange>& ranges, size_t part_index)
+{
+    if(ranges.at(part_index).n_entries)
+        return true;
+    if(part_index != 0)
+        return false;
+    for(const auto& range : ranges) {
+        if(range.n_entries)
+            return false;
+    }
+    return true;
+}
+
+std::vector<RootFilesMerger::ClusterInfo> RootFilesMerger::CollectClusters(const Key& key, const TreeDescriptor& tree,
+                                                                        const TreeFilter* filter)
+{
+    std::vector<ClusterInfo> clusters;
+    std::vector<double> size_per_entry;
+    Long64_t offset = 0;
+    for(const auto& file_name : tree.file_names) {
+        auto file = root_ext::OpenRootFile(file_name);
+        std::unique_ptr<TTree> file_tree(root_ext::ReadObject<TTree>(*file, key.full_name));
+        const Long64_t n_entries = file_tree->GetEntries();
+        if(!n_entries) continue;
+        if(filter)
+            filter->Apply(*file_tree);
+        Long64_t kept_bytes = 0;
+        TObjArray* branches = file_tree->GetListOfBranches();
+        for(Int_t n = 0; n <= branches->GetLast(); ++n) {
+            auto branch = dynamic_cast<TBranch*>(branches->At(n));
+            if(branch && file_tree->GetBranchStatus(branch->GetName()))
+                kept_bytes += branch->GetZipBytes("*");
+        }
+        const double file_size_per_entry = static_cast<double>(kept_bytes) / n_entries;
+        auto cluster_iter = file_tree->GetClusterIterator(0);
+        for(Long64_t start; (start = cluster_iter.Next()) < n_entries;) {
+            const Long64_t cluster_entries = std::min(cluster_iter.GetNextEntry(), n_entries) - start;
+            clusters.push_back(ClusterInfo{ offset + start, cluster_entries, file_size_per_entry * cluster_entries,
+                                            cluster_entries });
+            size_per_entry.push_back(file_size_per_entry);
+        }
+        offset += n_entries;
+    }
+
+    if(filter && filter->HasEntrySelection() && !clusters.empty()) {
+        // Only the number of the selected entries per cluster is kept, the selection is evaluated again while writing.
+        for(auto& cluster : clusters)
+            cluster.n_selected = 0;
+        size_t cluster_id = 0;
+        auto chain = tree.CreateChain(key.full_name);
+        ForEachSelectedEntry(*chain, *filter, 0, offset, [&](Long64_t entry) {
+            while(entry >= clusters.at(cluster_id).first_entry + clusters.at(cluster_id).n_entries)
+                ++cluster_id;
+            ++clusters.at(cluster_id).n_selected;
+        });
+        for(size_t n = 0; n < clusters.size(); ++n)
+            clusters.at(n).size = size_per_entry.at(n) * clusters.at(n).n_selected;
+    }
+    return clusters;
+}
+
+void RootFilesMerger::MergeSplitTrees(const std::map<Key, const TreeDescriptor*>& ordered_trees)
+{
+    const std::vector<std::pair<Key, const TreeDescriptor*>> trees(ordered_trees.begin(), ordered_trees.end());
+    std::vector<std::vector<ClusterInfo>> tree_clusters;
+    double total_size = 0;
+    Long64_t max_tree_entries = 0;
+    // Clusters of the trees are collected in parallel on the compute executor, if it is available: with the entry
+    // selection the selected entries are counted, which is CPU-bound.
+    const bool use_executors = run::Executors::IsGlobalDefined();
+    ROOT::EnableThreadSafety();
+    std::vector<std::future<std::vector<ClusterInfo>>> cluster_results;
+    for(const auto& tree : trees) {
+        const TreeFilter* filter = FindTreeFilter(tree.first);
+        if(use_executors)
+            cluster_results.push_back(run::async(&RootFilesMerger::CollectClusters, tree.first,
+                                                 std::cref(*tree.second), filter));
+        else
+            tree_clusters.push_back(CollectClusters(tree.first, *tree.second, filter));
+    }
+    for(auto& result : cluster_results)
+        tree_clusters.push_back(result.get());
+    for(const auto& clusters : tree_clusters) {
+        Long64_t n_entries = 0;
+        for(const auto& cluster : clusters) {
+            total_size += cluster.size;
+            n_entries += cluster.n_selected;
+        }
+        max_tree_entries = std::max(max_tree_entries, n_entries);
+    }
+
+    const auto n_parts_for = [](double total, double limit) {
+        return limit > 0 ? static_cast<size_t>(std::ceil(total / limit)) : size_t(1);
+    };
+    const size_t n_parts = std::max({ size_t(1),
+                                      n_parts_for(total_size, static_cast<double>(split_limits.max_size)),
+                                      n_parts_for(static_cast<double>(max_tree_entries),
+                                                  static_cast<double>(split_limits.max_entries)) });
+    std::cout << "Trees will be split into " << n_parts << " output files." << std::endl;
+
+    std::vector<std::vector<EntryRange>> tree_ranges;
+    for(const auto& clusters : tree_clusters)
+        tree_ranges.push_back(SplitClusters(clusters, n_parts));
+
+    std::vector<std::shared_ptr<TFile>> part_files(n_parts);
+    part_files.at(0) = output_file;
+    for(size_t n = 1; n < n_parts; ++n)
+        part_files.at(n) = root_ext::CreateRootFile(PartFileName(output_name, n), compression, compression_level);
+
+    std::vector<std::vector<Long64_t>> n_written(n_parts, std::vector<Long64_t>(trees.size(), 0));
+    {
+        // Parts are written on the I/O executor, if it is available, at most n_writers at the same time.
+        const size_t n_writers = std::max<size_t>(std::min<size_t>(split_limits.n_writers, n_parts), 1);
+        std::unique_ptr<run::ThreadPull> pool;
+        if(!use_executors)
+            pool = std::make_unique<run::ThreadPull>(n_writers, false);
+        std::deque<std::future<void>> results;
+        // Tasks refer to the local variables, so all of them should be finished before an error is reported.
+        std::exception_ptr error;
+        const auto wait_front = [&]() {
+            try {
+                results.front().get();
+            } catch(...) {
+                if(!error)
+                    error = std::current_exception();
+            }
+            results.pop_front();
+        };
+        for(size_t n = 0; n < n_parts; ++n) {
+            if(results.size() >= n_writers)
+                wait_front();
+            if(error) break;
+            const auto write_part = [this, &trees, &tree_ranges, &part_files, &n_written](size_t part_index) {
+                WritePart(trees, tree_ranges, part_index, part_files.at(part_index).get(), n_written.at(part_index));
+            };
+            results.push_back(pool ? pool->run(write_part, n) : run::async_io(write_part, n));
+        }
+        while(!results.empty())
+            wait_front();
+        if(error)
+            std::rethrow_exception(error);
+    }
+    for(size_t n = 1; n < n_parts; ++n)
+        part_files.at(n)->Close();
+
+    const boost::filesystem::path output_path(output_name);
+    const std::string manifest_name = (output_path.parent_path()
+                                       / (output_path.stem().string() + "_manifest.txt")).string();
+    std::ofstream manifest(manifest_name);
+    if(manifest.fail())
+        throw exception("Unable to create manifest '%1%'.") % manifest_name;
+    manifest << "# part file tree first_input_entry n_input_entries n_entries\n";
+    for(size_t n = 0; n < n_parts; ++n) {
+        for(size_t tree_id = 0; tree_id < trees.size(); ++tree_id) {
+            if(!IsPartUsed(tree_ranges.at(tree_id), n)) continue;
+            const EntryRange& range = tree_ranges.at(tree_id).at(n);
+            manifest << n << " " << PartFileName(output_name, n) << " " << trees.at(tree_id).first.full_name << " "
+                     << range.first_entry << " " << range.n_entries << " " << n_written.at(n).at(tree_id) << "\n";
+        }
+    }
+    std::cout << "Manifest: " << manifest_name << std::endl;
+}
+
+void RootFilesMerger::WritePart(const std::vector<std::pair<Key, const TreeDescriptor*>>& trees,
+                                const std::vector<std::vector<EntryRange>>& tree_ranges, size_t part_index,
+                                TFile* file, std::vector<Long64_t>& n_written) const
+{
+    for(size_t tree_id = 0; tree_id < trees.size(); ++tree_id) {
+        const Key& key = trees.at(tree_id).first;
+        const EntryRange& range = tree_ranges.at(tree_id).at(part_index);
+        if(!IsPartUsed(tree_ranges.at(tree_id), part_index))
+            continue;
+        const TreeFilter* filter = FindTreeFilter(key);
+        auto dir = root_ext::GetDirectory(*file, key.dir_name);
+        dir->cd();
+        std::unique_ptr<TEntryList> selected_entries;
+        auto chain = trees.at(tree_id).second->CreateChain(key.full_name);
+        if(range.n_entries && filter && filter->HasEntrySelection()) {
+            selected_entries = SelectEntries(*chain, *filter, range.first_entry, range.n_entries);
+            chain->SetEntryList(selected_entries.get());
+        }
+        if(filter)
+            filter->Apply(*chain);
+        std::unique_ptr<TTree> part_tree;
+        if(!range.n_entries)
+            part_tree.reset(chain->CloneTree(0));
+        else if(selected_entries)
+            part_tree.reset(chain->CopyTree(""));
+        else
+            part_tree.reset(chain->CopyTree("", "", range.n_entries, range.first_entry));
+        if(!part_tree)
+            throw exception("Unable to copy entries of '%1%' tree into part %2%.") % key.full_name % part_index;
+        n_written.at(tree_id) = part_tree->GetEntries();
+        if(!selected_entries && n_written.at(tree_id) != range.n_entries)
+            throw exception("Not all entries were copied for '%1%' tree into part %2%.") % key.full_name
+                % part_index;
+        dir->WriteTObject(part_tree.get(), key.name.c_str(), "Overwrite");
+    }
+}
+
+void RootFilesMerger::MergeHistograms()
+{
+    std::cout << "Writing histograms..." << std::endl;
+    std::map<Key, const HistDescriptor*> ordered_histograms;
+    for(auto& hist_entry : objects.hists) {
+        hist_entry.second.Merge();
+        ordered_histograms[hist_entry.first] = &hist_entry.second;
+    }
+
+    for(auto& hist_entry : ordered_histograms) {
+        auto dir = root_ext::GetDirectory(*output_file, hist_entry.first.dir_name);
+        root_ext::WriteObject(*hist_entry.second->GetMergedHisto(), dir);
+    }
+    objects.hists.clear();
+    UpdateMemoryUsage();
+}
+
+void RootFilesMerger::UpdateMemoryUsage()
+{
+    std::map<std::string, size_t> usage;
+    for(const auto& hist_entry : objects.hists) {
+        size_t& dir_usage = usage[hist_entry.first.dir_name];
+        for(const auto& hist : hist_entry.second.hists) {
+            if(hist)
+                dir_usage += root_ext::EstimateMemoryUsage(*hist);
+        }
+    }
+    for(const auto& tree_entry : objects.trees)
+        usage[tree_entry.first.dir_name] += analysis::EstimateMemoryUsage(tree_entry.second.file_names);
+
+    for(auto& tracker : memory_trackers) {
+        if(!usage.count(tracker.first))
+            tracker.second.Update(0);
+    }
+    for(const auto& dir_usage : usage)
+        memory_trackers.try_emplace(dir_usage.first, "RootFilesMerger", dir_usage.first).first->second
+            .Update(dir_usage.second);
+}
+
+size_t RootFilesMerger::EstimateNumberOfHistogramShards() const
+{
+    // For each key: uncompressed size of the histogram and number of files in which it is present.
+    std::unordered_map<Key, std::pair<size_t, size_t>, KeyHash> hist_sizes;
+    root_ext::FileOpenService file_service(input_files);
+    while(auto file = file_service.Next())
+        CollectHistogramSizes("", file.get(), hist_sizes);
+    size_t total_size = 0;
+    for(const auto& entry : hist_sizes) {
+        const size_t n_live = std::min(entry.second.second, HistDescriptor::MergeThreshold + 1);
+        total_size += entry.second.first * n_live;
+    }
+    const size_t n_shards = std::max<size_t>(1, (total_size + hist_memory_limit - 1) / hist_memory_limit);
+    std::cout << "Estimated memory needed to merge " << hist_sizes.size() << " histograms: "
+              << total_size / (1024. * 1024.) << " MiB." << std::endl;
+    return n_shards;
+}
+
+void RootFilesMerger::CollectHistogramSizes(const std::string& dir_name, TDirectory* dir,
+                                            std::unordered_map<Key, std::pair<size_t, size_t>, KeyHash>& hist_sizes)
+{
+    using ClassInheritance = root_ext::ClassInheritance;
+    TIter nextkey(dir->GetListOfKeys());
+    for(TKey* t_key; (t_key = dynamic_cast<TKey*>(nextkey()));) {
+        const ClassInheritance inheritance = root_ext::FindClassInheritance(t_key->GetClassName());
+        const Key key(dir_name, t_key->GetName());
+        if(inheritance == ClassInheritance::TH1) {
+            auto& entry = hist_sizes[key];
+            entry.first = std::max(entry.first, static_cast<size_t>(t_key->GetObjlen()));
+            ++entry.second;
+        } else if(inheritance == ClassInheritance::TDirectory) {
+            auto subdir = root_ext::ReadObject<TDirectory>(*dir, key.name);
+            CollectHistogramSizes(key.full_name + "/", subdir, hist_sizes);
         }
     }
 }
@@ -160,8 +693,24 @@ std::vector<std::string> RootFilesMerger::FindInputFiles(const std::vector<std::
     return files;
 }
 
+std::vector<std::string> RootFilesMerger::ReadFileList(const std::string& file_list)
+{
+    std::ifstream f(file_list);
+    if(f.fail())
+        throw analysis::exception("Failed to open file '%1%'.") % file_list;
+    std::vector<std::string> files;
+    std::string line;
+    while(std::getline(f, line)) {
+        boost::algorithm::trim(line);
+        if(line.empty() || line.at(0) == '#') continue;
+        files.push_back(line);
+    }
+    return files;
+}
+
 void RootFilesMerger::ProcessDirectory(const std::string& file_name, const std::string& dir_name, TDirectory* dir,
-                             ObjectCollection& objects, bool process_histograms, bool process_trees)
+                             ObjectCollection& objects, bool process_histograms, bool process_trees,
+                             const HistShard& hist_shard)
 {
     using ClassInheritance = root_ext::ClassInheritance;
     TIter nextkey(dir->GetListOfKeys());
@@ -171,7 +720,7 @@ void RootFilesMerger::ProcessDirectory(const std::string& file_name, const std::
 
         switch (inheritance) {
             case ClassInheritance::TH1: {
-                if(process_histograms) {
+                if(process_histograms && hist_shard.Contains(key)) {
                     auto hist = HistPtr(root_ext::ReadObject<TH1>(*dir, key.name));
                     hist->SetDirectory(nullptr);
                     objects.hists[key].AddHistogram(std::move(hist));
@@ -180,13 +729,13 @@ void RootFilesMerger::ProcessDirectory(const std::string& file_name, const std::
             }
             case ClassInheritance::TTree: {
                 if(process_trees) {
-                    objects.trees[key].AddFile(file_name);
+                    objects.trees[key].AddFile(file_name, dir->GetFile()->GetCompressionSettings());
                 }
                 break;
             } case ClassInheritance::TDirectory: {
                 auto subdir = root_ext::ReadObject<TDirectory>(*dir, key.name);
                 ProcessDirectory(file_name, key.full_name + "/", subdir, objects, process_histograms,
-                                 process_trees);
+                                 process_trees, hist_shard);
                 break;
             }
         }
@@ -0,0 +1,198 @@
+/*! Definition of streaming mergeable accumulators for summary statistics.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include "AnalysisTools/Core/include/SummaryStatistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include "AnalysisTools/Core/include/exception.h"
+
+namespace analysis {
+
+void QuantileSketch::Store::Add(int index, uint64_t n)
+{
+    if(counts.empty()) {
+        offset = index;
+        counts.push_back(0);
+    } else if(index < offset) {
+        counts.insert(counts.begin(), static_cast<size_t>(offset - index), 0);
+        offset = index;
+    } else if(index >= offset + static_cast<int>(counts.size())) {
+        counts.resize(static_cast<size_t>(index - offset + 1), 0);
+    }
+    counts[static_cast<size_t>(index - offset)] += n;
+}
+
+void QuantileSketch::Store::Merge(const Store& other)
+{
+    for(size_t n = 0; n < other.counts.size(); ++n) {
+        if(other.counts[n])
+            Add(other.offset + static_cast<int>(n), other.counts[n]);
+    }
+}
+
+QuantileSketch::QuantileSketch(double _relative_accuracy) :
+    relative_accuracy(_relative_accuracy)
+{
+    if(relative_accuracy <= 0 || relative_accuracy >= 1)
+        throw exception("Relative accuracy of the quantile sketch should be within (0, 1) interval.");
+    gamma = (1 + relative_accuracy) / (1 - relative_accuracy);
+    inv_log_gamma = 1. / std::log(gamma);
+}
+
+int QuantileSketch::Index(double abs_x) const
+{
+    return static_cast<int>(std::ceil(std::log(abs_x) * inv_log_gamma));
+}
+
+double QuantileSketch::Value(int index) const
+{
+    return 2 * std::pow(gamma, index) / (gamma + 1);
+}
+
+void QuantileSketch::Add(double x, uint64_t n)
+{
+    static constexpr double min_indexable = std::numeric_limits<double>::min();
+    if(!std::isfinite(x))
+        throw exception("Non-finite value can't be added to the quantile sketch.");
+    if(x > min_indexable)
+        positive.Add(Index(x), n);
+    else if(x < -min_indexable)
+        negative.Add(Index(-x), n);
+    else
+        zero_count += n;
+    count += n;
+}
+
+void QuantileSketch::Merge(const QuantileSketch& other)
+{
+    if(other.gamma != gamma)
+        throw exception("Unable to merge quantile sketches with different accuracy.");
+    positive.Merge(other.positive);
+    negative.Merge(other.negative);
+    zero_count += other.zero_count;
+    count += other.count;
+}
+
+template<typename Function>
+void QuantileSketch::ForEachBucket(Function&& fn) const
+{
+    for(size_t n = negative.counts.size(); n > 0; --n) {
+        const uint64_t bucket_count = negative.counts[n - 1];
+        if(bucket_count)
+            fn(-Value(negative.offset + static_cast<int>(n - 1)), bucket_count);
+    }
+    if(zero_count)
+        fn(0., zero_count);
+    for(size_t n = 0; n < positive.counts.size(); ++n) {
+        const uint64_t bucket_count = positive.counts[n];
+        if(bucket_count)
+            fn(Value(positive.offset + static_cast<int>(n)), bucket_count);
+    }
+}
+
+double QuantileSketch::Quantile(double q) const
+{
+    if(q < 0 || q > 1)
+        throw exception("Quantile value should be within [0, 1] interval.");
+    if(!count)
+        return std::numeric_limits<double>::quiet_NaN();
+    const double rank = q * static_cast<double>(count - 1);
+    double result = std::numeric_limits<double>::quiet_NaN();
+    uint64_t cumulative = 0;
+    bool found = false;
+    ForEachBucket([&](double value, uint64_t bucket_count) {
+        if(found) return;
+        cumulative += bucket_count;
+        if(static_cast<double>(cumulative) > rank) {
+            result = value;
+            found = true;
+        }
+    });
+    return result;
+}
+
+std::vector<uint64_t> QuantileSketch::Histogram(size_t n_bins, double x_min, double x_max) const
+{
+    if(!n_bins)
+        throw exception("Number of histogram bins should be positive.");
+    std::vector<uint64_t> hist(n_bins, 0);
+    if(!(x_max > x_min)) {
+        hist.front() = count;
+        return hist;
+    }
+    const double bin_width = (x_max - x_min) / static_cast<double>(n_bins);
+    ForEachBucket([&](double value, uint64_t bucket_count) {
+        const double clipped = std::min(std::max(value, x_min), x_max);
+        const size_t bin = std::min(static_cast<size_t>((clipped - x_min) / bin_width), n_bins - 1);
+        hist[bin] += bucket_count;
+    });
+    return hist;
+}
+
+SummaryAccumulator::SummaryAccumulator(double relative_accuracy) : sketch(relative_accuracy) {}
+
+void SummaryAccumulator::Add(double x)
+{
+    if(std::isnan(x)) {
+        ++n_nan;
+        return;
+    }
+    if(std::isinf(x)) {
+        if(x > 0) ++n_pos_inf;
+        else ++n_neg_inf;
+        return;
+    }
+    ++n_values;
+    sum += x;
+    const double delta = x - mean;
+    mean += delta / static_cast<double>(n_values);
+    m2 += delta * (x - mean);
+    min = std::min(min, x);
+    max = std::max(max, x);
+    sketch.Add(x);
+}
+
+void SummaryAccumulator::Merge(const SummaryAccumulator& other)
+{
+    n_entries += other.n_entries;
+    n_nan += other.n_nan;
+    n_pos_inf += other.n_pos_inf;
+    n_neg_inf += other.n_neg_inf;
+    if(other.n_values) {
+        const double n_a = static_cast<double>(n_values), n_b = static_cast<double>(other.n_values);
+        const double delta = other.mean - mean;
+        const double n_tot = n_a + n_b;
+        mean += delta * n_b / n_tot;
+        m2 += other.m2 + delta * delta * n_a * n_b / n_tot;
+        n_values += other.n_values;
+        sum += other.sum;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+    }
+    sketch.Merge(other.sketch);
+}
+
+double SummaryAccumulator::Mean() const
+{
+    return n_values ? mean : std::numeric_limits<double>::quiet_NaN();
+}
+
+double SummaryAccumulator::Variance() const
+{
+    return n_values > 1 ? m2 / static_cast<double>(n_values - 1) : std::numeric_limits<double>::quiet_NaN();
+}
+
+double SummaryAccumulator::StdDev() const { return std::sqrt(Variance()); }
+
+double SummaryAccumulator::Min() const
+{
+    return n_values ? min : std::numeric_limits<double>::quiet_NaN();
+}
+
+double SummaryAccumulator::Max() const
+{
+    return n_values ? max : std::numeric_limits<double>::quiet_NaN();
+}
+
+} // namespace analysis
@@ -0,0 +1,83 @@
+/*! Test the constant-time bin look-up for the variable-width binning.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include "AnalysisTools/Core/include/BinLookup.h"
+#include "AnalysisTools/Core/include/exception.h"
+
+#define BOOST_TEST_MODULE BinLookup_t
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using analysis::VariableBinLookup;
+
+namespace {
+// Reference implementation that follows TAxis::FindBin for the variable-width bins.
+int FindBinReference(const std::vector<double>& edges, double x)
+{
+    if(x < edges.front()) return 0;
+    if(!(x < edges.back())) return static_cast<int>(edges.size());
+    return static_cast<int>(std::upper_bound(edges.begin(), edges.end(), x) - edges.begin());
+}
+
+void CheckEdges(const VariableBinLookup& lookup, const std::vector<double>& edges)
+{
+    for(double edge : edges) {
+        for(double x : { edge, std::nextafter(edge, -1e300), std::nextafter(edge, 1e300) })
+            BOOST_TEST_REQUIRE(lookup.FindBin(x) == FindBinReference(edges, x));
+    }
+}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE(mass_binning)
+{
+    const std::vector<double> edges = { 0, 20, 40, 60, 80, 100, 120, 140, 160, 200, 250, 300, 400, 500, 700, 1000,
+                                        1500, 2500 };
+    const VariableBinLookup lookup(edges);
+    BOOST_TEST(lookup.GetNbins() == 17);
+    BOOST_TEST(lookup.FindBin(-1) == 0);
+    BOOST_TEST(lookup.FindBin(0) == 1);
+    BOOST_TEST(lookup.FindBin(199.9) == 9);
+    BOOST_TEST(lookup.FindBin(2500) == 18);
+    BOOST_TEST(lookup.FindBin(std::numeric_limits<double>::quiet_NaN()) == 18);
+    BOOST_TEST(lookup.FindBin(std::numeric_limits<double>::infinity()) == 18);
+    BOOST_TEST(lookup.FindBin(-std::numeric_limits<double>::infinity()) == 0);
+    CheckEdges(lookup, edges);
+
+    std::mt19937_64 gen(1);
+    std::uniform_real_distribution<double> distr(-100, 2600);
+    for(size_t n = 0; n < 100000; ++n) {
+        const double x = distr(gen);
+        BOOST_TEST_REQUIRE(lookup.FindBin(x) == FindBinReference(edges, x));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(irregular_binning)
+{
+    std::mt19937_64 gen(2);
+    std::exponential_distribution<double> width_distr(1.);
+    for(size_t max_grid_size : { size_t(1), size_t(7), VariableBinLookup::DefaultMaxGridSize }) {
+        std::vector<double> edges = { -0.1 };
+        for(size_t n = 0; n < 50; ++n)
+            edges.push_back(edges.back() + width_distr(gen) * 0.01 + 1e-6);
+        const VariableBinLookup lookup(edges, max_grid_size);
+        BOOST_TEST(lookup.GetGridSize() <= max_grid_size);
+        CheckEdges(lookup, edges);
+        std::uniform_real_distribution<double> distr(edges.front() - 0.01, edges.back() + 0.01);
+        for(size_t n = 0; n < 100000; ++n) {
+            const double x = distr(gen);
+            BOOST_TEST_REQUIRE(lookup.FindBin(x) == FindBinReference(edges, x));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(invalid_binning)
+{
+    BOOST_CHECK_THROW(VariableBinLookup({ 1. }), analysis::exception);
+    BOOST_CHECK_THROW(VariableBinLookup({ 0., 1., 1. }), analysis::exception);
+    BOOST_CHECK_THROW(VariableBinLookup({ 0., 2., 1. }), analysis::exception);
+    BOOST_CHECK_THROW(VariableBinLookup({ 0., std::numeric_limits<double>::infinity() }), analysis::exception);
+}
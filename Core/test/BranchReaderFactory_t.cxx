@@ -0,0 +1,76 @@
+/*! Test BranchReaderFactory.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <vector>
+#include <TTree.h>
+#include "AnalysisTools/Core/include/BranchReaderFactory.h"
+
+#define BOOST_TEST_MODULE BranchReaderFactory_t
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace root_ext;
+
+namespace {
+template<typename T>
+struct TestReader {
+    static int Make() { return sizeof(T); }
+};
+
+template<typename T>
+struct TestVectorReader {
+    static int Make() { return -static_cast<int>(sizeof(T)); }
+};
+
+using MakeMethodPtr = int (*)();
+using Factory = BranchReaderFactory<MakeMethodPtr, TestReader, TestVectorReader>;
+using ScalarOnlyFactory = BranchReaderFactory<MakeMethodPtr, TestReader>;
+
+struct TreeFixture {
+    Float_t x{0}, fixed_array[4];
+    Int_t n{0};
+    Double_t var_array[10];
+    Float_t multi[2];
+    std::vector<Short_t> vec;
+    std::vector<Short_t>* vec_ptr{&vec};
+    TTree tree{"tree", ""};
+
+    TreeFixture()
+    {
+        tree.SetDirectory(nullptr);
+        tree.Branch("x", &x, "x/F");
+        tree.Branch("fixed_array", fixed_array, "fixed_array[4]/F");
+        tree.Branch("n", &n, "n/I");
+        tree.Branch("var_array", var_array, "var_array[n]/D");
+        tree.Branch("multi", multi, "a/F:b/F");
+        tree.Branch("vec", &vec_ptr);
+    }
+
+    TBranch& GetBranch(const char* name) { return *tree.GetBranch(name); }
+};
+} // anonymous namespace
+
+BOOST_FIXTURE_TEST_CASE(scalar_branches, TreeFixture)
+{
+    BOOST_TEST((GetBranchValueType(GetBranch("x")).kind == BranchValueKind::Scalar));
+    BOOST_TEST((GetBranchValueType(GetBranch("n")).data_type == kInt_t));
+    BOOST_TEST(Factory::FindMakeMethod(GetBranch("x"))() == static_cast<int>(sizeof(Float_t)));
+    BOOST_TEST(Factory::FindMakeMethod(GetBranch("n"))() == static_cast<int>(sizeof(Int_t)));
+}
+
+BOOST_FIXTURE_TEST_CASE(array_branches, TreeFixture)
+{
+    for(const char* name : { "fixed_array", "var_array", "multi" }) {
+        const BranchValueType value_type = GetBranchValueType(GetBranch(name));
+        BOOST_TEST(!value_type.IsSupported());
+        BOOST_TEST(!value_type.reason.empty());
+        BOOST_TEST(!Factory::FindMakeMethod(GetBranch(name)));
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(vector_branches, TreeFixture)
+{
+    BOOST_TEST((GetBranchValueType(GetBranch("vec")).kind == BranchValueKind::Vector));
+    BOOST_TEST(Factory::FindMakeMethod(GetBranch("vec"))() == -static_cast<int>(sizeof(Short_t)));
+    BOOST_TEST(!ScalarOnlyFactory::FindMakeMethod(GetBranch("vec")));
+}
@@ -0,0 +1,102 @@
+/*! Test DatasetCatalog class.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <fstream>
+#include "AnalysisTools/Core/include/DatasetCatalog.h"
+#include "AnalysisTools/Core/test/TempFiles.h"
+
+#define BOOST_TEST_MODULE DatasetCatalog_t
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using DatasetCatalog = analysis::DatasetCatalog;
+
+namespace {
+struct DatasetFixture {
+    analysis::test::TempFiles temp_files;
+    const std::vector<Long64_t> n_entries = { 25, 7 };
+    std::vector<std::string> files;
+    const std::string index_file = temp_files.Add(".dsct");
+
+    DatasetFixture()
+    {
+        for(Long64_t n_file_entries : n_entries) {
+            files.push_back(temp_files.Add(".root"));
+            analysis::test::WriteTree(files.back(), "Events", [&](TTree& tree) {
+                Double_t weight;
+                Int_t evt;
+                tree.Branch("weight", &weight, "weight/D");
+                tree.Branch("evt", &evt, "evt/I");
+                tree.SetAutoFlush(10);
+                for(Long64_t n = 0; n < n_file_entries; ++n) {
+                    weight = 0.5;
+                    evt = static_cast<Int_t>(n);
+                    tree.Fill();
+                }
+            });
+        }
+    }
+};
+
+void CheckSameFiles(const DatasetCatalog& expected, const DatasetCatalog& catalog)
+{
+    BOOST_TEST_REQUIRE(catalog.GetFiles().size() == expected.GetFiles().size());
+    for(const auto& file_entry : expected.GetFiles()) {
+        const DatasetCatalog::FileInfo& info = catalog.at(file_entry.first);
+        BOOST_TEST(info.path == file_entry.second.path);
+        BOOST_TEST(info.size == file_entry.second.size);
+        BOOST_TEST(info.mtime == file_entry.second.mtime);
+        BOOST_TEST(info.weight_branch == file_entry.second.weight_branch);
+        BOOST_TEST_REQUIRE(info.trees.size() == file_entry.second.trees.size());
+        for(size_t n = 0; n < info.trees.size(); ++n) {
+            const auto& tree = info.trees.at(n);
+            const auto& expected_tree = file_entry.second.trees.at(n);
+            BOOST_TEST(tree.name == expected_tree.name);
+            BOOST_TEST(tree.n_entries == expected_tree.n_entries);
+            BOOST_TEST(tree.has_weights == expected_tree.has_weights);
+            BOOST_TEST(tree.sum_weights == expected_tree.sum_weights);
+            BOOST_TEST(tree.cluster_starts == expected_tree.cluster_starts, boost::test_tools::per_element());
+        }
+    }
+}
+} // anonymous namespace
+
+BOOST_FIXTURE_TEST_CASE(save_and_load, DatasetFixture)
+{
+    DatasetCatalog catalog(index_file);
+    BOOST_TEST(catalog.GetFiles().empty());
+    BOOST_TEST(catalog.Update(files, "weight") == files.size());
+    BOOST_TEST(catalog.TotalEntries("Events") == n_entries.at(0) + n_entries.at(1));
+    BOOST_TEST(catalog.TotalSumOfWeights("Events") == 0.5 * static_cast<double>(n_entries.at(0) + n_entries.at(1)));
+    BOOST_TEST(catalog.at(files.at(0)).FindTree("Events")->cluster_starts.size() > 1u);
+    catalog.Save();
+
+    DatasetCatalog loaded(index_file);
+    CheckSameFiles(catalog, loaded);
+    BOOST_TEST(loaded.Update(files, "weight") == 0u);
+    BOOST_TEST(loaded.Update(files, "") == files.size());
+    BOOST_TEST(loaded.Update({ files.at(1) }, "") == 0u);
+    BOOST_TEST(!loaded.Has(files.at(0)));
+    BOOST_CHECK_THROW(loaded.TotalSumOfWeights("Events"), analysis::exception);
+}
+
+BOOST_FIXTURE_TEST_CASE(plan_splits, DatasetFixture)
+{
+    DatasetCatalog catalog(index_file);
+    catalog.Update(files);
+    const auto ranges = catalog.PlanSplits("Events", 10);
+    Long64_t total = 0;
+    for(const auto& range : ranges) {
+        BOOST_TEST(range.size() > 0);
+        BOOST_TEST(range.size() <= 10);
+        total += range.size();
+    }
+    BOOST_TEST(total == catalog.TotalEntries("Events"));
+    BOOST_CHECK_THROW(catalog.PlanSplits("Events", 0), analysis::exception);
+}
+
+BOOST_FIXTURE_TEST_CASE(invalid_index, DatasetFixture)
+{
+    std::ofstream(index_file) << "not a catalog";
+    BOOST_CHECK_THROW(DatasetCatalog{index_file}, analysis::exception);
+}
@@ -0,0 +1,141 @@
+/*! Test EventCatalog class.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <algorithm>
+#include "AnalysisTools/Core/include/EventCatalog.h"
+#include "AnalysisTools/Core/test/TempFiles.h"
+
+#define BOOST_TEST_MODULE EventCatalog_t
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using EventCatalog = analysis::EventCatalog;
+using EventIdentifier = analysis::EventIdentifier;
+
+namespace {
+// Creates file with events (1, 1, evt) for evt in [first_evt, first_evt + n_events).
+void CreateEventsFile(const std::string& file_name, ULong64_t first_evt, ULong64_t n_events)
+{
+    analysis::test::WriteTree(file_name, "Events", [&](TTree& tree) {
+        UInt_t run = 1, lumi = 1;
+        ULong64_t evt;
+        tree.Branch("run", &run, "run/i");
+        tree.Branch("lumi", &lumi, "lumi/i");
+        tree.Branch("evt", &evt, "evt/l");
+        for(evt = first_evt; evt < first_evt + n_events; ++evt)
+            tree.Fill();
+    });
+}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE(record_packing)
+{
+    const EventIdentifier id(315257, 1234, 9876543210ULL);
+    const auto record = EventCatalog::Record::Make(id, 12345, 1000000);
+    BOOST_TEST(record.Id() == id);
+    BOOST_TEST(record.FileIndex() == 12345u);
+    BOOST_TEST(record.Entry() == 1000000);
+    BOOST_CHECK_THROW(EventCatalog::Record::Make(EventIdentifier(1ULL << 32, 1, 1), 0, 0), analysis::exception);
+    BOOST_CHECK_THROW(EventCatalog::Record::Make(id, EventCatalog::Record::MaxFileIndex + 1, 0), analysis::exception);
+    BOOST_CHECK_THROW(EventCatalog::Record::Make(id, 0, -1), analysis::exception);
+}
+
+BOOST_AUTO_TEST_CASE(write_and_locate)
+{
+    analysis::test::TempFiles temp_files;
+    const std::string catalog_file = temp_files.Add(".evtc");
+    std::vector<EventCatalog::FileEntry> files(3);
+    for(size_t n = 0; n < files.size(); ++n)
+        files.at(n).path = "file_" + std::to_string(n) + ".root";
+    std::vector<EventCatalog::Record> records;
+    for(size_t n = 0; n < 1000; ++n)
+        records.push_back(EventCatalog::Record::Make(EventIdentifier(1 + n % 7, 1 + n % 13, n), n % 3,
+                                                     static_cast<Long64_t>(n / 3)));
+    // the same event stored in two files
+    records.push_back(EventCatalog::Record::Make(EventIdentifier(1, 1, 0), 2, 500));
+    std::sort(records.begin(), records.end());
+    EventCatalog::Write(catalog_file, "Events", EventCatalog::DefaultIdBranches(), files, records);
+
+    {
+        const EventCatalog catalog(catalog_file);
+        BOOST_TEST(catalog.TreeName() == "Events");
+        BOOST_TEST(catalog.IdBranches().size() == 3u);
+        BOOST_TEST(catalog.GetFiles().size() == files.size());
+        BOOST_TEST(catalog.size() == records.size());
+        BOOST_TEST(std::is_sorted(catalog.begin(), catalog.end()));
+
+        const auto found = catalog.Find(EventIdentifier(1 + 500 % 7, 1 + 500 % 13, 500));
+        BOOST_TEST(found.second - found.first == 1);
+        BOOST_TEST(found.first->FileIndex() == 500u % 3);
+        BOOST_TEST(found.first->Entry() == 500 / 3);
+
+        std::vector<EventIdentifier> not_found;
+        const auto matches = catalog.Locate({ EventIdentifier(1, 1, 0), EventIdentifier(2, 2, 1),
+                                              EventIdentifier(2, 2, 3), EventIdentifier(5, 5, 5) }, &not_found);
+        BOOST_TEST(not_found.size() == 2u);
+        BOOST_TEST(matches.size() == 3u);
+        BOOST_TEST(matches.at(0).size() == 1u);
+        BOOST_TEST(matches.at(1).size() == 1u);
+        BOOST_TEST(matches.at(2).size() == 1u);
+        BOOST_TEST(matches.at(2).at(0).entry == 500);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(update)
+{
+    analysis::test::TempFiles temp_files;
+    const std::string catalog_file = temp_files.Add(".evtc");
+    const std::vector<std::string> inputs = { temp_files.Add(), temp_files.Add(), temp_files.Add() };
+    CreateEventsFile(inputs.at(0), 0, 10);
+    CreateEventsFile(inputs.at(1), 100, 10);
+    const std::string& id_branches = EventCatalog::DefaultIdBranches();
+
+    BOOST_TEST(EventCatalog::Update(catalog_file, { inputs.at(0), inputs.at(1) }, "Events", id_branches) == 2u);
+    BOOST_TEST(EventCatalog::Update(catalog_file, { inputs.at(0), inputs.at(1) }, "Events", id_branches) == 0u);
+    EventCatalog::FileEntry unchanged_entry;
+    {
+        const EventCatalog catalog(catalog_file);
+        BOOST_TEST(catalog.size() == 20u);
+        unchanged_entry = catalog.GetFiles().at(0);
+    }
+
+    // The second file is replaced with other events and the third file is added.
+    CreateEventsFile(inputs.at(1), 200, 5);
+    boost::filesystem::last_write_time(inputs.at(1), boost::filesystem::last_write_time(inputs.at(1)) + 10);
+    CreateEventsFile(inputs.at(2), 300, 3);
+    BOOST_TEST(EventCatalog::Update(catalog_file, inputs, "Events", id_branches, 2) == 2u);
+    {
+        const EventCatalog catalog(catalog_file);
+        BOOST_TEST(catalog.size() == 18u);
+        BOOST_TEST(std::is_sorted(catalog.begin(), catalog.end()));
+        BOOST_TEST(catalog.GetFiles().size() == 3u);
+        const EventCatalog::FileEntry& first_entry = catalog.GetFiles().at(0);
+        BOOST_TEST(first_entry.path == unchanged_entry.path);
+        BOOST_TEST(first_entry.size == unchanged_entry.size);
+        BOOST_TEST(first_entry.mtime == unchanged_entry.mtime);
+        BOOST_TEST(first_entry.n_entries == 10);
+
+        std::vector<EventIdentifier> not_found;
+        const auto stale = catalog.Locate({ EventIdentifier(1, 1, 100), EventIdentifier(1, 1, 109) }, &not_found);
+        BOOST_TEST(stale.empty());
+        BOOST_TEST(not_found.size() == 2u);
+
+        for(const auto& file_matches : catalog.Locate({ EventIdentifier(1, 1, 5), EventIdentifier(1, 1, 204),
+                                                        EventIdentifier(1, 1, 300) })) {
+            const EventCatalog::FileEntry& file = catalog.GetFiles().at(file_matches.first);
+            BOOST_TEST(file_matches.second.size() == 1u);
+            const auto& match = file_matches.second.at(0);
+            if(match.id.eventId == 5) {
+                BOOST_TEST(file.path == inputs.at(0));
+                BOOST_TEST(match.entry == 5);
+            } else if(match.id.eventId == 204) {
+                BOOST_TEST(file.path == inputs.at(1));
+                BOOST_TEST(file.n_entries == 5);
+                BOOST_TEST(match.entry == 4);
+            } else {
+                BOOST_TEST(file.path == inputs.at(2));
+                BOOST_TEST(match.entry == 0);
+            }
+        }
+    }
+}
@@ -0,0 +1,99 @@
+/*! Test EventSampler class.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <cmath>
+#include <vector>
+#include "AnalysisTools/Core/include/EventSampler.h"
+
+#define BOOST_TEST_MODULE EventSampler_t
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using EventSampler = analysis::EventSampler;
+using IdType = EventSampler::IdType;
+
+namespace {
+struct Event {
+    IdType run, lumi, evt;
+};
+
+std::vector<Event> MakeEvents(size_t n_events)
+{
+    std::vector<Event> events;
+    for(size_t n = 0; n < n_events; ++n)
+        events.push_back({ 1 + n / 100000, 1 + n / 1000, n });
+    return events;
+}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE(shards_are_disjoint_and_complete)
+{
+    static constexpr size_t n_shards = 7, n_events = 70000;
+    const auto events = MakeEvents(n_events);
+    std::vector<EventSampler> shards;
+    for(size_t k = 0; k < n_shards; ++k)
+        shards.push_back(EventSampler::Shard(k, n_shards, 42));
+    std::vector<size_t> shard_sizes(n_shards, 0);
+    for(const auto& event : events) {
+        size_t n_accepted = 0;
+        for(size_t k = 0; k < n_shards; ++k) {
+            if(shards.at(k)(event)) {
+                ++n_accepted;
+                ++shard_sizes.at(k);
+            }
+        }
+        BOOST_TEST(n_accepted == 1u);
+    }
+    for(size_t size : shard_sizes)
+        BOOST_TEST(std::abs(static_cast<double>(size) / n_events - 1. / n_shards) < 0.01);
+    BOOST_TEST(EventSampler::Shard(0, 1).SelectsAll());
+}
+
+BOOST_AUTO_TEST_CASE(fractions_and_ranges)
+{
+    static constexpr size_t n_events = 100000;
+    const auto events = MakeEvents(n_events);
+    const auto sample = EventSampler::Parse("10%");
+    const auto train = EventSampler::Parse("0:0.8", 3), test = EventSampler::Parse("0.8:1", 3);
+    size_t n_sample = 0, n_train = 0;
+    for(const auto& event : events) {
+        n_sample += sample(event);
+        n_train += train(event);
+        BOOST_TEST(train(event) != test(event));
+    }
+    BOOST_TEST(std::abs(static_cast<double>(n_sample) / n_events - 0.1) < 0.01);
+    BOOST_TEST(std::abs(static_cast<double>(n_train) / n_events - 0.8) < 0.01);
+    BOOST_TEST(EventSampler::Parse("0:1").SelectsAll());
+}
+
+BOOST_AUTO_TEST_CASE(parse_errors)
+{
+    BOOST_CHECK_THROW(EventSampler::Parse("7/7"), analysis::exception);
+    BOOST_CHECK_THROW(EventSampler::Parse("0.5:0.2"), analysis::exception);
+    BOOST_CHECK_THROW(EventSampler::Parse("abc%"), analysis::exception);
+    BOOST_CHECK_THROW(EventSampler::Parse("1/2/3"), analysis::exception);
+    BOOST_TEST(EventSampler::Parse("all").SelectsAll());
+}
+
+BOOST_AUTO_TEST_CASE(column_selection)
+{
+    static constexpr size_t n_events = 1000;
+    std::vector<unsigned> run(n_events, 1), lumi(n_events);
+    std::vector<unsigned long long> evt(n_events);
+    for(size_t n = 0; n < n_events; ++n) {
+        lumi[n] = static_cast<unsigned>(n / 10);
+        evt[n] = n;
+    }
+    const auto sampler = EventSampler::Shard(1, 3);
+    std::vector<uint8_t> mask(n_events);
+    std::vector<size_t> indices(n_events);
+    sampler.Select(run.data(), lumi.data(), evt.data(), n_events, mask.data());
+    const size_t n_selected = sampler.SelectIndices(run.data(), lumi.data(), evt.data(), n_events, indices.data());
+    size_t k = 0;
+    for(size_t n = 0; n < n_events; ++n) {
+        BOOST_TEST(static_cast<bool>(mask[n]) == sampler.Accept(run[n], lumi[n], evt[n]));
+        if(mask[n])
+            BOOST_TEST(indices.at(k++) == n);
+    }
+    BOOST_TEST(k == n_selected);
+}
@@ -0,0 +1,108 @@
+/*! Test file checksums and the checksum cache.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <fstream>
+#include <boost/filesystem.hpp>
+#include "AnalysisTools/Core/include/FileChecksum.h"
+#include "AnalysisTools/Core/include/exception.h"
+#include "AnalysisTools/Core/test/TempFiles.h"
+
+#define BOOST_TEST_MODULE FileChecksum_t
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace analysis;
+
+namespace {
+std::string CreateFile(const std::string& name, const std::string& content)
+{
+    const std::string file_name = test::TempFileName(name);
+    std::ofstream f(file_name, std::ios::binary);
+    f << content;
+    return file_name;
+}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE(known_values)
+{
+    const std::string data = "123456789";
+    Checksum crc(ChecksumType::CRC32), adler(ChecksumType::Adler32);
+    crc.Process(data.data(), data.size());
+    adler.Process(data.data(), data.size());
+    BOOST_TEST(crc.Value() == 0xCBF43926u);
+    BOOST_TEST(adler.Value() == 0x091E01DEu);
+    BOOST_TEST(Checksum::ToString(0x1234) == "00001234");
+}
+
+BOOST_AUTO_TEST_CASE(streaming)
+{
+    std::string data(100000, '\0');
+    for(size_t n = 0; n < data.size(); ++n)
+        data[n] = static_cast<char>((n * 7919) % 251);
+    for(auto type : { ChecksumType::CRC32, ChecksumType::Adler32, ChecksumType::XXH64 }) {
+        Checksum full(type), chunked(type);
+        full.Process(data.data(), data.size());
+        for(size_t pos = 0; pos < data.size(); pos += 777)
+            chunked.Process(data.data() + pos, std::min<size_t>(777, data.size() - pos));
+        BOOST_TEST(full.Value() == chunked.Value());
+        const std::string file = CreateFile("data.bin", data);
+        BOOST_TEST(ComputeFileChecksum(file, type, 1000) == full.Value());
+        boost::filesystem::remove(file);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(cache)
+{
+    const std::string file = CreateFile("data.txt", "123456789");
+    const std::string cache_file = CreateFile("cache.txt", "");
+    boost::filesystem::remove(cache_file);
+    {
+        ChecksumCache cache(cache_file);
+        BOOST_TEST(cache.size() == 0u);
+        BOOST_TEST(cache.Get(file, ChecksumType::CRC32) == 0xCBF43926u);
+        cache.Save();
+    }
+    {
+        ChecksumCache cache(cache_file);
+        uint64_t checksum = 0;
+        BOOST_TEST(cache.Find(file, ChecksumType::CRC32, checksum));
+        BOOST_TEST(checksum == 0xCBF43926u);
+        BOOST_TEST(!cache.Find(file, ChecksumType::Adler32, checksum));
+        {
+            std::ofstream f(file, std::ios::app);
+            f << "0";
+        }
+        BOOST_TEST(!cache.Find(file, ChecksumType::CRC32, checksum));
+    }
+    boost::filesystem::remove(file);
+    boost::filesystem::remove(cache_file);
+}
+
+BOOST_AUTO_TEST_CASE(xxh64)
+{
+    Checksum empty(ChecksumType::XXH64), abc(ChecksumType::XXH64);
+    abc.Process("abc", 3);
+    BOOST_TEST(empty.Value() == 0xEF46DB3751D8E999u);
+    BOOST_TEST(abc.Value() == 0x44BC2CF5AD770999u);
+    BOOST_TEST(Checksum::ToString(abc.Value(), ChecksumType::XXH64) == "44bc2cf5ad770999");
+}
+
+BOOST_AUTO_TEST_CASE(combine)
+{
+    std::string data(300000, '\0');
+    for(size_t n = 0; n < data.size(); ++n)
+        data[n] = static_cast<char>((n * 104729) % 253);
+    for(auto type : { ChecksumType::CRC32, ChecksumType::Adler32 }) {
+        BOOST_TEST(Checksum::IsCombinable(type));
+        Checksum full(type);
+        full.Process(data.data(), data.size());
+        for(size_t split : { size_t(0), size_t(1), size_t(65521), size_t(123456), data.size() }) {
+            Checksum first(type), second(type);
+            first.Process(data.data(), split);
+            second.Process(data.data() + split, data.size() - split);
+            BOOST_TEST(Checksum::Combine(type, first.Value(), second.Value(), data.size() - split) == full.Value());
+        }
+    }
+    BOOST_TEST(!Checksum::IsCombinable(ChecksumType::XXH64));
+    BOOST_CHECK_THROW(Checksum::Combine(ChecksumType::XXH64, 0, 0, 1), analysis::exception);
+}
@@ -0,0 +1,152 @@
+/*! Test the asynchronous file-open service.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include "AnalysisTools/Core/include/FileOpenService.h"
+#include "AnalysisTools/Core/include/exception.h"
+#include "AnalysisTools/Run/include/MultiThread.h"
+
+#define BOOST_TEST_MODULE FileOpenService_t
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using root_ext::FileOpenService;
+
+namespace {
+// Emulates opening of a file: the open takes some time and fails n_failures times before it succeeds.
+class TestOpener {
+public:
+    explicit TestOpener(const std::map<std::string, unsigned>& _n_failures = {}) : n_failures(_n_failures) {}
+
+    FileOpenService::FilePtr operator()(const std::string& file_name)
+    {
+        const size_t n = ++n_active;
+        size_t current_max = max_active;
+        while(n > current_max && !max_active.compare_exchange_weak(current_max, n)) {}
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        --n_active;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++n_calls[file_name];
+            auto iter = n_failures.find(file_name);
+            if(iter != n_failures.end() && iter->second > 0) {
+                --iter->second;
+                throw analysis::exception("Unable to open '%1%'.") % file_name;
+            }
+        }
+        auto file = std::make_shared<TFile>();
+        file->SetName(file_name.c_str());
+        return file;
+    }
+
+    std::atomic<size_t> n_active{0}, max_active{0};
+    std::map<std::string, unsigned> n_failures, n_calls;
+    std::mutex mutex;
+};
+
+std::vector<std::string> MakeFileNames(size_t n)
+{
+    std::vector<std::string> names;
+    for(size_t k = 0; k < n; ++k)
+        names.push_back("file_" + std::to_string(k) + ".root");
+    return names;
+}
+
+FileOpenService::Config MakeConfig(size_t n_ahead)
+{
+    FileOpenService::Config config;
+    config.n_ahead = n_ahead;
+    config.initial_backoff = 0.001;
+    config.max_backoff = 0.01;
+    return config;
+}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE(input_order)
+{
+    const auto names = MakeFileNames(20);
+    for(size_t n_ahead : { 0, 1, 4, 30 }) {
+        TestOpener opener;
+        FileOpenService service(names, MakeConfig(n_ahead), std::ref(opener));
+        std::string name;
+        FileOpenService::FilePtr file;
+        for(const auto& expected_name : names) {
+            BOOST_TEST_REQUIRE(service.Next(name, file));
+            BOOST_TEST(name == expected_name);
+            BOOST_TEST(file->GetName() == expected_name);
+        }
+        BOOST_TEST(!service.Next(name, file));
+        BOOST_TEST(!service.Next());
+        BOOST_TEST(service.GetNumberOfConsumedFiles() == names.size());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(concurrency_limit)
+{
+    const auto names = MakeFileNames(30);
+    const size_t default_limit = FileOpenService::GetMaxConcurrentOpens();
+    FileOpenService::SetMaxConcurrentOpens(2);
+    TestOpener opener;
+    {
+        FileOpenService service_a(names, MakeConfig(8), std::ref(opener));
+        FileOpenService service_b(names, MakeConfig(8), std::ref(opener));
+        while(service_a.Next() && service_b.Next()) {}
+    }
+    BOOST_TEST(opener.max_active <= 2u);
+    FileOpenService::SetMaxConcurrentOpens(default_limit);
+    BOOST_CHECK_THROW(FileOpenService::SetMaxConcurrentOpens(0), analysis::exception);
+}
+
+BOOST_AUTO_TEST_CASE(retries)
+{
+    const auto names = MakeFileNames(3);
+    TestOpener opener({ { names.at(1), 2 }, { names.at(2), 5 } });
+    FileOpenService service(names, MakeConfig(2), std::ref(opener));
+    BOOST_TEST(service.Next()->GetName() == names.at(0));
+    BOOST_TEST(service.Next()->GetName() == names.at(1));
+    BOOST_CHECK_THROW(service.Next(), analysis::exception);
+    BOOST_TEST(opener.n_calls.at(names.at(1)) == 3u);
+    BOOST_TEST(opener.n_calls.at(names.at(2)) == 3u);
+    BOOST_TEST(!service.Next());
+}
+
+BOOST_AUTO_TEST_CASE(missing_local_file)
+{
+    FileOpenService::Config config = MakeConfig(1);
+    config.initial_backoff = 60;
+    FileOpenService service({ "/nonexistent_FileOpenService_t/file.root" }, config);
+    const auto start = std::chrono::steady_clock::now();
+    BOOST_CHECK_THROW(service.Next(), analysis::exception);
+    BOOST_TEST((std::chrono::steady_clock::now() - start < std::chrono::seconds(10)));
+}
+
+BOOST_AUTO_TEST_CASE(global_io_executor)
+{
+    const auto names = MakeFileNames(10);
+    run::Executors executors(run::Executors::Config(3, 1));
+    TestOpener opener;
+    std::set<std::thread::id> open_threads;
+    std::mutex threads_mutex;
+    const auto tracking_opener = [&](const std::string& file_name) {
+        {
+            std::lock_guard<std::mutex> lock(threads_mutex);
+            open_threads.insert(std::this_thread::get_id());
+        }
+        return opener(file_name);
+    };
+    {
+        FileOpenService service(names, MakeConfig(4), tracking_opener);
+        for(const auto& expected_name : names)
+            BOOST_TEST(service.Next()->GetName() == expected_name);
+        // The service is destroyed with the opens in flight.
+        FileOpenService abandoned(names, MakeConfig(4), tracking_opener);
+        abandoned.Next();
+    }
+    BOOST_TEST(open_threads.size() <= 3u);
+    BOOST_TEST(!open_threads.count(std::this_thread::get_id()));
+}
@@ -0,0 +1,126 @@
+/*! Test MemoryAccounting and MemoryTracker classes and the memory usage reported by AnalyzerData.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <cstdlib>
+#include <sstream>
+#include "AnalysisTools/Core/include/AnalyzerData.h"
+#include "AnalysisTools/Core/include/MemoryAccounting.h"
+
+#define BOOST_TEST_MODULE MemoryAccounting_t
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace analysis;
+
+struct AccountingFixture {
+    AccountingFixture() { MemoryAccounting::Global().clear(); }
+    ~AccountingFixture() { MemoryAccounting::Global().clear(); }
+};
+
+struct ValuesData : public root_ext::AnalyzerData {
+    ValuesData() { values.SetMasterHist(); }
+
+    ANA_DATA_ENTRY(double, values)
+};
+
+BOOST_FIXTURE_TEST_CASE(aggregation_and_peaks, AccountingFixture)
+{
+    auto& accounting = MemoryAccounting::Global();
+    BOOST_TEST(accounting.empty());
+    {
+        MemoryTracker a("AnalyzerData", "out.root:/dir1"), b("AnalyzerData", "out.root:/dir1");
+        MemoryTracker c("AnalyzerData", "out.root:/dir2"), d("SmartTree", "out.root:/");
+        a.Update(100);
+        b.Update(50);
+        c.Add(30);
+        c.Add(20);
+        d.Update(1000);
+        BOOST_TEST(accounting.GetUsage("AnalyzerData", "out.root:/dir1").current == 150u);
+        BOOST_TEST(accounting.GetUsage("AnalyzerData", "out.root:/dir2").current == 50u);
+        BOOST_TEST(accounting.GetComponentUsage("AnalyzerData").current == 200u);
+        BOOST_TEST(accounting.GetTotalUsage().current == 1200u);
+
+        a.Update(10);
+        BOOST_TEST(accounting.GetUsage("AnalyzerData", "out.root:/dir1").current == 60u);
+        BOOST_TEST(accounting.GetUsage("AnalyzerData", "out.root:/dir1").peak == 150u);
+        BOOST_TEST(accounting.GetComponentUsage("AnalyzerData").peak == 200u);
+        BOOST_TEST(accounting.GetUsageByComponent().size() == 2u);
+        BOOST_TEST(accounting.GetUsageByDirectory().size() == 3u);
+    }
+    BOOST_TEST(accounting.GetTotalUsage().current == 0u);
+    BOOST_TEST(accounting.GetTotalUsage().peak == 1200u);
+    BOOST_TEST(accounting.GetComponentUsage("SmartTree").peak == 1000u);
+    BOOST_TEST(accounting.GetUsage("Unknown", "").peak == 0u);
+}
+
+BOOST_FIXTURE_TEST_CASE(tracker_directory, AccountingFixture)
+{
+    auto& accounting = MemoryAccounting::Global();
+    MemoryTracker tracker("RootFilesMerger");
+    tracker.Update(64);
+    BOOST_TEST(accounting.GetUsage("RootFilesMerger", "").current == 64u);
+    tracker.SetDirectory("hists/");
+    BOOST_TEST(accounting.GetUsage("RootFilesMerger", "").current == 0u);
+    BOOST_TEST(accounting.GetUsage("RootFilesMerger", "hists/").current == 64u);
+    BOOST_TEST(accounting.GetComponentUsage("RootFilesMerger").current == 64u);
+    BOOST_TEST(accounting.GetComponentUsage("RootFilesMerger").peak == 64u);
+    BOOST_TEST(tracker.GetDirectory() == "hists/");
+    BOOST_TEST(tracker.GetCurrent() == 64u);
+}
+
+BOOST_FIXTURE_TEST_CASE(summary, AccountingFixture)
+{
+    MemoryTracker tracker("EventSync", "group/events");
+    tracker.Update(3 * 1024 * 1024);
+    std::ostringstream ss;
+    MemoryAccounting::Global().PrintSummary(ss);
+    const std::string summary = ss.str();
+    BOOST_TEST(summary.find("EventSync") != std::string::npos);
+    BOOST_TEST(summary.find("  group/events") != std::string::npos);
+    BOOST_TEST(summary.find("3.0") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(container_estimates)
+{
+    std::vector<double> v;
+    v.reserve(10);
+    BOOST_TEST(EstimateMemoryUsage(v) == 10 * sizeof(double));
+
+    std::map<int, double> m = { { 1, 1. }, { 2, 2. } };
+    BOOST_TEST(EstimateMemoryUsage(m) >= 2 * sizeof(std::pair<const int, double>));
+
+    std::unordered_map<int, double> um = { { 1, 1. }, { 2, 2. } };
+    BOOST_TEST(EstimateMemoryUsage(um) >= 2 * sizeof(std::pair<const int, double>) + um.bucket_count() * sizeof(void*));
+}
+
+BOOST_AUTO_TEST_CASE(summary_request)
+{
+    unsetenv("ANALYSIS_TOOLS_MEMORY_SUMMARY");
+    BOOST_TEST(!MemoryAccounting::IsSummaryRequested());
+    setenv("ANALYSIS_TOOLS_MEMORY_SUMMARY", "0", 1);
+    BOOST_TEST(!MemoryAccounting::IsSummaryRequested());
+    setenv("ANALYSIS_TOOLS_MEMORY_SUMMARY", "1", 1);
+    BOOST_TEST(MemoryAccounting::IsSummaryRequested());
+    unsetenv("ANALYSIS_TOOLS_MEMORY_SUMMARY");
+}
+
+BOOST_FIXTURE_TEST_CASE(analyzer_data_growth, AccountingFixture)
+{
+    auto& accounting = MemoryAccounting::Global();
+    size_t final_usage;
+    {
+        ValuesData data;
+        data.values().Fill(0);
+        const size_t initial_usage = accounting.GetComponentUsage("AnalyzerData").current;
+        for(size_t n = 0; n < root_ext::AnalyzerData::MemoryUpdateInterval; ++n)
+            data.values().Fill(static_cast<double>(n));
+        // The histogram is filled after its creation, so the usage is updated by the periodic check.
+        BOOST_TEST(accounting.GetComponentUsage("AnalyzerData").current > initial_usage);
+        data.values().Fill(1);
+        final_usage = data.GetMemoryUsage();
+        BOOST_TEST(final_usage == (root_ext::AnalyzerData::MemoryUpdateInterval + 2) * sizeof(double));
+    }
+    // The usage is updated before the destruction, so the peak includes all values.
+    BOOST_TEST(accounting.GetComponentUsage("AnalyzerData").current == 0u);
+    BOOST_TEST(accounting.GetComponentUsage("AnalyzerData").peak == final_usage);
+}
@@ -0,0 +1,96 @@
+/*! Test MergePlanner class.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <fstream>
+#include <set>
+#include <boost/filesystem.hpp>
+#include "AnalysisTools/Core/include/MergePlanner.h"
+#include "AnalysisTools/Core/include/exception.h"
+
+#define BOOST_TEST_MODULE MergePlanner_t
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using MergePlanner = analysis::MergePlanner;
+
+namespace {
+std::vector<MergePlanner::Input> MakeInputs(size_t n_inputs)
+{
+    std::vector<MergePlanner::Input> inputs;
+    for(size_t n = 0; n < n_inputs; ++n)
+        inputs.push_back({ "input_" + std::to_string(n) + ".root", 100 + (n * 37) % 900, Long64_t(1000 + n % 5) });
+    return inputs;
+}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE(balanced_partition)
+{
+    const auto inputs = MakeInputs(1000);
+    MergePlanner::Limits limits;
+    limits.max_files = 50;
+    limits.max_size = 20000;
+    const auto groups = MergePlanner::Partition(inputs, limits);
+    uint64_t total_size = 0;
+    for(const auto& input : inputs)
+        total_size += input.size;
+    BOOST_TEST(groups.size() == std::max<size_t>(20, (total_size + limits.max_size - 1) / limits.max_size));
+
+    std::set<size_t> assigned;
+    uint64_t min_size = std::numeric_limits<uint64_t>::max(), max_size = 0;
+    for(const auto& group : groups) {
+        BOOST_TEST(group.size() <= limits.max_files);
+        uint64_t group_size = 0;
+        for(size_t input_id : group) {
+            BOOST_TEST(assigned.insert(input_id).second);
+            group_size += inputs.at(input_id).size;
+        }
+        min_size = std::min(min_size, group_size);
+        max_size = std::max(max_size, group_size);
+    }
+    BOOST_TEST(assigned.size() == inputs.size());
+    BOOST_TEST(max_size - min_size <= 1000u);
+}
+
+BOOST_AUTO_TEST_CASE(reduction_tree)
+{
+    const auto inputs = MakeInputs(1000);
+    MergePlanner::Limits limits;
+    limits.max_files = 10;
+    const MergePlanner planner(limits, "work", "output.root");
+    const auto levels = planner.Plan(inputs);
+    BOOST_TEST(levels.size() == 3u);
+    BOOST_TEST(levels.at(0).size() == 100u);
+    BOOST_TEST(levels.at(1).size() == 10u);
+    BOOST_TEST(levels.at(2).size() == 1u);
+    BOOST_TEST(levels.back().front().output == "output.root");
+    BOOST_TEST(levels.back().front().n_entries == [&]() {
+        Long64_t total = 0;
+        for(const auto& input : inputs)
+            total += input.n_entries;
+        return total;
+    }());
+    std::set<std::string> level_outputs;
+    for(const auto& task : levels.at(0))
+        level_outputs.insert(task.output);
+    for(const auto& task : levels.at(1)) {
+        for(const auto& input : task.inputs)
+            BOOST_TEST(level_outputs.count(input) == 1u);
+    }
+
+    BOOST_TEST(planner.Plan(MakeInputs(3)).size() == 1u);
+    BOOST_CHECK_THROW(MergePlanner(MergePlanner::Limits{ 1, 0, 0 }, "work", "output.root"), analysis::exception);
+}
+
+BOOST_AUTO_TEST_CASE(checksum_file)
+{
+    const std::string path = (boost::filesystem::temp_directory_path()
+                              / boost::filesystem::unique_path("%%%%-%%%%-%%%%.root")).string();
+    std::ofstream(path) << "merge output";
+    BOOST_CHECK_THROW(MergePlanner::VerifyChecksum(path), analysis::exception);
+    BOOST_TEST(MergePlanner::WriteChecksum(path) == MergePlanner::FileChecksum(path));
+    BOOST_CHECK_NO_THROW(MergePlanner::VerifyChecksum(path));
+    std::ofstream(path, std::ios::app) << " modified";
+    BOOST_CHECK_THROW(MergePlanner::VerifyChecksum(path), analysis::exception);
+    boost::filesystem::remove(path);
+    boost::filesystem::remove(MergePlanner::ChecksumFileName(path));
+}
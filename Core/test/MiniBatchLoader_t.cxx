@@ -0,0 +1,159 @@
+/*! Test the shuffle buffer and the mini-batch loader.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <algorithm>
+#include "AnalysisTools/Core/include/MiniBatchLoader.h"
+#include "AnalysisTools/Core/include/exception.h"
+#include "AnalysisTools/Core/test/TempFiles.h"
+
+#define BOOST_TEST_MODULE MiniBatchLoader_t
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace analysis;
+
+namespace {
+// Passes events (i, -i) for i = 0..n_events-1 through the buffer and returns the first feature of the output events.
+std::vector<float> Shuffle(size_t capacity, size_t n_events, uint64_t seed)
+{
+    ShuffleBuffer buffer(capacity, 2, seed);
+    std::vector<float> result;
+    float output[2];
+    for(size_t n = 0; n < n_events; ++n) {
+        const float event[2] = { static_cast<float>(n), -static_cast<float>(n) };
+        if(buffer.Push(event, output)) {
+            BOOST_TEST(output[1] == -output[0]);
+            result.push_back(output[0]);
+        }
+    }
+    BOOST_TEST(buffer.size() == std::min(capacity, n_events));
+    while(buffer.Pop(output)) {
+        BOOST_TEST(output[1] == -output[0]);
+        result.push_back(output[0]);
+    }
+    return result;
+}
+
+// Input files with event n of file k stored as x = 100 * k + n, y = -x and v = { x } for the even n.
+struct InputFilesFixture {
+    static constexpr size_t NumberOfFiles = 3, NumberOfFileEvents = 95;
+    test::TempFiles temp_files;
+    std::vector<std::string> files;
+
+    InputFilesFixture()
+    {
+        for(size_t k = 0; k < NumberOfFiles; ++k) {
+            files.push_back(temp_files.Add());
+            test::WriteTree(files.back(), "events", [&](TTree& tree) {
+                Float_t x;
+                Int_t y;
+                std::vector<float> v;
+                std::vector<float>* v_ptr = &v;
+                tree.Branch("x", &x, "x/F");
+                tree.Branch("y", &y, "y/I");
+                tree.Branch("v", &v_ptr);
+                tree.SetAutoFlush(10);
+                for(size_t n = 0; n < NumberOfFileEvents; ++n) {
+                    x = static_cast<Float_t>(100 * k + n);
+                    y = -static_cast<Int_t>(x);
+                    v = n % 2 ? std::vector<float>() : std::vector<float>{ x };
+                    tree.Fill();
+                }
+            });
+        }
+    }
+
+    MiniBatchLoader::Config MakeConfig(size_t n_threads) const
+    {
+        MiniBatchLoader::Config config;
+        config.files = files;
+        config.tree_name = "events";
+        config.features = { "x", "y", "v[0]" };
+        config.batch_size = 16;
+        config.shuffle_buffer_size = 30;
+        config.seed = 42;
+        config.n_threads = n_threads;
+        config.prefetch_size = 2;
+        config.chunk_size = 20;
+        config.default_value = -1;
+        return config;
+    }
+};
+
+std::vector<MiniBatch> ReadEpoch(MiniBatchLoader& loader, size_t epoch)
+{
+    std::vector<MiniBatch> batches;
+    loader.StartEpoch(epoch);
+    MiniBatch batch;
+    while(loader.Next(batch))
+        batches.push_back(batch);
+    return batches;
+}
+
+std::vector<float> FirstFeature(const std::vector<MiniBatch>& batches)
+{
+    std::vector<float> values;
+    for(const auto& batch : batches) {
+        for(size_t n = 0; n < batch.size(); ++n)
+            values.push_back(batch[n][0]);
+    }
+    return values;
+}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE(shuffle_buffer)
+{
+    const auto first = Shuffle(10, 100, 1);
+    BOOST_TEST(first.size() == 100u);
+    auto sorted = first;
+    std::sort(sorted.begin(), sorted.end());
+    for(size_t n = 0; n < sorted.size(); ++n)
+        BOOST_TEST(sorted.at(n) == static_cast<float>(n));
+    BOOST_TEST(!std::is_sorted(first.begin(), first.end()));
+
+    BOOST_TEST(Shuffle(10, 100, 1) == first, boost::test_tools::per_element());
+    BOOST_TEST(Shuffle(10, 100, 2) != first);
+    BOOST_TEST(Shuffle(200, 100, 1).size() == 100u);
+    BOOST_CHECK_THROW(ShuffleBuffer(0, 2, 1), exception);
+}
+
+BOOST_AUTO_TEST_CASE(mini_batch)
+{
+    MiniBatch batch;
+    BOOST_TEST(batch.size() == 0u);
+    batch.n_features = 3;
+    batch.values = { 1, 2, 3, 4, 5, 6 };
+    BOOST_TEST(batch.size() == 2u);
+    BOOST_TEST(batch[1][0] == 4.f);
+    BOOST_TEST(batch[1][2] == 6.f);
+}
+
+BOOST_FIXTURE_TEST_CASE(reproducible_batch_order, InputFilesFixture)
+{
+    MiniBatchLoader loader(MakeConfig(3));
+    BOOST_TEST(loader.GetNumberOfEvents() == static_cast<Long64_t>(NumberOfFiles * NumberOfFileEvents));
+    BOOST_TEST(loader.GetChunks().size() == NumberOfFiles * 5);
+
+    const auto batches = ReadEpoch(loader, 0);
+    const std::vector<float> first = FirstFeature(batches);
+    BOOST_TEST_REQUIRE(first.size() == NumberOfFiles * NumberOfFileEvents);
+    for(const auto& batch : batches) {
+        BOOST_TEST(batch.n_features == 3u);
+        for(size_t n = 0; n < batch.size(); ++n) {
+            BOOST_TEST(batch[n][1] == -batch[n][0]);
+            const bool even = static_cast<size_t>(batch[n][0]) % 2 == 0;
+            BOOST_TEST(batch[n][2] == (even ? batch[n][0] : -1.f));
+        }
+    }
+    auto sorted = first;
+    std::sort(sorted.begin(), sorted.end());
+    for(size_t n = 0; n < sorted.size(); ++n)
+        BOOST_TEST(sorted.at(n) == static_cast<float>(100 * (n / NumberOfFileEvents) + n % NumberOfFileEvents));
+    BOOST_TEST(!std::is_sorted(first.begin(), first.end()));
+
+    // The same seed gives the same order in another run, independently of the number of threads.
+    MiniBatchLoader other_run(MakeConfig(1));
+    BOOST_TEST(FirstFeature(ReadEpoch(other_run, 0)) == first, boost::test_tools::per_element());
+    BOOST_TEST(FirstFeature(ReadEpoch(loader, 0)) == first, boost::test_tools::per_element());
+    BOOST_TEST(FirstFeature(ReadEpoch(loader, 1)) != first);
+}
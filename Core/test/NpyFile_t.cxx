@@ -0,0 +1,76 @@
+/*! Test writer and memory-mapped reader of the .npy files.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <boost/filesystem.hpp>
+#include "AnalysisTools/Core/include/NpyFile.h"
+#include "AnalysisTools/Core/test/TempFiles.h"
+
+#define BOOST_TEST_MODULE NpyFile_t
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace analysis;
+
+BOOST_AUTO_TEST_CASE(header)
+{
+    const std::string header_v1 = std::string("\x93NUMPY\x01\x00\x46\x00", 10)
+            + "{'descr': '<f8', 'fortran_order': False, 'shape': (3, 4), }                                   \n";
+    const NpyHeader header = NpyHeader::Parse(header_v1.data(), header_v1.size(), "test");
+    BOOST_TEST(header.descr == "<f8");
+    BOOST_TEST(!header.fortran_order);
+    BOOST_TEST(header.shape == std::vector<size_t>({ 3, 4 }), boost::test_tools::per_element());
+    BOOST_TEST(header.NumberOfElements() == 12u);
+    BOOST_TEST(header.data_offset == 80u);
+    BOOST_CHECK_THROW(NpyHeader::Parse("NUMPY", 5, "test"), exception);
+}
+
+BOOST_AUTO_TEST_CASE(write_and_map)
+{
+    test::TempFiles temp_files;
+    const std::string file_name = temp_files.Add("values.npy");
+    {
+        auto writer = NpyWriter::Create<float>(file_name);
+        for(int n = 0; n < 1000; ++n)
+            writer->Append(n * 0.5f);
+        BOOST_TEST(writer->size() == 1000u);
+    }
+    {
+        MappedNpyFile file(file_name);
+        BOOST_TEST(file.GetHeader().descr == "<f4");
+        BOOST_TEST(file.GetHeader().data_offset % NpyHeader::Alignment == 0u);
+        BOOST_TEST(file.size() == 1000u);
+        const auto values = file.View<float>();
+        BOOST_TEST(values.size() == 1000u);
+        BOOST_TEST(values[0] == 0.f);
+        BOOST_TEST(values[999] == 499.5f);
+        BOOST_CHECK_THROW(values.at(1000), exception);
+        BOOST_CHECK_THROW(file.View<double>(), exception);
+    }
+    BOOST_TEST(boost::filesystem::file_size(file_name) == MappedNpyFile(file_name).GetHeader().data_offset + 4000);
+}
+
+BOOST_AUTO_TEST_CASE(jagged_column)
+{
+    test::TempFiles temp_files;
+    const std::string file_name = temp_files.Add("jet_pt.npy");
+    temp_files.Track(NpyOffsetsFileName(file_name));
+    BOOST_TEST(NpyOffsetsFileName("dir/jet_pt.npy") == "dir/jet_pt.offsets.npy");
+    {
+        auto values = NpyWriter::Create<int>(file_name);
+        auto offsets = NpyWriter::Create<uint64_t>(NpyOffsetsFileName(file_name));
+        const std::vector<std::vector<int>> rows = { { 1, 2 }, {}, { 3 } };
+        offsets->Append(uint64_t(0));
+        for(const auto& row : rows) {
+            for(int value : row)
+                values->Append(value);
+            offsets->Append(static_cast<uint64_t>(values->size()));
+        }
+    }
+    MappedJaggedColumn<int> column(file_name);
+    BOOST_TEST(column.size() == 3u);
+    BOOST_TEST(column[0].size() == 2u);
+    BOOST_TEST(column[0][1] == 2);
+    BOOST_TEST(column[1].empty());
+    BOOST_TEST(column[2][0] == 3);
+    BOOST_CHECK_THROW(MappedJaggedColumn<float>{file_name}, exception);
+}
@@ -0,0 +1,156 @@
+/*! Test splitting and sampling of the merged trees in RootFilesMerger.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <algorithm>
+#include "AnalysisTools/Core/include/RootFilesMerger.h"
+#include "AnalysisTools/Core/test/TempFiles.h"
+
+#define BOOST_TEST_MODULE RootFilesMerger_t
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using RootFilesMerger = analysis::RootFilesMerger;
+
+namespace {
+std::vector<RootFilesMerger::ClusterInfo> MakeClusters(size_t n_clusters, Long64_t cluster_entries, double size)
+{
+    std::vector<RootFilesMerger::ClusterInfo> clusters;
+    for(size_t n = 0; n < n_clusters; ++n)
+        clusters.push_back({ Long64_t(n) * cluster_entries, cluster_entries, size, cluster_entries });
+    return clusters;
+}
+
+void CheckContiguous(const std::vector<RootFilesMerger::EntryRange>& ranges, Long64_t n_entries)
+{
+    Long64_t end = 0;
+    for(const auto& range : ranges) {
+        BOOST_TEST(range.first_entry == end);
+        end = range.first_entry + range.n_entries;
+    }
+    BOOST_TEST(end == n_entries);
+}
+
+// Merges the input with the given filter and returns the ids of the merged events.
+std::vector<ULong64_t> MergeEvents(const std::string& input, const RootFilesMerger::TreeFilter& filter)
+{
+    analysis::test::TempFiles temp_files;
+    const std::string output = temp_files.Add();
+    {
+        RootFilesMerger merger(output, { input }, 1, ROOT::kZLIB, 1);
+        merger.SetTreeFilter("events", filter);
+        merger.Process(false, true);
+    }
+    std::vector<ULong64_t> ids;
+    {
+        auto file = root_ext::OpenRootFile(output);
+        std::unique_ptr<TTree> tree(root_ext::ReadObject<TTree>(*file, "events"));
+        ULong64_t evt;
+        tree->SetBranchAddress("evt", &evt);
+        for(Long64_t entry = 0; entry < tree->GetEntries(); ++entry) {
+            tree->GetEntry(entry);
+            ids.push_back(evt);
+        }
+    }
+    return ids;
+}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE(uniform_clusters)
+{
+    const auto ranges = RootFilesMerger::SplitClusters(MakeClusters(100, 1000, 1.), 4);
+    BOOST_TEST(ranges.size() == 4u);
+    CheckContiguous(ranges, 100000);
+    for(const auto& range : ranges)
+        BOOST_TEST(range.n_entries == 25000);
+}
+
+BOOST_AUTO_TEST_CASE(cluster_alignment)
+{
+    auto clusters = MakeClusters(10, 1000, 1.);
+    clusters.at(9).n_entries = 10;
+    clusters.at(9).size = 0.01;
+    const auto ranges = RootFilesMerger::SplitClusters(clusters, 3);
+    CheckContiguous(ranges, 9010);
+    for(const auto& range : ranges) {
+        BOOST_TEST(range.first_entry % 1000 == 0);
+        BOOST_TEST(range.n_entries >= 3000);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(more_parts_than_clusters)
+{
+    const auto ranges = RootFilesMerger::SplitClusters(MakeClusters(2, 500, 0.), 5);
+    BOOST_TEST(ranges.size() == 5u);
+    CheckContiguous(ranges, 1000);
+    size_t n_non_empty = 0;
+    for(const auto& range : ranges)
+        n_non_empty += range.n_entries > 0;
+    BOOST_TEST(n_non_empty == 2u);
+}
+
+BOOST_AUTO_TEST_CASE(used_parts)
+{
+    const auto ranges = RootFilesMerger::SplitClusters(MakeClusters(2, 500, 1.), 5);
+    size_t n_used = 0;
+    for(size_t n = 0; n < ranges.size(); ++n) {
+        BOOST_TEST(RootFilesMerger::IsPartUsed(ranges, n) == (ranges.at(n).n_entries > 0));
+        n_used += RootFilesMerger::IsPartUsed(ranges, n);
+    }
+    BOOST_TEST(n_used == 2u);
+
+    // A tree without entries is kept only in the first part.
+    const auto empty_ranges = RootFilesMerger::SplitClusters({}, 3);
+    BOOST_TEST(RootFilesMerger::IsPartUsed(empty_ranges, 0));
+    BOOST_TEST(!RootFilesMerger::IsPartUsed(empty_ranges, 1));
+    BOOST_TEST(!RootFilesMerger::IsPartUsed(empty_ranges, 2));
+}
+
+BOOST_AUTO_TEST_CASE(part_file_names)
+{
+    BOOST_TEST(RootFilesMerger::PartFileName("out/merged.root", 0) == "out/merged.root");
+    BOOST_TEST(RootFilesMerger::PartFileName("out/merged.root", 2) == "out/merged_2.root");
+    BOOST_TEST(RootFilesMerger::PartFileName("merged.root", 1) == "merged_1.root");
+}
+
+BOOST_AUTO_TEST_CASE(sampling)
+{
+    analysis::test::TempFiles temp_files;
+    const std::string input = temp_files.Add();
+    const ULong64_t n_events = 1000, first_evt = (1ULL << 63) + 1;
+    const analysis::EventSampler first_sampler = analysis::EventSampler::FractionRange(0, 0.5, 3);
+    analysis::test::WriteTree(input, "events", [&](TTree& tree) {
+        UInt_t run = 1, lumi = 2, idx;
+        ULong64_t evt;
+        tree.Branch("run", &run, "run/i");
+        tree.Branch("lumi", &lumi, "lumi/i");
+        tree.Branch("evt", &evt, "evt/l");
+        tree.Branch("idx", &idx, "idx/i");
+        for(idx = 0; idx < n_events; ++idx) {
+            evt = first_evt + idx;
+            tree.Fill();
+        }
+    });
+
+    // Event ids above 2^63 are passed to the sampler without a loss of precision.
+    RootFilesMerger::TreeFilter filter;
+    filter.sampler = first_sampler;
+    const auto first = MergeEvents(input, filter);
+    filter.sampler = analysis::EventSampler::FractionRange(0.5, 1, 3);
+    const auto second = MergeEvents(input, filter);
+    BOOST_TEST(first.size() + second.size() == n_events);
+    size_t n_expected = 0;
+    for(ULong64_t n = 0; n < n_events; ++n) {
+        if(first_sampler.Accept(1, 2, first_evt + n))
+            ++n_expected;
+    }
+    BOOST_TEST(first.size() == n_expected);
+    for(ULong64_t evt : first)
+        BOOST_TEST(first_sampler.Accept(1, 2, evt));
+
+    // The sample is combined with the selection.
+    filter.selection = "idx % 2 == 0";
+    for(ULong64_t evt : MergeEvents(input, filter)) {
+        BOOST_TEST((evt - first_evt) % 2 == 0u);
+        BOOST_TEST(std::count(second.begin(), second.end(), evt) == 1);
+    }
+}
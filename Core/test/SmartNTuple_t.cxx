@@ -0,0 +1,121 @@
+/*! Test RNTuple storage backend of SmartTree and conversion between the TTree and the RNTuple formats.
+The tests run only if AnalysisTools is built with the RNTuple support (ROOT 6.32 or newer).
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include "AnalysisTools/Core/include/RNTupleConversion.h"
+#include "AnalysisTools/Core/include/RootExt.h"
+#include "AnalysisTools/Core/include/SmartTree.h"
+#include "AnalysisTools/Core/test/TempFiles.h"
+
+#define BOOST_TEST_MODULE SmartNTuple_t
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#ifdef ANALYSIS_TOOLS_HAS_RNTUPLE
+
+#define TEST_DATA() \
+    VAR(UInt_t, run) \
+    VAR(ULong64_t, evt) \
+    VAR(Float_t, pt) \
+    VAR(Double_t, weight) \
+    VAR(Bool_t, pass) \
+    VAR(std::vector<float>, jet_pt) \
+    /**/
+
+#define VAR(type, name) DECLARE_BRANCH_VARIABLE(type, name)
+DECLARE_TREE(test, Event, EventTree, TEST_DATA, "events")
+#undef VAR
+
+#define VAR(type, name) ADD_DATA_TREE_BRANCH(name)
+INITIALIZE_TREE(test, EventTree, TEST_DATA)
+#undef VAR
+#undef TEST_DATA
+
+namespace {
+constexpr unsigned NumberOfEvents = 20;
+constexpr Long64_t NumberOfEntries = NumberOfEvents;
+
+void FillEvent(test::Event& event, unsigned n)
+{
+    event.run = n % 3;
+    event.evt = (1ULL << 40) + n;
+    event.pt = 1.5f * static_cast<float>(n);
+    event.weight = 0.25 * static_cast<double>(n);
+    event.pass = n % 2 == 0;
+    event.jet_pt = std::vector<float>(n % 4, static_cast<float>(n));
+}
+
+template<typename Tree>
+void Write(const std::string& file_name)
+{
+    auto file = root_ext::CreateRootFile(file_name);
+    Tree tree(file.get(), false);
+    for(unsigned n = 0; n < NumberOfEvents; ++n) {
+        FillEvent(tree(), n);
+        tree.Fill();
+    }
+    tree.Write();
+}
+
+template<typename Tree>
+void Check(const std::string& file_name)
+{
+    auto file = root_ext::OpenRootFile(file_name);
+    Tree tree(file.get(), true);
+    BOOST_TEST_REQUIRE(tree.GetEntries() == NumberOfEntries);
+    test::Event expected;
+    for(unsigned n = 0; n < NumberOfEvents; ++n) {
+        tree.GetEntry(n);
+        FillEvent(expected, n);
+        BOOST_TEST(tree().run == expected.run);
+        BOOST_TEST(tree().evt == expected.evt);
+        BOOST_TEST(tree().pt == expected.pt);
+        BOOST_TEST(tree().weight == expected.weight);
+        BOOST_TEST(tree().pass == expected.pass);
+        BOOST_TEST(tree().jet_pt == expected.jet_pt, boost::test_tools::per_element());
+    }
+}
+
+struct FilesFixture {
+    analysis::test::TempFiles temp_files;
+    const std::string tree_file = temp_files.Add(), ntuple_file = temp_files.Add(), converted_file = temp_files.Add();
+};
+} // anonymous namespace
+
+BOOST_FIXTURE_TEST_CASE(ntuple_write_and_read, FilesFixture)
+{
+    Write<test::EventTreeNTuple>(ntuple_file);
+    Check<test::EventTreeNTuple>(ntuple_file);
+}
+
+BOOST_FIXTURE_TEST_CASE(no_fill_after_write, FilesFixture)
+{
+    auto file = root_ext::CreateRootFile(ntuple_file);
+    test::EventTreeNTuple ntuple(file.get(), false);
+    ntuple.Fill();
+    ntuple.Write();
+    BOOST_CHECK_THROW(ntuple.Fill(), std::runtime_error);
+}
+
+BOOST_FIXTURE_TEST_CASE(convert_tree_to_ntuple_and_back, FilesFixture)
+{
+    Write<test::EventTree>(tree_file);
+    BOOST_TEST(root_ext::ConvertTreeToNTuple(tree_file, "events", ntuple_file, ROOT::kZSTD, 5) == NumberOfEntries);
+    Check<test::EventTreeNTuple>(ntuple_file);
+
+    {
+        auto input = root_ext::OpenRootFile(ntuple_file);
+        auto output = root_ext::CreateRootFile(converted_file);
+        BOOST_TEST(root_ext::ConvertNTupleToTree(*input, *output, "events") == NumberOfEntries);
+    }
+    Check<test::EventTree>(converted_file);
+}
+
+#else
+
+BOOST_AUTO_TEST_CASE(rntuple_not_available)
+{
+    BOOST_TEST_MESSAGE("RNTuple support is not available in this build.");
+}
+
+#endif
@@ -0,0 +1,111 @@
+/*! Test delta-encoded variation trees of SmartTree and SmartTreeVariations.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include "AnalysisTools/Core/include/RootExt.h"
+#include "AnalysisTools/Core/include/SmartTreeVariations.h"
+#include "AnalysisTools/Core/test/TempFiles.h"
+
+#define BOOST_TEST_MODULE SmartTreeVariations_t
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#define TEST_DATA() \
+    VAR(UInt_t, run) \
+    VAR(Float_t, pt) \
+    VAR(std::vector<float>, jet_pt) \
+    /**/
+
+#define VAR(type, name) DECLARE_BRANCH_VARIABLE(type, name)
+DECLARE_TREE(test, Event, EventTree, TEST_DATA, "events")
+#undef VAR
+
+#define VAR(type, name) ADD_DATA_TREE_BRANCH(name)
+INITIALIZE_TREE(test, EventTree, TEST_DATA)
+#undef VAR
+#undef TEST_DATA
+
+namespace {
+constexpr unsigned NumberOfEvents = 5;
+
+float NominalPt(unsigned n) { return 10.f * static_cast<float>(n); }
+float VariedPt(unsigned n) { return 11.f * static_cast<float>(n); }
+
+struct VariationFileFixture {
+    analysis::test::TempFiles temp_files;
+    const std::string file_name = temp_files.Add();
+    std::shared_ptr<TFile> file;
+
+    VariationFileFixture()
+    {
+        {
+            auto output = root_ext::CreateRootFile(file_name);
+            test::EventTree nominal(output.get(), false);
+            test::EventTree varied("events_up", output.get(), false, {}, { "pt" });
+            varied.SetReferenceTree(nominal.Name());
+            for(unsigned n = 0; n < NumberOfEvents; ++n) {
+                nominal().run = n;
+                nominal().pt = NominalPt(n);
+                nominal().jet_pt = std::vector<float>(n, 1.f);
+                nominal.Fill();
+                varied().pt = VariedPt(n);
+                varied.Fill();
+            }
+            nominal.Write();
+            varied.Write();
+        }
+        file = root_ext::OpenRootFile(file_name);
+    }
+};
+
+void CheckVariedTree(test::EventTree& tree)
+{
+    BOOST_TEST(tree.GetReferenceTreeName() == "events");
+    BOOST_TEST(tree.GetEntries() == NumberOfEvents);
+    for(unsigned n = 0; n < NumberOfEvents; ++n) {
+        tree.GetEntry(n);
+        BOOST_TEST(tree().run == n);
+        BOOST_TEST(tree().pt == VariedPt(n));
+        BOOST_TEST(tree().jet_pt.size() == n);
+    }
+}
+} // anonymous namespace
+
+BOOST_FIXTURE_TEST_CASE(read_variation_with_reference, VariationFileFixture)
+{
+    test::EventTree varied("events_up", file.get(), true);
+    CheckVariedTree(varied);
+}
+
+BOOST_FIXTURE_TEST_CASE(reference_not_shared_with_nominal, VariationFileFixture)
+{
+    auto nominal = std::make_unique<test::EventTree>(file.get(), true);
+    test::EventTree varied("events_up", file.get(), true);
+    for(unsigned n = 0; n < NumberOfEvents; ++n) {
+        nominal->GetEntry(n);
+        BOOST_TEST((*nominal)().pt == NominalPt(n));
+    }
+    // The nominal reader deletes its tree from the directory, which should not affect the reference of the variation.
+    nominal.reset();
+    CheckVariedTree(varied);
+}
+
+BOOST_FIXTURE_TEST_CASE(move_variation, VariationFileFixture)
+{
+    test::EventTree varied("events_up", file.get(), true);
+    test::EventTree moved(std::move(varied));
+    CheckVariedTree(moved);
+}
+
+BOOST_FIXTURE_TEST_CASE(read_all_variations, VariationFileFixture)
+{
+    root_ext::SmartTreeVariations<test::EventTree> variations(file.get(), "events", { "events_up" });
+    BOOST_TEST(variations.size() == 1u);
+    BOOST_TEST(variations.GetEntries() == NumberOfEvents);
+    for(unsigned n = 0; n < NumberOfEvents; ++n) {
+        variations.GetEntry(n);
+        BOOST_TEST(variations.GetNominal().pt == NominalPt(n));
+        BOOST_TEST(variations.GetVariation("events_up").run == n);
+        BOOST_TEST(variations.GetVariation("events_up").pt == VariedPt(n));
+        BOOST_TEST(variations.GetVariation(0).jet_pt.size() == n);
+    }
+}
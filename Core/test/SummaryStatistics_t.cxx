@@ -0,0 +1,73 @@
+/*! Test SummaryAccumulator and QuantileSketch classes.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include "AnalysisTools/Core/include/SummaryStatistics.h"
+
+#define BOOST_TEST_MODULE SummaryStatistics_t
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using SummaryAccumulator = analysis::SummaryAccumulator;
+
+BOOST_AUTO_TEST_CASE(moments_and_extremes)
+{
+    static constexpr double inf = std::numeric_limits<double>::infinity();
+    SummaryAccumulator acc;
+    for(double x : { 1., 2., 3., 4., std::nan(""), inf, -inf, -inf })
+        acc.Add(x);
+    BOOST_TEST(acc.NumberOfValues() == 4u);
+    BOOST_TEST(acc.NumberOfNaN() == 1u);
+    BOOST_TEST(acc.NumberOfPositiveInf() == 1u);
+    BOOST_TEST(acc.NumberOfNegativeInf() == 2u);
+    BOOST_TEST(acc.Sum() == 10.);
+    BOOST_TEST(acc.Mean() == 2.5);
+    BOOST_TEST(std::abs(acc.Variance() - 5. / 3.) < 1e-12);
+    BOOST_TEST(acc.Min() == 1.);
+    BOOST_TEST(acc.Max() == 4.);
+}
+
+BOOST_AUTO_TEST_CASE(merge_is_equivalent_to_single_pass)
+{
+    std::mt19937_64 gen(42);
+    std::normal_distribution<double> dist(3., 2.);
+    SummaryAccumulator all, part_a, part_b;
+    for(size_t n = 0; n < 10000; ++n) {
+        const double x = dist(gen);
+        all.Add(x);
+        (n % 3 ? part_a : part_b).Add(x);
+    }
+    part_a.Merge(part_b);
+    BOOST_TEST(part_a.NumberOfValues() == all.NumberOfValues());
+    BOOST_TEST(std::abs(part_a.Mean() - all.Mean()) < 1e-12);
+    BOOST_TEST(std::abs(part_a.StdDev() - all.StdDev()) < 1e-12);
+    BOOST_TEST(part_a.Min() == all.Min());
+    BOOST_TEST(part_a.Max() == all.Max());
+    for(double q : { 0.01, 0.5, 0.99 })
+        BOOST_TEST(part_a.Sketch().Quantile(q) == all.Sketch().Quantile(q));
+}
+
+BOOST_AUTO_TEST_CASE(quantile_relative_accuracy)
+{
+    static constexpr double accuracy = 0.01;
+    analysis::QuantileSketch sketch(accuracy);
+    std::vector<double> values;
+    std::mt19937_64 gen(1);
+    std::lognormal_distribution<double> dist(0., 1.);
+    for(size_t n = 0; n < 20001; ++n) {
+        values.push_back(n % 2 ? dist(gen) : -dist(gen));
+        sketch.Add(values.back());
+    }
+    std::sort(values.begin(), values.end());
+    for(double q : { 0.05, 0.25, 0.5, 0.75, 0.95 }) {
+        const double exact = values.at(static_cast<size_t>(q * static_cast<double>(values.size() - 1)));
+        BOOST_TEST(std::abs(sketch.Quantile(q) - exact) <= accuracy * std::abs(exact) * (1 + 1e-9));
+    }
+    const auto hist = sketch.Histogram(10, values.front(), values.back());
+    uint64_t total = 0;
+    for(uint64_t count : hist)
+        total += count;
+    BOOST_TEST(total == values.size());
+}
@@ -0,0 +1,65 @@
+/*! Definition of temporary files used by the tests.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <TTree.h>
+#include "AnalysisTools/Core/include/RootExt.h"
+
+namespace analysis {
+namespace test {
+
+// Returns a unique name of a file in the temporary directory that ends with the given suffix.
+inline std::string TempFileName(const std::string& suffix = ".root")
+{
+    return (boost::filesystem::temp_directory_path()
+            / boost::filesystem::unique_path("%%%%-%%%%-%%%%-" + suffix)).string();
+}
+
+// Temporary files that are removed when the collection goes out of scope.
+class TempFiles {
+public:
+    TempFiles() {}
+    TempFiles(const TempFiles&) = delete;
+    TempFiles& operator=(const TempFiles&) = delete;
+
+    ~TempFiles()
+    {
+        for(const auto& file_name : file_names) {
+            boost::system::error_code ec;
+            boost::filesystem::remove(file_name, ec);
+        }
+    }
+
+    // Returns a new unique file name, the file will be removed with the collection.
+    std::string Add(const std::string& suffix = ".root")
+    {
+        file_names.push_back(TempFileName(suffix));
+        return file_names.back();
+    }
+
+    // Removes the file with the given name with the collection.
+    void Track(const std::string& file_name) { file_names.push_back(file_name); }
+
+private:
+    std::vector<std::string> file_names;
+};
+
+// Creates a ROOT file with a single tree. The function defines branches of the tree and fills it. Branch addresses
+// are reset before the tree is written, so they can point to the local variables of the function.
+inline void WriteTree(const std::string& file_name, const std::string& tree_name,
+                      const std::function<void(TTree&)>& fill)
+{
+    auto file = root_ext::CreateRootFile(file_name);
+    TTree tree(tree_name.c_str(), "");
+    fill(tree);
+    tree.ResetBranchAddresses();
+    tree.Write();
+}
+
+} // namespace test
+} // namespace analysis
@@ -0,0 +1,114 @@
+/*! Test columnar representation of the tree data classes.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include "AnalysisTools/Core/include/SmartTree.h"
+
+#define BOOST_TEST_MODULE TreeColumns_t
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#define TEST_DATA() \
+    VAR(UInt_t, run) \
+    VAR(Float_t, pt) \
+    VAR(Bool_t, flag) \
+    VAR(std::vector<float>, jet_pt) \
+    /**/
+
+#define VAR(type, name) DECLARE_BRANCH_VARIABLE(type, name)
+DECLARE_TREE(test, Event, EventTree, TEST_DATA, "events")
+#undef VAR
+
+#define VAR(type, name) ADD_DATA_TREE_BRANCH(name)
+INITIALIZE_TREE(test, EventTree, TEST_DATA)
+#undef VAR
+#undef TEST_DATA
+
+namespace {
+test::Event MakeEvent(unsigned n)
+{
+    test::Event event;
+    event.run = n;
+    event.pt = 10.f * n;
+    event.flag = n % 2 == 0;
+    for(unsigned k = 0; k < n % 3; ++k)
+        event.jet_pt.push_back(n + 0.5f * k);
+    return event;
+}
+
+// Minimal tree interface used by the columns to read entries.
+struct MemoryTree {
+    test::EventVector events;
+    test::Event current;
+
+    Long64_t GetEntries() const { return static_cast<Long64_t>(events.size()); }
+    void GetEntry(Long64_t entry) { current = events.at(static_cast<size_t>(entry)); }
+    const test::Event& operator()() const { return current; }
+};
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE(push_back)
+{
+    test::EventColumns columns;
+    BOOST_TEST(columns.GetColumnNames() == std::vector<std::string>({ "run", "pt", "flag", "jet_pt" }),
+               boost::test_tools::per_element());
+    for(unsigned n = 0; n < 5; ++n)
+        columns.push_back(MakeEvent(n));
+
+    BOOST_TEST(columns.size() == 5u);
+    const auto& run = columns.get<UInt_t>("run");
+    const auto& pt = columns.get<Float_t>("pt");
+    const auto& flag = columns.get<Bool_t>("flag");
+    const auto& jet_pt = columns.get<std::vector<float>>("jet_pt");
+    BOOST_TEST(run == std::vector<UInt_t>({ 0, 1, 2, 3, 4 }), boost::test_tools::per_element());
+    BOOST_TEST(pt.at(3) == 30.f);
+    BOOST_TEST(flag == std::vector<char>({ 1, 0, 1, 0, 1 }), boost::test_tools::per_element());
+
+    BOOST_TEST(jet_pt.size() == 5u);
+    BOOST_TEST(jet_pt.GetOffsets() == std::vector<size_t>({ 0, 0, 1, 3, 3, 4 }), boost::test_tools::per_element());
+    BOOST_TEST(jet_pt.GetValues() == std::vector<float>({ 1.f, 2.f, 2.5f, 4.f }), boost::test_tools::per_element());
+    BOOST_TEST(jet_pt.at(0).empty());
+    BOOST_TEST(jet_pt.at(2).size() == 2u);
+    BOOST_TEST(jet_pt.at(2)[1] == 2.5f);
+    BOOST_CHECK_THROW(jet_pt.at(5), std::out_of_range);
+
+    BOOST_CHECK_THROW(columns.get<Float_t>("missing"), std::runtime_error);
+    BOOST_CHECK_THROW(columns.get<Double_t>("pt"), std::runtime_error);
+
+    columns.clear();
+    BOOST_TEST(columns.empty());
+    BOOST_TEST(columns.get<std::vector<float>>("jet_pt").GetOffsets().size() == 1u);
+}
+
+BOOST_AUTO_TEST_CASE(enabled_branches)
+{
+    test::EventColumns columns({}, { "pt", "jet_pt" });
+    BOOST_TEST(columns.GetColumnNames() == std::vector<std::string>({ "pt", "jet_pt" }),
+               boost::test_tools::per_element());
+    BOOST_TEST(!columns.HasColumn("run"));
+    columns.push_back(MakeEvent(2));
+    BOOST_TEST(columns.get<Float_t>("pt").at(0) == 20.f);
+}
+
+BOOST_AUTO_TEST_CASE(batches)
+{
+    MemoryTree tree;
+    for(unsigned n = 0; n < 10; ++n)
+        tree.events.push_back(MakeEvent(n));
+
+    test::EventColumns columns;
+    BOOST_TEST(columns.Fill(tree, 8, 5) == 2u);
+    BOOST_TEST(columns.get<UInt_t>("run") == std::vector<UInt_t>({ 8, 9 }), boost::test_tools::per_element());
+
+    std::vector<Long64_t> first_entries;
+    std::vector<size_t> batch_sizes;
+    UInt_t run_sum = 0;
+    root_ext::ForEachBatch(tree, columns, 4, [&](const test::EventColumns& batch, Long64_t first_entry) {
+        first_entries.push_back(first_entry);
+        batch_sizes.push_back(batch.size());
+        for(UInt_t run : batch.get<UInt_t>("run"))
+            run_sum += run;
+    });
+    BOOST_TEST(first_entries == std::vector<Long64_t>({ 0, 4, 8 }), boost::test_tools::per_element());
+    BOOST_TEST(batch_sizes == std::vector<size_t>({ 4, 4, 2 }), boost::test_tools::per_element());
+    BOOST_TEST(run_sum == 45u);
+}
@@ -0,0 +1,76 @@
+/*! Test flat_map_vec class.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <string>
+#include "AnalysisTools/Core/include/flat_map_vec.h"
+
+#define BOOST_TEST_MODULE flat_map_vec_t
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using analysis::flat_map_vec;
+
+BOOST_AUTO_TEST_CASE(insertion_order)
+{
+    flat_map_vec<std::string, int> m;
+    BOOST_TEST(m.empty());
+    BOOST_TEST(!m.count("a"));
+    BOOST_TEST((m.find("a") == m.end()));
+    m["c"] = 1;
+    m["a"] = 2;
+    BOOST_TEST(m.insert({ "b", 3 }).second);
+    BOOST_TEST(!m.insert({ "a", 4 }).second);
+    m["c"] += 10;
+
+    BOOST_TEST(m.size() == 3u);
+    BOOST_TEST(m.at("a") == 2);
+    BOOST_TEST(m.find("c")->second == 11);
+    BOOST_CHECK_THROW(m.at("d"), std::out_of_range);
+
+    const std::vector<std::string> expected_keys = { "c", "a", "b" };
+    std::vector<std::string> keys;
+    for(const auto& item : m.get_ordered_by_insertion())
+        keys.push_back(item.first);
+    BOOST_TEST(keys == expected_keys, boost::test_tools::per_element());
+
+    m.clear();
+    BOOST_TEST(m.empty());
+    BOOST_TEST(!m.count("c"));
+    m["x"] = 5;
+    BOOST_TEST(m.begin()->first == "x");
+}
+
+BOOST_AUTO_TEST_CASE(colliding_hashes)
+{
+    // All keys share the same hash, so they are located only by the linear probing.
+    struct ConstantHash {
+        size_t operator()(int) const { return 42; }
+    };
+    flat_map_vec<int, int, ConstantHash> m;
+    for(int k = 0; k < 100; ++k)
+        m[k] = -k;
+    BOOST_TEST(m.size() == 100u);
+    for(int k = 0; k < 100; ++k)
+        BOOST_TEST_REQUIRE(m.at(k) == -k);
+    BOOST_TEST(!m.count(100));
+}
+
+BOOST_AUTO_TEST_CASE(growth)
+{
+    flat_map_vec<int, int> m;
+    const int n = 10000;
+    for(int k = 0; k < n; ++k)
+        m[k * 1024] = k;
+    BOOST_TEST(m.size() == static_cast<size_t>(n));
+    for(int k = 0; k < n; ++k) {
+        BOOST_TEST_REQUIRE(m.count(k * 1024) == 1u);
+        BOOST_TEST_REQUIRE(m.at(k * 1024) == k);
+        BOOST_TEST_REQUIRE(m.get_ordered_by_insertion().at(static_cast<size_t>(k)).second == k);
+    }
+    BOOST_TEST(!m.count(1));
+
+    flat_map_vec<int, int> reserved(n);
+    for(int k = 0; k < n; ++k)
+        reserved.insert({ -k, k });
+    BOOST_TEST(reserved.at(-(n - 1)) == n - 1);
+}
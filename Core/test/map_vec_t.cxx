@@ -0,0 +1,85 @@
+/*! Test map_vec class.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <string>
+#include "AnalysisTools/Core/include/map_vec.h"
+
+#define BOOST_TEST_MODULE map_vec_t
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using analysis::map_vec;
+
+BOOST_AUTO_TEST_CASE(insertion_order)
+{
+    map_vec<std::string, int> m;
+    BOOST_TEST(m.empty());
+    BOOST_TEST(!m.count("a"));
+    BOOST_TEST((m.find("a") == m.end()));
+    m["c"] = 1;
+    m["a"] = 2;
+    BOOST_TEST(m.insert({ "b", 3 }).second);
+    BOOST_TEST(!m.insert({ "a", 4 }).second);
+    m["c"] += 10;
+
+    BOOST_TEST(m.size() == 3u);
+    BOOST_TEST(m.at("a") == 2);
+    BOOST_TEST(m.find("c")->second == 11);
+    BOOST_CHECK_THROW(m.at("d"), std::out_of_range);
+
+    const std::vector<std::string> expected_keys = { "c", "a", "b" };
+    const std::vector<int> expected_values = { 11, 2, 3 };
+    std::vector<std::string> keys;
+    std::vector<int> values;
+    for(const auto& item : m.get_ordered_by_insertion()) {
+        keys.push_back(item.first);
+        values.push_back(*item.second);
+    }
+    BOOST_TEST(keys == expected_keys, boost::test_tools::per_element());
+    BOOST_TEST(values == expected_values, boost::test_tools::per_element());
+
+    const std::vector<std::string> expected_sorted_keys = { "a", "b", "c" };
+    std::vector<std::string> sorted_keys;
+    for(const auto& item : m)
+        sorted_keys.push_back(item.first);
+    BOOST_TEST(sorted_keys == expected_sorted_keys, boost::test_tools::per_element());
+
+    m.clear();
+    BOOST_TEST(m.empty());
+    BOOST_TEST(!m.count("c"));
+    BOOST_TEST(m.get_ordered_by_insertion().empty());
+    m["x"] = 5;
+    BOOST_TEST(m.begin()->first == "x");
+}
+
+BOOST_AUTO_TEST_CASE(stable_references)
+{
+    map_vec<int, int> m;
+    m.reserve(10);
+    const int n = 10000;
+    int& first = m[0];
+    for(int k = 1; k < n; ++k)
+        m[k * 1024] = k;
+    first = -1;
+    BOOST_TEST(m.size() == static_cast<size_t>(n));
+    BOOST_TEST(m.at(0) == -1);
+    for(int k = 1; k < n; ++k) {
+        BOOST_TEST_REQUIRE(m.count(k * 1024) == 1u);
+        BOOST_TEST_REQUIRE(m.at(k * 1024) == k);
+        BOOST_TEST_REQUIRE(*m.get_ordered_by_insertion().at(static_cast<size_t>(k)).second == k);
+    }
+    BOOST_TEST(!m.count(1));
+}
+
+BOOST_AUTO_TEST_CASE(custom_compare)
+{
+    // Keys without std::hash are supported, iteration follows the comparator.
+    using Key = std::pair<int, int>;
+    map_vec<Key, double, std::greater<Key>> m;
+    m[{ 1, 2 }] = 1.;
+    m[{ 3, 0 }] = 2.;
+    m[{ 1, 5 }] = 3.;
+    BOOST_TEST(m.begin()->first.first == 3);
+    BOOST_TEST(m.get_ordered_by_insertion().front().first.second == 2);
+    BOOST_TEST(*m.get_ordered_by_insertion().back().second == 3.);
+}
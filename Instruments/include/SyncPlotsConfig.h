@@ -42,26 +42,34 @@ private:
 std::ostream& operator <<(std::ostream& s, const Condition& cond);
 std::istream& operator >>(std::istream& s, Condition& cond);
 
-struct SyncPlotEntry {
-    static constexpr size_t N = 2;
+// Inputs that are compared with each other: all pairs of inputs or the first input (reference) with each other input.
+enum class SyncComparison { AllPairs, Reference };
+ENUM_NAMES(SyncComparison) = {
+    { SyncComparison::AllPairs, "all_pairs" }, { SyncComparison::Reference, "reference" },
+};
 
-    std::array<std::string, N> names;
+// Plot entry for n inputs in the format "name [name_1 ... name_{n-1}] n_bins x_min x_max [cond_0 ... cond_{n-1}]".
+// Either one branch name common for all inputs or a branch name for each input should be specified. Conditions that
+// are not specified are always true.
+struct SyncPlotEntry {
+    std::vector<std::string> names;
     size_t n_bins;
     Range<double> x_range;
-    std::array<Condition, N> conditions;
+    std::vector<Condition> conditions;
 
+    explicit SyncPlotEntry(size_t n_inputs = 2);
+    size_t NumberOfInputs() const { return names.size(); }
     bool HasAtLeastOneCondition() const;
-    SyncPlotEntry();
 };
 
 std::ostream& operator <<(std::ostream& s, const SyncPlotEntry& entry);
 std::istream& operator >>(std::istream& s, SyncPlotEntry& entry);
 
+// Configuration starts with a line with the event id branches for each input, followed by the plot entries.
 class SyncPlotConfig {
 public:
-    static constexpr size_t N = SyncPlotEntry::N;
-
-    explicit SyncPlotConfig(const std::string& file_name);
+    explicit SyncPlotConfig(const std::string& file_name, size_t n_inputs = 2);
+    size_t NumberOfInputs() const { return idBranches.size(); }
     const std::vector<std::string>& GetIdBranches(size_t n) const;
     const std::vector<SyncPlotEntry>& GetEntries() const;
 
@@ -69,7 +77,7 @@ private:
     std::vector<std::string> ReadIdBranches(std::ifstream& cfg);
 
 private:
-    std::array<std::vector<std::string>, N> idBranches;
+    std::vector<std::vector<std::string>> idBranches;
     std::vector<SyncPlotEntry> entries;
 };
 
@@ -24,6 +24,12 @@ parser.add_argument('--input-range', required=False, type=str, default=None,
                     help="read only entries in range begin:end (before any selection)")
 parser.add_argument('--output-range', required=False, type=str, default=None,
                     help="write only entries in range begin:end (after all selections)")
+parser.add_argument('--sample', required=False, type=str, default=None,
+                    help="select events by the hash of the event id: 'k/N' for shard k of N, 'x%%' for x percents"
+                         " of events, 'a:b' for the fraction range [a, b)")
+parser.add_argument('--sample-seed', required=False, type=int, default=0, help="seed of the event id hash")
+parser.add_argument('--id-columns', required=False, type=str, default='run,lumi,evt',
+                    help="run, lumi and event columns used to compute the event id hash")
 args = parser.parse_args()
 
 import ROOT
@@ -70,6 +76,33 @@ if args.input_range is not None:
     begin, end = [ int(x) for x in args.input_range.split(':') ]
     df = df.Range(begin, end)
 
+if args.sample is not None:
+    import math
+    def fraction_boundary(x):
+        return int(math.ldexp(x, 64)) % 2 ** 64
+    sample = args.sample.strip()
+    if sample.endswith('%'):
+        lower, upper = 0, fraction_boundary(float(sample[:-1]) / 100)
+    elif '/' in sample:
+        k, n = [ int(x) for x in sample.split('/') ]
+        if n <= 0 or k < 0 or k >= n:
+            raise RuntimeError("Invalid shard '{}'.".format(sample))
+        lower, upper = [ (-(-i * 2 ** 64 // n)) % 2 ** 64 for i in [ k, k + 1 ] ]
+    elif ':' in sample:
+        begin, end = [ float(x) for x in sample.split(':') ]
+        if not (0 <= begin < end <= 1):
+            raise RuntimeError("Invalid fraction range '{}'.".format(sample))
+        lower, upper = fraction_boundary(begin), fraction_boundary(end)
+    else:
+        raise RuntimeError("Invalid sample '{}'.".format(sample))
+    width_minus_one = (upper - lower - 1) % 2 ** 64
+    at_dir = os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+    ROOT.gInterpreter.AddIncludePath(os.path.dirname(at_dir))
+    ROOT.gInterpreter.Declare('#include "{}/Core/include/EventSampler.h"'.format(os.path.basename(at_dir)))
+    run, lumi, evt = args.id_columns.split(',')
+    df = df.Filter('analysis::EventSampler::Hash({}, {}, {}, {}ULL) - {}ULL <= {}ULL'.format(
+                   run, lumi, evt, args.sample_seed, lower, width_minus_one), 'sample ' + sample)
+
 if args.processing_module is not None:
     module_desc = args.processing_module.split(':')
     import imp
@@ -2,16 +2,22 @@
 This file is part of https://github.com/hh-italian-group/AnalysisTools. */
 
 #include <set>
+#include <array>
 #include <algorithm>
+#include <functional>
 #include <string>
 #include <sstream>
 #include <iostream>
 #include <stdexcept>
 #include <cmath>
+#include <limits>
 #include <memory>
+#include <numeric>
+#include <type_traits>
 #include <boost/filesystem.hpp>
 #include <TFile.h>
 #include <TTree.h>
+#include <TBranch.h>
 #include <TString.h>
 #include <TCanvas.h>
 #include <TH1.h>
@@ -25,6 +31,8 @@ This file is part of https://github.com/hh-italian-group/AnalysisTools. */
 #include "RootExt.h"
 #include "EventIdentifier.h"
 
+#include "AnalysisTools/Core/include/BranchReaderFactory.h"
+#include "AnalysisTools/Core/include/MemoryAccounting.h"
 #include "AnalysisTools/Run/include/program_main.h"
 #include "AnalysisTools/Instruments/include/SyncPlotsConfig.h"
 
@@ -37,72 +45,207 @@ struct Arguments {
     REQ_ARG(std::vector<std::string>, tree);
     OPT_ARG(std::vector<std::string>, preSelection, std::vector<std::string>());
     OPT_ARG(double, badThreshold, 0.01);
+    OPT_ARG(analysis::SyncComparison, comparison, analysis::SyncComparison::AllPairs);
 };
 
+namespace analysis {
+
 namespace {
-template<typename T, bool is_integral = std::is_integral<T>::value>
-struct BadEventCheck {
-    static bool isBadEvent(T first, T second, double badThreshold)
+// Values of a branch for all entries of a tree. Values of the integer branches are stored as integers, so they are
+// compared exactly. Unsigned values are stored separately, so the 64-bit values above the Long64_t range are kept.
+struct Column {
+    bool is_integer{false}, is_unsigned{false};
+    std::vector<Long64_t> int_values;
+    std::vector<ULong64_t> uint_values;
+    std::vector<double> double_values;
+
+    size_t size() const
+    {
+        return is_unsigned ? uint_values.size() : is_integer ? int_values.size() : double_values.size();
+    }
+    double Get(size_t entry) const
+    {
+        if(is_unsigned)
+            return static_cast<double>(uint_values.at(entry));
+        return is_integer ? static_cast<double>(int_values.at(entry)) : double_values.at(entry);
+    }
+    Long64_t GetInteger(size_t entry) const
+    {
+        if(is_unsigned)
+            return static_cast<Long64_t>(uint_values.at(entry));
+        return is_integer ? int_values.at(entry) : static_cast<Long64_t>(double_values.at(entry));
+    }
+    ULong64_t GetUnsigned(size_t entry) const
+    {
+        if(is_unsigned)
+            return uint_values.at(entry);
+        return is_integer ? static_cast<ULong64_t>(int_values.at(entry))
+                          : static_cast<ULong64_t>(double_values.at(entry));
+    }
+    bool IsNegative(size_t entry) const { return !is_unsigned && Get(entry) < 0; }
+    size_t GetMemoryUsage() const
     {
-        if(first == second) return false;
-        if(first == 0 || second == 0) return true;
-        const auto delta = first - second;
-        return std::abs<T>(delta/second) >= badThreshold;
+        return EstimateMemoryUsage(int_values) + EstimateMemoryUsage(uint_values) + EstimateMemoryUsage(double_values);
     }
+
+    void Print(std::ostream& os, size_t entry) const
+    {
+        if(is_unsigned)
+            os << uint_values.at(entry);
+        else if(is_integer)
+            os << int_values.at(entry);
+        else
+            os << double_values.at(entry);
+    }
+};
+
+struct ColumnReader {
+    virtual ~ColumnReader() {}
+    virtual void Read() = 0;
 };
 
 template<typename T>
-struct BadEventCheck<T, true> {
-    static bool isBadEvent(T first, T second, double /*badThreshold*/)
+struct TypedColumnReader : ColumnReader {
+    TypedColumnReader(TTree& tree, const std::string& name, Column& _column, size_t n_entries) : column(&_column)
+    {
+        column->is_integer = std::is_integral<T>::value;
+        column->is_unsigned = std::is_unsigned<T>::value;
+        if(column->is_unsigned)
+            column->uint_values.reserve(n_entries);
+        else if(column->is_integer)
+            column->int_values.reserve(n_entries);
+        else
+            column->double_values.reserve(n_entries);
+        tree.SetBranchAddress(name.c_str(), &value);
+    }
+
+    virtual void Read() override
     {
-        return first != second;
+        if(column->is_unsigned)
+            column->uint_values.push_back(static_cast<ULong64_t>(value));
+        else if(column->is_integer)
+            column->int_values.push_back(static_cast<Long64_t>(value));
+        else
+            column->double_values.push_back(static_cast<double>(value));
     }
+
+    static ColumnReader* Make(TTree& tree, const std::string& name, Column& column, size_t n_entries)
+    {
+        return new TypedColumnReader<T>(tree, name, column, n_entries);
+    }
+
+private:
+    T value{};
+    Column* column;
 };
+
+using ColumnReaderFactory = root_ext::BranchReaderFactory<ColumnReader* (*)(TTree&, const std::string&, Column&,
+                                                                            size_t), TypedColumnReader>;
+
+std::unique_ptr<ColumnReader> CreateColumnReader(TTree& tree, const std::string& name, Column& column,
+                                                 size_t n_entries)
+{
+    TBranch* branch = tree.GetBranch(name.c_str());
+    if(!branch)
+        throw exception("Branch '%1%' not found.") % name;
+    const auto make = ColumnReaderFactory::FindMakeMethod(*branch);
+    if(!make) {
+        const std::string reason = root_ext::GetBranchValueType(*branch).reason;
+        throw exception("Branch '%1%' has unsupported type%2%.") % name
+                % (reason.empty() ? std::string() : " (" + reason + ")");
+    }
+
+    UInt_t n_found = 0;
+    tree.SetBranchStatus(name.c_str(), true, &n_found);
+    if(n_found != 1)
+        throw exception("Branch '%1%' is not found.") % name;
+    return std::unique_ptr<ColumnReader>((*make)(tree, name, column, n_entries));
 }
 
-namespace analysis {
+// Integers are compared exactly, also when one of the values is signed and the other is unsigned.
+bool IntegersEqual(const Column& first, size_t first_entry, const Column& second, size_t second_entry)
+{
+    const bool first_negative = first.IsNegative(first_entry), second_negative = second.IsNegative(second_entry);
+    if(first_negative || second_negative)
+        return first_negative && second_negative
+            && first.GetInteger(first_entry) == second.GetInteger(second_entry);
+    return first.GetUnsigned(first_entry) == second.GetUnsigned(second_entry);
+}
+
+// Check for the first value type of the compared pair: integers are compared exactly, floating point values with the
+// relative threshold.
+bool IsBadEvent(const Column& first, size_t first_entry, const Column& second, size_t second_entry,
+                double badThreshold)
+{
+    if(first.is_integer)
+        return !IntegersEqual(first, first_entry, second, second_entry);
+    const double first_value = first.Get(first_entry), second_value = second.Get(second_entry);
+    if(first_value == second_value) return false;
+    if(first_value == 0 || second_value == 0) return true;
+    return std::abs((first_value - second_value) / second_value) >= badThreshold;
+}
+
+// Prints second - first. The difference of integers is exact, also for the unsigned 64-bit values.
+void PrintDifference(std::ostream& os, const Column& first, size_t first_entry, const Column& second,
+                     size_t second_entry)
+{
+    if(!first.is_integer || first.IsNegative(first_entry) || second.IsNegative(second_entry)) {
+        if(first.is_integer && !first.is_unsigned && !second.is_unsigned)
+            os << second.GetInteger(second_entry) - first.GetInteger(first_entry);
+        else
+            os << second.Get(second_entry) - first.Get(first_entry);
+        return;
+    }
+    const ULong64_t first_value = first.GetUnsigned(first_entry), second_value = second.GetUnsigned(second_entry);
+    if(second_value >= first_value)
+        os << second_value - first_value;
+    else
+        os << "-" << first_value - second_value;
+}
+} // anonymous namespace
+
+// Synchronizes N inputs in a single pass: each tree is read once, event ids of all inputs are joined once, and the
+// pairwise comparisons (all pairs or the first input with each other input) are produced from the shared columns.
 class EventSync {
 public:
-    static constexpr size_t N = 2;
+    static constexpr size_t NotFound = std::numeric_limits<size_t>::max();
+    static constexpr size_t N = 2; // number of inputs in one comparison
 
-    using EventSet = std::set<EventIdentifier> ;
     using EventVector = std::vector<EventIdentifier>;
-    using EventToEntryMap = std::map<EventIdentifier, size_t>;
-    using EntryPair = std::pair<size_t, size_t>;
-    using EventToEntryPairMap = std::map<EventIdentifier, EntryPair>;
+    using EntryVector = std::vector<size_t>;
+    using ColumnMap = std::map<std::string, Column>;
     using SelectorFn = std::function<bool(size_t)>;
     using SelectorFnArray = std::array<SelectorFn, N>;
+    using InputArray = std::array<size_t, N>;
     using Hist = TH1F;
     using HistPtr = std::shared_ptr<Hist>;
     using Hist2D = TH2F;
     using Hist2DPtr = std::shared_ptr<Hist2D>;
 
     EventSync(const Arguments& _args) :
-        args(_args), config(args.config()), channel(args.channel()), sample(args.sample()),
-        isFirstPage(true), isLastDraw(false)
+        args(_args), n_inputs(args.group().size()), config(args.config(), n_inputs), channel(args.channel()),
+        sample(args.sample()), groups(args.group()), rootFileNames(args.file()), treeNames(args.tree()),
+        preSelections(n_inputs), rootFiles(n_inputs), trees(n_inputs), events(n_inputs), columns(n_inputs),
+        event_entries(n_inputs), isFirstPage(true), isLastDraw(false)
     {
-        if(args.group().size() != N || args.file().size() != N || args.tree().size() != N
-                || args.preSelection().size() > N )
+        if(n_inputs < 2 || args.file().size() != n_inputs || args.tree().size() != n_inputs
+                || args.preSelection().size() > n_inputs )
             throw exception("Invalid number of arguments");
 
         std::cout << channel << " " << sample << std::endl;
-        for(size_t n = 0; n < N; ++n) {
-            groups[n] = args.group().at(n);
-            rootFileNames[n] = args.file().at(n);
-            treeNames[n] = args.tree().at(n);
+        for(size_t n = 0; n < n_inputs; ++n) {
             if(args.preSelection().size() > n)
                 preSelections[n] = args.preSelection().at(n);
             std::cout << groups[n] << "  " << rootFileNames[n] << "  " << treeNames[n] << std::endl;
             trees[n] = LoadTree(rootFiles[n], rootFileNames[n], treeNames[n], preSelections[n]);
         }
 
-        file_name = "PlotsDiff_" + channel + "_" + sample + "_" + groups[0] + "_" + groups[1] + ".pdf";
         gErrorIgnoreLevel = kWarning;
     }
 
     ~EventSync()
     {
-        for(size_t n = 0; n < N; ++n)
+        for(size_t n = 0; n < n_inputs; ++n)
             trees[n].reset();
         tmpRootFile.reset();
         boost::filesystem::remove(tmpName);
@@ -110,38 +253,19 @@ public:
 
     void Run()
     {
-        CollectEvents();
-
-        for(size_t k = 0; k < config.GetEntries().size(); ++k) {
-            const SyncPlotEntry& entry = config.GetEntries().at(k);
-            isLastDraw = k + 1 == config.GetEntries().size();
-
-            std::array<std::vector<int>, N> vars_int;
-            std::array<std::vector<double>, N> vars_double;
-            std::string selection_label;
-            for(size_t n = 0; n < N; ++n) {
-                if(!entry.conditions[n].always_true) {
-                    if(entry.conditions[n].is_integer)
-                        vars_int[n] = CollectValuesEx<int>(*trees[n], entry.conditions[n].entry);
-                    else
-                        vars_double[n] = CollectValuesEx<double>(*trees[n], entry.conditions[n].entry);
-                    if(!selection_label.size())
-                        selection_label = ToString(entry.conditions[n]);
-                }
+        for(size_t n = 0; n < n_inputs; ++n)
+            ReadInput(n);
+        JoinEvents();
+
+        for(const InputArray& inputs : GetComparisons()) {
+            ReportEvents(inputs);
+            file_name = "PlotsDiff_" + channel + "_" + sample + "_" + groups[inputs[0]] + "_" + groups[inputs[1]]
+                      + ".pdf";
+            isFirstPage = true;
+            for(size_t k = 0; k < config.GetEntries().size(); ++k) {
+                isLastDraw = k + 1 == config.GetEntries().size();
+                drawHistos(config.GetEntries().at(k), inputs);
             }
-
-            const auto selector = [&](size_t groupId, size_t n) -> bool {
-                if(entry.conditions[groupId].always_true) return true;
-                if(entry.conditions[groupId].is_integer)
-                    return entry.conditions[groupId].pass_int(vars_int[groupId].at(n));
-                return entry.conditions[groupId].pass_double(vars_double[groupId].at(n));
-            };
-
-            SelectorFnArray selectors;
-            selectors[0] = std::bind(selector, 0, std::placeholders::_1);
-            selectors[1] = std::bind(selector, 1, std::placeholders::_1);
-
-            drawHistos(entry.names, entry.n_bins, entry.x_range.min(), entry.x_range.max(), selectors, selection_label);
         }
     }
 
@@ -163,73 +287,181 @@ private:
         return tree;
     }
 
-    void drawHistos(const std::array<std::string, N>& var_names, size_t nbins, double xmin, double xmax,
-                    const SelectorFnArray& selectors, const std::string& selection_label)
+    // Reads the event id branches and all branches used in the plots and conditions in a single pass over the tree.
+    void ReadInput(size_t n)
     {
-        try {
+        TTree& tree = *trees[n];
+        std::set<std::string> names(config.GetIdBranches(n).begin(), config.GetIdBranches(n).end());
+        for(const SyncPlotEntry& entry : config.GetEntries()) {
+            names.insert(entry.names.at(n));
+            if(!entry.conditions.at(n).always_true)
+                names.insert(entry.conditions.at(n).entry);
+        }
 
-            using DataTypePair = std::pair<EDataType, EDataType>;
-            using FillMethodPtr = void (EventSync::*)(const std::array<std::string, N>&, const SelectorFnArray&,
-                                  std::array<HistPtr, N>&, std::array<HistPtr, N>&, std::array<HistPtr, N>&, Hist2D&);
-            using FillMethodMap = std::map<DataTypePair, FillMethodPtr>;
+        const Long64_t n_entries = tree.GetEntries();
+        std::vector<std::unique_ptr<ColumnReader>> readers;
+        for(const std::string& name : names) {
+            try {
+                readers.push_back(CreateColumnReader(tree, name, columns[n][name], static_cast<size_t>(n_entries)));
+            } catch(std::runtime_error& e) {
+                columns[n].erase(name);
+                std::cerr << "WARNING: " << groups[n] << " " << e.what() << std::endl;
+            }
+        }
+        for(Long64_t entry = 0; entry < n_entries; ++entry) {
+            if(tree.GetEntry(entry) < 0)
+                throw exception("error while reading tree.");
+            for(auto& reader : readers)
+                reader->Read();
+        }
+        readers.clear();
+        trees[n].reset();
+
+        events[n] = CollectEventIds(n);
+        size_t columns_memory = 0;
+        for(const auto& column : columns[n])
+            columns_memory += column.second.GetMemoryUsage();
+        ReportMemoryUsage(groups[n] + "/columns", columns_memory);
+        ReportMemoryUsage(groups[n] + "/events", EstimateMemoryUsage(events[n]));
+    }
 
-            const auto createHist = [&](const std::string& name) -> HistPtr {
-                return HistPtr(new Hist(name.c_str(), "", static_cast<int>(nbins), xmin, xmax));
-            };
-            const auto createHist0 = [&](const std::string& suffix) -> HistPtr {
-                return createHist("H" + groups[0] + var_names[0] + suffix);
-            };
-            const auto createHist1 = [&](const std::string& suffix) -> HistPtr {
-                return createHist("H" + groups[1] + var_names[0] + suffix);
-            };
-            const auto create2DHist = [&](const std::string& name) -> Hist2DPtr {
-                return Hist2DPtr(new Hist2D(name.c_str(), "", static_cast<int>(nbins), xmin, xmax, 61, -1.525, 1.525));
-            };
+    EventVector CollectEventIds(size_t n) const
+    {
+        using IdType = EventIdentifier::IdType;
+        std::vector<const Column*> id_columns;
+        for(const auto& id_branch : config.GetIdBranches(n))
+            id_columns.push_back(&GetColumn(n, id_branch));
+
+        EventVector result;
+        const size_t n_entries = id_columns.at(0)->size();
+        result.reserve(n_entries);
+        for(size_t entry = 0; entry < n_entries; ++entry) {
+            const auto get_id = [&](size_t k) { return static_cast<IdType>(id_columns.at(k)->GetUnsigned(entry)); };
+            const IdType sampleId = id_columns.size() > 3 ? get_id(3) : EventIdentifier::Undef_id;
+            result.emplace_back(get_id(0), get_id(1), get_id(2), sampleId);
+        }
+        return result;
+    }
+
+    // Joins events of all inputs: all_events contains the ordered union of the event ids, and event_entries[n][k]
+    // is the entry of the event all_events[k] in the input n (the last one for the duplicated events) or NotFound.
+    void JoinEvents()
+    {
+        std::vector<EntryVector> unique_entries(n_inputs);
+        for(size_t n = 0; n < n_inputs; ++n) {
+            EntryVector order(events[n].size());
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+                return events[n][a] < events[n][b];
+            });
+            for(size_t k = 0; k < order.size(); ++k) {
+                if(k + 1 < order.size() && events[n][order[k]] == events[n][order[k + 1]]) continue;
+                unique_entries[n].push_back(order[k]);
+            }
+            std::cout << "# " << groups[n] << " events = " << events[n].size() << ", " << "# " << groups[n]
+                      << " unique events = " << unique_entries[n].size() << std::endl;
+            ReportDuplicatedEvents(events[n], order, unique_entries[n].size(), groups[n]);
+        }
 
-            std::array<HistPtr, N> H_all = { createHist0("all"), createHist1("all") };
-            std::array<HistPtr, N> H_common = { createHist0("common"), createHist1("common") };
-            std::array<HistPtr, N> H_diff = { createHist0("diff"), createHist1("diff") };
-            auto H_0vs1 = create2DHist("H" + groups[0] + "_vs_" + groups[1] + var_names[0]);
+        for(size_t n = 0; n < n_inputs; ++n) {
+            for(size_t entry : unique_entries[n])
+                all_events.push_back(events[n][entry]);
+        }
+        std::sort(all_events.begin(), all_events.end());
+        all_events.erase(std::unique(all_events.begin(), all_events.end()), all_events.end());
+
+        std::vector<bool> in_all_inputs(all_events.size(), true);
+        for(size_t n = 0; n < n_inputs; ++n) {
+            event_entries[n].assign(all_events.size(), NotFound);
+            size_t k = 0;
+            for(size_t entry : unique_entries[n]) {
+                while(all_events[k] < events[n][entry]) ++k;
+                event_entries[n][k] = entry;
+            }
+            for(k = 0; k < all_events.size(); ++k)
+                in_all_inputs[k] = in_all_inputs[k] && event_entries[n][k] != NotFound;
+        }
+        std::cout << "# events common to all inputs = "
+                  << std::count(in_all_inputs.begin(), in_all_inputs.end(), true) << std::endl;
 
-            std::array<EDataType, N> data_types;
+        for(size_t n = 0; n < n_inputs; ++n) {
+            events[n] = EventVector();
+            ReportMemoryUsage(groups[n] + "/events", EstimateMemoryUsage(event_entries[n]));
+        }
+        ReportMemoryUsage("all/events", EstimateMemoryUsage(all_events));
+    }
+
+    std::vector<InputArray> GetComparisons() const
+    {
+        std::vector<InputArray> comparisons;
+        for(size_t first = 0; first < n_inputs; ++first) {
+            if(first > 0 && args.comparison() == SyncComparison::Reference) break;
+            for(size_t second = first + 1; second < n_inputs; ++second)
+                comparisons.push_back(InputArray{ { first, second } });
+        }
+        return comparisons;
+    }
+
+    void ReportEvents(const InputArray& inputs) const
+    {
+        size_t n_common = 0;
+        for(size_t k = 0; k < all_events.size(); ++k) {
+            if(event_entries[inputs[0]][k] != NotFound && event_entries[inputs[1]][k] != NotFound)
+                ++n_common;
+        }
+        std::cout << "# " << groups[inputs[0]] << " and " << groups[inputs[1]] << " common events = " << n_common
+                  << std::endl;
+
+        for(size_t n = 0; n < N; ++n) {
+            std::cout << groups[inputs[n]] << " events" << std::endl;
+            for(size_t k = 0; k < all_events.size(); ++k) {
+                if(event_entries[inputs[n]][k] != NotFound && event_entries[inputs[(n + 1) % N]][k] == NotFound)
+                    std::cout << all_events[k].GetLegendString() << " = " << all_events[k] << std::endl;
+            }
+        }
+    }
+
+    void drawHistos(const SyncPlotEntry& entry, const InputArray& inputs)
+    {
+        try {
+            std::array<std::string, N> var_names;
+            std::array<const Column*, N> values;
+            SelectorFnArray selectors;
+            std::string selection_label;
             for(size_t n = 0; n < N; ++n) {
-                auto branch = trees[n]->GetBranch(var_names[n].c_str());
-                if (!branch)
-                    throw exception("%1% Branch '%2%' is not found.") % groups[n] % var_names[n];
-                TClass* t_class;
-                branch->GetExpectedType(t_class, data_types[n]);
-                if(t_class)
-                    throw exception("Branches with complex objects are not supported for branch '%1%'.") % var_names[n];
+                var_names[n] = entry.names.at(inputs[n]);
+                values[n] = &GetColumn(inputs[n], var_names[n]);
+                const Condition& condition = entry.conditions.at(inputs[n]);
+                selectors[n] = MakeSelector(condition, inputs[n]);
+                if(!condition.always_true && !selection_label.size())
+                    selection_label = ToString(condition);
             }
 
-            static const FillMethodMap fillMethods = {
-                { { kFloat_t, kFloat_t }, &EventSync::FillAllHistograms<Float_t, Float_t> },
-                { { kDouble_t, kDouble_t }, &EventSync::FillAllHistograms<Double_t, Double_t> },
-                { { kDouble_t, kFloat_t }, &EventSync::FillAllHistograms<Double_t, Float_t> },
-                { { kFloat_t, kDouble_t }, &EventSync::FillAllHistograms<Float_t, Double_t> },
-                { { kFloat_t, kUInt_t }, &EventSync::FillAllHistograms<Float_t, UInt_t> },
-                { { kInt_t, kInt_t }, &EventSync::FillAllHistograms<Int_t, Int_t> },
-                { { kInt_t, kUInt_t }, &EventSync::FillAllHistograms<Int_t, UInt_t> },
-                { { kUInt_t, kInt_t }, &EventSync::FillAllHistograms<UInt_t, Int_t> },
-                { { kInt_t, kDouble_t }, &EventSync::FillAllHistograms<Int_t, Double_t> },
-                { { kDouble_t, kInt_t }, &EventSync::FillAllHistograms<Double_t, Int_t> },
-                { { kULong64_t, kULong64_t }, &EventSync::FillAllHistograms<ULong64_t, ULong64_t> },
-                { { kBool_t, kBool_t }, &EventSync::FillAllHistograms<Bool_t, Bool_t> },
-                { { kBool_t, kChar_t }, &EventSync::FillAllHistograms<Bool_t, Char_t> },
-                { { kBool_t, kInt_t }, &EventSync::FillAllHistograms<Bool_t, Int_t> },
+            const auto createHist = [&](const std::string& name) -> HistPtr {
+                return HistPtr(new Hist(name.c_str(), "", static_cast<int>(entry.n_bins), entry.x_range.min(),
+                                        entry.x_range.max()));
             };
+            const auto createHists = [&](const std::string& suffix) -> std::array<HistPtr, N> {
+                return { { createHist("H" + groups[inputs[0]] + var_names[0] + suffix),
+                           createHist("H" + groups[inputs[1]] + var_names[0] + suffix) } };
+            };
+
+            std::array<HistPtr, N> H_all = createHists("all");
+            std::array<HistPtr, N> H_common = createHists("common");
+            std::array<HistPtr, N> H_diff = createHists("diff");
+            const std::string name_0vs1 = "H" + groups[inputs[0]] + "_vs_" + groups[inputs[1]] + var_names[0];
+            Hist2DPtr H_0vs1(new Hist2D(name_0vs1.c_str(), "", static_cast<int>(entry.n_bins), entry.x_range.min(),
+                                        entry.x_range.max(), 61, -1.525, 1.525));
 
-            const auto typePair = DataTypePair(data_types[0], data_types[1]);
-            if(!fillMethods.count(typePair))
-                throw exception("Unknown branch type combination (%1%, %2%) for branch ('%3%', '%4%').")
-                    % data_types[0] % data_types[1] % var_names[0] % var_names[1];
-            FillMethodPtr fillMethod = fillMethods.at(typePair);
-            (this->*fillMethod)(var_names, selectors, H_all, H_common, H_diff, *H_0vs1);
+            FillCommonHistograms(var_names[0], inputs, values, selectors, H_common, *H_0vs1);
+            for(size_t n = 0; n < N; ++n)
+                FillInclusiveHistogram(*values[n], selectors[n], *H_all[n]);
+            FillExclusiveHistogram(inputs, values, selectors, H_diff);
 
-            DrawSuperimposedHistograms(H_all, selection_label, var_names, "all");
-            DrawSuperimposedHistograms(H_common, selection_label, var_names, "common");
-            DrawSuperimposedHistograms(H_diff, selection_label, var_names, "different");
-            Draw2DHistogram(H_0vs1, selection_label, var_names);
+            DrawSuperimposedHistograms(H_all, selection_label, var_names, "all", inputs);
+            DrawSuperimposedHistograms(H_common, selection_label, var_names, "common", inputs);
+            DrawSuperimposedHistograms(H_diff, selection_label, var_names, "different", inputs);
+            Draw2DHistogram(H_0vs1, selection_label, var_names, inputs);
 
         } catch(std::runtime_error& e){
             std::cerr << "WARNING: " << e.what() << std::endl;
@@ -250,7 +482,8 @@ private:
     }
 
     void DrawSuperimposedHistograms(const std::array<HistPtr, N>& hists, const std::string& selection_label,
-                                    const std::array<std::string, N>& var_names, const std::string& event_subset)
+                                    const std::array<std::string, N>& var_names, const std::string& event_subset,
+                                    const InputArray& inputs)
     {
         const std::string title = MakeTitle(var_names, event_subset, selection_label);
         hists[0]->SetTitle(title.c_str());
@@ -277,7 +510,7 @@ private:
         hists[0]->Draw("hist");
         hists[1]->Draw("histsame");
         DrawTextLabels({static_cast<size_t>(hists[0]->Integral(0, hists[0]->GetNbinsX() + 1)),
-                       static_cast<size_t>(hists[1]->Integral(0, hists[1]->GetNbinsX() + 1))});
+                       static_cast<size_t>(hists[1]->Integral(0, hists[1]->GetNbinsX() + 1))}, inputs);
 
         pad2.cd();
 
@@ -306,13 +539,13 @@ private:
     }
 
     void Draw2DHistogram(Hist2DPtr H_0vs1, const std::string& selection_label,
-                         const std::array<std::string, N>& var_names)
+                         const std::array<std::string, N>& var_names, const InputArray& inputs)
     {
         const std::string title = MakeTitle(var_names, "common", selection_label);
         H_0vs1->SetTitle(title.c_str());
         std::array<std::string, N> names;
         for(size_t n = 0; n < N; ++n)
-            names[n] = var_names[n] + "_" + groups[n];
+            names[n] = var_names[n] + "_" + groups[inputs[n]];
         std::ostringstream y_name;
         y_name << "(" << names[1] << " - " << names[0] << ")/" << names[1];
         H_0vs1->GetXaxis()->SetTitle(names[1].c_str());
@@ -325,14 +558,14 @@ private:
         H_0vs1->Draw("colz");
         const size_t n_events = static_cast<size_t>(H_0vs1->Integral(0, H_0vs1->GetNbinsX() + 1,
                                                                      0, H_0vs1->GetNbinsY() + 1));
-        DrawTextLabels({n_events, n_events});
+        DrawTextLabels({n_events, n_events}, inputs);
 
         PrintCanvas(title + " 2D", isLastDraw);
         pad1.Clear();
         canvas.Clear();
     }
 
-    void DrawTextLabels(std::array<size_t, N> n_events)
+    void DrawTextLabels(std::array<size_t, N> n_events, const InputArray& inputs)
     {
         std::array<Color_t, N> colors = { 1, 2 };
         std::array<double, N> x_pos = { .23, .53 };
@@ -340,262 +573,99 @@ private:
             TText text;
             text.SetTextColor(colors[n]);
             text.SetTextSize(.04f);
-            text.DrawTextNDC(x_pos[n], .84, (groups[n] + " : " + ToString(n_events[n])).c_str());
+            text.DrawTextNDC(x_pos[n], .84, (groups[inputs[n]] + " : " + ToString(n_events[n])).c_str());
         }
     }
 
-    template<typename VarType0, typename VarType1>
-    void FillAllHistograms(const std::array<std::string, N>& var_names, const SelectorFnArray& selectors,
-                           std::array<HistPtr, N>& H_all, std::array<HistPtr, N>& H_common,
-                           std::array<HistPtr, N>& H_diff, Hist2D& H_0vs1)
-    {
-        const std::vector<VarType0> values0 = CollectValues<VarType0>(*trees[0], var_names[0]);
-        const std::vector<VarType1> values1 = CollectValues<VarType1>(*trees[1], var_names[1]);
-        FillCommonHistograms(var_names[0], values0, values1, selectors, H_common, H_0vs1);
-        FillInclusiveHistogram(values0, selectors[0], *H_all[0]);
-        FillInclusiveHistogram(values1, selectors[1], *H_all[1]);
-        FillExclusiveHistogram(values0, values1, selectors, H_diff);
-    }
-
-    template<typename VarType0, typename VarType1>
-    void FillCommonHistograms(const std::string& var, const std::vector<VarType0>& values0,
-                              const std::vector<VarType1>& values1, const SelectorFnArray& selectors,
+    void FillCommonHistograms(const std::string& var, const InputArray& inputs,
+                              const std::array<const Column*, N>& values, const SelectorFnArray& selectors,
                               std::array<HistPtr, N>& H_common, Hist2D& hist2D)
     {
+        const Column& values0 = *values[0];
+        const Column& values1 = *values[1];
         std::cout << var << " bad events:\n";
-        for(const auto& event_entry_pair : common_event_to_entry_pair_map) {
-            const size_t entry0 = event_entry_pair.second.first;
-            const size_t entry1 = event_entry_pair.second.second;
-            if(!selectors[0](entry0) || !selectors[1](entry1))
+        for(size_t k = 0; k < all_events.size(); ++k) {
+            const size_t entry0 = event_entries[inputs[0]][k];
+            const size_t entry1 = event_entries[inputs[1]][k];
+            if(entry0 == NotFound || entry1 == NotFound || !selectors[0](entry0) || !selectors[1](entry1))
                 continue;
-            const VarType0& value0 = values0.at(entry0);
-            const VarType1& value1 = values1.at(entry1);
+            const double value0 = values0.Get(entry0);
+            const double value1 = values1.Get(entry1);
             H_common[0]->Fill(value0);
             H_common[1]->Fill(value1);
-            const double y_value = value1 != VarType1(0)
-                                 ? double(static_cast<VarType0>(value1) - value0) / value1 : -value0;
-            const auto diff = static_cast<VarType0>(value1) - value0;
-            if (BadEventCheck<VarType0>::isBadEvent(value0, static_cast<VarType0>(value1), args.badThreshold())) {
-                std::cout << event_entry_pair.first.GetLegendString() << " = " << event_entry_pair.first << ", "
-                          << groups[1] << " = " << value1 << ", " << groups[0] << " = " << value0 << ", "
-                          << groups[1] <<  " - " << groups[0] << " = " << diff << std::endl;
+            const double y_value = value1 != 0 ? (value1 - value0) / value1 : -value0;
+            if(IsBadEvent(values0, entry0, values1, entry1, args.badThreshold())) {
+                const auto& event = all_events[k];
+                std::cout << event.GetLegendString() << " = " << event << ", " << groups[inputs[1]] << " = ";
+                values1.Print(std::cout, entry1);
+                std::cout << ", " << groups[inputs[0]] << " = ";
+                values0.Print(std::cout, entry0);
+                std::cout << ", " << groups[inputs[1]] <<  " - " << groups[inputs[0]] << " = ";
+                PrintDifference(std::cout, values0, entry0, values1, entry1);
+                std::cout << std::endl;
             }
             hist2D.Fill(value1, y_value);
         }
     }
 
-    template<typename VarType>
-    void FillInclusiveHistogram(const std::vector<VarType>& values, const SelectorFn& selector, Hist& histogram)
+    static void FillInclusiveHistogram(const Column& values, const SelectorFn& selector, Hist& histogram)
     {
         for(size_t n = 0; n < values.size(); ++n) {
             if(selector(n))
-                histogram.Fill(values.at(n));
+                histogram.Fill(values.Get(n));
         }
     }
 
-    template<typename VarType0, typename VarType1>
-    void FillExclusiveHistogram(const std::vector<VarType0>& values0, const std::vector<VarType1>& values1,
+    void FillExclusiveHistogram(const InputArray& inputs, const std::array<const Column*, N>& values,
                                 const SelectorFnArray& selectors, std::array<HistPtr, N>& H_diff)
     {
-        for (const auto& event_entry_pair : common_event_to_entry_pair_map){
-            const size_t entry0 = event_entry_pair.second.first;
-            const size_t entry1 = event_entry_pair.second.second;
-            if(selectors[0](entry0) && !selectors[1](entry1)){
-                const auto& value0 = values0.at(entry0);
-                H_diff[0]->Fill(value0);
-            }
-            if(!selectors[0](entry0) && selectors[1](entry1)){
-                const auto& value1 = values1.at(entry1);
-                H_diff[1]->Fill(value1);
-            }
-        }
-        for(const auto& event_entry : group_events_only_map[0]) {
-            if(selectors[0](event_entry.second)) {
-                const auto& value = values0.at(event_entry.second);
-                H_diff[0]->Fill(value);
-            }
-        }
-        for(const auto& event_entry : group_events_only_map[1]) {
-            if(selectors[1](event_entry.second)) {
-                const auto& value = values1.at(event_entry.second);
-                H_diff[1]->Fill(value);
-            }
-        }
-    }
-
-    void CollectEvents()
-    {
-        std::array<EventSet, N> event_sets, group_events_only;
-        for(size_t n = 0; n < N; ++n) {
-            events[n] = CollectEventIds(*trees[n], config.GetIdBranches(n));
-            event_sets[n] = EventSet(events[n].begin(), events[n].end());
-        }
-
-        EventSet intersection;
-        for(size_t n = 0; n < N; ++n)
-            EventSetDifference(event_sets[n % N], event_sets[(n+1) % N], group_events_only[n % N]);
-        EventSetIntersection(event_sets[0], event_sets[1], intersection);
-
-        std::array<EventToEntryMap, N> event_to_entry_map;
-        for(size_t n = 0; n < N; ++n) {
-            FillEventToEntryMap(events[n], event_to_entry_map[n]);
-            std::cout << "# " << groups[n] << " events = " << events[n].size() << ", " << "# " << groups[n]
-                      << " unique events = " << event_sets[n].size() << std::endl;
-            ReportDuplicatedEvents(events[n], event_sets[n], groups[n]);
-        }
-        std::cout << "# common events = " << intersection.size() << std::endl;
-
-
-        std::cout << groups[0] << " events" << std::endl;
-        for(const auto& event_entry : event_to_entry_map[0]) {
-            if(intersection.count(event_entry.first)) {
-                common_event_to_entry_pair_map[event_entry.first] =
-                        std::pair<size_t, size_t>(event_entry.second, event_to_entry_map[1].at(event_entry.first));
-            }
-            if(group_events_only[0].count(event_entry.first)) {
-                group_events_only_map[0][event_entry.first] = event_entry.second;
-                std::cout << event_entry.first.GetLegendString() << " = " << event_entry.first << std::endl;
-            }
-        }
-
-        std::cout << groups[1] << " events" << std::endl;
-        for(const auto& event_entry : event_to_entry_map[1]) {
-            if(group_events_only[1].count(event_entry.first)){
-                group_events_only_map[1][event_entry.first] = event_entry.second;
-                std::cout << event_entry.first.GetLegendString() << " = " << event_entry.first << std::endl;
+        for(size_t k = 0; k < all_events.size(); ++k) {
+            const std::array<size_t, N> entries = { { event_entries[inputs[0]][k], event_entries[inputs[1]][k] } };
+            for(size_t n = 0; n < N; ++n) {
+                const size_t other = (n + 1) % N;
+                if(entries[n] != NotFound && selectors[n](entries[n])
+                        && (entries[other] == NotFound || !selectors[other](entries[other])))
+                    H_diff[n]->Fill(values[n]->Get(entries[n]));
             }
         }
     }
 
-    static void EventSetIntersection(const EventSet& first_set, const EventSet& second_set, EventSet& intersection_set)
-    {
-        const size_t max_intersection_size = std::max(first_set.size(), second_set.size());
-        EventVector intersection_vector(max_intersection_size);
-        const auto iter = std::set_intersection(first_set.begin(), first_set.end(),
-                                                second_set.begin(), second_set.end(),
-                                                intersection_vector.begin());
-        intersection_vector.resize(static_cast<size_t>(iter - intersection_vector.begin()));
-        intersection_set.clear();
-        intersection_set.insert(intersection_vector.begin(), intersection_vector.end());
-    }
-
-    static void EventSetDifference(const EventSet& first_set, const EventSet& second_set, EventSet& diff_set)
-    {
-        EventVector diff_vector(first_set.size());
-        const auto iter = std::set_difference(first_set.begin(), first_set.end(),
-                                              second_set.begin(), second_set.end(),
-                                              diff_vector.begin());
-        diff_vector.resize(static_cast<size_t>(iter - diff_vector.begin()));
-        diff_set.clear();
-        diff_set.insert(diff_vector.begin(), diff_vector.end());
-    }
-
-    static void ReportDuplicatedEvents(const EventVector& event_vec, const EventSet& event_set,
+    static void ReportDuplicatedEvents(const EventVector& event_vec, const EntryVector& order, size_t n_unique,
                                        const std::string& name)
     {
-        if(event_vec.size() == event_set.size()) return;
-        EventSet processed_events;
+        if(event_vec.size() == n_unique) return;
         std::cout << name << " duplicated events:\n";
-        for(const auto& evt : event_vec) {
-            if(processed_events.count(evt))
-                std::cout << evt << "\n";
-            else
-                processed_events.insert(evt);
+        for(size_t k = 1; k < order.size(); ++k) {
+            if(event_vec[order[k]] == event_vec[order[k - 1]])
+                std::cout << event_vec[order[k]] << "\n";
         }
         std::cout << std::endl;
     }
 
-    void FillEventToEntryMap(const EventVector& events, EventToEntryMap& event_to_entry_map) const
+    const Column& GetColumn(size_t n, const std::string& name) const
     {
-        for(size_t n = 0; n < events.size(); ++n) {
-             event_to_entry_map[events[n]] = n;
-        }
-    }
-
-    template<typename VarType>
-    std::vector<VarType> CollectValues(TTree& tree, const std::string& name)
-    {
-        EnableBranch(tree, name, true);
-        std::vector<VarType> result;
-        VarType value;
-        tree.SetBranchAddress(name.c_str(), &value);
-        const Long64_t N = tree.GetEntries();
-        for(Long64_t n = 0; n < N;++n) {
-            if(tree.GetEntry(n) < 0)
-                throw exception("error while reading tree.");
-            result.push_back(value);
-        }
-        EnableBranch(tree, name, false);
-        return result;
-    }
-
-    template<typename VarType>
-    std::vector<VarType> CollectValuesEx(TTree& tree, const std::string& name)
-    {
-        std::vector<VarType> result;
-
-        using CollectMethodPtr = void (EventSync::*)(TTree&, const std::string&, std::vector<VarType>&);
-        using CollectMethodMap = std::map<EDataType, CollectMethodPtr>;
-
-        static const CollectMethodMap collectMethods = {
-            { kInt_t, &EventSync::CollectAndConvertValue<Int_t, VarType> },
-            { kUInt_t, &EventSync::CollectAndConvertValue<UInt_t, VarType> },
-            { kULong64_t, &EventSync::CollectAndConvertValue<ULong64_t, VarType> },
-            { kFloat_t, &EventSync::CollectAndConvertValue<Float_t, VarType> },
-            { kDouble_t, &EventSync::CollectAndConvertValue<Double_t, VarType> },
-            { kChar_t, &EventSync::CollectAndConvertValue<Char_t, VarType> },
-            { kBool_t, &EventSync::CollectAndConvertValue<Bool_t, VarType> }
-        };
-
-        TBranch* branch = tree.GetBranch(name.c_str());
-        if (!branch)
-            throw exception("Branch '%1%' not found.") % name;
-        TClass *branch_class;
-        EDataType branch_type;
-        branch->GetExpectedType(branch_class, branch_type);
-        if(branch_class)
-            throw exception("Branches with complex objects are not supported for branch '%1%'.") % name;
-
-        if(!collectMethods.count(branch_type))
-            throw exception("Branch '%1%' has unsupported type %2%.") % name % branch_type;
-
-        auto collectMethod = collectMethods.at(branch_type);
-        (this->*collectMethod)(tree, name, result);
-        return result;
+        auto iter = columns.at(n).find(name);
+        if(iter == columns.at(n).end())
+            throw exception("%1% Branch '%2%' is not found.") % groups.at(n) % name;
+        return iter->second;
     }
 
-    template<typename InputType, typename OutputType>
-    void CollectAndConvertValue(TTree& tree, const std::string& name, std::vector<OutputType>& result)
+    SelectorFn MakeSelector(const Condition& condition, size_t n) const
     {
-        const auto original_result = CollectValues<InputType>(tree, name);
-        result.resize(original_result.size());
-        std::copy(original_result.begin(), original_result.end(), result.begin());
-    }
-
-    EventVector CollectEventIds(TTree& tree, const std::vector<std::string>& idBranches)
-    {
-        using IdType = EventIdentifier::IdType;
-        const auto run = CollectValuesEx<IdType>(tree, idBranches.at(0));
-        const auto lumi = CollectValuesEx<IdType>(tree, idBranches.at(1));
-        const auto evt = CollectValuesEx<IdType>(tree, idBranches.at(2));
-        std::vector<IdType> sampleIds;
-        if(idBranches.size() > 3)
-            sampleIds = CollectValuesEx<IdType>(tree, idBranches.at(3));
-
-        EventVector events;
-        for(size_t n = 0; n < evt.size(); ++n) {
-            const IdType sampleId = sampleIds.size() ? sampleIds.at(n) : EventIdentifier::Undef_id;
-            events.emplace_back(run.at(n), lumi.at(n), evt.at(n), sampleId);
-        }
-        return events;
+        if(condition.always_true)
+            return [](size_t) { return true; };
+        const Column* column = &GetColumn(n, condition.entry);
+        if(condition.is_integer)
+            return [&condition, column](size_t entry) {
+                return condition.pass_int(static_cast<int>(column->GetInteger(entry)));
+            };
+        return [&condition, column](size_t entry) { return condition.pass_double(column->Get(entry)); };
     }
 
-    void EnableBranch(TTree& tree, const std::string& name, bool enable)
+    // Reports the memory used by the event lists and the value columns to the global memory accounting.
+    void ReportMemoryUsage(const std::string& directory, size_t bytes)
     {
-        UInt_t n_found = 0;
-        tree.SetBranchStatus(name.c_str(), enable, &n_found);
-        if(n_found != 1)
-            throw exception("Branch '%1%' is not found.") % name;
+        memory_trackers.try_emplace(directory, "EventSync", directory).first->second.Update(bytes);
     }
 
     void PrintCanvas(const std::string& page_name, bool isLastPage = false)
@@ -614,18 +684,21 @@ private:
 
 private:
     Arguments args;
+    size_t n_inputs;
     SyncPlotConfig config;
     std::string channel, sample;
-    std::array<std::string, N> groups, rootFileNames, treeNames, preSelections;
-    std::array<std::shared_ptr<TFile>, N> rootFiles;
-    std::array<std::shared_ptr<TTree>, N> trees;
+    std::vector<std::string> groups, rootFileNames, treeNames, preSelections;
+    std::vector<std::shared_ptr<TFile>> rootFiles;
+    std::vector<std::shared_ptr<TTree>> trees;
 
     std::string tmpName;
     std::shared_ptr<TFile> tmpRootFile;
 
-    std::array<EventVector, N> events;
-    std::array<EventToEntryMap, N> group_events_only_map;
-    EventToEntryPairMap common_event_to_entry_pair_map;
+    std::vector<EventVector> events;
+    std::vector<ColumnMap> columns;
+    EventVector all_events;
+    std::vector<EntryVector> event_entries;
+    std::map<std::string, MemoryTracker> memory_trackers;
 
     TCanvas canvas;
     std::string file_name;
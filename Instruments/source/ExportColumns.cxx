@@ -0,0 +1,208 @@
+/*! Export selected branches into memory-mappable column files in the NumPy .npy format.
+Each scalar branch is stored as <output>/<branch>.npy. Vector branches are stored as the flat array of values
+(<branch>.npy) and the row offsets (<branch>.offsets.npy). Files are not compressed, so they can be mapped into
+the memory (see MappedNpyFile) and used without any decoding.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <chrono>
+#include <iomanip>
+#include <boost/filesystem.hpp>
+#include <TLeaf.h>
+#include <TTree.h>
+#include <TTreeFormula.h>
+
+#include "AnalysisTools/Run/include/program_main.h"
+#include "AnalysisTools/Core/include/BranchReaderFactory.h"
+#include "AnalysisTools/Core/include/NpyFile.h"
+#include "AnalysisTools/Core/include/RootExt.h"
+#include "AnalysisTools/Core/include/TextIO.h"
+
+struct Arguments {
+    run::Argument<std::string> tree_name{"tree", "tree name"};
+    run::Argument<std::string> output{"output", "output directory"};
+    run::Argument<std::string> branches{"branches", "comma separated list of branches"};
+    run::Argument<std::string> selection{"sel", "selection", ""};
+    run::Argument<std::vector<std::string>> input_files{"input", "input root files"};
+};
+
+namespace analysis {
+
+namespace detail {
+
+struct ColumnExporter {
+    virtual ~ColumnExporter() {}
+    virtual void Attach(TTree& tree) = 0;
+    virtual void Export(Long64_t entry) = 0;
+    virtual void Close() = 0;
+};
+
+template<typename T>
+struct ScalarColumnExporter : ColumnExporter {
+    const std::string name;
+    T value;
+    TBranch* branch{nullptr};
+    std::unique_ptr<NpyWriter> writer;
+
+    ScalarColumnExporter(const std::string& _name, const std::string& file_name) :
+        name(_name), writer(NpyWriter::Create<T>(file_name)) {}
+
+    virtual void Attach(TTree& tree) override
+    {
+        tree.SetBranchStatus(name.c_str(), 1);
+        tree.SetBranchAddress(name.c_str(), &value, &branch);
+    }
+
+    virtual void Export(Long64_t entry) override
+    {
+        if(branch->GetEntry(entry) < 0)
+            throw exception("Error while reading branch '%1%'.") % branch->GetName();
+        writer->Append(value);
+    }
+
+    virtual void Close() override { writer->Close(); }
+
+    static ColumnExporter* Make(const std::string& name, const std::string& file_name)
+    {
+        return new ScalarColumnExporter(name, file_name);
+    }
+};
+
+template<typename T>
+struct VectorColumnExporter : ColumnExporter {
+    const std::string name;
+    std::vector<T>* value{nullptr};
+    TBranch* branch{nullptr};
+    std::unique_ptr<NpyWriter> values_writer, offsets_writer;
+
+    VectorColumnExporter(const std::string& _name, const std::string& file_name) :
+        name(_name), values_writer(NpyWriter::Create<T>(file_name)),
+        offsets_writer(NpyWriter::Create<uint64_t>(NpyOffsetsFileName(file_name)))
+    {
+        offsets_writer->Append(uint64_t(0));
+    }
+
+    virtual ~VectorColumnExporter() override { delete value; }
+
+    virtual void Attach(TTree& tree) override
+    {
+        tree.SetBranchStatus(name.c_str(), 1);
+        tree.SetBranchAddress(name.c_str(), &value, &branch);
+    }
+
+    virtual void Export(Long64_t entry) override
+    {
+        if(branch->GetEntry(entry) < 0)
+            throw exception("Error while reading branch '%1%'.") % branch->GetName();
+        for(const T& x : *value)
+            values_writer->Append(x);
+        offsets_writer->Append(static_cast<uint64_t>(values_writer->size()));
+    }
+
+    virtual void Close() override
+    {
+        values_writer->Close();
+        offsets_writer->Close();
+    }
+
+    static ColumnExporter* Make(const std::string& name, const std::string& file_name)
+    {
+        return new VectorColumnExporter(name, file_name);
+    }
+};
+
+using ColumnExporterFactory =
+    root_ext::BranchReaderFactory<ColumnExporter* (*)(const std::string&, const std::string&), ScalarColumnExporter,
+                                  VectorColumnExporter>;
+
+} // namespace detail
+
+class ExportColumns {
+public:
+    using ExporterPtr = std::unique_ptr<detail::ColumnExporter>;
+    using Clock = std::chrono::steady_clock;
+
+    ExportColumns(const Arguments& _args) :
+        args(_args), branch_names(SplitValueList(args.branches(), false, ","))
+    {
+        if(args.input_files().empty())
+            throw exception("No input files are specified.");
+        if(branch_names.empty())
+            throw exception("No branches are specified.");
+        boost::filesystem::create_directories(args.output());
+        CreateExporters();
+    }
+
+    void Run()
+    {
+        const auto start = Clock::now();
+        Long64_t n_total = 0, n_selected = 0;
+        for(const auto& file_name : args.input_files()) {
+            auto file = root_ext::OpenRootFile(file_name);
+            std::unique_ptr<TTree> tree(root_ext::ReadObject<TTree>(*file, args.tree_name()));
+            tree->SetBranchStatus("*", 0);
+            for(const auto& exporter : exporters)
+                exporter->Attach(*tree);
+
+            std::unique_ptr<TTreeFormula> selection;
+            if(!args.selection().empty()) {
+                selection = std::make_unique<TTreeFormula>("selection", args.selection().c_str(), tree.get());
+                if(selection->GetNdim() == 0)
+                    throw exception("Invalid selection '%1%'.") % args.selection();
+                // Branches used in the selection are read by the formula, even if they are not exported.
+                for(Int_t n = 0; n < selection->GetNcodes(); ++n) {
+                    if(TLeaf* leaf = selection->GetLeaf(n))
+                        tree->SetBranchStatus(leaf->GetBranch()->GetName(), 1);
+                }
+            }
+
+            const Long64_t n_entries = tree->GetEntries();
+            for(Long64_t entry = 0; entry < n_entries; ++entry) {
+                if(selection) {
+                    tree->LoadTree(entry);
+                    selection->GetNdata();
+                    if(selection->EvalInstance(0) == 0) continue;
+                }
+                for(auto& exporter : exporters)
+                    exporter->Export(entry);
+                ++n_selected;
+            }
+            n_total += n_entries;
+            tree->ResetBranchAddresses();
+        }
+        for(auto& exporter : exporters)
+            exporter->Close();
+
+        const double time = std::chrono::duration<double>(Clock::now() - start).count();
+        std::cout << n_selected << " out of " << n_total << " entries exported into '" << args.output() << "' in "
+                  << std::fixed << std::setprecision(1) << time << " s." << std::endl;
+    }
+
+private:
+    void CreateExporters()
+    {
+        auto file = root_ext::OpenRootFile(args.input_files().front());
+        std::unique_ptr<TTree> tree(root_ext::ReadObject<TTree>(*file, args.tree_name()));
+        for(const auto& name : branch_names) {
+            TBranch* branch = tree->GetBranch(name.c_str());
+            if(!branch)
+                throw exception("Branch '%1%' not found.") % name;
+            const auto make = detail::ColumnExporterFactory::FindMakeMethod(*branch);
+            if(!make) {
+                const std::string reason = root_ext::GetBranchValueType(*branch).reason;
+                throw exception("Branch '%1%' has unsupported type%2%.") % name
+                        % (reason.empty() ? std::string() : " (" + reason + ")");
+            }
+            const std::string file_name = (boost::filesystem::path(args.output()) / (name + ".npy")).string();
+            exporters.emplace_back((*make)(name, file_name));
+        }
+    }
+
+private:
+    Arguments args;
+    std::vector<std::string> branch_names;
+    std::vector<ExporterPtr> exporters;
+};
+
+} // namespace analysis
+
+PROGRAM_MAIN(analysis::ExportColumns, Arguments)
@@ -8,7 +8,9 @@ This file is part of https://github.com/hh-italian-group/AnalysisTools. */
 #include <TRatioPlot.h>
 #include <TText.h>
 
+#include "AnalysisTools/Run/include/MultiThread.h"
 #include "AnalysisTools/Run/include/program_main.h"
+#include "AnalysisTools/Core/include/FileOpenService.h"
 #include "AnalysisTools/Core/include/RootExt.h"
 #include "AnalysisTools/Core/include/TextIO.h"
 #include "AnalysisTools/Core/include/Tools.h"
@@ -23,6 +25,8 @@ struct Arguments {
     REQ_ARG(std::string, cfg);
     REQ_ARG(std::string, output);
     REQ_ARG(std::vector<std::string>, input);
+    OPT_ARG(unsigned, n_io_threads, 2);
+    OPT_ARG(run::ThreadAffinity, affinity, run::ThreadAffinity::None);
 };
 
 struct InputPattern {
@@ -83,9 +87,9 @@ struct Source {
     float label_size{.02f};
     DirHistMap histograms;
 
-    Source(size_t n, const std::vector<std::string>& inputs, const ItemCollection& config_items,
+    Source(size_t n, const std::shared_ptr<TFile>& _file, const ItemCollection& config_items,
            const InputPattern& pattern) :
-        file(root_ext::OpenRootFile(inputs.at(n)))
+        file(_file)
     {
         const std::string item_name = boost::str(boost::format("input%1%") % n);
         if(!config_items.count(item_name))
@@ -139,7 +143,7 @@ public:
     using DrawOptions = ::root_ext::draw_options::Page;
 
     ShapeSync(const Arguments& _args) :
-        args(_args)
+        args(_args), executors(run::Executors::Config(std::max(args.n_io_threads(), 1u), 1, args.affinity()))
     {
         static const std::string draw_opt_item_name = "draw_opt";
 
@@ -156,8 +160,21 @@ public:
             throw analysis::exception("Draw options not found.");
         draw_options = std::make_shared<DrawOptions>(config.GetItems().at(draw_opt_item_name));
 
-        for(size_t n = 0; n < args.input().size(); ++n)
-            inputs.emplace_back(n, args.input(), config.GetItems(), *patterns);
+        // Inputs are opened ahead and their histograms are loaded in parallel on the I/O executor.
+        std::vector<std::shared_ptr<TFile>> files;
+        root_ext::FileOpenService file_service(args.input());
+        while(auto file = file_service.Next())
+            files.push_back(file);
+        std::vector<std::future<Source>> sources;
+        for(size_t n = 0; n < files.size(); ++n) {
+            sources.push_back(run::async_io([&](size_t index) {
+                return Source(index, files.at(index), config.GetItems(), *patterns);
+            }, n));
+        }
+        for(auto& source : sources)
+            source.wait();
+        for(auto& source : sources)
+            inputs.push_back(source.get());
         canvas = std::make_shared<TCanvas>("canvas", "", draw_options->canvas_size.x(),
                                            draw_options->canvas_size.y());
         canvas->cd();
@@ -334,6 +351,7 @@ private:
 
 private:
     Arguments args;
+    run::Executors executors;
     std::vector<Source> inputs;
     std::shared_ptr<InputPattern> patterns;
     std::shared_ptr<DrawOptions> draw_options;
@@ -0,0 +1,276 @@
+/*! Compute summary statistics for several branches in a single pass over the input files.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <TTree.h>
+#include <TTreeFormula.h>
+
+#include "AnalysisTools/Run/include/program_main.h"
+#include "AnalysisTools/Run/include/MultiThread.h"
+#include "AnalysisTools/Core/include/BranchReaderFactory.h"
+#include "AnalysisTools/Core/include/RootExt.h"
+#include "AnalysisTools/Core/include/TextIO.h"
+#include "AnalysisTools/Core/include/SummaryStatistics.h"
+
+struct Arguments {
+    run::Argument<std::string> tree_name{"tree", "tree name"};
+    run::Argument<std::string> output{"output", "output json file (if empty, the summary is printed to stdout)", ""};
+    run::Argument<std::string> branches{"branches", "comma separated list of branches (all supported if empty)",
+                                        ""};
+    run::Argument<std::string> selection{"sel", "selection", ""};
+    run::Argument<std::string> quantiles{"quantiles", "comma separated list of quantiles to compute",
+                                         "0.01,0.025,0.16,0.5,0.84,0.975,0.99"};
+    run::Argument<unsigned> n_hist_bins{"n-hist-bins", "number of bins in the histogram sketch", 20};
+    run::Argument<double> relative_accuracy{"relative-accuracy", "relative accuracy of the quantiles", 0.01};
+    run::Argument<unsigned> n_threads{"n-threads", "number of threads", 1};
+    run::Argument<std::vector<std::string>> input_files{"input", "input root files"};
+};
+
+namespace analysis {
+
+namespace detail {
+
+struct ColumnReader {
+    virtual ~ColumnReader() {}
+    virtual void Read(Long64_t entry, SummaryAccumulator& acc) = 0;
+};
+
+template<typename T>
+struct ScalarColumnReader : ColumnReader {
+    T value;
+    TBranch* branch{nullptr};
+
+    ScalarColumnReader(TTree& tree, const std::string& name)
+    {
+        tree.SetBranchStatus(name.c_str(), 1);
+        tree.SetBranchAddress(name.c_str(), &value, &branch);
+    }
+
+    virtual void Read(Long64_t entry, SummaryAccumulator& acc) override
+    {
+        if(branch->GetEntry(entry) < 0)
+            throw exception("Error while reading branch '%1%'.") % branch->GetName();
+        acc.AddEntry();
+        acc.Add(static_cast<double>(value));
+    }
+
+    static ColumnReader* Make(TTree& tree, const std::string& name) { return new ScalarColumnReader(tree, name); }
+};
+
+template<typename T>
+struct VectorColumnReader : ColumnReader {
+    std::vector<T>* value{nullptr};
+    TBranch* branch{nullptr};
+
+    VectorColumnReader(TTree& tree, const std::string& name)
+    {
+        tree.SetBranchStatus(name.c_str(), 1);
+        tree.SetBranchAddress(name.c_str(), &value, &branch);
+    }
+
+    virtual ~VectorColumnReader() override { delete value; }
+
+    virtual void Read(Long64_t entry, SummaryAccumulator& acc) override
+    {
+        if(branch->GetEntry(entry) < 0)
+            throw exception("Error while reading branch '%1%'.") % branch->GetName();
+        acc.AddEntry();
+        for(const auto& x : *value)
+            acc.Add(static_cast<double>(x));
+    }
+
+    static ColumnReader* Make(TTree& tree, const std::string& name) { return new VectorColumnReader(tree, name); }
+};
+
+using ColumnReaderFactory = root_ext::BranchReaderFactory<ColumnReader* (*)(TTree&, const std::string&),
+                                                      ScalarColumnReader, VectorColumnReader>;
+
+} // namespace detail
+
+class SummarizeBranches {
+public:
+    using AccumulatorMap = std::map<std::string, SummaryAccumulator>;
+    using ReaderPtr = std::unique_ptr<detail::ColumnReader>;
+
+    SummarizeBranches(const Arguments& _args) :
+        args(_args), quantiles(SplitValueListT<double>(args.quantiles(), false, ",")),
+        pool(std::max(args.n_threads(), 1u))
+    {
+        if(args.n_threads() > 1)
+            ROOT::EnableThreadSafety();
+        ResolveBranches();
+    }
+
+    void Run()
+    {
+        std::vector<std::future<AccumulatorMap>> results;
+        for(const auto& file_name : args.input_files())
+            results.push_back(pool.run([this, file_name]() { return ProcessFile(file_name); }));
+
+        AccumulatorMap summary = CreateAccumulators();
+        for(auto& result : results) {
+            const AccumulatorMap file_summary = result.get();
+            for(const auto& entry : file_summary)
+                summary.at(entry.first).Merge(entry.second);
+        }
+
+        if(args.output().empty()) {
+            WriteJson(std::cout, summary);
+        } else {
+            std::ofstream output(args.output());
+            if(!output.is_open())
+                throw exception("Unable to create '%1%'.") % args.output();
+            WriteJson(output, summary);
+        }
+    }
+
+private:
+    void ResolveBranches()
+    {
+        if(args.input_files().empty())
+            throw exception("No input files are specified.");
+        auto file = root_ext::OpenRootFile(args.input_files().front());
+        auto tree = root_ext::ReadObject<TTree>(*file, args.tree_name());
+        std::vector<std::string> requested = SplitValueList(args.branches(), false, ",");
+        const bool use_all = requested.empty();
+        if(use_all) {
+            const auto branch_list = tree->GetListOfBranches();
+            for(Int_t n = 0; n < branch_list->GetEntries(); ++n)
+                requested.push_back(branch_list->At(n)->GetName());
+        }
+        for(const auto& name : requested) {
+            TBranch* branch = tree->GetBranch(name.c_str());
+            if(!branch)
+                throw exception("Branch '%1%' not found.") % name;
+            if(detail::ColumnReaderFactory::FindMakeMethod(*branch)) {
+                branch_names.push_back(name);
+                continue;
+            }
+            const std::string reason = root_ext::GetBranchValueType(*branch).reason;
+            const std::string type_desc = reason.empty() ? "unsupported type" : "unsupported type (" + reason + ")";
+            if(!use_all)
+                throw exception("Branch '%1%' has %2%.") % name % type_desc;
+            std::cerr << "WARNING: branch '" << name << "' has " << type_desc << " and will be skipped." << std::endl;
+        }
+    }
+
+    AccumulatorMap CreateAccumulators() const
+    {
+        AccumulatorMap accumulators;
+        for(const auto& name : branch_names)
+            accumulators.emplace(name, SummaryAccumulator(args.relative_accuracy()));
+        return accumulators;
+    }
+
+    AccumulatorMap ProcessFile(const std::string& file_name) const
+    {
+        AccumulatorMap accumulators = CreateAccumulators();
+        auto file = root_ext::OpenRootFile(file_name);
+        std::unique_ptr<TTree> tree(root_ext::ReadObject<TTree>(*file, args.tree_name()));
+
+        std::vector<std::pair<ReaderPtr, SummaryAccumulator*>> readers;
+        for(const auto& name : branch_names) {
+            TBranch* branch = tree->GetBranch(name.c_str());
+            if(!branch)
+                throw exception("Branch '%1%' not found in '%2%'.") % name % file_name;
+            const auto make = detail::ColumnReaderFactory::FindMakeMethod(*branch);
+            if(!make)
+                throw exception("Branch '%1%' has unsupported type in '%2%'.") % name % file_name;
+            readers.emplace_back(ReaderPtr((*make)(*tree, name)), &accumulators.at(name));
+        }
+
+        std::unique_ptr<TTreeFormula> selection;
+        if(!args.selection().empty()) {
+            selection = std::make_unique<TTreeFormula>("selection", args.selection().c_str(), tree.get());
+            if(selection->GetNdim() == 0)
+                throw exception("Invalid selection '%1%'.") % args.selection();
+        }
+
+        const Long64_t n_entries = tree->GetEntries();
+        for(Long64_t entry = 0; entry < n_entries; ++entry) {
+            if(selection) {
+                tree->LoadTree(entry);
+                selection->GetNdata();
+                if(selection->EvalInstance(0) == 0) continue;
+            }
+            for(auto& reader : readers)
+                reader.first->Read(entry, *reader.second);
+        }
+        tree->ResetBranchAddresses();
+        return accumulators;
+    }
+
+    static void WriteString(std::ostream& os, const std::string& str)
+    {
+        os << '"';
+        for(char c : str) {
+            if(c == '"' || c == '\\')
+                os << '\\' << c;
+            else if(static_cast<unsigned char>(c) < 0x20)
+                os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec
+                   << std::setfill(' ');
+            else
+                os << c;
+        }
+        os << '"';
+    }
+
+    static void WriteNumber(std::ostream& os, double x)
+    {
+        if(std::isfinite(x))
+            os << x;
+        else
+            os << "null";
+    }
+
+    void WriteJson(std::ostream& os, const AccumulatorMap& summary) const
+    {
+        os << std::setprecision(10) << "{\n  \"tree\": ";
+        WriteString(os, args.tree_name());
+        os << ",\n  \"n_files\": " << args.input_files().size() << ",\n  \"branches\": {";
+        bool first_branch = true;
+        for(const auto& name : branch_names) {
+            const SummaryAccumulator& acc = summary.at(name);
+            os << (first_branch ? "\n" : ",\n") << "    ";
+            WriteString(os, name);
+            os << ": { \"n_entries\": " << acc.NumberOfEntries() << ", \"n_values\": " << acc.NumberOfValues()
+               << ", \"n_nan\": " << acc.NumberOfNaN() << ", \"n_pos_inf\": " << acc.NumberOfPositiveInf()
+               << ", \"n_neg_inf\": " << acc.NumberOfNegativeInf() << ", \"sum\": ";
+            WriteNumber(os, acc.Sum());
+            os << ", \"mean\": ";
+            WriteNumber(os, acc.Mean());
+            os << ", \"std_dev\": ";
+            WriteNumber(os, acc.StdDev());
+            os << ", \"min\": ";
+            WriteNumber(os, acc.Min());
+            os << ", \"max\": ";
+            WriteNumber(os, acc.Max());
+            os << ", \"quantiles\": {";
+            for(size_t n = 0; n < quantiles.size(); ++n) {
+                os << (n ? ", " : " ") << "\"" << quantiles.at(n) << "\": ";
+                const double q = acc.Sketch().Quantile(quantiles.at(n));
+                WriteNumber(os, std::isfinite(q) ? std::min(std::max(q, acc.Min()), acc.Max()) : q);
+            }
+            os << " }, \"histogram\": [";
+            if(acc.NumberOfValues()) {
+                const auto hist = acc.Sketch().Histogram(args.n_hist_bins(), acc.Min(), acc.Max());
+                os << " " << CollectionToString(hist, ", ") << " ";
+            }
+            os << "] }";
+            first_branch = false;
+        }
+        os << "\n  }\n}" << std::endl;
+    }
+
+private:
+    Arguments args;
+    std::vector<double> quantiles;
+    std::vector<std::string> branch_names;
+    run::ThreadPull pool;
+};
+
+} // namespace analysis
+
+PROGRAM_MAIN(analysis::SummarizeBranches, Arguments)
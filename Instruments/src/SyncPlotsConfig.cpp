@@ -78,58 +78,56 @@ std::istream& operator >>(std::istream& s, Condition& cond)
 
 bool SyncPlotEntry::HasAtLeastOneCondition() const
 {
-    for(size_t n = 0; n < N; ++n) {
-        if(!conditions[n].always_true)
+    for(const auto& condition : conditions) {
+        if(!condition.always_true)
             return true;
     }
     return false;
 }
 
-SyncPlotEntry::SyncPlotEntry() : n_bins(0) {}
+SyncPlotEntry::SyncPlotEntry(size_t n_inputs) : names(n_inputs), n_bins(0), conditions(n_inputs) {}
 
 std::ostream& operator <<(std::ostream& s, const SyncPlotEntry& entry)
 {
     static constexpr char sep = ' ';
-    for(size_t n = 0; n < SyncPlotEntry::N; ++n) {
-        if(entry.names[n].size())
-            s << entry.names[n] <<  sep;
+    for(const auto& name : entry.names) {
+        if(name.size())
+            s << name <<  sep;
     }
     s << entry.n_bins << sep << entry.x_range;
     if(entry.HasAtLeastOneCondition()) {
-        for(size_t n = 0; n < SyncPlotEntry::N; ++n)
-            s << sep << entry.conditions[n];
+        for(const auto& condition : entry.conditions)
+            s << sep << condition;
     }
     return s;
 }
 
 std::istream& operator >>(std::istream& s, SyncPlotEntry& entry)
 {
+    const size_t n_inputs = entry.NumberOfInputs();
     std::string line;
     std::getline(s, line);
     const auto params = SplitValueList(line, true);
 
     try {
-        if(params.size() >= 4 && params.size() <= 7) {
+        if(params.size() >= 4 && params.size() <= 2 * n_inputs + 3) {
             size_t n = 0;
-            entry.names[0] = params.at(n++);
-
-            if(TryParse(params.at(n), entry.n_bins)) {
-                entry.names[1] = entry.names[0];
-                ++n;
-            } else {
-                entry.names[1] = params.at(n++);
-                entry.n_bins = Parse<size_t>(params.at(n++));
-            }
+            std::vector<std::string> names = { params.at(n++) };
+            while(n < params.size() && !TryParse(params.at(n), entry.n_bins))
+                names.push_back(params.at(n++));
+            if(names.size() != 1 && names.size() != n_inputs)
+                throw exception("Invalid number of branch names.");
+            for(size_t k = 0; k < n_inputs; ++k)
+                entry.names.at(k) = names.at(names.size() == 1 ? 0 : k);
+            ++n;
+            if(n + 2 > params.size() || params.size() - n - 2 > n_inputs)
+                throw exception("Invalid number of parameters.");
             const std::string range_str = params.at(n) + " " + params.at(n+1);
             entry.x_range = Parse<Range<double>>(range_str);
             n += 2;
-            if(n < params.size()) {
-                std::istringstream ss(params.at(n++));
-                ss >> entry.conditions[0];
-            }
-            if(n < params.size()) {
+            for(size_t k = 0; n < params.size(); ++k) {
                 std::istringstream ss(params.at(n++));
-                ss >> entry.conditions[1];
+                ss >> entry.conditions.at(k);
             }
 
             return s;
@@ -139,18 +137,20 @@ std::istream& operator >>(std::istream& s, SyncPlotEntry& entry)
     throw exception("Invalid plot entry '%1%'.") % line;
 }
 
-SyncPlotConfig::SyncPlotConfig(const std::string& file_name)
+SyncPlotConfig::SyncPlotConfig(const std::string& file_name, size_t n_inputs)
 {
+    if(n_inputs < 2)
+        throw exception("At least 2 inputs should be synchronized.");
     std::ifstream cfg(file_name);
 
-    for(size_t n = 0; n < N; ++n)
-        idBranches[n] = ReadIdBranches(cfg);
+    for(size_t n = 0; n < n_inputs; ++n)
+        idBranches.push_back(ReadIdBranches(cfg));
 
     while(cfg.good()) {
         std::string cfgLine;
         std::getline(cfg, cfgLine);
         if (!cfgLine.size() || (cfgLine.size() && cfgLine.at(0) == '#')) continue;
-        SyncPlotEntry entry;
+        SyncPlotEntry entry(n_inputs);
         std::istringstream ss(cfgLine);
         ss >> entry;
         entries.push_back(entry);
@@ -159,7 +159,7 @@ SyncPlotConfig::SyncPlotConfig(const std::string& file_name)
 
 const std::vector<std::string>& SyncPlotConfig::GetIdBranches(size_t n) const
 {
-    if(n >= N)
+    if(n >= idBranches.size())
         throw exception("Invalid id branches index.");
     return idBranches[n];
 }
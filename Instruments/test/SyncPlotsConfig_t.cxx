@@ -0,0 +1,115 @@
+/*! Test parsing of the EventSync configuration.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <fstream>
+#include <sstream>
+#include <boost/filesystem.hpp>
+#include "AnalysisTools/Instruments/include/SyncPlotsConfig.h"
+
+#define BOOST_TEST_MODULE SyncPlotsConfig_t
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace analysis;
+
+namespace {
+SyncPlotEntry ParseEntry(const std::string& line, size_t n_inputs)
+{
+    SyncPlotEntry entry(n_inputs);
+    std::istringstream ss(line);
+    ss >> entry;
+    return entry;
+}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE(name_per_input)
+{
+    const SyncPlotEntry entry = ParseEntry("pt_1 pt_a pt_b 50 0 100", 3);
+    const std::vector<std::string> expected_names = { "pt_1", "pt_a", "pt_b" };
+    BOOST_TEST(entry.names == expected_names, boost::test_tools::per_element());
+    BOOST_TEST(entry.n_bins == 50u);
+    BOOST_TEST(entry.x_range.min() == 0.);
+    BOOST_TEST(entry.x_range.max() == 100.);
+    BOOST_TEST(!entry.HasAtLeastOneCondition());
+}
+
+BOOST_AUTO_TEST_CASE(shared_name)
+{
+    const SyncPlotEntry entry = ParseEntry("eta 10 -2.5 2.5", 4);
+    BOOST_TEST(entry.NumberOfInputs() == 4u);
+    for(const auto& name : entry.names)
+        BOOST_TEST(name == "eta");
+    BOOST_TEST(entry.x_range.min() == -2.5);
+    BOOST_TEST(entry.conditions.size() == 4u);
+}
+
+BOOST_AUTO_TEST_CASE(conditions_per_input)
+{
+    const SyncPlotEntry entry = ParseEntry("m_vis 40 0 200 q_1==1 1 iso<0.15", 3);
+    const Condition& integer_cond = entry.conditions.at(0);
+    BOOST_TEST(!integer_cond.always_true);
+    BOOST_TEST(integer_cond.entry == "q_1");
+    BOOST_TEST((integer_cond.expr == CondExpr::Equal));
+    BOOST_TEST(integer_cond.is_integer);
+    BOOST_TEST(integer_cond.value_int == 1);
+    BOOST_TEST(integer_cond.pass_int(1));
+    BOOST_TEST(!integer_cond.pass_int(0));
+
+    BOOST_TEST(entry.conditions.at(1).always_true);
+
+    const Condition& double_cond = entry.conditions.at(2);
+    BOOST_TEST(double_cond.entry == "iso");
+    BOOST_TEST((double_cond.expr == CondExpr::Less));
+    BOOST_TEST(!double_cond.is_integer);
+    BOOST_TEST(double_cond.value_double == 0.15);
+    BOOST_TEST(double_cond.pass_double(0.1));
+    BOOST_TEST(!double_cond.pass_double(0.2));
+
+    // Conditions that are not specified are always true.
+    const SyncPlotEntry partial = ParseEntry("m_vis 40 0 200 njets>=2", 3);
+    BOOST_TEST((partial.conditions.at(0).expr == CondExpr::MoreOrEqual));
+    BOOST_TEST(partial.conditions.at(0).value_int == 2);
+    BOOST_TEST(partial.conditions.at(1).always_true);
+    BOOST_TEST(partial.conditions.at(2).always_true);
+}
+
+BOOST_AUTO_TEST_CASE(two_input_format)
+{
+    const SyncPlotEntry entry = ParseEntry("pt_1 pt_tau 50 0 100 q_1==1 q_tau==1", 2);
+    BOOST_TEST(entry.names.at(0) == "pt_1");
+    BOOST_TEST(entry.names.at(1) == "pt_tau");
+    BOOST_TEST(entry.conditions.at(0).entry == "q_1");
+    BOOST_TEST(entry.conditions.at(1).entry == "q_tau");
+
+    const SyncPlotEntry shared = ParseEntry("pt_1 50 0 100", 2);
+    BOOST_TEST(shared.names.at(0) == "pt_1");
+    BOOST_TEST(shared.names.at(1) == "pt_1");
+}
+
+BOOST_AUTO_TEST_CASE(invalid_entries)
+{
+    BOOST_CHECK_THROW(ParseEntry("pt_1 pt_a 50 0 100", 3), exception);
+    BOOST_CHECK_THROW(ParseEntry("pt 50 0 100 1 1 1", 2), exception);
+    BOOST_CHECK_THROW(ParseEntry("pt 50", 2), exception);
+}
+
+BOOST_AUTO_TEST_CASE(config_file)
+{
+    const std::string file_name = (boost::filesystem::temp_directory_path()
+                                   / boost::filesystem::unique_path("%%%%-%%%%-%%%%.txt")).string();
+    {
+        std::ofstream cfg(file_name);
+        cfg << "run lumi evt\nrun lumi evt\nrun lumi evt sample\n"
+            << "# comment\n"
+            << "pt 50 0 100\n"
+            << "pt_1 pt_a pt_b 50 0 100 1 q==1\n";
+    }
+    const SyncPlotConfig config(file_name, 3);
+    boost::filesystem::remove(file_name);
+    BOOST_TEST(config.NumberOfInputs() == 3u);
+    BOOST_TEST(config.GetIdBranches(2).size() == 4u);
+    BOOST_TEST(config.GetEntries().size() == 2u);
+    BOOST_TEST(config.GetEntries().at(1).names.at(2) == "pt_b");
+    BOOST_TEST(config.GetEntries().at(1).conditions.at(1).entry == "q");
+    BOOST_CHECK_THROW(config.GetIdBranches(3), exception);
+}
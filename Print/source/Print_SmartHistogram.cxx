@@ -1,32 +1,32 @@
 /*! Print smart histograms with specified name superimposing several files.
 This file is part of https://github.com/hh-italian-group/AnalysisTools. */
 
+#include <TFile.h>
 #include <TTree.h>
 
 #include "AnalysisTools/Run/include/program_main.h"
+#include "AnalysisTools/Core/include/BranchProjection.h"
 #include "AnalysisTools/Core/include/RootExt.h"
 #include "../include/RootPrintToPdf.h"
 
+// Histograms are projected from all input files in parallel by BranchProjection before printing.
 class MyHistogramSource : public root_ext::HistogramSource<TH1D, Double_t, TTree> {
 public:
-    MyHistogramSource(const analysis::Range<double>& _xRange, unsigned _nBins)
-        : xRange(_xRange), nBins(_nBins) {}
+    using HistPtr = analysis::BranchProjection::HistPtr;
+
+    void AddProjection(const std::string& fileName, HistPtr histogram) { projections[fileName] = histogram; }
+
 protected:
     virtual TH1D* Convert(TTree* tree) const
     {
-        std::ostringstream s_name;
-        s_name << tree->GetName() << "_hist";
-        const std::string name = s_name.str();
-        const std::string command = "values>>+" + name;
-
-        TH1D* histogram = new TH1D(name.c_str(), name.c_str(), static_cast<int>(nBins), xRange.min(), xRange.max());
-        tree->Draw(command.c_str(), "");
-        return histogram;
+        const auto iter = projections.find(tree->GetCurrentFile()->GetName());
+        if(iter == projections.end())
+            throw analysis::exception("Projection for tree '%1%' not found.") % tree->GetName();
+        return new TH1D(*iter->second);
     }
 
 private:
-    analysis::Range<double> xRange;
-    unsigned nBins;
+    std::map<std::string, HistPtr> projections;
 };
 
 struct Arguments {
@@ -47,7 +47,8 @@ public:
     using Printer = root_ext::PdfPrinter;
 
     Print_SmartHistogram(const Arguments& _args)
-       : args(_args), printer(args.outputFileName()), xRange(args.xMin(), args.xMax()), source(xRange, args.nBins())
+       : args(_args), printer(args.outputFileName()), xRange(args.xMin(), args.xMax()),
+         projection(args.histogramName(), "values", static_cast<int>(args.nBins()), args.xMin(), args.xMax())
     {
         for(const std::string& inputName : args.inputs()) {
             const size_t split_index = inputName.find_first_of(':');
@@ -55,9 +56,14 @@ public:
             const std::string tagName = inputName.substr(split_index + 1);
             inputs.push_back(FileTagPair(fileName, tagName));
         }
-        for(const FileTagPair& fileTag : inputs) {
-            auto file = root_ext::OpenRootFile(fileTag.first);
-            source.Add(fileTag.second, file);
+        std::vector<std::string> fileNames;
+        for(const FileTagPair& fileTag : inputs)
+            fileNames.push_back(fileTag.first);
+        const auto histograms = projection.Project(fileNames);
+        for(size_t n = 0; n < inputs.size(); ++n) {
+            auto file = root_ext::OpenRootFile(inputs.at(n).first);
+            source.AddProjection(file->GetName(), histograms.at(n));
+            source.Add(inputs.at(n).second, file);
         }
     }
 
@@ -96,6 +102,7 @@ private:
     root_ext::SingleSidedPage page;
     Printer printer;
     analysis::Range<double> xRange;
+    analysis::BranchProjection projection;
     MyHistogramSource source;
 };
 
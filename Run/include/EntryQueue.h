@@ -21,7 +21,7 @@ public:
     {
         {
             std::unique_lock<std::mutex> lock(mutex);
-            cond_var.wait(lock, [&] { return queue.size() < max_queue_size; });
+            cond_var.wait(lock, [&] { return queue.size() < max_queue_size || all_done; });
             queue.push(entry);
         }
         cond_var.notify_all();
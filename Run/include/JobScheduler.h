@@ -0,0 +1,186 @@
+/*! Definition of a slot-aware scheduler of local jobs.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "AnalysisTools/Core/include/exception.h"
+
+namespace run {
+
+struct JobDescriptor {
+    std::string name, command;
+    unsigned n_threads{1};
+    size_t memory{0}; // bytes
+    unsigned n_attempts{0};
+
+    // Returns the number of threads requested by the command through --n-threads, --n_processes or --n-parallel
+    // style arguments (the same convention as in submit_job.sh), or 1 if no such argument is found.
+    static unsigned DetermineNumberOfSlots(const std::string& command)
+    {
+        static const std::regex pattern("^-+n[_-](threads|processes|parallel)(=(\\d+))?$");
+        std::istringstream ss(command);
+        std::string arg;
+        bool next = false;
+        while(ss >> arg) {
+            if(next)
+                return ParseNumberOfThreads(arg);
+            std::smatch match;
+            if(std::regex_match(arg, match, pattern)) {
+                if(match[3].matched)
+                    return ParseNumberOfThreads(match[3].str());
+                next = true;
+            }
+        }
+        return 1;
+    }
+
+    // Parses memory size in the format "<number>[K|M|G|T]" (e.g. "2G" or "1.5G"). Number without a suffix is
+    // interpreted as bytes.
+    static size_t ParseMemory(const std::string& str)
+    {
+        static const std::regex pattern("^([0-9]*\\.?[0-9]+)([KMGT]?)B?$", std::regex::icase);
+        std::smatch match;
+        if(!std::regex_match(str, match, pattern))
+            throw analysis::exception("Invalid memory size '%1%'.") % str;
+        static const std::string suffixes = "KMGT";
+        const auto suffix_pos = match[2].length() ? suffixes.find(std::toupper(match[2].str().at(0))) + 1 : 0;
+        return static_cast<size_t>(std::stod(match[1].str()) * std::pow(1024., suffix_pos));
+    }
+
+    // Reads jobs from the file in which each line has format "name n_threads memory command".
+    // "-" can be used for n_threads (determined from the command arguments) and memory (not limited).
+    // Empty lines and lines that start with '#' are ignored.
+    static std::vector<JobDescriptor> ReadJobList(const std::string& file_name)
+    {
+        std::ifstream f(file_name);
+        if(f.fail())
+            throw analysis::exception("Failed to open file '%1%'.") % file_name;
+        std::vector<JobDescriptor> jobs;
+        std::string line;
+        for(size_t line_number = 1; std::getline(f, line); ++line_number) {
+            if(line.find_first_not_of(" \t") == std::string::npos || line.at(line.find_first_not_of(" \t")) == '#')
+                continue;
+            std::istringstream ss(line);
+            JobDescriptor job;
+            std::string n_threads_str, memory_str;
+            ss >> job.name >> n_threads_str >> memory_str;
+            std::getline(ss >> std::ws, job.command);
+            if(ss.fail() || job.command.empty())
+                throw analysis::exception("Invalid job description at line %1% in '%2%'.") % line_number
+                    % file_name;
+            job.n_threads = n_threads_str == "-" ? DetermineNumberOfSlots(job.command)
+                                                 : ParseNumberOfThreads(n_threads_str);
+            job.memory = memory_str == "-" ? 0 : ParseMemory(memory_str);
+            jobs.push_back(job);
+        }
+        return jobs;
+    }
+
+private:
+    static unsigned ParseNumberOfThreads(const std::string& str)
+    {
+        std::istringstream ss(str);
+        unsigned n_threads;
+        ss >> n_threads;
+        if(ss.fail() || !ss.eof() || n_threads == 0)
+            throw analysis::exception("Invalid number of threads '%1%'.") % str;
+        return n_threads;
+    }
+};
+
+// Keeps the queue of pending jobs and the available resources. Jobs are started in the queue order as long as they
+// fit into the free cores and memory; if the first pending job does not fit, smaller jobs behind it are used to fill
+// the remaining resources (backfilling). To avoid starvation of a large job, the first pending job can be bypassed
+// only max_bypass times. After that, the resources are reserved for it: no other job is started until it fits.
+class JobScheduler {
+public:
+    static constexpr unsigned DefaultMaxBypass = 10;
+
+    JobScheduler(unsigned _total_cores, size_t _total_memory, unsigned _max_bypass = DefaultMaxBypass) :
+        total_cores(_total_cores), total_memory(_total_memory), max_bypass(_max_bypass), free_cores(_total_cores),
+        free_memory(_total_memory)
+    {
+        if(!total_cores)
+            throw analysis::exception("Number of cores should be positive.");
+    }
+
+    void Add(const JobDescriptor& job)
+    {
+        if(job.n_threads > total_cores)
+            throw analysis::exception("Job '%1%' requires %2% threads, while only %3% cores are available.")
+                % job.name % job.n_threads % total_cores;
+        if(total_memory && job.memory > total_memory)
+            throw analysis::exception("Job '%1%' requires %2% bytes of memory, while only %3% bytes are available.")
+                % job.name % job.memory % total_memory;
+        pending.push_back(PendingJob{ job, 0 });
+    }
+
+    // Returns jobs that should be started now and allocates resources for them.
+    std::vector<JobDescriptor> Schedule()
+    {
+        std::vector<JobDescriptor> to_start;
+        // Only jobs behind the blocked job are erased, so its index stays valid.
+        static constexpr size_t NotBlocked = std::numeric_limits<size_t>::max();
+        size_t blocked_index = NotBlocked;
+        for(size_t n = 0; n < pending.size();) {
+            if(!Fits(pending.at(n).job)) {
+                blocked_index = std::min(blocked_index, n);
+                ++n;
+                continue;
+            }
+            if(blocked_index != NotBlocked) {
+                if(pending.at(blocked_index).n_bypassed >= max_bypass) break;
+                ++pending.at(blocked_index).n_bypassed;
+            }
+            const JobDescriptor& job = pending.at(n).job;
+            free_cores -= job.n_threads;
+            if(total_memory)
+                free_memory -= job.memory;
+            to_start.push_back(job);
+            pending.erase(pending.begin() + static_cast<std::ptrdiff_t>(n));
+        }
+        return to_start;
+    }
+
+    void Release(const JobDescriptor& job)
+    {
+        free_cores += job.n_threads;
+        if(total_memory)
+            free_memory += job.memory;
+    }
+
+    bool HasPending() const { return !pending.empty(); }
+    unsigned FreeCores() const { return free_cores; }
+    size_t FreeMemory() const { return free_memory; }
+
+private:
+    bool Fits(const JobDescriptor& job) const
+    {
+        return job.n_threads <= free_cores && (!total_memory || job.memory <= free_memory);
+    }
+
+private:
+    struct PendingJob {
+        JobDescriptor job;
+        unsigned n_bypassed; // number of jobs started ahead of this job while it did not fit
+    };
+
+    unsigned total_cores;
+    size_t total_memory;
+    unsigned max_bypass;
+    unsigned free_cores;
+    size_t free_memory;
+    std::deque<PendingJob> pending;
+};
+
+} // namespace run
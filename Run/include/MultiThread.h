@@ -5,18 +5,175 @@ This file is part of https://github.com/hh-italian-group/AnalysisTools. */
 
 #include <boost/asio/io_service.hpp>
 #include <boost/thread/thread.hpp>
+#include <algorithm>
+#include <cctype>
+#include <fstream>
 #include <future>
+#include <sstream>
+#include <string>
 #include <thread>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "AnalysisTools/Core/include/EnumNameMap.h"
 
 namespace run {
 
+// Placement of the pool threads on the CPUs.
+//  None: threads are not pinned;
+//  Core: thread i is pinned to the i-th CPU of the pool CPU list (round robin);
+//  NumaNode: threads are distributed round robin over the NUMA nodes and can move only between the CPUs of their
+//            node, so the memory allocated by a thread stays local.
+// Pinning is supported only on Linux. On other platforms the affinity is ignored.
+enum class ThreadAffinity { None, Core, NumaNode };
+ENUM_NAMES(ThreadAffinity) = {
+    { ThreadAffinity::None, "none" },
+    { ThreadAffinity::Core, "core" },
+    { ThreadAffinity::NumaNode, "numa" },
+};
+ENUM_OSTREAM_OPERATORS()
+ENUM_ISTREAM_OPERATORS()
+
+struct ThreadPullConfig {
+    size_t n_threads{1};
+    ThreadAffinity affinity{ThreadAffinity::None};
+    std::vector<unsigned> cpus; // CPUs available for the pool; if empty, all CPUs available for the process are used
+
+    ThreadPullConfig() {}
+    ThreadPullConfig(size_t _n_threads, ThreadAffinity _affinity = ThreadAffinity::None,
+                     const std::vector<unsigned>& _cpus = {}) :
+        n_threads(_n_threads), affinity(_affinity), cpus(_cpus) {}
+};
+
+namespace detail {
+
+// Parses the CPU list in the Linux format, e.g. "0-3,8,10-11".
+inline std::vector<unsigned> ParseCpuList(const std::string& cpu_list)
+{
+    std::vector<unsigned> cpus;
+    std::istringstream ss(cpu_list);
+    std::string range;
+    while(std::getline(ss, range, ',')) {
+        range.erase(std::remove_if(range.begin(), range.end(), ::isspace), range.end());
+        if(range.empty()) continue;
+        const size_t dash = range.find('-');
+        try {
+            const unsigned first = static_cast<unsigned>(std::stoul(range.substr(0, dash)));
+            const unsigned last = dash == std::string::npos ? first
+                                                            : static_cast<unsigned>(std::stoul(range.substr(dash + 1)));
+            if(last < first)
+                throw std::invalid_argument(range);
+            for(unsigned cpu = first; cpu <= last; ++cpu)
+                cpus.push_back(cpu);
+        } catch(std::logic_error&) {
+            throw std::runtime_error("Invalid CPU list '" + cpu_list + "'.");
+        }
+    }
+    return cpus;
+}
+
+} // namespace detail
+
+// Returns CPUs on which the process is allowed to run.
+inline std::vector<unsigned> GetAvailableCpus()
+{
+    std::vector<unsigned> cpus;
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    if(sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0) {
+        for(unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if(CPU_ISSET(cpu, &cpu_set))
+                cpus.push_back(cpu);
+        }
+    }
+#endif
+    if(cpus.empty()) {
+        for(unsigned cpu = 0; cpu < std::max(std::thread::hardware_concurrency(), 1u); ++cpu)
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+// Returns CPUs of each NUMA node restricted to the given CPUs. Nodes without such CPUs are skipped. If the NUMA
+// topology is not available, all CPUs are considered to belong to a single node.
+inline std::vector<std::vector<unsigned>> GetNumaNodeCpus(const std::vector<unsigned>& cpus)
+{
+    std::vector<std::vector<unsigned>> nodes;
+    for(unsigned node = 0; ; ++node) {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if(!file.is_open()) break;
+        std::string cpu_list;
+        std::getline(file, cpu_list);
+        std::vector<unsigned> node_cpus;
+        for(unsigned cpu : detail::ParseCpuList(cpu_list)) {
+            if(std::find(cpus.begin(), cpus.end(), cpu) != cpus.end())
+                node_cpus.push_back(cpu);
+        }
+        if(!node_cpus.empty())
+            nodes.push_back(node_cpus);
+    }
+    if(nodes.empty())
+        nodes.push_back(cpus);
+    return nodes;
+}
+
+// Returns the CPU sets to which the threads of the pool are pinned (one set per thread), or an empty list if the
+// threads should not be pinned.
+inline std::vector<std::vector<unsigned>> GetThreadCpuSets(const ThreadPullConfig& config)
+{
+    std::vector<std::vector<unsigned>> cpu_sets;
+    if(config.affinity == ThreadAffinity::None) return cpu_sets;
+    const std::vector<unsigned> cpus = config.cpus.empty() ? GetAvailableCpus() : config.cpus;
+    if(cpus.empty())
+        throw std::runtime_error("Empty list of CPUs for the thread pull.");
+    const std::vector<std::vector<unsigned>> nodes = config.affinity == ThreadAffinity::NumaNode
+            ? GetNumaNodeCpus(cpus) : std::vector<std::vector<unsigned>>();
+    for(size_t n = 0; n < config.n_threads; ++n) {
+        if(config.affinity == ThreadAffinity::Core)
+            cpu_sets.push_back({ cpus.at(n % cpus.size()) });
+        else
+            cpu_sets.push_back(nodes.at(n % nodes.size()));
+    }
+    return cpu_sets;
+}
+
+// Pins the calling thread to the given CPUs. Returns false, if pinning failed or is not supported.
+inline bool SetCurrentThreadAffinity(const std::vector<unsigned>& cpus)
+{
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for(unsigned cpu : cpus) {
+        if(cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &cpu_set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+#else
+    (void) cpus;
+    return false;
+#endif
+}
+
 class ThreadPull {
 public:
     ThreadPull(size_t n_threads, bool is_global = true)
+        : ThreadPull(ThreadPullConfig(n_threads), is_global) {}
+
+    ThreadPull(const ThreadPullConfig& config, bool is_global = true)
         : work(io_service)
     {
-        for(size_t n = 0; n < n_threads; ++n)
-            thread_group.create_thread(boost::bind(&boost::asio::io_service::run, &io_service));
+        const auto cpu_sets = GetThreadCpuSets(config);
+        for(size_t n = 0; n < config.n_threads; ++n) {
+            const std::vector<unsigned> cpus = cpu_sets.empty() ? std::vector<unsigned>() : cpu_sets.at(n);
+            thread_group.create_thread([this, cpus] {
+                if(!cpus.empty())
+                    SetCurrentThreadAffinity(cpus);
+                io_service.run();
+            });
+        }
         if(is_global)
             GlobalPull() = this;
     }
@@ -27,6 +184,8 @@ public:
     {
         io_service.stop();
         thread_group.join_all();
+        if(GlobalPull() == this)
+            GlobalPull() = nullptr;
     }
 
     template<class Function, class... Args>
@@ -64,4 +223,76 @@ std::future<std::result_of_t<std::decay_t<Function>(std::decay_t<Args>...)>>
     return ThreadPull::run_global(f, std::forward<Args>(args)...);
 }
 
+// Separate executors for the blocking tasks (file opening, reading and writing) and for the CPU-bound tasks
+// (decompression, event processing). Blocking tasks do not occupy the compute threads, so the I/O pool can be
+// larger than the number of CPUs, while the compute pool should match the number of CPUs and can be pinned.
+class Executors {
+public:
+    struct Config {
+        ThreadPullConfig io{2}, compute{std::max(std::thread::hardware_concurrency(), 1u)};
+
+        Config() {}
+        // The affinity is applied to both pools. The I/O threads spend most of the time waiting, so they can share
+        // the CPUs with the compute threads.
+        Config(size_t n_io_threads, size_t n_compute_threads, ThreadAffinity affinity = ThreadAffinity::None) :
+            io(n_io_threads, affinity), compute(n_compute_threads, affinity) {}
+    };
+
+    explicit Executors(const Config& config, bool is_global = true)
+        : io_pull(config.io, false), compute_pull(config.compute, is_global)
+    {
+        if(is_global)
+            GlobalExecutors() = this;
+    }
+
+    Executors(const Executors&) = delete;
+
+    ~Executors()
+    {
+        if(GlobalExecutors() == this)
+            GlobalExecutors() = nullptr;
+    }
+
+    ThreadPull& Io() { return io_pull; }
+    ThreadPull& Compute() { return compute_pull; }
+
+    template<class Function, class... Args>
+    std::future<std::result_of_t<std::decay_t<Function>(std::decay_t<Args>...)>>
+        run_io(Function&& f, Args&&... args)
+    {
+        return io_pull.run(f, std::forward<Args>(args)...);
+    }
+
+    template<class Function, class... Args>
+    std::future<std::result_of_t<std::decay_t<Function>(std::decay_t<Args>...)>>
+        run_compute(Function&& f, Args&&... args)
+    {
+        return compute_pull.run(f, std::forward<Args>(args)...);
+    }
+
+    static bool IsGlobalDefined() { return GlobalExecutors() != nullptr; }
+
+    static Executors& Global()
+    {
+        if(!GlobalExecutors())
+            throw std::runtime_error("Global executors not defined.");
+        return *GlobalExecutors();
+    }
+
+private:
+    static Executors*& GlobalExecutors() { static Executors* global_executors = nullptr; return global_executors; }
+
+private:
+    ThreadPull io_pull, compute_pull;
+};
+
+// Runs a blocking task on the I/O executor of the global executors. CPU-bound tasks should be run with run::async,
+// which uses the compute executor of the global executors.
+template< class Function, class... Args>
+std::future<std::result_of_t<std::decay_t<Function>(std::decay_t<Args>...)>>
+    async_io(Function&& f, Args&&... args)
+{
+    return Executors::Global().run_io(f, std::forward<Args>(args)...);
+}
+
 } // namespace run
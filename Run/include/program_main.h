@@ -11,6 +11,7 @@ This file is part of https://github.com/hh-italian-group/AnalysisTools. */
 #include <TH1.h>
 #include <TH2.h>
 #include "AnalysisTools/Core/include/exception.h"
+#include "AnalysisTools/Core/include/MemoryAccounting.h"
 
 #define REQ_ARG(type, name) run::Argument<type> name{#name, ""}
 #define OPT_ARG(type, name, default_value) run::Argument<type> name{#name, "", default_value}
@@ -72,12 +73,13 @@ int Main(int argc, char* argv[], const Options& options, const options_descripti
         TH1::SetDefaultSumw2();
         TH1::AddDirectory(kFALSE);
         TH2::AddDirectory(kFALSE);
-        gROOT->ProcessLine("#include <vector>");
         gROOT->SetMustClean(kFALSE);
         if(!ParseProgramArguments(argc, argv, options_desc, pos_desc))
             return PRINT_ARGS_EXIT_CODE;
         Program program(options);
         program.Run();
+        if(analysis::MemoryAccounting::IsSummaryRequested() && !analysis::MemoryAccounting::Global().empty())
+            analysis::MemoryAccounting::Global().PrintSummary(std::cerr);
     } catch(analysis::exception& e) {
         std::cerr << "ERROR: " << e.what() << "\nStack trace:\n" << e.stacktrace() << std::endl;
         return ERROR_EXIT_CODE;
@@ -0,0 +1,206 @@
+/*! Run jobs concurrently on the local machine, packing them onto the available cores and memory.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include <cerrno>
+#include <chrono>
+#include <ctime>
+#include <fcntl.h>
+#include <iomanip>
+#include <map>
+#include <set>
+#include <thread>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <boost/filesystem.hpp>
+#include "AnalysisTools/Run/include/JobScheduler.h"
+#include "AnalysisTools/Run/include/program_main.h"
+
+struct Arguments {
+    run::Argument<std::string> job_list{"jobs", "file with the list of jobs: one 'name n_threads memory command' per line"};
+    run::Argument<std::string> log_dir{"log-dir", "directory where job logs and the summary are stored", "."};
+    run::Argument<unsigned> n_cores{"n-cores", "number of cores to use (0 - all cores)", 0};
+    run::Argument<std::string> memory{"memory", "total memory available for jobs, e.g. 64G (0 - not limited)", "0"};
+    run::Argument<unsigned> max_retries{"max-retries", "maximal number of retries for failed jobs", 0};
+    run::Argument<unsigned> max_bypass{"max-bypass", "number of times a job that does not fit can be bypassed by the"
+                                                     " jobs behind it before the resources are reserved for it",
+                                       run::JobScheduler::DefaultMaxBypass};
+};
+
+namespace {
+struct JobResult {
+    run::JobDescriptor job;
+    int exit_code{-1};
+    bool signaled{false};
+    double wall_time{0}, user_time{0}, system_time{0}; // seconds
+    long max_rss{0}; // KiB
+
+    bool Succeeded() const { return !signaled && exit_code == 0; }
+};
+
+struct RunningJob {
+    run::JobDescriptor job;
+    std::chrono::steady_clock::time_point start;
+};
+
+double ToSeconds(const timeval& tv) { return tv.tv_sec + tv.tv_usec / 1e6; }
+
+std::string CurrentTime()
+{
+    const std::time_t now = std::time(nullptr);
+    char buffer[64];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+    return buffer;
+}
+} // anonymous namespace
+
+class RunLocalJobs {
+public:
+    using exception = analysis::exception;
+
+    RunLocalJobs(const Arguments& _args) :
+        args(_args),
+        scheduler(args.n_cores() ? args.n_cores() : std::max(std::thread::hardware_concurrency(), 1u),
+                  run::JobDescriptor::ParseMemory(args.memory()), args.max_bypass())
+    {
+        for(const auto& job : run::JobDescriptor::ReadJobList(args.job_list())) {
+            if(job_names.count(job.name))
+                throw exception("Duplicated job name '%1%'.") % job.name;
+            job_names.insert(job.name);
+            scheduler.Add(job);
+        }
+        boost::filesystem::create_directories(args.log_dir());
+    }
+
+    void Run()
+    {
+        std::cout << "Running " << job_names.size() << " jobs using " << scheduler.FreeCores() << " cores."
+                  << std::endl;
+        while(scheduler.HasPending() || !running.empty()) {
+            for(const auto& job : scheduler.Schedule())
+                Start(job);
+            if(running.empty())
+                throw exception("Unable to schedule the remaining jobs.");
+            WaitForJob();
+        }
+        PrintSummary();
+        size_t n_failed = 0;
+        for(const auto& result : results)
+            n_failed += !result.Succeeded();
+        if(n_failed)
+            throw exception("%1% of %2% jobs failed.") % n_failed % results.size();
+    }
+
+private:
+    std::string LogFile(const run::JobDescriptor& job) const
+    {
+        return (boost::filesystem::path(args.log_dir()) / (job.name + ".log")).string();
+    }
+
+    void Start(run::JobDescriptor job)
+    {
+        ++job.n_attempts;
+        const std::string log_file = LogFile(job);
+        {
+            std::ofstream log(log_file, job.n_attempts == 1 ? std::ios::trunc : std::ios::app);
+            log << "Attempt " << job.n_attempts << " started at " << CurrentTime() << " with " << job.n_threads
+                << " threads.\n> " << job.command << std::endl;
+        }
+        std::cout << "[" << CurrentTime() << "] starting '" << job.name << "' (attempt " << job.n_attempts
+                  << ", " << job.n_threads << " threads)." << std::endl;
+
+        const pid_t pid = fork();
+        if(pid < 0)
+            throw exception("Unable to start job '%1%'.") % job.name;
+        if(pid == 0) {
+            const int fd = open(log_file.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+            if(fd >= 0) {
+                dup2(fd, STDOUT_FILENO);
+                dup2(fd, STDERR_FILENO);
+                close(fd);
+            }
+            const int null_fd = open("/dev/null", O_RDONLY);
+            if(null_fd >= 0) {
+                dup2(null_fd, STDIN_FILENO);
+                close(null_fd);
+            }
+            execl("/bin/sh", "sh", "-c", job.command.c_str(), static_cast<char*>(nullptr));
+            _exit(127);
+        }
+        running[pid] = RunningJob{ job, std::chrono::steady_clock::now() };
+    }
+
+    void WaitForJob()
+    {
+        int status;
+        rusage usage;
+        pid_t pid;
+        while((pid = wait4(-1, &status, 0, &usage)) < 0) {
+            if(errno != EINTR)
+                throw exception("Error while waiting for the running jobs.");
+        }
+        auto iter = running.find(pid);
+        if(iter == running.end()) return;
+        const RunningJob running_job = iter->second;
+        running.erase(iter);
+        scheduler.Release(running_job.job);
+
+        JobResult result;
+        result.job = running_job.job;
+        result.wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - running_job.start).count();
+        result.user_time = ToSeconds(usage.ru_utime);
+        result.system_time = ToSeconds(usage.ru_stime);
+        result.max_rss = usage.ru_maxrss;
+        result.signaled = WIFSIGNALED(status);
+        result.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : (result.signaled ? WTERMSIG(status) : -1);
+
+        {
+            std::ofstream log(LogFile(result.job), std::ios::app);
+            log << "Attempt " << result.job.n_attempts << (result.Succeeded() ? " successfully ended" : " failed")
+                << " at " << CurrentTime() << (result.signaled ? " with signal " : " with exit code ")
+                << result.exit_code << ". Wall time = " << result.wall_time << " s, CPU time = "
+                << result.user_time + result.system_time << " s, max RSS = " << result.max_rss << " KiB."
+                << std::endl;
+        }
+        std::cout << "[" << CurrentTime() << "] '" << result.job.name << "' "
+                  << (result.Succeeded() ? "successfully ended" : "failed") << " after " << std::fixed
+                  << std::setprecision(1) << result.wall_time << " s." << std::endl;
+
+        if(!result.Succeeded() && result.job.n_attempts <= args.max_retries())
+            scheduler.Add(result.job);
+        else
+            results.push_back(result);
+    }
+
+    void PrintSummary() const
+    {
+        const std::string summary_file = (boost::filesystem::path(args.log_dir()) / "summary.txt").string();
+        std::ofstream summary(summary_file);
+        for(std::ostream* os : { static_cast<std::ostream*>(&std::cout), static_cast<std::ostream*>(&summary) }) {
+            *os << std::left << std::setw(30) << "job" << std::setw(8) << "status" << std::setw(9) << "attempts"
+                << std::setw(10) << "exit_code" << std::setw(8) << "threads" << std::setw(12) << "wall_time_s"
+                << std::setw(12) << "cpu_time_s" << std::setw(10) << "cpu_eff" << "max_rss_MiB" << "\n";
+            for(const auto& result : results) {
+                const double cpu_time = result.user_time + result.system_time;
+                const double cpu_eff = result.wall_time > 0 ? cpu_time / (result.wall_time * result.job.n_threads)
+                                                            : 0;
+                *os << std::left << std::setw(30) << result.job.name << std::setw(8)
+                    << (result.Succeeded() ? "OK" : "FAILED") << std::setw(9) << result.job.n_attempts
+                    << std::setw(10) << result.exit_code << std::setw(8) << result.job.n_threads << std::fixed
+                    << std::setprecision(1) << std::setw(12) << result.wall_time << std::setw(12) << cpu_time
+                    << std::setprecision(2) << std::setw(10) << cpu_eff << std::setprecision(1)
+                    << result.max_rss / 1024. << "\n";
+            }
+            os->flush();
+        }
+    }
+
+private:
+    Arguments args;
+    run::JobScheduler scheduler;
+    std::set<std::string> job_names;
+    std::map<pid_t, RunningJob> running;
+    std::vector<JobResult> results;
+};
+
+PROGRAM_MAIN(RunLocalJobs, Arguments)
@@ -0,0 +1,91 @@
+/*! Test JobScheduler class.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include "AnalysisTools/Run/include/JobScheduler.h"
+
+#define BOOST_TEST_MODULE JobScheduler_t
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using JobDescriptor = run::JobDescriptor;
+
+namespace {
+JobDescriptor MakeJob(const std::string& name, unsigned n_threads, size_t memory = 0)
+{
+    JobDescriptor job;
+    job.name = name;
+    job.command = "true";
+    job.n_threads = n_threads;
+    job.memory = memory;
+    return job;
+}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE(parse_job_requirements)
+{
+    BOOST_TEST(JobDescriptor::DetermineNumberOfSlots("Tool --input a.root --n-threads 8") == 8u);
+    BOOST_TEST(JobDescriptor::DetermineNumberOfSlots("Tool --n_processes=3") == 3u);
+    BOOST_TEST(JobDescriptor::DetermineNumberOfSlots("Tool --input a.root") == 1u);
+    BOOST_TEST(JobDescriptor::ParseMemory("2G") == size_t(2) << 30);
+    BOOST_TEST(JobDescriptor::ParseMemory("1.5k") == 1536u);
+    BOOST_TEST(JobDescriptor::ParseMemory("100") == 100u);
+    BOOST_CHECK_THROW(JobDescriptor::ParseMemory("2X"), analysis::exception);
+}
+
+BOOST_AUTO_TEST_CASE(packing_and_backfilling)
+{
+    run::JobScheduler scheduler(8, 10);
+    scheduler.Add(MakeJob("a", 4, 2));
+    scheduler.Add(MakeJob("b", 6, 2));
+    scheduler.Add(MakeJob("c", 2, 2));
+    scheduler.Add(MakeJob("d", 2, 7));
+    BOOST_CHECK_THROW(scheduler.Add(MakeJob("e", 9)), analysis::exception);
+
+    auto started = scheduler.Schedule();
+    BOOST_TEST(started.size() == 2u);
+    BOOST_TEST(started.at(0).name == "a");
+    BOOST_TEST(started.at(1).name == "c");
+    BOOST_TEST(scheduler.FreeCores() == 2u);
+    BOOST_TEST(scheduler.Schedule().empty());
+
+    scheduler.Release(started.at(0));
+    started = scheduler.Schedule();
+    BOOST_TEST(started.size() == 1u);
+    BOOST_TEST(started.at(0).name == "b");
+
+    scheduler.Release(started.at(0));
+    started = scheduler.Schedule();
+    BOOST_TEST(started.size() == 1u);
+    BOOST_TEST(started.at(0).name == "d");
+    BOOST_TEST(!scheduler.HasPending());
+}
+
+BOOST_AUTO_TEST_CASE(reservation_for_blocked_job)
+{
+    run::JobScheduler scheduler(4, 0, 2);
+    scheduler.Add(MakeJob("small_0", 2));
+    scheduler.Add(MakeJob("large", 4));
+    for(size_t n = 1; n <= 4; ++n)
+        scheduler.Add(MakeJob("small_" + std::to_string(n), 1));
+
+    auto started = scheduler.Schedule();
+    BOOST_TEST(started.size() == 3u);
+    BOOST_TEST(started.at(0).name == "small_0");
+    BOOST_TEST(started.at(1).name == "small_1");
+    BOOST_TEST(started.at(2).name == "small_2");
+
+    // The large job was bypassed twice, so the freed cores are reserved for it.
+    scheduler.Release(started.at(1));
+    BOOST_TEST(scheduler.Schedule().empty());
+    scheduler.Release(started.at(0));
+    BOOST_TEST(scheduler.Schedule().empty());
+    scheduler.Release(started.at(2));
+    started = scheduler.Schedule();
+    BOOST_TEST(started.size() == 1u);
+    BOOST_TEST(started.at(0).name == "large");
+
+    scheduler.Release(started.at(0));
+    started = scheduler.Schedule();
+    BOOST_TEST(started.size() == 2u);
+    BOOST_TEST(!scheduler.HasPending());
+}
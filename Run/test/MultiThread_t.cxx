@@ -0,0 +1,83 @@
+/*! Test thread pulls with CPU affinity and separate I/O and compute executors.
+This file is part of https://github.com/hh-italian-group/AnalysisTools. */
+
+#include "AnalysisTools/Run/include/MultiThread.h"
+
+#define BOOST_TEST_MODULE MultiThread_t
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace run;
+
+BOOST_AUTO_TEST_CASE(cpu_list)
+{
+    const std::vector<unsigned> expected = { 0, 1, 2, 3, 8, 10, 11 };
+    BOOST_TEST(detail::ParseCpuList("0-3,8,10-11\n") == expected, boost::test_tools::per_element());
+    BOOST_TEST(detail::ParseCpuList("").empty());
+    BOOST_CHECK_THROW(detail::ParseCpuList("3-1"), std::runtime_error);
+    BOOST_CHECK_THROW(detail::ParseCpuList("a"), std::runtime_error);
+    BOOST_TEST(!GetAvailableCpus().empty());
+}
+
+BOOST_AUTO_TEST_CASE(thread_cpu_sets)
+{
+    BOOST_TEST(GetThreadCpuSets(ThreadPullConfig(4)).empty());
+    const auto core_sets = GetThreadCpuSets(ThreadPullConfig(3, ThreadAffinity::Core, { 4, 6 }));
+    BOOST_TEST(core_sets.size() == 3u);
+    BOOST_TEST(core_sets.at(0) == std::vector<unsigned>({ 4 }), boost::test_tools::per_element());
+    BOOST_TEST(core_sets.at(1) == std::vector<unsigned>({ 6 }), boost::test_tools::per_element());
+    BOOST_TEST(core_sets.at(2) == std::vector<unsigned>({ 4 }), boost::test_tools::per_element());
+
+    const auto cpus = GetAvailableCpus();
+    const auto node_sets = GetThreadCpuSets(ThreadPullConfig(2, ThreadAffinity::NumaNode));
+    BOOST_TEST(node_sets.size() == 2u);
+    for(const auto& node_set : node_sets) {
+        BOOST_TEST(!node_set.empty());
+        for(unsigned cpu : node_set)
+            BOOST_TEST(std::count(cpus.begin(), cpus.end(), cpu) == 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(affinity_names)
+{
+    std::istringstream is("numa");
+    ThreadAffinity affinity = ThreadAffinity::None;
+    is >> affinity;
+    BOOST_TEST((affinity == ThreadAffinity::NumaNode));
+    std::ostringstream os;
+    os << ThreadAffinity::Core;
+    BOOST_TEST(os.str() == "core");
+}
+
+BOOST_AUTO_TEST_CASE(pinned_pull)
+{
+    const unsigned cpu = GetAvailableCpus().back();
+    ThreadPull pull(ThreadPullConfig(2, ThreadAffinity::Core, { cpu }), false);
+    std::vector<std::future<int>> results;
+    for(int n = 0; n < 10; ++n)
+        results.push_back(pull.run([](int x) { return x * x; }, n));
+    for(int n = 0; n < 10; ++n)
+        BOOST_TEST(results.at(static_cast<size_t>(n)).get() == n * n);
+#ifdef __linux__
+    BOOST_TEST(pull.run([] { return sched_getcpu(); }).get() == static_cast<int>(cpu));
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(executors)
+{
+    Executors::Config config;
+    config.io = ThreadPullConfig(3);
+    config.compute = ThreadPullConfig(2, ThreadAffinity::NumaNode);
+    {
+        Executors exec(config);
+        BOOST_TEST(Executors::IsGlobalDefined());
+        const auto io_thread = async_io([] { return std::this_thread::get_id(); }).get();
+        const auto compute_thread = async([] { return std::this_thread::get_id(); }).get();
+        BOOST_TEST((io_thread != compute_thread));
+        BOOST_TEST(exec.run_compute([](int x) { return x + 1; }, 1).get() == 2);
+        BOOST_TEST(exec.run_io([](int x) { return x - 1; }, 1).get() == 0);
+    }
+    BOOST_TEST(!Executors::IsGlobalDefined());
+    BOOST_CHECK_THROW(Executors::Global(), std::runtime_error);
+    BOOST_CHECK_THROW(async([] { return 0; }), std::runtime_error);
+}
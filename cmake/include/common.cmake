@@ -5,6 +5,17 @@ find_package(BoostEx REQUIRED COMPONENTS program_options filesystem regex system
 include_directories(SYSTEM ${Boost_INCLUDE_DIRS} ${ROOT_INCLUDE_DIR})
 set(ALL_LIBS ${Boost_LIBRARIES} ${ROOT_LIBRARIES} pthread dl)
 
+# RNTuple storage backend for SmartTree is available with ROOT 6.32 or newer.
+string(REPLACE "/" "." ROOT_VERSION_NUMBER "${ROOT_VERSION}")
+if(ROOT_VERSION_NUMBER VERSION_GREATER_EQUAL "6.32" AND EXISTS "${ROOT_INCLUDE_DIR}/ROOT/RNTuple.hxx")
+    find_library(ROOT_NTUPLE_LIBRARY ROOTNTuple HINTS "${ROOT_LIBRARY_DIR}")
+    find_library(ROOT_NTUPLE_UTIL_LIBRARY ROOTNTupleUtil HINTS "${ROOT_LIBRARY_DIR}")
+    if(ROOT_NTUPLE_LIBRARY AND ROOT_NTUPLE_UTIL_LIBRARY)
+        list(APPEND ALL_LIBS ${ROOT_NTUPLE_LIBRARY} ${ROOT_NTUPLE_UTIL_LIBRARY})
+        add_definitions(-DANALYSIS_TOOLS_HAS_RNTUPLE)
+    endif()
+endif()
+
 SET(CMAKE_BUILD_WITH_INSTALL_RPATH TRUE)
 SET(CMAKE_INSTALL_RPATH "${Boost_LIBRARY_DIRS};${ROOT_LIBRARY_DIR}")
 
@@ -51,7 +62,8 @@ set(CMAKE_CXX_FLAGS "${CXX_COMMON_FLAGS} -O3 -gline-tables-only")
 
 set(LinkDef "${AnalysisTools_DIR}/Core/include/LinkDef.h")
 set(RootDict "${CMAKE_BINARY_DIR}/RootDictionaries.cpp")
-set(RootDictIncludes "Math/LorentzVector.h" "Math/PtEtaPhiM4D.h" "Math/PtEtaPhiE4D.h" "Math/PxPyPzM4D.h")
+set(RootDictIncludes "vector" "map" "string" "Math/LorentzVector.h" "Math/PtEtaPhiM4D.h" "Math/PtEtaPhiE4D.h"
+                     "Math/PxPyPzM4D.h" "Math/PxPyPzE4D.h" "Math/Point3D.h")
 add_custom_command(OUTPUT "${RootDict}"
                    COMMAND rootcling -f "${RootDict}" ${RootDictIncludes} "${LinkDef}"
                    IMPLICIT_DEPENDS CXX "${LinkDef}"